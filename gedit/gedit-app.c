@@ -43,6 +43,8 @@
 #include "gedit-commands.h"
 #include "gedit-preferences-dialog.h"
 #include "gedit-tab.h"
+#include "gedit-journal.h"
+#include "gedit-startup-trace.h"
 
 #define GEDIT_PAGE_SETUP_FILE		"gedit-page-setup"
 #define GEDIT_PRINT_SETTINGS_FILE	"gedit-print-settings"
@@ -127,6 +129,13 @@ static const GOptionEntry options[] =
 		NULL
 	},
 
+	/* Startup trace */
+	{
+		"startup-trace", '\0', 0, G_OPTION_ARG_FILENAME, NULL,
+		N_("Write the timings of the startup to FILE, in the Trace Event Format"),
+		N_("FILE")
+	},
+
 	/* collects file arguments */
 	{
 		G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, NULL, NULL,
@@ -494,7 +503,22 @@ extension_added (PeasExtensionSet *extensions,
 		 PeasExtension    *exten,
 		 GeditApp         *app)
 {
+	gchar *trace_name = NULL;
+
+	if (gedit_startup_trace_is_enabled ())
+	{
+		trace_name = g_strdup_printf ("app-activatable %s",
+		                              peas_plugin_info_get_module_name (info));
+		gedit_startup_trace_begin (trace_name);
+	}
+
 	gedit_app_activatable_activate (GEDIT_APP_ACTIVATABLE (exten));
+
+	if (trace_name != NULL)
+	{
+		gedit_startup_trace_end (trace_name);
+		g_free (trace_name);
+	}
 }
 
 static void
@@ -646,18 +670,26 @@ gedit_app_startup (GApplication *application)
 
 	priv = gedit_app_get_instance_private (GEDIT_APP (application));
 
+	gedit_startup_trace_begin ("startup");
+
+	gedit_startup_trace_begin ("gtk-startup");
 	G_APPLICATION_CLASS (gedit_app_parent_class)->startup (application);
+	gedit_startup_trace_end ("gtk-startup");
 
 	/* Setup debugging */
 	gedit_debug_init ();
 	gedit_debug_message (DEBUG_APP, "Startup");
 
+	gedit_startup_trace_begin ("theme-extensions");
 	setup_theme_extensions (GEDIT_APP (application));
+	gedit_startup_trace_end ("theme-extensions");
 
 	/* Load/init settings */
+	gedit_startup_trace_begin ("settings");
 	_gedit_settings_get_singleton ();
 	priv->ui_settings = g_settings_new ("org.gnome.gedit.preferences.ui");
 	priv->window_settings = g_settings_new ("org.gnome.gedit.state.window");
+	gedit_startup_trace_end ("settings");
 
 	g_action_map_add_action_entries (G_ACTION_MAP (application),
 	                                 app_entries,
@@ -665,6 +697,8 @@ gedit_app_startup (GApplication *application)
 	                                 application);
 
 	/* menus */
+	gedit_startup_trace_begin ("menus-and-accels");
+
 	if (!show_menubar ())
 	{
 		gtk_application_set_menubar (GTK_APPLICATION (application), NULL);
@@ -710,10 +744,14 @@ gedit_app_startup (GApplication *application)
 
 	load_accels ();
 
+	gedit_startup_trace_end ("menus-and-accels");
+
 	/* Load custom css */
+	gedit_startup_trace_begin ("css");
 	g_object_unref (load_css_from_resource ("gedit-style.css", TRUE));
 	css_provider = load_css_from_resource ("gedit-style-os.css", FALSE);
 	g_clear_object (&css_provider);
+	gedit_startup_trace_end ("css");
 
 	/*
 	 * We use the default gtksourceview style scheme manager so that plugins
@@ -724,7 +762,11 @@ gedit_app_startup (GApplication *application)
 	gtk_source_style_scheme_manager_append_search_path (manager,
 	                                                    gedit_dirs_get_user_styles_dir ());
 
+	gedit_startup_trace_begin ("plugins-engine");
 	priv->engine = gedit_plugins_engine_get_default ();
+	gedit_startup_trace_end ("plugins-engine");
+
+	gedit_startup_trace_begin ("app-extensions");
 	priv->extensions = peas_extension_set_new (PEAS_ENGINE (priv->engine),
 	                                           GEDIT_TYPE_APP_ACTIVATABLE,
 	                                           "app", GEDIT_APP (application),
@@ -743,6 +785,14 @@ gedit_app_startup (GApplication *application)
 	peas_extension_set_foreach (priv->extensions,
 	                            (PeasExtensionSetForeachFunc) extension_added,
 	                            application);
+
+	gedit_plugins_engine_add_deferred_actions (priv->engine,
+	                                           G_ACTION_MAP (application),
+	                                           "app");
+
+	gedit_startup_trace_end ("app-extensions");
+
+	gedit_startup_trace_end ("startup");
 }
 
 static void
@@ -906,6 +956,8 @@ static gint
 gedit_app_handle_local_options (GApplication *application,
                                 GVariantDict *options)
 {
+	const gchar *trace_filename;
+
 	if (g_variant_dict_contains (options, "version"))
 	{
 		g_print ("%s - Version %s\n", g_get_application_name (), VERSION);
@@ -934,6 +986,11 @@ gedit_app_handle_local_options (GApplication *application,
 		g_application_set_flags (application, old_flags | G_APPLICATION_IS_LAUNCHER);
 	}
 
+	if (g_variant_dict_lookup (options, "startup-trace", "^&ay", &trace_filename))
+	{
+		gedit_startup_trace_enable (trace_filename);
+	}
+
 	return -1;
 }
 
@@ -1114,6 +1171,11 @@ gedit_app_shutdown (GApplication *app)
 	save_page_setup (GEDIT_APP (app));
 	save_print_settings (GEDIT_APP (app));
 
+	gedit_journal_shutdown ();
+
+	/* If gedit quits before the first window is ready */
+	gedit_startup_trace_finish ();
+
 	G_APPLICATION_CLASS (gedit_app_parent_class)->shutdown (app);
 }
 
@@ -1138,6 +1200,58 @@ window_delete_event (GeditWindow *window,
 	return TRUE;
 }
 
+static void
+trace_window_state_changed (GeditWindow *window,
+                            GParamSpec  *pspec,
+                            gpointer     user_data)
+{
+	if (!gtk_widget_get_mapped (GTK_WIDGET (window)) ||
+	    (gedit_window_get_state (window) & GEDIT_WINDOW_STATE_LOADING) != 0)
+	{
+		return;
+	}
+
+	g_signal_handlers_disconnect_by_func (window, trace_window_state_changed, user_data);
+
+	gedit_startup_trace_mark ("documents-loaded");
+	gedit_startup_trace_finish ();
+}
+
+static gboolean
+trace_window_map_event (GtkWidget *window,
+                        GdkEvent  *event,
+                        gpointer   user_data)
+{
+	g_signal_handlers_disconnect_by_func (window, trace_window_map_event, user_data);
+
+	gedit_startup_trace_mark ("first-window-map");
+	trace_window_state_changed (GEDIT_WINDOW (window), NULL, user_data);
+
+	return GDK_EVENT_PROPAGATE;
+}
+
+static gboolean
+load_idle_plugins_cb (gpointer user_data)
+{
+	gedit_plugins_engine_activate_trigger (gedit_plugins_engine_get_default (),
+	                                       "idle");
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+window_map_event (GtkWidget *window,
+                  GdkEvent  *event,
+                  gpointer   user_data)
+{
+	g_signal_handlers_disconnect_by_func (window, window_map_event, user_data);
+
+	/* With a lower priority than the redraws, so after the first paint */
+	g_idle_add_full (G_PRIORITY_LOW, load_idle_plugins_cb, NULL, NULL);
+
+	return GDK_EVENT_PROPAGATE;
+}
+
 static GeditWindow *
 gedit_app_create_window_impl (GeditApp *app)
 {
@@ -1286,7 +1400,31 @@ gedit_app_create_window (GeditApp  *app,
 
 	priv = gedit_app_get_instance_private (app);
 
+	gedit_startup_trace_begin ("create-window");
 	window = GEDIT_APP_GET_CLASS (app)->create_window (app);
+	gedit_startup_trace_end ("create-window");
+
+	if (gedit_plugins_engine_has_deferred_trigger (priv->engine, "idle"))
+	{
+		g_signal_connect (window,
+		                  "map-event",
+		                  G_CALLBACK (window_map_event),
+		                  NULL);
+	}
+
+	/* The trace ends when the first window is shown with its documents */
+	if (gedit_startup_trace_is_enabled ())
+	{
+		g_signal_connect (window,
+		                  "map-event",
+		                  G_CALLBACK (trace_window_map_event),
+		                  NULL);
+
+		g_signal_connect (window,
+		                  "notify::state",
+		                  G_CALLBACK (trace_window_state_changed),
+		                  NULL);
+	}
 
 	if (screen != NULL)
 	{
@@ -114,7 +114,8 @@ load_file_list (GeditWindow             *window,
 		const GtkSourceEncoding *encoding,
 		gint                     line_pos,
 		gint                     column_pos,
-		gboolean                 create)
+		gboolean                 create,
+		gboolean                 defer)
 {
 	GList *win_docs;
 	GSList *files_to_load = NULL;
@@ -220,13 +221,29 @@ load_file_list (GeditWindow             *window,
 	{
 		g_return_val_if_fail (l->data != NULL, NULL);
 
-		tab = gedit_window_create_tab_from_location (window,
-							     l->data,
-							     encoding,
-							     line_pos,
-							     column_pos,
-							     create,
-							     jump_to);
+		/* When @defer is set, only the tab that is shown is loaded
+		 * right away, the other ones are loaded when they are shown
+		 * for the first time.
+		 */
+		if (jump_to || !defer)
+		{
+			tab = gedit_window_create_tab_from_location (window,
+								     l->data,
+								     encoding,
+								     line_pos,
+								     column_pos,
+								     create,
+								     jump_to);
+		}
+		else
+		{
+			tab = _gedit_window_create_deferred_tab_from_location (window,
+									       l->data,
+									       encoding,
+									       line_pos,
+									       column_pos,
+									       create);
+		}
 
 		if (tab != NULL)
 		{
@@ -305,7 +322,7 @@ gedit_commands_load_location (GeditWindow             *window,
 
 	locations = g_slist_prepend (locations, location);
 
-	ret = load_file_list (window, locations, encoding, line_pos, column_pos, FALSE);
+	ret = load_file_list (window, locations, encoding, line_pos, column_pos, FALSE, FALSE);
 	g_slist_free (ret);
 
 	g_slist_free (locations);
@@ -336,7 +353,28 @@ gedit_commands_load_locations (GeditWindow             *window,
 
 	gedit_debug (DEBUG_COMMANDS);
 
-	return load_file_list (window, locations, encoding, line_pos, column_pos, FALSE);
+	return load_file_list (window, locations, encoding, line_pos, column_pos, FALSE, FALSE);
+}
+
+/*
+ * Like gedit_commands_load_locations(), but only the first document is
+ * loaded right away. The tabs of the other ones are in the
+ * GEDIT_TAB_STATE_DEFERRED state until they are shown. Used when the user
+ * opens several files at once.
+ */
+GSList *
+_gedit_cmd_load_locations_deferred (GeditWindow             *window,
+				    const GSList            *locations,
+				    const GtkSourceEncoding *encoding,
+				    gint                     line_pos,
+				    gint                     column_pos)
+{
+	g_return_val_if_fail (GEDIT_IS_WINDOW (window), NULL);
+	g_return_val_if_fail (locations != NULL && locations->data != NULL, NULL);
+
+	gedit_debug (DEBUG_COMMANDS);
+
+	return load_file_list (window, locations, encoding, line_pos, column_pos, FALSE, TRUE);
 }
 
 /*
@@ -353,7 +391,7 @@ _gedit_cmd_load_files_from_prompt (GeditWindow             *window,
 {
 	gedit_debug (DEBUG_COMMANDS);
 
-	return load_file_list (window, files, encoding, line_pos, column_pos, TRUE);
+	return load_file_list (window, files, encoding, line_pos, column_pos, TRUE, TRUE);
 }
 
 static void
@@ -391,7 +429,7 @@ file_chooser_open_done_cb (GeditFileChooserOpen *file_chooser,
 	_gedit_window_set_file_chooser_folder_uri (window, GTK_FILE_CHOOSER_ACTION_OPEN, folder_uri);
 	g_free (folder_uri);
 
-	loaded_documents = gedit_commands_load_locations (window, files, encoding, 0, 0);
+	loaded_documents = _gedit_cmd_load_locations_deferred (window, files, encoding, 0, 0);
 
 	g_slist_free (loaded_documents);
 	g_slist_free_full (files, g_object_unref);
@@ -1643,6 +1681,7 @@ save_and_close_documents (GList         *docs,
 		/* If the state is: ([*] invalid states)
 		   - GEDIT_TAB_STATE_NORMAL: close (and if needed save)
 		   - GEDIT_TAB_STATE_LOADING: close, we are sure the file is unmodified
+		   - GEDIT_TAB_STATE_DEFERRED: close, the file is not even loaded
 		   - GEDIT_TAB_STATE_REVERTING: since the user wants
 		     to return back to the version of the file she previously saved, we can close
 		     without saving (CHECK: are we sure this is the right behavior, suppose the case
@@ -37,6 +37,13 @@ GSList	       *_gedit_cmd_load_files_from_prompt	(GeditWindow             *windo
 							 gint                     line_pos,
 							 gint                     column_pos) G_GNUC_WARN_UNUSED_RESULT;
 
+/* Only the first document is loaded right away */
+GSList	       *_gedit_cmd_load_locations_deferred	(GeditWindow             *window,
+							 const GSList            *locations,
+							 const GtkSourceEncoding *encoding,
+							 gint                     line_pos,
+							 gint                     column_pos) G_GNUC_WARN_UNUSED_RESULT;
+
 void		_gedit_cmd_file_new			(GSimpleAction *action,
 							 GVariant      *parameter,
 							 gpointer       user_data);
@@ -39,10 +39,22 @@
 #include "gedit-window.h"
 #include "gedit-window-private.h"
 #include "gedit-utils.h"
+#include "gedit-replace-all.h"
 #include "gedit-replace-dialog.h"
 
 #define GEDIT_REPLACE_DIALOG_KEY	"gedit-replace-dialog-key"
 #define GEDIT_LAST_SEARCH_DATA_KEY	"gedit-last-search-data-key"
+#define GEDIT_REPLACE_ALL_CANCELLABLE_KEY	"gedit-replace-all-cancellable-key"
+
+typedef struct _ReplaceAllOperation ReplaceAllOperation;
+struct _ReplaceAllOperation
+{
+	/* Weak pointers. */
+	GeditWindow *window;
+	GeditReplaceDialog *dialog;
+
+	GtkSourceCompletion *completion;
+};
 
 typedef struct _LastSearchData LastSearchData;
 struct _LastSearchData
@@ -441,6 +453,118 @@ do_replace (GeditReplaceDialog *dialog,
 	do_find (dialog, window);
 }
 
+static void
+replace_all_operation_free (ReplaceAllOperation *op)
+{
+	if (op->window != NULL)
+	{
+		g_object_remove_weak_pointer (G_OBJECT (op->window), (gpointer *) &op->window);
+	}
+
+	if (op->dialog != NULL)
+	{
+		g_object_remove_weak_pointer (G_OBJECT (op->dialog), (gpointer *) &op->dialog);
+	}
+
+	gtk_source_completion_unblock_interactive (op->completion);
+	g_object_unref (op->completion);
+
+	g_slice_free (ReplaceAllOperation, op);
+}
+
+static void
+cancel_replace_all (GCancellable *cancellable)
+{
+	g_cancellable_cancel (cancellable);
+	g_object_unref (cancellable);
+}
+
+static void
+replace_all_progress_cb (guint                n_replaced,
+			 guint                n_matches,
+			 ReplaceAllOperation *op)
+{
+	if (op->window == NULL)
+	{
+		return;
+	}
+
+	gedit_statusbar_flash_message (GEDIT_STATUSBAR (op->window->priv->statusbar),
+				       op->window->priv->generic_message_cid,
+				       ngettext ("Replaced %u of %u occurrence",
+						 "Replaced %u of %u occurrences",
+						 n_matches),
+				       n_replaced,
+				       n_matches);
+}
+
+static void
+replace_all_finished_cb (GObject             *source_object,
+			 GAsyncResult        *result,
+			 ReplaceAllOperation *op)
+{
+	gint count;
+	guint n_replaced = 0;
+	GError *error = NULL;
+
+	count = gedit_replace_all_finish (result, &n_replaced, &error);
+
+	if (op->dialog != NULL)
+	{
+		gedit_replace_dialog_set_replace_all_running (op->dialog, FALSE);
+		g_object_set_data (G_OBJECT (op->dialog), GEDIT_REPLACE_ALL_CANCELLABLE_KEY, NULL);
+	}
+
+	if (op->window == NULL || op->dialog == NULL)
+	{
+		g_clear_error (&error);
+		replace_all_operation_free (op);
+		return;
+	}
+
+	if (count > 0)
+	{
+		text_found (op->window, count);
+	}
+	else if (error == NULL)
+	{
+		text_not_found (op->window, op->dialog);
+	}
+	else if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		text_found (op->window, n_replaced);
+	}
+	else if (error->domain == G_REGEX_ERROR)
+	{
+		gedit_replace_dialog_set_replace_error (op->dialog, error->message);
+	}
+	else
+	{
+		gedit_statusbar_flash_message (GEDIT_STATUSBAR (op->window->priv->statusbar),
+					       op->window->priv->generic_message_cid,
+					       "%s", error->message);
+	}
+
+	g_clear_error (&error);
+	replace_all_operation_free (op);
+}
+
+static void
+cancel_running_replace_all (GeditReplaceDialog *dialog)
+{
+	GCancellable *cancellable;
+
+	cancellable = g_object_get_data (G_OBJECT (dialog), GEDIT_REPLACE_ALL_CANCELLABLE_KEY);
+
+	if (cancellable != NULL)
+	{
+		g_cancellable_cancel (cancellable);
+	}
+}
+
+/* The occurrences are searched in a thread and replaced in batches on the main
+ * loop. The Replace All response stops it while it is running.
+ */
 static void
 do_replace_all (GeditReplaceDialog *dialog,
 		GeditWindow        *window)
@@ -451,8 +575,14 @@ do_replace_all (GeditReplaceDialog *dialog,
 	GtkSourceCompletion *completion;
 	const gchar *replace_entry_text;
 	gchar *unescaped_replace_text;
-	gint count;
-	GError *error = NULL;
+	GCancellable *cancellable;
+	ReplaceAllOperation *op;
+
+	if (gedit_replace_dialog_get_replace_all_running (dialog))
+	{
+		cancel_running_replace_all (dialog);
+		return;
+	}
 
 	view = gedit_window_get_active_view (window);
 
@@ -470,41 +600,46 @@ do_replace_all (GeditReplaceDialog *dialog,
 		return;
 	}
 
+	/* replace text may be "", we just delete all occurrences */
+	replace_entry_text = gedit_replace_dialog_get_replace_text (dialog);
+	g_return_if_fail (replace_entry_text != NULL);
+
 	/* FIXME: this should really be done automatically in gtksoureview, but
 	 * it is an important performance fix, so let's do it here for now.
 	 */
 	completion = gtk_source_view_get_completion (GTK_SOURCE_VIEW (view));
 	gtk_source_completion_block_interactive (completion);
 
-	/* replace text may be "", we just delete all occurrences */
-	replace_entry_text = gedit_replace_dialog_get_replace_text (dialog);
-	g_return_if_fail (replace_entry_text != NULL);
+	op = g_slice_new0 (ReplaceAllOperation);
+	op->completion = g_object_ref (completion);
 
-	unescaped_replace_text = gtk_source_utils_unescape_search_text (replace_entry_text);
+	op->window = window;
+	g_object_add_weak_pointer (G_OBJECT (window), (gpointer *) &op->window);
 
-	count = gtk_source_search_context_replace_all (search_context,
-						       unescaped_replace_text,
-						       -1,
-						       &error);
+	op->dialog = dialog;
+	g_object_add_weak_pointer (G_OBJECT (dialog), (gpointer *) &op->dialog);
 
-	g_free (unescaped_replace_text);
+	/* Destroying the dialog cancels the operation. */
+	cancellable = g_cancellable_new ();
+	g_object_set_data_full (G_OBJECT (dialog),
+				GEDIT_REPLACE_ALL_CANCELLABLE_KEY,
+				g_object_ref (cancellable),
+				(GDestroyNotify) cancel_replace_all);
 
-	gtk_source_completion_unblock_interactive (completion);
+	gedit_replace_dialog_set_replace_all_running (dialog, TRUE);
 
-	if (count > 0)
-	{
-		text_found (window, count);
-	}
-	else if (error == NULL)
-	{
-		text_not_found (window, dialog);
-	}
+	unescaped_replace_text = gtk_source_utils_unescape_search_text (replace_entry_text);
 
-	if (error != NULL)
-	{
-		gedit_replace_dialog_set_replace_error (dialog, error->message);
-		g_error_free (error);
-	}
+	gedit_replace_all_async (search_context,
+				 unescaped_replace_text,
+				 cancellable,
+				 (GeditReplaceAllProgressCallback) replace_all_progress_cb,
+				 op,
+				 (GAsyncReadyCallback) replace_all_finished_cb,
+				 op);
+
+	g_free (unescaped_replace_text);
+	g_object_unref (cancellable);
 }
 
 static void
@@ -529,6 +664,8 @@ replace_dialog_response_cb (GeditReplaceDialog *dialog,
 			break;
 
 		default:
+			/* The dialog is only hidden, it would not cancel it. */
+			cancel_running_replace_all (dialog);
 			last_search_data_store_position (dialog);
 			gtk_widget_hide (GTK_WIDGET (dialog));
 	}
@@ -48,6 +48,10 @@ void		_gedit_document_set_create				(GeditDocument *doc,
 G_GNUC_INTERNAL
 gboolean	_gedit_document_get_create				(GeditDocument *doc);
 
+G_GNUC_INTERNAL
+void		_gedit_document_set_deferred				(GeditDocument *doc,
+									 gboolean       deferred);
+
 G_GNUC_INTERNAL
 gchar *		_gedit_document_get_uri_for_display			(GeditDocument *doc);
 
@@ -66,6 +66,11 @@ typedef struct
 	 * when opened from the command line).
 	 */
 	guint create : 1;
+
+	/* The file is not loaded yet, the tab of the document is in the
+	 * GEDIT_TAB_STATE_DEFERRED state.
+	 */
+	guint deferred : 1;
 } GeditDocumentPrivate;
 
 enum
@@ -161,6 +166,21 @@ save_metadata (GeditDocument *doc)
 		language = get_language_string (doc);
 	}
 
+	/* The file was never loaded, so the position saved previously must
+	 * be kept.
+	 */
+	if (priv->deferred)
+	{
+		if (language != NULL)
+		{
+			gedit_document_set_metadata (doc,
+						     GEDIT_METADATA_ATTRIBUTE_LANGUAGE, language,
+						     NULL);
+		}
+
+		return;
+	}
+
 	gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (doc),
 					  &iter,
 					  gtk_text_buffer_get_insert (GTK_TEXT_BUFFER (doc)));
@@ -1401,4 +1421,17 @@ _gedit_document_get_create (GeditDocument *doc)
 	return priv->create;
 }
 
+void
+_gedit_document_set_deferred (GeditDocument *doc,
+			      gboolean       deferred)
+{
+	GeditDocumentPrivate *priv;
+
+	g_return_if_fail (GEDIT_IS_DOCUMENT (doc));
+
+	priv = gedit_document_get_instance_private (doc);
+
+	priv->deferred = deferred != FALSE;
+}
+
 /* ex:set ts=8 noet: */
@@ -0,0 +1,420 @@
+/*
+ * gedit-encoding-detector.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-encoding-detector.h"
+
+#include <string.h>
+
+#include "gedit-debug.h"
+
+/* GtkSourceFileLoader tries the candidate encodings one after the other on
+ * the whole file: when the first candidates are wrong, the file is read and
+ * converted several times. To avoid that, a few samples of the file are read
+ * in a worker thread, and the candidates are checked on those samples only.
+ * The file loader can then be given the right encoding first, so that the
+ * file is converted only once.
+ *
+ * Like the file loader, the first candidate that is valid wins. The samples
+ * are: the beginning, the middle and the end of the file. Multi-byte
+ * encodings other than UTF-8 are only checked on the beginning, since the
+ * other samples can start in the middle of a character.
+ */
+
+#define SAMPLE_SIZE (64 * 1024)
+#define N_SAMPLES 3
+
+typedef struct
+{
+	guchar *data;
+	gsize length;
+
+	/* Whether the sample is at the beginning or at the end of the file,
+	 * i.e. whether a character can be cut at the sample boundaries.
+	 */
+	guint at_start : 1;
+	guint at_end : 1;
+} Sample;
+
+typedef struct
+{
+	GFile *location;
+	GSList *candidates;
+
+	Sample samples[N_SAMPLES];
+	guint n_samples;
+
+	gint64 elapsed_usec;
+} DetectionData;
+
+static void
+detection_data_free (DetectionData *data)
+{
+	if (data != NULL)
+	{
+		guint i;
+
+		for (i = 0; i < data->n_samples; i++)
+		{
+			g_free (data->samples[i].data);
+		}
+
+		g_clear_object (&data->location);
+		g_slist_free (data->candidates);
+
+		g_slice_free (DetectionData, data);
+	}
+}
+
+static gboolean
+read_sample (GInputStream  *stream,
+	     goffset        offset,
+	     goffset        file_size,
+	     Sample        *sample,
+	     GCancellable  *cancellable,
+	     GError       **error)
+{
+	gsize bytes_read = 0;
+
+	if (offset > 0 &&
+	    !g_seekable_seek (G_SEEKABLE (stream), offset, G_SEEK_SET, cancellable, error))
+	{
+		return FALSE;
+	}
+
+	sample->data = g_malloc (SAMPLE_SIZE);
+
+	if (!g_input_stream_read_all (stream,
+				      sample->data,
+				      SAMPLE_SIZE,
+				      &bytes_read,
+				      cancellable,
+				      error))
+	{
+		g_clear_pointer (&sample->data, g_free);
+		return FALSE;
+	}
+
+	sample->length = bytes_read;
+	sample->at_start = offset == 0;
+	sample->at_end = bytes_read < SAMPLE_SIZE || offset + (goffset) bytes_read >= file_size;
+
+	return TRUE;
+}
+
+static gboolean
+read_samples (DetectionData  *data,
+	      GCancellable   *cancellable,
+	      GError        **error)
+{
+	GFileInputStream *stream;
+	GFileInfo *info;
+	goffset file_size;
+	gboolean ok = TRUE;
+
+	stream = g_file_read (data->location, cancellable, error);
+
+	if (stream == NULL)
+	{
+		return FALSE;
+	}
+
+	info = g_file_input_stream_query_info (stream,
+					       G_FILE_ATTRIBUTE_STANDARD_SIZE,
+					       cancellable,
+					       NULL);
+
+	file_size = info != NULL ? g_file_info_get_size (info) : 0;
+	g_clear_object (&info);
+
+	ok = read_sample (G_INPUT_STREAM (stream), 0, file_size,
+			  &data->samples[data->n_samples++],
+			  cancellable, error);
+
+	if (ok &&
+	    file_size > N_SAMPLES * SAMPLE_SIZE &&
+	    g_seekable_can_seek (G_SEEKABLE (stream)))
+	{
+		ok = read_sample (G_INPUT_STREAM (stream), file_size / 2, file_size,
+				  &data->samples[data->n_samples++],
+				  cancellable, error);
+
+		if (ok)
+		{
+			ok = read_sample (G_INPUT_STREAM (stream), file_size - SAMPLE_SIZE, file_size,
+					  &data->samples[data->n_samples++],
+					  cancellable, error);
+		}
+	}
+
+	g_object_unref (stream);
+	return ok;
+}
+
+/* Counts the bytes with the high bit set and the NUL bytes. The loop has no
+ * branches, so that the compiler can vectorize it.
+ */
+static void
+count_bytes (const guchar *bytes,
+	     gsize         length,
+	     gsize        *n_high,
+	     gsize        *n_nul)
+{
+	gsize high = 0;
+	gsize nul = 0;
+	gsize i;
+
+	for (i = 0; i < length; i++)
+	{
+		high += bytes[i] >> 7;
+		nul += bytes[i] == 0;
+	}
+
+	*n_high += high;
+	*n_nul += nul;
+}
+
+static gboolean
+is_utf8_continuation_byte (guchar byte)
+{
+	return (byte & 0xc0) == 0x80;
+}
+
+static gboolean
+sample_is_valid_utf8 (const Sample *sample)
+{
+	const gchar *start = (const gchar *) sample->data;
+	const gchar *end = start + sample->length;
+	const gchar *invalid;
+	gint i;
+
+	/* Skip a character cut at the beginning of the sample. */
+	for (i = 0; !sample->at_start && i < 3 && start < end; i++)
+	{
+		if (!is_utf8_continuation_byte (*start))
+		{
+			break;
+		}
+
+		start++;
+	}
+
+	if (g_utf8_validate (start, end - start, &invalid))
+	{
+		return TRUE;
+	}
+
+	/* A character cut at the end of the sample is not an error. */
+	return (!sample->at_end &&
+		end - invalid < 4 &&
+		g_utf8_get_char_validated (invalid, end - invalid) == (gunichar) -2);
+}
+
+static gboolean
+sample_can_be_converted (const Sample            *sample,
+			 const GtkSourceEncoding *encoding)
+{
+	gchar *converted;
+	GError *error = NULL;
+
+	converted = g_convert ((const gchar *) sample->data,
+			       sample->length,
+			       "UTF-8",
+			       gtk_source_encoding_get_charset (encoding),
+			       NULL,
+			       NULL,
+			       &error);
+
+	g_free (converted);
+
+	if (error == NULL)
+	{
+		return TRUE;
+	}
+
+	if (!sample->at_end &&
+	    g_error_matches (error, G_CONVERT_ERROR, G_CONVERT_ERROR_PARTIAL_INPUT))
+	{
+		g_error_free (error);
+		return TRUE;
+	}
+
+	g_error_free (error);
+	return FALSE;
+}
+
+static gboolean
+candidate_is_valid (DetectionData           *data,
+		    const GtkSourceEncoding *encoding)
+{
+	guint i;
+
+	if (encoding == gtk_source_encoding_get_utf8 ())
+	{
+		for (i = 0; i < data->n_samples; i++)
+		{
+			if (!sample_is_valid_utf8 (&data->samples[i]))
+			{
+				return FALSE;
+			}
+		}
+
+		return TRUE;
+	}
+
+	return sample_can_be_converted (&data->samples[0], encoding);
+}
+
+static const GtkSourceEncoding *
+detect_encoding (DetectionData *data)
+{
+	const GtkSourceEncoding *utf8 = gtk_source_encoding_get_utf8 ();
+	gsize n_high = 0;
+	gsize n_nul = 0;
+	const GSList *l;
+	guint i;
+
+	for (i = 0; i < data->n_samples; i++)
+	{
+		count_bytes (data->samples[i].data,
+			     data->samples[i].length,
+			     &n_high,
+			     &n_nul);
+	}
+
+	/* Probably UTF-16 or a binary file, let the file loader deal with
+	 * it.
+	 */
+	if (n_nul > 0)
+	{
+		return NULL;
+	}
+
+	/* Pure ASCII. */
+	if (n_high == 0 && g_slist_find (data->candidates, utf8) != NULL)
+	{
+		return utf8;
+	}
+
+	for (l = data->candidates; l != NULL; l = l->next)
+	{
+		const GtkSourceEncoding *encoding = l->data;
+
+		if (candidate_is_valid (data, encoding))
+		{
+			return encoding;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+detection_thread (GTask        *task,
+		  gpointer      source_object,
+		  gpointer      task_data,
+		  GCancellable *cancellable)
+{
+	DetectionData *data = task_data;
+	const GtkSourceEncoding *encoding;
+	gint64 start_time;
+	GError *error = NULL;
+
+	start_time = g_get_monotonic_time ();
+
+	if (!read_samples (data, cancellable, &error))
+	{
+		g_task_return_error (task, error);
+		return;
+	}
+
+	encoding = detect_encoding (data);
+	data->elapsed_usec = g_get_monotonic_time () - start_time;
+
+	gedit_debug_message (DEBUG_TAB, "Detected encoding: %s (%" G_GINT64_FORMAT " µs)",
+			     encoding != NULL ? gtk_source_encoding_get_charset (encoding) : "none",
+			     data->elapsed_usec);
+
+	g_task_return_pointer (task, (gpointer) encoding, NULL);
+}
+
+/*
+ * gedit_encoding_detect_async:
+ * @location: the #GFile to analyze.
+ * @candidates: (element-type GtkSourceEncoding): the candidate encodings, in
+ *   order of preference.
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the request is
+ *   satisfied.
+ * @user_data: user data to pass to @callback.
+ *
+ * Finds, in a worker thread, the first encoding of @candidates that is valid
+ * for samples of @location.
+ */
+void
+gedit_encoding_detect_async (GFile               *location,
+			     const GSList        *candidates,
+			     GCancellable        *cancellable,
+			     GAsyncReadyCallback  callback,
+			     gpointer             user_data)
+{
+	GTask *task;
+	DetectionData *data;
+
+	g_return_if_fail (G_IS_FILE (location));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+
+	data = g_slice_new0 (DetectionData);
+	data->location = g_object_ref (location);
+	data->candidates = g_slist_copy ((GSList *) candidates);
+	g_task_set_task_data (task, data, (GDestroyNotify) detection_data_free);
+
+	g_task_run_in_thread (task, detection_thread);
+	g_object_unref (task);
+}
+
+/*
+ * gedit_encoding_detect_finish:
+ * @result: a #GAsyncResult.
+ * @elapsed_usec: (out) (optional): the time spent to read the samples and to
+ *   check the candidates, in microseconds.
+ * @error: a location for a #GError, or %NULL.
+ *
+ * Returns: (nullable): the detected encoding, or %NULL if no candidate
+ * matched or on error.
+ */
+const GtkSourceEncoding *
+gedit_encoding_detect_finish (GAsyncResult  *result,
+			      gint64        *elapsed_usec,
+			      GError       **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+	if (elapsed_usec != NULL)
+	{
+		DetectionData *data = g_task_get_task_data (G_TASK (result));
+		*elapsed_usec = data->elapsed_usec;
+	}
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,42 @@
+/*
+ * gedit-encoding-detector.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_ENCODING_DETECTOR_H
+#define GEDIT_ENCODING_DETECTOR_H
+
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+void				 gedit_encoding_detect_async	(GFile                *location,
+								 const GSList         *candidates,
+								 GCancellable         *cancellable,
+								 GAsyncReadyCallback   callback,
+								 gpointer              user_data);
+
+const GtkSourceEncoding		*gedit_encoding_detect_finish	(GAsyncResult         *result,
+								 gint64               *elapsed_usec,
+								 GError              **error);
+
+G_END_DECLS
+
+#endif /* GEDIT_ENCODING_DETECTOR_H */
+
+/* ex:set ts=8 noet: */
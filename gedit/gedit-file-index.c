@@ -0,0 +1,1113 @@
+/*
+ * gedit-file-index.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-file-index.h"
+
+#include <string.h>
+
+#include "gedit-debug.h"
+
+/**
+ * SECTION:gedit-file-index
+ * @short_description: fuzzy file finder
+ * @include: gedit/gedit-file-index.h
+ *
+ * A #GeditFileIndex lists once, in a thread, all the files below a
+ * directory, and then finds the files whose path contains the characters
+ * of a query in order, like "gfi" for "gedit/gedit-file-index.c".
+ *
+ * The paths are kept lowercased, with a bitmask of the characters that
+ * they contain. Most of the paths are rejected by comparing their bitmask
+ * with the one of the query, the others with memchr(). The paths are
+ * split between several threads when there are a lot of them. When a
+ * query extends the previous one, only the paths that matched the previous
+ * query are looked at again.
+ */
+
+/* The hidden files and directories are not listed. */
+#define INDEX_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+			 G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+			 G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK "," \
+			 G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+			 G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP
+
+#define MAX_FILES 300000
+
+/* Under this number of paths, a query is done by a single thread. */
+#define MIN_PATHS_PER_THREAD 16384
+#define MAX_THREADS 8
+
+#define CANCEL_CHECK_INTERVAL 4096
+
+#define SCORE_MATCH 16
+#define BONUS_BOUNDARY 24
+#define BONUS_CAMEL_CASE 16
+#define BONUS_CONSECUTIVE 12
+#define BONUS_BASENAME 8
+#define MAX_GAP_PENALTY 8
+
+typedef struct
+{
+	gchar *path;
+
+	/* The path with the ASCII letters lowercased */
+	gchar *lower;
+
+	/* The characters in @lower, see char_bit() */
+	guint64 mask;
+
+	guint length;
+	guint basename;
+} Entry;
+
+typedef struct
+{
+	gint ref_count;
+	GArray *entries;
+} Snapshot;
+
+typedef struct
+{
+	gint score;
+	guint index;
+} Match;
+
+struct _GeditFileIndex
+{
+	GObject parent_instance;
+
+	GFile *root;
+
+	GMutex mutex;
+	Snapshot *snapshot;
+
+	/* The matches of the last query, in the order of the entries */
+	gchar *last_query;
+	Snapshot *last_snapshot;
+	GArray *last_matches;
+};
+
+typedef struct
+{
+	const Snapshot *snapshot;
+	const gchar *query;
+	gsize query_length;
+	guint64 query_mask;
+
+	/* The indexes of the entries to look at, or NULL for all */
+	const guint *candidates;
+	guint start;
+	guint end;
+
+	guint max_results;
+	GCancellable *cancellable;
+
+	GArray *matches;
+	GArray *top;
+} Worker;
+
+typedef struct
+{
+	gchar *query;
+	guint max_results;
+} QueryData;
+
+enum
+{
+	PROP_0,
+	PROP_ROOT,
+	LAST_PROP
+};
+
+static GParamSpec *properties[LAST_PROP];
+
+G_DEFINE_TYPE (GeditFileIndex, gedit_file_index, G_TYPE_OBJECT)
+
+static guint
+char_bit (guchar c)
+{
+	if (c >= 'a' && c <= 'z')
+	{
+		return c - 'a';
+	}
+
+	if (c >= '0' && c <= '9')
+	{
+		return 26 + c - '0';
+	}
+
+	if (c >= 0x80)
+	{
+		return 36;
+	}
+
+	return 37 + c % 27;
+}
+
+static guint64
+string_mask (const gchar *str,
+	     gsize        length)
+{
+	guint64 mask = 0;
+	gsize i;
+
+	for (i = 0; i < length; i++)
+	{
+		mask |= G_GUINT64_CONSTANT (1) << char_bit (str[i]);
+	}
+
+	return mask;
+}
+
+static gboolean
+is_separator (gchar c)
+{
+	return c == '/' || c == '_' || c == '-' || c == '.' || c == ' ';
+}
+
+static void
+entry_init (Entry       *entry,
+	    const gchar *path)
+{
+	const gchar *slash;
+
+	entry->path = g_strdup (path);
+	entry->lower = g_ascii_strdown (path, -1);
+	entry->length = strlen (path);
+	entry->mask = string_mask (entry->lower, entry->length);
+
+	slash = strrchr (path, '/');
+	entry->basename = slash != NULL ? slash - path + 1 : 0;
+}
+
+static void
+entry_clear (Entry *entry)
+{
+	g_free (entry->path);
+	g_free (entry->lower);
+}
+
+static Snapshot *
+snapshot_ref (Snapshot *snapshot)
+{
+	g_atomic_int_inc (&snapshot->ref_count);
+	return snapshot;
+}
+
+static void
+snapshot_unref (Snapshot *snapshot)
+{
+	if (snapshot != NULL && g_atomic_int_dec_and_test (&snapshot->ref_count))
+	{
+		g_array_unref (snapshot->entries);
+		g_slice_free (Snapshot, snapshot);
+	}
+}
+
+/* Lowercases the ASCII letters and removes the spaces. */
+static gchar *
+normalize_query (const gchar *query)
+{
+	GString *normalized = g_string_new (NULL);
+
+	for (; *query != '\0'; query++)
+	{
+		if (*query != ' ')
+		{
+			g_string_append_c (normalized, g_ascii_tolower (*query));
+		}
+	}
+
+	return g_string_free (normalized, FALSE);
+}
+
+static gboolean
+entry_contains (const Entry *entry,
+		const gchar *query,
+		gsize        query_length)
+{
+	const gchar *p = entry->lower;
+	const gchar *end = entry->lower + entry->length;
+	gsize i;
+
+	for (i = 0; i < query_length; i++)
+	{
+		p = memchr (p, query[i], end - p);
+
+		if (p == NULL)
+		{
+			return FALSE;
+		}
+
+		p++;
+	}
+
+	return TRUE;
+}
+
+/* The characters of the query are matched from the end of the path, so
+ * that the matches in the basename are preferred. Must only be called if
+ * the entry contains the query.
+ */
+static gint
+entry_score (const Entry *entry,
+	     const gchar *query,
+	     gsize        query_length,
+	     guint       *positions)
+{
+	gint pos = entry->length - 1;
+	gint next = -1;
+	gint score = 0;
+	gint q;
+
+	for (q = query_length - 1; q >= 0; q--)
+	{
+		while (pos >= 0 && entry->lower[pos] != query[q])
+		{
+			pos--;
+		}
+
+		g_return_val_if_fail (pos >= 0, G_MININT);
+
+		score += SCORE_MATCH;
+
+		if (pos == 0 || is_separator (entry->lower[pos - 1]))
+		{
+			score += BONUS_BOUNDARY;
+		}
+		else if (g_ascii_isupper (entry->path[pos]) &&
+			 !g_ascii_isupper (entry->path[pos - 1]))
+		{
+			score += BONUS_CAMEL_CASE;
+		}
+
+		if (next == pos + 1)
+		{
+			score += BONUS_CONSECUTIVE;
+		}
+		else if (next != -1)
+		{
+			score -= MIN (next - pos - 1, MAX_GAP_PENALTY);
+		}
+
+		if ((guint) pos >= entry->basename)
+		{
+			score += BONUS_BASENAME;
+		}
+
+		if (positions != NULL)
+		{
+			positions[q] = pos;
+		}
+
+		next = pos;
+		pos--;
+	}
+
+	/* The shorter paths first */
+	return score - entry->length / 8;
+}
+
+/* Whether @a is a worse match than @b. */
+static gboolean
+match_worse (const Snapshot *snapshot,
+	     const Match    *a,
+	     const Match    *b)
+{
+	const Entry *entry_a;
+	const Entry *entry_b;
+
+	if (a->score != b->score)
+	{
+		return a->score < b->score;
+	}
+
+	entry_a = &g_array_index (snapshot->entries, Entry, a->index);
+	entry_b = &g_array_index (snapshot->entries, Entry, b->index);
+
+	if (entry_a->length != entry_b->length)
+	{
+		return entry_a->length > entry_b->length;
+	}
+
+	return a->index > b->index;
+}
+
+/* @top is a min-heap of the best matches, with the worst one first. */
+static void
+top_push (const Snapshot *snapshot,
+	  GArray         *top,
+	  guint           max_results,
+	  const Match    *match)
+{
+	Match *heap;
+	guint i;
+
+	if (top->len < max_results)
+	{
+		g_array_append_val (top, *match);
+		heap = (Match *) top->data;
+
+		for (i = top->len - 1; i > 0; i = (i - 1) / 2)
+		{
+			Match tmp;
+
+			if (!match_worse (snapshot, &heap[i], &heap[(i - 1) / 2]))
+			{
+				break;
+			}
+
+			tmp = heap[i];
+			heap[i] = heap[(i - 1) / 2];
+			heap[(i - 1) / 2] = tmp;
+		}
+
+		return;
+	}
+
+	heap = (Match *) top->data;
+
+	if (top->len == 0 || !match_worse (snapshot, &heap[0], match))
+	{
+		return;
+	}
+
+	heap[0] = *match;
+	i = 0;
+
+	for (;;)
+	{
+		guint smallest = i;
+		guint left = 2 * i + 1;
+		guint right = 2 * i + 2;
+		Match tmp;
+
+		if (left < top->len && match_worse (snapshot, &heap[left], &heap[smallest]))
+		{
+			smallest = left;
+		}
+
+		if (right < top->len && match_worse (snapshot, &heap[right], &heap[smallest]))
+		{
+			smallest = right;
+		}
+
+		if (smallest == i)
+		{
+			break;
+		}
+
+		tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+static gpointer
+worker_run (Worker *worker)
+{
+	guint i;
+
+	for (i = worker->start; i < worker->end; i++)
+	{
+		guint index = worker->candidates != NULL ? worker->candidates[i] : i;
+		const Entry *entry = &g_array_index (worker->snapshot->entries, Entry, index);
+		Match match;
+
+		if ((i - worker->start) % CANCEL_CHECK_INTERVAL == 0 &&
+		    g_cancellable_is_cancelled (worker->cancellable))
+		{
+			break;
+		}
+
+		if ((worker->query_mask & ~entry->mask) != 0 ||
+		    entry->length < worker->query_length ||
+		    !entry_contains (entry, worker->query, worker->query_length))
+		{
+			continue;
+		}
+
+		g_array_append_val (worker->matches, index);
+
+		match.score = entry_score (entry, worker->query, worker->query_length, NULL);
+		match.index = index;
+		top_push (worker->snapshot, worker->top, worker->max_results, &match);
+	}
+
+	return NULL;
+}
+
+static gint
+compare_matches (gconstpointer a,
+		 gconstpointer b,
+		 gpointer      user_data)
+{
+	const Snapshot *snapshot = user_data;
+
+	if (match_worse (snapshot, a, b))
+	{
+		return 1;
+	}
+
+	if (match_worse (snapshot, b, a))
+	{
+		return -1;
+	}
+
+	return 0;
+}
+
+static void
+query_thread (GTask        *task,
+	      gpointer      source_object,
+	      gpointer      task_data,
+	      GCancellable *cancellable)
+{
+	GeditFileIndex *index = source_object;
+	QueryData *data = task_data;
+	Snapshot *snapshot = NULL;
+	GArray *candidates = NULL;
+	GArray *matches;
+	GArray *top;
+	Worker *workers;
+	GThread **threads;
+	gchar *query;
+	gsize query_length;
+	guint64 query_mask;
+	guint n_candidates;
+	guint n_threads;
+	GPtrArray *paths;
+	gint64 start_time = g_get_monotonic_time ();
+	guint i;
+
+	query = normalize_query (data->query);
+	query_length = strlen (query);
+	query_mask = string_mask (query, query_length);
+
+	g_mutex_lock (&index->mutex);
+
+	if (index->snapshot != NULL)
+	{
+		snapshot = snapshot_ref (index->snapshot);
+
+		if (index->last_query != NULL &&
+		    index->last_snapshot == snapshot &&
+		    g_str_has_prefix (query, index->last_query))
+		{
+			candidates = g_array_ref (index->last_matches);
+		}
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	if (snapshot == NULL || query_length == 0)
+	{
+		snapshot_unref (snapshot);
+		g_free (query);
+		g_task_return_pointer (task, g_new0 (gchar *, 1), (GDestroyNotify) g_strfreev);
+		return;
+	}
+
+	n_candidates = candidates != NULL ? candidates->len : snapshot->entries->len;
+	n_threads = CLAMP (n_candidates / MIN_PATHS_PER_THREAD, 1, MIN (g_get_num_processors (), MAX_THREADS));
+
+	workers = g_new0 (Worker, n_threads);
+	threads = g_new0 (GThread *, n_threads);
+
+	for (i = 0; i < n_threads; i++)
+	{
+		Worker *worker = &workers[i];
+
+		worker->snapshot = snapshot;
+		worker->query = query;
+		worker->query_length = query_length;
+		worker->query_mask = query_mask;
+		worker->candidates = candidates != NULL ? (const guint *) candidates->data : NULL;
+		worker->start = (guint64) n_candidates * i / n_threads;
+		worker->end = (guint64) n_candidates * (i + 1) / n_threads;
+		worker->max_results = data->max_results;
+		worker->cancellable = cancellable;
+		worker->matches = g_array_new (FALSE, FALSE, sizeof (guint));
+		worker->top = g_array_sized_new (FALSE, FALSE, sizeof (Match), data->max_results);
+
+		/* The first part is done by this thread */
+		if (i > 0)
+		{
+			threads[i] = g_thread_new ("gedit-file-index", (GThreadFunc) worker_run, worker);
+		}
+	}
+
+	worker_run (&workers[0]);
+
+	matches = g_array_sized_new (FALSE, FALSE, sizeof (guint), workers[0].matches->len);
+	top = g_array_sized_new (FALSE, FALSE, sizeof (Match), data->max_results);
+
+	for (i = 0; i < n_threads; i++)
+	{
+		Worker *worker = &workers[i];
+		guint j;
+
+		if (threads[i] != NULL)
+		{
+			g_thread_join (threads[i]);
+		}
+
+		g_array_append_vals (matches, worker->matches->data, worker->matches->len);
+
+		for (j = 0; j < worker->top->len; j++)
+		{
+			top_push (snapshot, top, data->max_results, &g_array_index (worker->top, Match, j));
+		}
+
+		g_array_unref (worker->matches);
+		g_array_unref (worker->top);
+	}
+
+	g_free (workers);
+	g_free (threads);
+
+	if (candidates != NULL)
+	{
+		g_array_unref (candidates);
+	}
+
+	if (g_task_return_error_if_cancelled (task))
+	{
+		g_array_unref (matches);
+		g_array_unref (top);
+		snapshot_unref (snapshot);
+		g_free (query);
+		return;
+	}
+
+	g_array_sort_with_data (top, compare_matches, snapshot);
+
+	paths = g_ptr_array_new ();
+
+	for (i = 0; i < top->len; i++)
+	{
+		const Match *match = &g_array_index (top, Match, i);
+
+		g_ptr_array_add (paths, g_strdup (g_array_index (snapshot->entries, Entry, match->index).path));
+	}
+
+	g_ptr_array_add (paths, NULL);
+
+	gedit_debug_message (DEBUG_UTILS,
+			     "Query '%s': %u matches among %u paths with %u threads in %" G_GINT64_FORMAT " us",
+			     query,
+			     matches->len,
+			     n_candidates,
+			     n_threads,
+			     g_get_monotonic_time () - start_time);
+
+	g_mutex_lock (&index->mutex);
+
+	if (index->snapshot == snapshot)
+	{
+		g_free (index->last_query);
+		index->last_query = query;
+		query = NULL;
+
+		snapshot_unref (index->last_snapshot);
+		index->last_snapshot = snapshot_ref (snapshot);
+
+		if (index->last_matches != NULL)
+		{
+			g_array_unref (index->last_matches);
+		}
+
+		index->last_matches = g_array_ref (matches);
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	g_array_unref (matches);
+	g_array_unref (top);
+	snapshot_unref (snapshot);
+	g_free (query);
+
+	g_task_return_pointer (task,
+			       g_ptr_array_free (paths, FALSE),
+			       (GDestroyNotify) g_strfreev);
+}
+
+static void
+build_thread (GTask        *task,
+	      gpointer      source_object,
+	      gpointer      task_data,
+	      GCancellable *cancellable)
+{
+	GeditFileIndex *index = source_object;
+	GQueue directories = G_QUEUE_INIT;
+	Snapshot *snapshot;
+	GFile *directory;
+	gint64 start_time = g_get_monotonic_time ();
+	GError *error = NULL;
+
+	snapshot = g_slice_new (Snapshot);
+	snapshot->ref_count = 1;
+	snapshot->entries = g_array_new (FALSE, FALSE, sizeof (Entry));
+	g_array_set_clear_func (snapshot->entries, (GDestroyNotify) entry_clear);
+
+	g_queue_push_tail (&directories, g_object_ref (index->root));
+
+	/* Breadth first, so that the files near the root are kept when there
+	 * are too many files.
+	 */
+	while ((directory = g_queue_pop_head (&directories)) != NULL)
+	{
+		GFileEnumerator *enumerator;
+		GFileInfo *info;
+
+		enumerator = g_file_enumerate_children (directory,
+							INDEX_ATTRIBUTES,
+							G_FILE_QUERY_INFO_NONE,
+							cancellable,
+							NULL);
+
+		g_object_unref (directory);
+
+		if (enumerator == NULL)
+		{
+			continue;
+		}
+
+		while (snapshot->entries->len < MAX_FILES &&
+		       (info = g_file_enumerator_next_file (enumerator, cancellable, NULL)) != NULL)
+		{
+			GFileType type = g_file_info_get_file_type (info);
+
+			if (!g_file_info_get_is_hidden (info) &&
+			    !g_file_info_get_is_backup (info))
+			{
+				GFile *child = g_file_enumerator_get_child (enumerator, info);
+
+				/* The symbolic links to directories could make loops. */
+				if (type == G_FILE_TYPE_DIRECTORY &&
+				    !g_file_info_get_is_symlink (info))
+				{
+					g_queue_push_tail (&directories, g_object_ref (child));
+				}
+				else if (type == G_FILE_TYPE_REGULAR)
+				{
+					gchar *path = g_file_get_relative_path (index->root, child);
+					Entry entry;
+
+					if (path != NULL)
+					{
+						entry_init (&entry, path);
+						g_array_append_val (snapshot->entries, entry);
+						g_free (path);
+					}
+				}
+
+				g_object_unref (child);
+			}
+
+			g_object_unref (info);
+		}
+
+		g_object_unref (enumerator);
+
+		if (snapshot->entries->len >= MAX_FILES)
+		{
+			gedit_debug_message (DEBUG_UTILS, "Too many files, the index is truncated");
+			break;
+		}
+	}
+
+	g_queue_clear_full (&directories, g_object_unref);
+
+	if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+	{
+		snapshot_unref (snapshot);
+		g_task_return_error (task, error);
+		return;
+	}
+
+	gedit_debug_message (DEBUG_UTILS,
+			     "Indexed %u files in %" G_GINT64_FORMAT " ms",
+			     snapshot->entries->len,
+			     (g_get_monotonic_time () - start_time) / 1000);
+
+	g_mutex_lock (&index->mutex);
+
+	snapshot_unref (index->snapshot);
+	index->snapshot = snapshot;
+
+	g_clear_pointer (&index->last_query, g_free);
+	g_clear_pointer (&index->last_snapshot, snapshot_unref);
+	g_clear_pointer (&index->last_matches, g_array_unref);
+
+	g_mutex_unlock (&index->mutex);
+
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+gedit_file_index_finalize (GObject *object)
+{
+	GeditFileIndex *index = GEDIT_FILE_INDEX (object);
+
+	g_clear_object (&index->root);
+
+	snapshot_unref (index->snapshot);
+	snapshot_unref (index->last_snapshot);
+	g_free (index->last_query);
+
+	if (index->last_matches != NULL)
+	{
+		g_array_unref (index->last_matches);
+	}
+
+	g_mutex_clear (&index->mutex);
+
+	G_OBJECT_CLASS (gedit_file_index_parent_class)->finalize (object);
+}
+
+static void
+gedit_file_index_get_property (GObject    *object,
+			       guint       prop_id,
+			       GValue     *value,
+			       GParamSpec *pspec)
+{
+	GeditFileIndex *index = GEDIT_FILE_INDEX (object);
+
+	switch (prop_id)
+	{
+		case PROP_ROOT:
+			g_value_set_object (value, index->root);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gedit_file_index_set_property (GObject      *object,
+			       guint         prop_id,
+			       const GValue *value,
+			       GParamSpec   *pspec)
+{
+	GeditFileIndex *index = GEDIT_FILE_INDEX (object);
+
+	switch (prop_id)
+	{
+		case PROP_ROOT:
+			index->root = g_value_dup_object (value);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gedit_file_index_class_init (GeditFileIndexClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = gedit_file_index_finalize;
+	object_class->get_property = gedit_file_index_get_property;
+	object_class->set_property = gedit_file_index_set_property;
+
+	/**
+	 * GeditFileIndex:root:
+	 *
+	 * The directory whose files are indexed.
+	 */
+	properties[PROP_ROOT] =
+		g_param_spec_object ("root",
+				     "Root",
+				     "The directory whose files are indexed",
+				     G_TYPE_FILE,
+				     G_PARAM_READWRITE |
+				     G_PARAM_CONSTRUCT_ONLY |
+				     G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties (object_class, LAST_PROP, properties);
+}
+
+static void
+gedit_file_index_init (GeditFileIndex *index)
+{
+	g_mutex_init (&index->mutex);
+}
+
+/**
+ * gedit_file_index_new:
+ * @root: the directory to index
+ *
+ * Creates an empty index of the files below @root, see
+ * gedit_file_index_build_async().
+ *
+ * Returns: a new #GeditFileIndex
+ */
+GeditFileIndex *
+gedit_file_index_new (GFile *root)
+{
+	g_return_val_if_fail (G_IS_FILE (root), NULL);
+
+	return g_object_new (GEDIT_TYPE_FILE_INDEX,
+			     "root", root,
+			     NULL);
+}
+
+/**
+ * gedit_file_index_get_root:
+ * @index: a #GeditFileIndex
+ *
+ * Returns: (transfer none): the directory whose files are indexed
+ */
+GFile *
+gedit_file_index_get_root (GeditFileIndex *index)
+{
+	g_return_val_if_fail (GEDIT_IS_FILE_INDEX (index), NULL);
+
+	return index->root;
+}
+
+/**
+ * gedit_file_index_get_n_files:
+ * @index: a #GeditFileIndex
+ *
+ * Returns: the number of files in the index, 0 until the index is built
+ */
+guint
+gedit_file_index_get_n_files (GeditFileIndex *index)
+{
+	guint n_files = 0;
+
+	g_return_val_if_fail (GEDIT_IS_FILE_INDEX (index), 0);
+
+	g_mutex_lock (&index->mutex);
+
+	if (index->snapshot != NULL)
+	{
+		n_files = index->snapshot->entries->len;
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	return n_files;
+}
+
+/**
+ * gedit_file_index_build_async:
+ * @index: a #GeditFileIndex
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): the callback to call when the index is built
+ * @user_data: the data to pass to @callback
+ *
+ * Lists the files below the root in a thread. The hidden files and
+ * directories, and the backup files, are skipped. The previous content
+ * of the index is used by the queries until the new one is ready.
+ */
+void
+gedit_file_index_build_async (GeditFileIndex      *index,
+			      GCancellable        *cancellable,
+			      GAsyncReadyCallback  callback,
+			      gpointer             user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (GEDIT_IS_FILE_INDEX (index));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (index, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gedit_file_index_build_async);
+	g_task_run_in_thread (task, build_thread);
+	g_object_unref (task);
+}
+
+/**
+ * gedit_file_index_build_finish:
+ * @index: a #GeditFileIndex
+ * @result: a #GAsyncResult
+ * @error: a #GError, or %NULL
+ *
+ * Returns: whether the index was built
+ */
+gboolean
+gedit_file_index_build_finish (GeditFileIndex  *index,
+			       GAsyncResult    *result,
+			       GError         **error)
+{
+	g_return_val_if_fail (GEDIT_IS_FILE_INDEX (index), FALSE);
+	g_return_val_if_fail (g_task_is_valid (result, index), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+query_data_free (QueryData *data)
+{
+	g_free (data->query);
+	g_slice_free (QueryData, data);
+}
+
+/**
+ * gedit_file_index_query_async:
+ * @index: a #GeditFileIndex
+ * @query: the characters to look for
+ * @max_results: the maximum number of paths to return
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): the callback to call when the query is done
+ * @user_data: the data to pass to @callback
+ *
+ * Finds in a thread the files whose path relative to the root contains
+ * the characters of @query in order. The spaces of @query are ignored,
+ * and the case of the ASCII letters too.
+ *
+ * The query is faster when it extends the previous one, so a query
+ * should be done each time a character is typed.
+ */
+void
+gedit_file_index_query_async (GeditFileIndex      *index,
+			      const gchar         *query,
+			      guint                max_results,
+			      GCancellable        *cancellable,
+			      GAsyncReadyCallback  callback,
+			      gpointer             user_data)
+{
+	GTask *task;
+	QueryData *data;
+
+	g_return_if_fail (GEDIT_IS_FILE_INDEX (index));
+	g_return_if_fail (query != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	data = g_slice_new (QueryData);
+	data->query = g_strdup (query);
+	data->max_results = max_results;
+
+	task = g_task_new (index, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gedit_file_index_query_async);
+	g_task_set_task_data (task, data, (GDestroyNotify) query_data_free);
+	g_task_run_in_thread (task, query_thread);
+	g_object_unref (task);
+}
+
+/**
+ * gedit_file_index_query_finish:
+ * @index: a #GeditFileIndex
+ * @result: a #GAsyncResult
+ * @error: a #GError, or %NULL
+ *
+ * Returns: (transfer full) (array zero-terminated=1) (element-type filename):
+ * the paths relative to the root of the best matches, the best first, or
+ * %NULL on error
+ */
+gchar **
+gedit_file_index_query_finish (GeditFileIndex  *index,
+			       GAsyncResult    *result,
+			       GError         **error)
+{
+	g_return_val_if_fail (GEDIT_IS_FILE_INDEX (index), NULL);
+	g_return_val_if_fail (g_task_is_valid (result, index), NULL);
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * gedit_file_index_highlight_match:
+ * @query: the query
+ * @path: (type filename): a path returned for @query
+ *
+ * Returns: (transfer full): the markup of @path for display, with the
+ * characters matching @query in bold
+ */
+gchar *
+gedit_file_index_highlight_match (const gchar *query,
+				  const gchar *path)
+{
+	gchar *display;
+	gchar *normalized;
+	gsize query_length;
+	GString *markup;
+	Entry entry;
+
+	g_return_val_if_fail (query != NULL, NULL);
+	g_return_val_if_fail (path != NULL, NULL);
+
+	display = g_filename_display_name (path);
+	normalized = normalize_query (query);
+	query_length = strlen (normalized);
+
+	entry_init (&entry, display);
+	markup = g_string_new (NULL);
+
+	if (query_length > 0 && entry_contains (&entry, normalized, query_length))
+	{
+		guint *positions = g_new (guint, query_length);
+		gchar *escaped;
+		gsize last = 0;
+		gsize q;
+
+		entry_score (&entry, normalized, query_length, positions);
+
+		for (q = 0; q < query_length; q++)
+		{
+			guint pos = positions[q];
+
+			/* Only a part of a multibyte character */
+			if ((guchar) display[pos] >= 0x80)
+			{
+				continue;
+			}
+
+			escaped = g_markup_escape_text (display + last, pos - last);
+			g_string_append (markup, escaped);
+			g_free (escaped);
+
+			escaped = g_markup_escape_text (display + pos, 1);
+			g_string_append_printf (markup, "<b>%s</b>", escaped);
+			g_free (escaped);
+
+			last = pos + 1;
+		}
+
+		escaped = g_markup_escape_text (display + last, -1);
+		g_string_append (markup, escaped);
+		g_free (escaped);
+
+		g_free (positions);
+	}
+	else
+	{
+		gchar *escaped = g_markup_escape_text (display, -1);
+
+		g_string_append (markup, escaped);
+		g_free (escaped);
+	}
+
+	entry_clear (&entry);
+	g_free (normalized);
+	g_free (display);
+
+	return g_string_free (markup, FALSE);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,65 @@
+/*
+ * gedit-file-index.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_FILE_INDEX_H
+#define GEDIT_FILE_INDEX_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GEDIT_TYPE_FILE_INDEX (gedit_file_index_get_type ())
+
+G_DECLARE_FINAL_TYPE (GeditFileIndex, gedit_file_index, GEDIT, FILE_INDEX, GObject)
+
+GeditFileIndex	*gedit_file_index_new			(GFile                *root);
+
+GFile		*gedit_file_index_get_root		(GeditFileIndex       *index);
+
+guint		 gedit_file_index_get_n_files		(GeditFileIndex       *index);
+
+void		 gedit_file_index_build_async		(GeditFileIndex       *index,
+							 GCancellable         *cancellable,
+							 GAsyncReadyCallback   callback,
+							 gpointer              user_data);
+
+gboolean	 gedit_file_index_build_finish		(GeditFileIndex       *index,
+							 GAsyncResult         *result,
+							 GError              **error);
+
+void		 gedit_file_index_query_async		(GeditFileIndex       *index,
+							 const gchar          *query,
+							 guint                 max_results,
+							 GCancellable         *cancellable,
+							 GAsyncReadyCallback   callback,
+							 gpointer              user_data);
+
+gchar		**gedit_file_index_query_finish		(GeditFileIndex       *index,
+							 GAsyncResult         *result,
+							 GError              **error);
+
+gchar		*gedit_file_index_highlight_match	(const gchar          *query,
+							 const gchar          *path);
+
+G_END_DECLS
+
+#endif /* GEDIT_FILE_INDEX_H */
+
+/* ex:set ts=8 noet: */
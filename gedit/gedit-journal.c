@@ -0,0 +1,1025 @@
+/*
+ * gedit-journal.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-journal.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "gedit-debug.h"
+#include "gedit-dirs.h"
+
+/* A journal records the changes done to a buffer since its file was last
+ * loaded or saved, so that the changes can be recovered after a crash without
+ * rewriting the whole file on every auto-save.
+ *
+ * The journal file is stored in the user data directory and contains a
+ * header, to know on which version of the file the changes apply, followed
+ * by one record per change:
+ *
+ *   GEDIT-JOURNAL 2
+ *   <file size> <file modification time>.<microseconds>
+ *   I <char offset> <length in bytes>
+ *   <inserted text>
+ *   D <start char offset> <end char offset>
+ *
+ * The records are accumulated in memory and appended to the file, followed by
+ * an fsync, by a single worker thread. The worker also deletes and reads the
+ * journal files, so that all the operations on a given journal file are done
+ * in order.
+ *
+ * The journal file is named after the location, so a given location must
+ * have only one writer: a tab takes the journal of its location with
+ * gedit_journal_claim() before reading or writing it, and another tab on
+ * the same file is left without a journal.
+ *
+ * The journal of a file that is never opened again stays behind. When the
+ * worker is started, the journals not modified for MAX_AGE_DAYS are
+ * removed, then the least recently modified ones until the journals take
+ * at most MAX_TOTAL_SIZE. The journals already claimed are left alone.
+ */
+
+#define JOURNAL_MAGIC "GEDIT-JOURNAL 2"
+
+#define MAX_AGE_DAYS	30
+#define MAX_TOTAL_SIZE	(64 * 1024 * 1024)
+
+/* The pending records are written at most one second after a change, or
+ * right away when there are a lot of them.
+ */
+#define FLUSH_DELAY_MS 1000
+#define FLUSH_THRESHOLD (64 * 1024)
+
+struct _GeditJournal
+{
+	GObject parent_instance;
+
+	GtkTextBuffer *buffer;
+	GFile *location;
+
+	GString *pending_records;
+	guint64 n_records;
+
+	guint flush_timeout_id;
+
+	guint replaying : 1;
+};
+
+typedef enum
+{
+	JOB_APPEND,
+	JOB_DISCARD,
+	JOB_LOAD,
+	JOB_PRUNE
+} JobType;
+
+typedef struct
+{
+	JobType type;
+	GFile *location;
+	gchar *path;
+
+	/* For JOB_APPEND. */
+	GString *records;
+
+	/* For JOB_LOAD. */
+	GTask *task;
+
+	/* For JOB_PRUNE, the paths of the claimed journals. */
+	GHashTable *claimed_paths;
+} Job;
+
+typedef struct
+{
+	gchar *path;
+	gint64 mtime;
+	gint64 size;
+} JournalFile;
+
+G_DEFINE_TYPE (GeditJournal, gedit_journal, G_TYPE_OBJECT)
+
+static GThreadPool *journal_pool = NULL;
+
+/* The claimed locations, GFile -> GFile. */
+static GHashTable *claimed_locations = NULL;
+
+static gchar *
+get_journal_path (GFile *location)
+{
+	gchar *uri;
+	gchar *checksum;
+	gchar *path;
+
+	uri = g_file_get_uri (location);
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+
+	path = g_build_filename (gedit_dirs_get_user_data_dir (),
+				 "journal",
+				 checksum,
+				 NULL);
+
+	g_free (uri);
+	g_free (checksum);
+	return path;
+}
+
+/* The header identifies the version of the file on which the records apply.
+ * Returns %NULL if the file doesn't exist.
+ */
+static gchar *
+get_header (GFile *location)
+{
+	GFileInfo *info;
+	gchar *header;
+
+	info = g_file_query_info (location,
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+				  G_FILE_QUERY_INFO_NONE,
+				  NULL,
+				  NULL);
+
+	if (info == NULL)
+	{
+		return NULL;
+	}
+
+	/* With the microseconds, a file modified twice in the same second is
+	 * not taken for the version the journal was started on.
+	 */
+	header = g_strdup_printf ("%s\n%" G_GINT64_FORMAT " %" G_GUINT64_FORMAT ".%06u\n",
+				  JOURNAL_MAGIC,
+				  (gint64) g_file_info_get_size (info),
+				  g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+				  g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC));
+
+	g_object_unref (info);
+	return header;
+}
+
+static void
+job_free (Job *job)
+{
+	if (job != NULL)
+	{
+		g_clear_object (&job->location);
+		g_free (job->path);
+
+		if (job->records != NULL)
+		{
+			g_string_free (job->records, TRUE);
+		}
+
+		if (job->claimed_paths != NULL)
+		{
+			g_hash_table_unref (job->claimed_paths);
+		}
+
+		g_slice_free (Job, job);
+	}
+}
+
+static void
+append_records (Job *job)
+{
+	gchar *header = NULL;
+	FILE *stream;
+
+	if (!g_file_test (job->path, G_FILE_TEST_EXISTS))
+	{
+		gchar *dir;
+
+		header = get_header (job->location);
+
+		if (header == NULL)
+		{
+			/* The file has been deleted, there is nothing on
+			 * which the records can be applied.
+			 */
+			return;
+		}
+
+		dir = g_path_get_dirname (job->path);
+		g_mkdir_with_parents (dir, 0700);
+		g_free (dir);
+	}
+
+	stream = g_fopen (job->path, "ab");
+
+	if (stream == NULL)
+	{
+		g_warning ("Impossible to open the journal file '%s': %s",
+			   job->path,
+			   g_strerror (errno));
+
+		g_free (header);
+		return;
+	}
+
+	if (header != NULL)
+	{
+		fputs (header, stream);
+	}
+
+	if (fwrite (job->records->str, 1, job->records->len, stream) != job->records->len ||
+	    fflush (stream) != 0 ||
+	    g_fsync (fileno (stream)) != 0)
+	{
+		g_warning ("Error while writing the journal file '%s': %s",
+			   job->path,
+			   g_strerror (errno));
+	}
+
+	fclose (stream);
+	g_free (header);
+}
+
+static void
+load_records (Job *job)
+{
+	gchar *contents = NULL;
+	gsize length = 0;
+	gchar *header = NULL;
+	gsize header_length;
+	GBytes *records = NULL;
+
+	if (g_task_return_error_if_cancelled (job->task))
+	{
+		return;
+	}
+
+	if (!g_file_get_contents (job->path, &contents, &length, NULL))
+	{
+		/* No journal. */
+		g_task_return_pointer (job->task, NULL, NULL);
+		return;
+	}
+
+	header = get_header (job->location);
+	header_length = header != NULL ? strlen (header) : 0;
+
+	/* The file has been modified since the journal was started, the
+	 * records can not be applied anymore.
+	 */
+	if (header == NULL ||
+	    length < header_length ||
+	    memcmp (contents, header, header_length) != 0)
+	{
+		gedit_debug_message (DEBUG_TAB, "Outdated journal: %s", job->path);
+
+		g_unlink (job->path);
+		g_free (contents);
+		g_free (header);
+
+		g_task_return_pointer (job->task, NULL, NULL);
+		return;
+	}
+
+	if (length > header_length)
+	{
+		GBytes *bytes = g_bytes_new_take (contents, length);
+
+		records = g_bytes_new_from_bytes (bytes, header_length, length - header_length);
+		g_bytes_unref (bytes);
+	}
+	else
+	{
+		g_free (contents);
+	}
+
+	g_free (header);
+
+	g_task_return_pointer (job->task, records, (GDestroyNotify) g_bytes_unref);
+}
+
+static void
+journal_file_free (JournalFile *file)
+{
+	g_free (file->path);
+	g_slice_free (JournalFile, file);
+}
+
+static gint
+compare_journal_files (gconstpointer a,
+		       gconstpointer b)
+{
+	const JournalFile *file_a = *(const JournalFile **) a;
+	const JournalFile *file_b = *(const JournalFile **) b;
+
+	/* Most recently modified first */
+	if (file_a->mtime != file_b->mtime)
+	{
+		return file_a->mtime > file_b->mtime ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/* Removes the journals not modified for MAX_AGE_DAYS, and the least recently
+ * modified ones beyond MAX_TOTAL_SIZE, except the claimed ones.
+ */
+static void
+prune_journals (Job *job)
+{
+	GDir *dir;
+	const gchar *name;
+	GPtrArray *files;
+	gint64 min_mtime;
+	gint64 total_size = 0;
+	guint i;
+
+	dir = g_dir_open (job->path, 0, NULL);
+
+	if (dir == NULL)
+	{
+		return;
+	}
+
+	files = g_ptr_array_new_with_free_func ((GDestroyNotify) journal_file_free);
+	min_mtime = g_get_real_time () / G_USEC_PER_SEC - MAX_AGE_DAYS * 24 * 60 * 60;
+
+	while ((name = g_dir_read_name (dir)) != NULL)
+	{
+		gchar *path = g_build_filename (job->path, name, NULL);
+		GStatBuf buf;
+		JournalFile *file;
+
+		if (g_hash_table_contains (job->claimed_paths, path) ||
+		    g_stat (path, &buf) != 0 ||
+		    !S_ISREG (buf.st_mode))
+		{
+			g_free (path);
+			continue;
+		}
+
+		if (buf.st_mtime < min_mtime)
+		{
+			gedit_debug_message (DEBUG_TAB, "Old journal: %s", path);
+
+			g_unlink (path);
+			g_free (path);
+			continue;
+		}
+
+		file = g_slice_new (JournalFile);
+		file->path = path;
+		file->mtime = buf.st_mtime;
+		file->size = buf.st_size;
+		g_ptr_array_add (files, file);
+	}
+
+	g_ptr_array_sort (files, compare_journal_files);
+
+	for (i = 0; i < files->len; i++)
+	{
+		JournalFile *file = g_ptr_array_index (files, i);
+
+		total_size += file->size;
+
+		if (total_size > MAX_TOTAL_SIZE)
+		{
+			gedit_debug_message (DEBUG_TAB, "Journal beyond the size limit: %s", file->path);
+			g_unlink (file->path);
+		}
+	}
+
+	g_ptr_array_unref (files);
+	g_dir_close (dir);
+}
+
+static void
+run_job (Job      *job,
+	 gpointer  user_data)
+{
+	switch (job->type)
+	{
+		case JOB_APPEND:
+			append_records (job);
+			break;
+
+		case JOB_DISCARD:
+			g_unlink (job->path);
+			break;
+
+		case JOB_LOAD:
+			load_records (job);
+			g_object_unref (job->task);
+			break;
+
+		case JOB_PRUNE:
+			prune_journals (job);
+			break;
+
+		default:
+			g_assert_not_reached ();
+	}
+
+	job_free (job);
+}
+
+/* The journals claimed later are only written after the pruning, since the
+ * jobs are run in order.
+ */
+static void
+push_prune_job (void)
+{
+	Job *job;
+
+	job = g_slice_new0 (Job);
+	job->type = JOB_PRUNE;
+	job->path = g_build_filename (gedit_dirs_get_user_data_dir (), "journal", NULL);
+	job->claimed_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	if (claimed_locations != NULL)
+	{
+		GHashTableIter iter;
+		gpointer location;
+
+		g_hash_table_iter_init (&iter, claimed_locations);
+
+		while (g_hash_table_iter_next (&iter, &location, NULL))
+		{
+			g_hash_table_add (job->claimed_paths, get_journal_path (location));
+		}
+	}
+
+	g_thread_pool_push (journal_pool, job, NULL);
+}
+
+static void
+push_job (JobType   type,
+	  GFile    *location,
+	  GString  *records,
+	  GTask    *task)
+{
+	Job *job;
+
+	if (journal_pool == NULL)
+	{
+		/* A single thread, so that the jobs are run in order. */
+		journal_pool = g_thread_pool_new ((GFunc) run_job,
+						  NULL,
+						  1,
+						  FALSE,
+						  NULL);
+
+		push_prune_job ();
+	}
+
+	job = g_slice_new0 (Job);
+	job->type = type;
+	job->location = g_object_ref (location);
+	job->path = get_journal_path (location);
+	job->records = records;
+	job->task = task;
+
+	g_thread_pool_push (journal_pool, job, NULL);
+}
+
+static gboolean
+flush_timeout_cb (gpointer user_data)
+{
+	GeditJournal *journal = GEDIT_JOURNAL (user_data);
+
+	journal->flush_timeout_id = 0;
+	gedit_journal_flush (journal);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+record_added (GeditJournal *journal)
+{
+	journal->n_records++;
+
+	if (journal->pending_records->len >= FLUSH_THRESHOLD)
+	{
+		gedit_journal_flush (journal);
+	}
+	else if (journal->flush_timeout_id == 0)
+	{
+		journal->flush_timeout_id = g_timeout_add (FLUSH_DELAY_MS,
+							   flush_timeout_cb,
+							   journal);
+	}
+}
+
+/* Connected before the default handlers, the offsets are the ones before the
+ * change, like when the records are replayed.
+ */
+static void
+insert_text_cb (GtkTextBuffer *buffer,
+		GtkTextIter   *location,
+		const gchar   *text,
+		gint           length,
+		GeditJournal  *journal)
+{
+	if (journal->replaying)
+	{
+		return;
+	}
+
+	if (length < 0)
+	{
+		length = strlen (text);
+	}
+
+	g_string_append_printf (journal->pending_records,
+				"I %d %d\n",
+				gtk_text_iter_get_offset (location),
+				length);
+	g_string_append_len (journal->pending_records, text, length);
+	g_string_append_c (journal->pending_records, '\n');
+
+	record_added (journal);
+}
+
+static void
+delete_range_cb (GtkTextBuffer *buffer,
+		 GtkTextIter   *start,
+		 GtkTextIter   *end,
+		 GeditJournal  *journal)
+{
+	if (journal->replaying)
+	{
+		return;
+	}
+
+	g_string_append_printf (journal->pending_records,
+				"D %d %d\n",
+				gtk_text_iter_get_offset (start),
+				gtk_text_iter_get_offset (end));
+
+	record_added (journal);
+}
+
+static void
+gedit_journal_dispose (GObject *object)
+{
+	GeditJournal *journal = GEDIT_JOURNAL (object);
+
+	/* The pending records are dropped on purpose: the journal is disposed
+	 * when the document has been saved or closed, and a later append
+	 * would create an outdated journal file.
+	 */
+	if (journal->flush_timeout_id != 0)
+	{
+		g_source_remove (journal->flush_timeout_id);
+		journal->flush_timeout_id = 0;
+	}
+
+	if (journal->buffer != NULL)
+	{
+		g_signal_handlers_disconnect_by_data (journal->buffer, journal);
+		g_clear_object (&journal->buffer);
+	}
+
+	g_clear_object (&journal->location);
+
+	G_OBJECT_CLASS (gedit_journal_parent_class)->dispose (object);
+}
+
+static void
+gedit_journal_finalize (GObject *object)
+{
+	GeditJournal *journal = GEDIT_JOURNAL (object);
+
+	g_string_free (journal->pending_records, TRUE);
+
+	G_OBJECT_CLASS (gedit_journal_parent_class)->finalize (object);
+}
+
+static void
+gedit_journal_class_init (GeditJournalClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gedit_journal_dispose;
+	object_class->finalize = gedit_journal_finalize;
+}
+
+static void
+gedit_journal_init (GeditJournal *journal)
+{
+	journal->pending_records = g_string_new (NULL);
+}
+
+/*
+ * gedit_journal_new:
+ * @buffer: a #GtkTextBuffer.
+ * @location: the location of the file loaded in @buffer.
+ *
+ * Starts recording the changes done to @buffer. The buffer content must be
+ * the same as the file at @location, or as the file plus the records of an
+ * existing journal, replayed with gedit_journal_replay().
+ *
+ * Returns: (transfer full): a new #GeditJournal.
+ */
+GeditJournal *
+gedit_journal_new (GtkTextBuffer *buffer,
+		   GFile         *location)
+{
+	GeditJournal *journal;
+
+	g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+
+	journal = g_object_new (GEDIT_TYPE_JOURNAL, NULL);
+	journal->buffer = g_object_ref (buffer);
+	journal->location = g_object_ref (location);
+
+	g_signal_connect (buffer,
+			  "insert-text",
+			  G_CALLBACK (insert_text_cb),
+			  journal);
+
+	g_signal_connect (buffer,
+			  "delete-range",
+			  G_CALLBACK (delete_range_cb),
+			  journal);
+
+	return journal;
+}
+
+GFile *
+gedit_journal_get_location (GeditJournal *journal)
+{
+	g_return_val_if_fail (GEDIT_IS_JOURNAL (journal), NULL);
+
+	return journal->location;
+}
+
+/*
+ * gedit_journal_get_n_records:
+ * @journal: a #GeditJournal.
+ *
+ * Returns: the number of changes recorded by @journal, which can be used to
+ * know whether the buffer has been modified since a previous call.
+ */
+guint64
+gedit_journal_get_n_records (GeditJournal *journal)
+{
+	g_return_val_if_fail (GEDIT_IS_JOURNAL (journal), 0);
+
+	return journal->n_records;
+}
+
+/*
+ * gedit_journal_flush:
+ * @journal: a #GeditJournal.
+ *
+ * Writes the pending records to the journal file, in the worker thread.
+ */
+void
+gedit_journal_flush (GeditJournal *journal)
+{
+	GString *records;
+
+	g_return_if_fail (GEDIT_IS_JOURNAL (journal));
+
+	if (journal->flush_timeout_id != 0)
+	{
+		g_source_remove (journal->flush_timeout_id);
+		journal->flush_timeout_id = 0;
+	}
+
+	if (journal->pending_records->len == 0)
+	{
+		return;
+	}
+
+	records = journal->pending_records;
+	journal->pending_records = g_string_new (NULL);
+
+	push_job (JOB_APPEND, journal->location, records, NULL);
+}
+
+typedef struct
+{
+	gchar type;
+	gint offset;
+	gint end_offset;
+	const gchar *text;
+	gint length;
+} Record;
+
+/* Parses the records and checks that they can be applied one after the
+ * other on a buffer of @n_chars characters. A truncated last record, written
+ * when gedit crashed, is ignored.
+ */
+static GArray *
+parse_records (GBytes  *bytes,
+	       gint     n_chars,
+	       GError **error)
+{
+	GArray *records;
+	const gchar *data;
+	const gchar *end;
+	gsize size;
+
+	records = g_array_new (FALSE, FALSE, sizeof (Record));
+
+	data = g_bytes_get_data (bytes, &size);
+	end = data + size;
+
+	while (data < end)
+	{
+		Record record = { 0 };
+		const gchar *line_end;
+		gchar *next;
+
+		line_end = memchr (data, '\n', end - data);
+
+		if (line_end == NULL)
+		{
+			break;
+		}
+
+		record.type = data[0];
+
+		if ((record.type != 'I' && record.type != 'D') ||
+		    line_end - data < 4 ||
+		    data[1] != ' ')
+		{
+			goto invalid;
+		}
+
+		record.offset = g_ascii_strtoll (data + 2, &next, 10);
+
+		if (next == data + 2 || *next != ' ')
+		{
+			goto invalid;
+		}
+
+		data = next + 1;
+
+		if (record.type == 'I')
+		{
+			record.length = g_ascii_strtoll (data, &next, 10);
+		}
+		else
+		{
+			record.end_offset = g_ascii_strtoll (data, &next, 10);
+		}
+
+		if (next == data || next != line_end)
+		{
+			goto invalid;
+		}
+
+		data = line_end + 1;
+
+		if (record.type == 'I')
+		{
+			if (record.length < 0 ||
+			    end - data < record.length + 1)
+			{
+				break;
+			}
+
+			record.text = data;
+			data += record.length + 1;
+
+			if (!g_utf8_validate (record.text, record.length, NULL) ||
+			    record.offset < 0 ||
+			    record.offset > n_chars)
+			{
+				goto invalid;
+			}
+
+			n_chars += g_utf8_strlen (record.text, record.length);
+		}
+		else
+		{
+			if (record.offset < 0 ||
+			    record.offset > record.end_offset ||
+			    record.end_offset > n_chars)
+			{
+				goto invalid;
+			}
+
+			n_chars -= record.end_offset - record.offset;
+		}
+
+		g_array_append_val (records, record);
+	}
+
+	return records;
+
+invalid:
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     "The journal file is corrupted");
+
+	g_array_unref (records);
+	return NULL;
+}
+
+/*
+ * gedit_journal_replay:
+ * @journal: a #GeditJournal.
+ * @records: the records returned by gedit_journal_load_finish().
+ * @error: a location for a #GError, or %NULL.
+ *
+ * Applies @records to the buffer of @journal, as a single user action. The
+ * records are not recorded again, since they are already in the journal
+ * file.
+ *
+ * Returns: whether the records have been applied.
+ */
+gboolean
+gedit_journal_replay (GeditJournal  *journal,
+		      GBytes        *records,
+		      GError       **error)
+{
+	GArray *parsed;
+	guint i;
+
+	g_return_val_if_fail (GEDIT_IS_JOURNAL (journal), FALSE);
+	g_return_val_if_fail (records != NULL, FALSE);
+
+	parsed = parse_records (records,
+				gtk_text_buffer_get_char_count (journal->buffer),
+				error);
+
+	if (parsed == NULL)
+	{
+		return FALSE;
+	}
+
+	gedit_debug_message (DEBUG_TAB, "Replaying %u journal records", parsed->len);
+
+	journal->replaying = TRUE;
+	gtk_text_buffer_begin_user_action (journal->buffer);
+
+	for (i = 0; i < parsed->len; i++)
+	{
+		const Record *record = &g_array_index (parsed, Record, i);
+		GtkTextIter start;
+
+		gtk_text_buffer_get_iter_at_offset (journal->buffer, &start, record->offset);
+
+		if (record->type == 'I')
+		{
+			gtk_text_buffer_insert (journal->buffer, &start, record->text, record->length);
+		}
+		else
+		{
+			GtkTextIter end;
+
+			gtk_text_buffer_get_iter_at_offset (journal->buffer, &end, record->end_offset);
+			gtk_text_buffer_delete (journal->buffer, &start, &end);
+		}
+	}
+
+	gtk_text_buffer_end_user_action (journal->buffer);
+	journal->replaying = FALSE;
+
+	journal->n_records += parsed->len;
+
+	g_array_unref (parsed);
+	return TRUE;
+}
+
+/*
+ * gedit_journal_load_async:
+ * @location: the location of a file.
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the request is
+ *   satisfied.
+ * @user_data: user data to pass to @callback.
+ *
+ * Reads, in the worker thread, the journal of @location left by a previous
+ * gedit instance. An outdated journal is deleted.
+ */
+void
+gedit_journal_load_async (GFile               *location,
+			  GCancellable        *cancellable,
+			  GAsyncReadyCallback  callback,
+			  gpointer             user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (G_IS_FILE (location));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	push_job (JOB_LOAD, location, NULL, task);
+}
+
+/*
+ * gedit_journal_load_finish:
+ * @result: a #GAsyncResult.
+ * @error: a location for a #GError, or %NULL.
+ *
+ * Returns: (transfer full) (nullable): the records of the journal, or %NULL
+ * if there is no journal to recover.
+ */
+GBytes *
+gedit_journal_load_finish (GAsyncResult  *result,
+			   GError       **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/*
+ * gedit_journal_discard:
+ * @location: the location of a file.
+ *
+ * Deletes the journal of @location, in the worker thread. To call when the
+ * buffer has been saved, or when its changes are no longer wanted.
+ */
+void
+gedit_journal_discard (GFile *location)
+{
+	g_return_if_fail (G_IS_FILE (location));
+
+	push_job (JOB_DISCARD, location, NULL, NULL);
+}
+
+/*
+ * gedit_journal_claim:
+ * @location: the location of a file.
+ *
+ * Takes the journal of @location, for the lifetime of the gedit instance or
+ * until gedit_journal_unclaim() is called.
+ *
+ * Returns: %TRUE if the journal of @location was not claimed yet, in which
+ * case the caller can read and write it.
+ */
+gboolean
+gedit_journal_claim (GFile *location)
+{
+	g_return_val_if_fail (G_IS_FILE (location), FALSE);
+
+	if (claimed_locations == NULL)
+	{
+		claimed_locations = g_hash_table_new_full ((GHashFunc) g_file_hash,
+							   (GEqualFunc) g_file_equal,
+							   g_object_unref,
+							   NULL);
+	}
+
+	if (g_hash_table_contains (claimed_locations, location))
+	{
+		gedit_debug_message (DEBUG_TAB, "Journal already claimed");
+		return FALSE;
+	}
+
+	g_hash_table_add (claimed_locations, g_object_ref (location));
+	return TRUE;
+}
+
+/*
+ * gedit_journal_unclaim:
+ * @location: a location claimed with gedit_journal_claim().
+ *
+ * Gives back the journal of @location. It is not deleted, call
+ * gedit_journal_discard() before for that.
+ */
+void
+gedit_journal_unclaim (GFile *location)
+{
+	g_return_if_fail (G_IS_FILE (location));
+	g_return_if_fail (claimed_locations != NULL);
+
+	g_hash_table_remove (claimed_locations, location);
+}
+
+/* Waits for the pending journal operations, to call before exiting. */
+void
+gedit_journal_shutdown (void)
+{
+	if (journal_pool != NULL)
+	{
+		g_thread_pool_free (journal_pool, FALSE, TRUE);
+		journal_pool = NULL;
+	}
+
+	g_clear_pointer (&claimed_locations, g_hash_table_unref);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,65 @@
+/*
+ * gedit-journal.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_JOURNAL_H
+#define GEDIT_JOURNAL_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GEDIT_TYPE_JOURNAL (gedit_journal_get_type ())
+
+G_DECLARE_FINAL_TYPE (GeditJournal, gedit_journal, GEDIT, JOURNAL, GObject)
+
+GeditJournal	*gedit_journal_new			(GtkTextBuffer  *buffer,
+							 GFile          *location);
+
+GFile		*gedit_journal_get_location		(GeditJournal   *journal);
+
+guint64		 gedit_journal_get_n_records		(GeditJournal   *journal);
+
+void		 gedit_journal_flush			(GeditJournal   *journal);
+
+gboolean	 gedit_journal_replay			(GeditJournal   *journal,
+							 GBytes         *records,
+							 GError        **error);
+
+void		 gedit_journal_load_async		(GFile                *location,
+							 GCancellable         *cancellable,
+							 GAsyncReadyCallback   callback,
+							 gpointer              user_data);
+
+GBytes		*gedit_journal_load_finish		(GAsyncResult         *result,
+							 GError              **error);
+
+void		 gedit_journal_discard			(GFile          *location);
+
+gboolean	 gedit_journal_claim			(GFile          *location);
+
+void		 gedit_journal_unclaim			(GFile          *location);
+
+void		 gedit_journal_shutdown			(void);
+
+G_END_DECLS
+
+#endif /* GEDIT_JOURNAL_H */
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,457 @@
+/*
+ * gedit-large-file-view.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-large-file-view.h"
+
+#include <gdk/gdkkeysyms.h>
+#include <tepl/tepl.h>
+
+#include "gedit-settings.h"
+
+/* A read-only and virtualized view of a GeditLargeFile. The GtkTextView only
+ * contains the lines that are visible on screen, the scrollbar is driven by
+ * the line index and not by the GtkTextView. So the memory used doesn't
+ * depend on the file size.
+ */
+
+/* Number of lines scrolled by a mouse wheel step. */
+#define SCROLL_STEP_LINES 3
+
+/* While the index is being built, how often the scrollbar range is updated,
+ * in milliseconds.
+ */
+#define INDEX_POLL_INTERVAL 200
+
+struct _GeditLargeFileView
+{
+	GtkGrid parent_instance;
+
+	GeditLargeFile *file;
+
+	GtkTextView *text_view;
+	GtkAdjustment *adjustment;
+
+	/* The line currently displayed at the top of the text view. */
+	gint64 top_line;
+	gint n_visible_lines;
+
+	/* Line requested with gedit_large_file_view_goto_line() but not yet
+	 * indexed, or -1.
+	 */
+	gint64 pending_line;
+
+	guint index_poll_id;
+	guint materialize_idle_id;
+};
+
+G_DEFINE_TYPE (GeditLargeFileView, gedit_large_file_view, GTK_TYPE_GRID)
+
+static void
+materialize_visible_lines (GeditLargeFileView *view)
+{
+	GtkTextBuffer *buffer;
+	gchar *text;
+
+	view->top_line = (gint64) gtk_adjustment_get_value (view->adjustment);
+
+	text = gedit_large_file_get_lines (view->file,
+					   view->top_line,
+					   view->n_visible_lines);
+
+	buffer = gtk_text_view_get_buffer (view->text_view);
+	gtk_text_buffer_set_text (buffer, text, -1);
+	g_free (text);
+}
+
+static gboolean
+materialize_idle_cb (gpointer user_data)
+{
+	GeditLargeFileView *view = GEDIT_LARGE_FILE_VIEW (user_data);
+
+	view->materialize_idle_id = 0;
+	materialize_visible_lines (view);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* The text buffer must not be modified during a size allocation, which can
+ * also change the value of the adjustment. The idle runs before the redraw.
+ */
+static void
+queue_materialize (GeditLargeFileView *view)
+{
+	if (view->materialize_idle_id == 0)
+	{
+		view->materialize_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+							     materialize_idle_cb,
+							     view,
+							     NULL);
+	}
+}
+
+static void
+update_adjustment (GeditLargeFileView *view)
+{
+	gint64 n_lines;
+
+	n_lines = gedit_large_file_get_n_lines (view->file);
+
+	gtk_adjustment_configure (view->adjustment,
+				  gtk_adjustment_get_value (view->adjustment),
+				  0.0,
+				  (gdouble) n_lines,
+				  1.0,
+				  MAX (1, view->n_visible_lines - 1),
+				  MIN (view->n_visible_lines, n_lines));
+}
+
+static gint
+get_line_height (GeditLargeFileView *view)
+{
+	PangoContext *context;
+	PangoFontMetrics *metrics;
+	gint height;
+
+	context = gtk_widget_get_pango_context (GTK_WIDGET (view->text_view));
+	metrics = pango_context_get_metrics (context, NULL, NULL);
+
+	height = PANGO_PIXELS (pango_font_metrics_get_ascent (metrics) +
+			       pango_font_metrics_get_descent (metrics));
+
+	pango_font_metrics_unref (metrics);
+
+	return MAX (1, height);
+}
+
+static void
+text_view_size_allocate_cb (GtkWidget          *widget,
+			    GdkRectangle       *allocation,
+			    GeditLargeFileView *view)
+{
+	gint n_visible_lines;
+
+	/* One more line for the partially visible one at the bottom. */
+	n_visible_lines = allocation->height / get_line_height (view) + 1;
+
+	if (n_visible_lines != view->n_visible_lines)
+	{
+		view->n_visible_lines = n_visible_lines;
+		update_adjustment (view);
+		queue_materialize (view);
+	}
+}
+
+static void
+adjustment_value_changed_cb (GtkAdjustment      *adjustment,
+			     GeditLargeFileView *view)
+{
+	if ((gint64) gtk_adjustment_get_value (adjustment) != view->top_line)
+	{
+		queue_materialize (view);
+	}
+}
+
+static void
+scroll_lines (GeditLargeFileView *view,
+	      gdouble             n_lines)
+{
+	gtk_adjustment_set_value (view->adjustment,
+				  gtk_adjustment_get_value (view->adjustment) + n_lines);
+}
+
+static gboolean
+text_view_scroll_event_cb (GtkWidget          *widget,
+			   GdkEventScroll     *event,
+			   GeditLargeFileView *view)
+{
+	gdouble delta_x;
+	gdouble delta_y;
+
+	switch (event->direction)
+	{
+		case GDK_SCROLL_UP:
+			scroll_lines (view, -SCROLL_STEP_LINES);
+			return GDK_EVENT_STOP;
+
+		case GDK_SCROLL_DOWN:
+			scroll_lines (view, SCROLL_STEP_LINES);
+			return GDK_EVENT_STOP;
+
+		case GDK_SCROLL_SMOOTH:
+			if (gdk_event_get_scroll_deltas ((GdkEvent *) event, &delta_x, &delta_y) &&
+			    delta_y != 0.0)
+			{
+				scroll_lines (view, delta_y * SCROLL_STEP_LINES);
+				return GDK_EVENT_STOP;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	/* Horizontal scrolling is handled by the GtkScrolledWindow. */
+	return GDK_EVENT_PROPAGATE;
+}
+
+static gboolean
+text_view_key_press_event_cb (GtkWidget          *widget,
+			      GdkEventKey        *event,
+			      GeditLargeFileView *view)
+{
+	gboolean control = (event->state & GDK_CONTROL_MASK) != 0;
+	gdouble page = MAX (1, view->n_visible_lines - 1);
+
+	switch (event->keyval)
+	{
+		case GDK_KEY_Page_Up:
+		case GDK_KEY_KP_Page_Up:
+			scroll_lines (view, -page);
+			return GDK_EVENT_STOP;
+
+		case GDK_KEY_Page_Down:
+		case GDK_KEY_KP_Page_Down:
+			scroll_lines (view, page);
+			return GDK_EVENT_STOP;
+
+		case GDK_KEY_Home:
+		case GDK_KEY_KP_Home:
+			if (control)
+			{
+				gtk_adjustment_set_value (view->adjustment, 0.0);
+				return GDK_EVENT_STOP;
+			}
+			break;
+
+		case GDK_KEY_End:
+		case GDK_KEY_KP_End:
+			if (control)
+			{
+				gtk_adjustment_set_value (view->adjustment,
+							  gtk_adjustment_get_upper (view->adjustment));
+				return GDK_EVENT_STOP;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return GDK_EVENT_PROPAGATE;
+}
+
+static gboolean
+index_poll_cb (gpointer user_data)
+{
+	GeditLargeFileView *view = GEDIT_LARGE_FILE_VIEW (user_data);
+	gdouble old_n_lines;
+	gboolean indexing;
+
+	old_n_lines = gtk_adjustment_get_upper (view->adjustment);
+	indexing = gedit_large_file_is_indexing (view->file);
+	update_adjustment (view);
+
+	/* Some visible lines were maybe not indexed yet. */
+	if (view->pending_line >= 0 &&
+	    (view->pending_line < gtk_adjustment_get_upper (view->adjustment) || !indexing))
+	{
+		gtk_adjustment_set_value (view->adjustment, view->pending_line);
+		view->pending_line = -1;
+	}
+
+	if (view->top_line + view->n_visible_lines > old_n_lines)
+	{
+		materialize_visible_lines (view);
+	}
+
+	/* Stop when the indexing is complete, or when it was cancelled. */
+	if (!indexing)
+	{
+		view->index_poll_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+update_font (GeditLargeFileView *view)
+{
+	GeditSettings *settings;
+	gchar *selected_font;
+
+	settings = _gedit_settings_get_singleton ();
+	selected_font = _gedit_settings_get_selected_font (settings);
+	tepl_utils_override_font (GTK_WIDGET (view->text_view), selected_font);
+	g_free (selected_font);
+}
+
+static void
+fonts_changed_cb (GeditSettings      *settings,
+		  GeditLargeFileView *view)
+{
+	update_font (view);
+
+	/* Forces the number of visible lines to be recomputed. */
+	view->n_visible_lines = 0;
+	gtk_widget_queue_resize (GTK_WIDGET (view->text_view));
+}
+
+static void
+gedit_large_file_view_dispose (GObject *object)
+{
+	GeditLargeFileView *view = GEDIT_LARGE_FILE_VIEW (object);
+
+	if (view->index_poll_id != 0)
+	{
+		g_source_remove (view->index_poll_id);
+		view->index_poll_id = 0;
+	}
+
+	if (view->materialize_idle_id != 0)
+	{
+		g_source_remove (view->materialize_idle_id);
+		view->materialize_idle_id = 0;
+	}
+
+	g_clear_object (&view->file);
+
+	G_OBJECT_CLASS (gedit_large_file_view_parent_class)->dispose (object);
+}
+
+static void
+gedit_large_file_view_class_init (GeditLargeFileViewClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gedit_large_file_view_dispose;
+}
+
+static void
+gedit_large_file_view_init (GeditLargeFileView *view)
+{
+	GtkWidget *scrolled_window;
+	GtkWidget *scrollbar;
+
+	view->pending_line = -1;
+
+	view->text_view = GTK_TEXT_VIEW (gtk_text_view_new ());
+	gtk_text_view_set_editable (view->text_view, FALSE);
+	gtk_text_view_set_monospace (view->text_view, TRUE);
+	gtk_text_view_set_wrap_mode (view->text_view, GTK_WRAP_NONE);
+
+	/* The vertical scrolling is done on the line index, so the text view
+	 * must not scroll vertically by itself.
+	 */
+	scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+					GTK_POLICY_AUTOMATIC,
+					GTK_POLICY_EXTERNAL);
+	gtk_widget_set_hexpand (scrolled_window, TRUE);
+	gtk_widget_set_vexpand (scrolled_window, TRUE);
+	gtk_container_add (GTK_CONTAINER (scrolled_window), GTK_WIDGET (view->text_view));
+
+	view->adjustment = gtk_adjustment_new (0.0, 0.0, 0.0, 1.0, 1.0, 0.0);
+	scrollbar = gtk_scrollbar_new (GTK_ORIENTATION_VERTICAL, view->adjustment);
+
+	gtk_grid_attach (GTK_GRID (view), scrolled_window, 0, 0, 1, 1);
+	gtk_grid_attach (GTK_GRID (view), scrollbar, 1, 0, 1, 1);
+	gtk_widget_show_all (GTK_WIDGET (view));
+
+	g_signal_connect (view->adjustment,
+			  "value-changed",
+			  G_CALLBACK (adjustment_value_changed_cb),
+			  view);
+
+	g_signal_connect (view->text_view,
+			  "size-allocate",
+			  G_CALLBACK (text_view_size_allocate_cb),
+			  view);
+
+	g_signal_connect (view->text_view,
+			  "scroll-event",
+			  G_CALLBACK (text_view_scroll_event_cb),
+			  view);
+
+	g_signal_connect (view->text_view,
+			  "key-press-event",
+			  G_CALLBACK (text_view_key_press_event_cb),
+			  view);
+
+	update_font (view);
+
+	g_signal_connect_object (_gedit_settings_get_singleton (),
+				 "fonts-changed",
+				 G_CALLBACK (fonts_changed_cb),
+				 view,
+				 0);
+}
+
+GtkWidget *
+gedit_large_file_view_new (GeditLargeFile *file)
+{
+	GeditLargeFileView *view;
+
+	g_return_val_if_fail (GEDIT_IS_LARGE_FILE (file), NULL);
+
+	view = g_object_new (GEDIT_TYPE_LARGE_FILE_VIEW, NULL);
+	view->file = g_object_ref (file);
+
+	update_adjustment (view);
+
+	if (gedit_large_file_is_indexing (file))
+	{
+		view->index_poll_id = g_timeout_add (INDEX_POLL_INTERVAL, index_poll_cb, view);
+	}
+
+	return GTK_WIDGET (view);
+}
+
+GeditLargeFile *
+gedit_large_file_view_get_file (GeditLargeFileView *view)
+{
+	g_return_val_if_fail (GEDIT_IS_LARGE_FILE_VIEW (view), NULL);
+
+	return view->file;
+}
+
+/* @line starts at 0. If the line is not yet indexed, the view goes to it as
+ * soon as it is.
+ */
+void
+gedit_large_file_view_goto_line (GeditLargeFileView *view,
+				 gint64              line)
+{
+	g_return_if_fail (GEDIT_IS_LARGE_FILE_VIEW (view));
+
+	line = MAX (0, line);
+
+	if (line >= gedit_large_file_get_n_lines (view->file) &&
+	    gedit_large_file_is_indexing (view->file))
+	{
+		view->pending_line = line;
+		return;
+	}
+
+	view->pending_line = -1;
+	gtk_adjustment_set_value (view->adjustment, line);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,44 @@
+/*
+ * gedit-large-file-view.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_LARGE_FILE_VIEW_H
+#define GEDIT_LARGE_FILE_VIEW_H
+
+#include <gtk/gtk.h>
+#include "gedit-large-file.h"
+
+G_BEGIN_DECLS
+
+#define GEDIT_TYPE_LARGE_FILE_VIEW (gedit_large_file_view_get_type ())
+
+G_DECLARE_FINAL_TYPE (GeditLargeFileView, gedit_large_file_view, GEDIT, LARGE_FILE_VIEW, GtkGrid)
+
+GtkWidget	*gedit_large_file_view_new		(GeditLargeFile     *file);
+
+GeditLargeFile	*gedit_large_file_view_get_file		(GeditLargeFileView *view);
+
+void		 gedit_large_file_view_goto_line	(GeditLargeFileView *view,
+							 gint64              line);
+
+G_END_DECLS
+
+#endif /* GEDIT_LARGE_FILE_VIEW_H */
+
+/* ex:set ts=8 noet: */
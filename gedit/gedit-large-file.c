@@ -0,0 +1,655 @@
+/*
+ * gedit-large-file.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-large-file.h"
+
+#include <string.h>
+
+#include "gedit-debug.h"
+#include "gedit-settings.h"
+
+/* GeditLargeFile is the read-only model behind the "large file mode" of a
+ * GeditTab. Instead of pushing the whole file through a GtkSourceFileLoader,
+ * only a sparse line index is kept: the byte offset of one line out of
+ * LINES_PER_CHECKPOINT. Getting the text of a line thus needs to scan at most
+ * LINES_PER_CHECKPOINT lines from the nearest checkpoint, which is cheap, and
+ * the index stays small even for files with hundreds of millions of lines.
+ *
+ * The index is built in a worker thread. It is published in blocks, so the
+ * lines already indexed can be displayed while the end of the file is still
+ * being scanned.
+ *
+ * The file is read with streams, one buffer at a time, and not mapped in
+ * memory: such files are often logs, which can be truncated while they are
+ * open, and reading a mapping past the new end of the file raises SIGBUS.
+ * A truncated file just looks shorter.
+ */
+
+#define LINES_PER_CHECKPOINT 64
+
+/* Amount of bytes scanned by the indexing thread between two publications of
+ * the index.
+ */
+#define INDEX_BLOCK_SIZE (8 * 1024 * 1024)
+
+/* Size of the buffers the file is read with. */
+#define READ_BUFFER_SIZE (64 * 1024)
+
+/* Lines longer than that are truncated when they are materialized. */
+#define MAX_LINE_LENGTH 4096
+
+struct _GeditLargeFile
+{
+	GObject parent_instance;
+
+	GFile *location;
+
+	/* Only used from the main thread, the indexing thread has its own
+	 * stream.
+	 */
+	GFileInputStream *stream;
+
+	/* The size of the file when it was opened. */
+	goffset length;
+
+	/* Protects the fields below, which are written by the indexing
+	 * thread.
+	 */
+	GMutex mutex;
+
+	/* Element type: guint64. The offset of the line number
+	 * i * LINES_PER_CHECKPOINT is at index i.
+	 */
+	GArray *checkpoints;
+	gint64 n_lines;
+
+	guint indexing : 1;
+	guint indexed : 1;
+};
+
+G_DEFINE_TYPE (GeditLargeFile, gedit_large_file, G_TYPE_OBJECT)
+
+static void
+gedit_large_file_finalize (GObject *object)
+{
+	GeditLargeFile *file = GEDIT_LARGE_FILE (object);
+
+	g_clear_object (&file->location);
+	g_clear_object (&file->stream);
+	g_array_unref (file->checkpoints);
+	g_mutex_clear (&file->mutex);
+
+	G_OBJECT_CLASS (gedit_large_file_parent_class)->finalize (object);
+}
+
+static void
+gedit_large_file_class_init (GeditLargeFileClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = gedit_large_file_finalize;
+}
+
+static void
+gedit_large_file_init (GeditLargeFile *file)
+{
+	g_mutex_init (&file->mutex);
+	file->checkpoints = g_array_new (FALSE, FALSE, sizeof (guint64));
+}
+
+/**
+ * gedit_large_file_new:
+ * @location: a local #GFile.
+ * @error: a location for a #GError, or %NULL.
+ *
+ * Opens @location. The line index is not built, call
+ * gedit_large_file_index_async() for that.
+ *
+ * Returns: (transfer full) (nullable): a new #GeditLargeFile, or %NULL on
+ * error.
+ */
+GeditLargeFile *
+gedit_large_file_new (GFile   *location,
+		      GError **error)
+{
+	GeditLargeFile *file;
+	GFileInputStream *stream;
+	GFileInfo *info;
+
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	if (!g_file_is_native (location))
+	{
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_NOT_SUPPORTED,
+				     "Only local files can be opened in large file mode");
+		return NULL;
+	}
+
+	stream = g_file_read (location, NULL, error);
+
+	if (stream == NULL)
+	{
+		return NULL;
+	}
+
+	info = g_file_input_stream_query_info (stream,
+					       G_FILE_ATTRIBUTE_STANDARD_SIZE,
+					       NULL,
+					       error);
+
+	if (info == NULL)
+	{
+		g_object_unref (stream);
+		return NULL;
+	}
+
+	file = g_object_new (GEDIT_TYPE_LARGE_FILE, NULL);
+
+	file->location = g_object_ref (location);
+	file->stream = stream;
+	file->length = g_file_info_get_size (info);
+
+	g_object_unref (info);
+
+	if (file->length > 0)
+	{
+		guint64 first_line_offset = 0;
+
+		g_array_append_val (file->checkpoints, first_line_offset);
+		file->n_lines = 1;
+	}
+
+	return file;
+}
+
+GFile *
+gedit_large_file_get_location (GeditLargeFile *file)
+{
+	g_return_val_if_fail (GEDIT_IS_LARGE_FILE (file), NULL);
+
+	return file->location;
+}
+
+goffset
+gedit_large_file_get_size (GeditLargeFile *file)
+{
+	g_return_val_if_fail (GEDIT_IS_LARGE_FILE (file), 0);
+
+	return file->length;
+}
+
+static void
+set_indexing_done (GeditLargeFile *file,
+		   gboolean        indexed)
+{
+	g_mutex_lock (&file->mutex);
+	file->indexing = FALSE;
+	file->indexed = indexed;
+	g_mutex_unlock (&file->mutex);
+}
+
+static void
+publish_checkpoints (GeditLargeFile *file,
+		     GArray         *pending,
+		     gint64          line)
+{
+	g_mutex_lock (&file->mutex);
+	g_array_append_vals (file->checkpoints, pending->data, pending->len);
+	file->n_lines = line + 1;
+	g_mutex_unlock (&file->mutex);
+
+	g_array_set_size (pending, 0);
+}
+
+static void
+index_thread (GTask        *task,
+	      gpointer      source_object,
+	      gpointer      task_data,
+	      GCancellable *cancellable)
+{
+	GeditLargeFile *file = source_object;
+	GFileInputStream *stream;
+	gchar *buffer;
+	GArray *pending;
+	goffset offset = 0;
+	goffset published = 0;
+	gint64 line = 0;
+	GError *error = NULL;
+
+	stream = g_file_read (file->location, cancellable, &error);
+
+	if (stream == NULL)
+	{
+		set_indexing_done (file, FALSE);
+		g_task_return_error (task, error);
+		return;
+	}
+
+	buffer = g_malloc (READ_BUFFER_SIZE);
+	pending = g_array_new (FALSE, FALSE, sizeof (guint64));
+
+	while (offset < file->length)
+	{
+		const gchar *p;
+		const gchar *end;
+		gssize n_read;
+
+		n_read = g_input_stream_read (G_INPUT_STREAM (stream),
+					      buffer,
+					      MIN (READ_BUFFER_SIZE, file->length - offset),
+					      cancellable,
+					      &error);
+
+		if (n_read < 0)
+		{
+			break;
+		}
+
+		/* The file was truncated since it was opened. */
+		if (n_read == 0)
+		{
+			break;
+		}
+
+		p = buffer;
+		end = buffer + n_read;
+
+		while (p < end)
+		{
+			const gchar *newline;
+			guint64 line_offset;
+
+			newline = memchr (p, '\n', end - p);
+
+			if (newline == NULL)
+			{
+				break;
+			}
+
+			p = newline + 1;
+			line_offset = offset + (p - buffer);
+
+			/* A trailing newline doesn't start a new line. */
+			if (line_offset < (guint64) file->length)
+			{
+				line++;
+
+				if (line % LINES_PER_CHECKPOINT == 0)
+				{
+					g_array_append_val (pending, line_offset);
+				}
+			}
+		}
+
+		offset += n_read;
+
+		if (offset - published >= INDEX_BLOCK_SIZE)
+		{
+			publish_checkpoints (file, pending, line);
+			published = offset;
+		}
+	}
+
+	publish_checkpoints (file, pending, line);
+
+	g_array_unref (pending);
+	g_free (buffer);
+	g_object_unref (stream);
+
+	if (error != NULL)
+	{
+		set_indexing_done (file, FALSE);
+		g_task_return_error (task, error);
+		return;
+	}
+
+	set_indexing_done (file, TRUE);
+
+	gedit_debug_message (DEBUG_TAB, "Large file indexed: %" G_GINT64_FORMAT " lines", line + 1);
+
+	g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * gedit_large_file_index_async:
+ * @file: a #GeditLargeFile.
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the index is
+ *   complete.
+ * @user_data: user data to pass to @callback.
+ *
+ * Builds the line index of @file in a worker thread. While the index is
+ * being built, gedit_large_file_get_n_lines() returns the number of lines
+ * indexed so far.
+ */
+void
+gedit_large_file_index_async (GeditLargeFile      *file,
+			      GCancellable        *cancellable,
+			      GAsyncReadyCallback  callback,
+			      gpointer             user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (GEDIT_IS_LARGE_FILE (file));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (!file->indexing && !file->indexed);
+
+	g_mutex_lock (&file->mutex);
+	file->indexing = TRUE;
+	g_mutex_unlock (&file->mutex);
+
+	task = g_task_new (file, cancellable, callback, user_data);
+	g_task_run_in_thread (task, index_thread);
+	g_object_unref (task);
+}
+
+gboolean
+gedit_large_file_index_finish (GeditLargeFile  *file,
+			       GAsyncResult    *result,
+			       GError         **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, file), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+gboolean
+gedit_large_file_is_indexed (GeditLargeFile *file)
+{
+	gboolean indexed;
+
+	g_return_val_if_fail (GEDIT_IS_LARGE_FILE (file), FALSE);
+
+	g_mutex_lock (&file->mutex);
+	indexed = file->indexed;
+	g_mutex_unlock (&file->mutex);
+
+	return indexed;
+}
+
+/**
+ * gedit_large_file_is_indexing:
+ * @file: a #GeditLargeFile.
+ *
+ * Returns: whether the index of @file is being built. It is %FALSE once the
+ * indexing is complete, but also when it was cancelled, in which case
+ * gedit_large_file_is_indexed() stays %FALSE.
+ */
+gboolean
+gedit_large_file_is_indexing (GeditLargeFile *file)
+{
+	gboolean indexing;
+
+	g_return_val_if_fail (GEDIT_IS_LARGE_FILE (file), FALSE);
+
+	g_mutex_lock (&file->mutex);
+	indexing = file->indexing;
+	g_mutex_unlock (&file->mutex);
+
+	return indexing;
+}
+
+gint64
+gedit_large_file_get_n_lines (GeditLargeFile *file)
+{
+	gint64 n_lines;
+
+	g_return_val_if_fail (GEDIT_IS_LARGE_FILE (file), 0);
+
+	g_mutex_lock (&file->mutex);
+	n_lines = file->n_lines;
+	g_mutex_unlock (&file->mutex);
+
+	return n_lines;
+}
+
+typedef struct
+{
+	GInputStream *stream;
+	gchar *buffer;
+	gsize pos;
+	gsize len;
+
+	/* The bytes left to read up to the size of the file. */
+	goffset remaining;
+} LineReader;
+
+/* Reads the next line into @line, without its newline, keeping at most
+ * MAX_LINE_LENGTH + 1 bytes of it: the rest is skipped. @line can be %NULL
+ * to skip the line. Returns %FALSE at the end of the file.
+ */
+static gboolean
+line_reader_next (LineReader *reader,
+		  GString    *line)
+{
+	gboolean read_any = FALSE;
+
+	while (TRUE)
+	{
+		const gchar *start;
+		const gchar *newline;
+		gsize n_bytes;
+
+		if (reader->pos == reader->len)
+		{
+			gssize n_read;
+
+			if (reader->remaining <= 0)
+			{
+				return read_any;
+			}
+
+			n_read = g_input_stream_read (reader->stream,
+						      reader->buffer,
+						      MIN (READ_BUFFER_SIZE, reader->remaining),
+						      NULL,
+						      NULL);
+
+			if (n_read <= 0)
+			{
+				return read_any;
+			}
+
+			reader->pos = 0;
+			reader->len = n_read;
+			reader->remaining -= n_read;
+		}
+
+		read_any = TRUE;
+
+		start = reader->buffer + reader->pos;
+		newline = memchr (start, '\n', reader->len - reader->pos);
+		n_bytes = newline != NULL ? (gsize) (newline - start) : reader->len - reader->pos;
+
+		if (line != NULL && line->len <= MAX_LINE_LENGTH)
+		{
+			g_string_append_len (line, start, MIN (n_bytes, MAX_LINE_LENGTH + 1 - line->len));
+		}
+
+		reader->pos += n_bytes;
+
+		if (newline != NULL)
+		{
+			reader->pos++;
+			return TRUE;
+		}
+	}
+}
+
+static void
+append_line (GString     *str,
+	     const gchar *line,
+	     gsize        length)
+{
+	gchar *valid;
+
+	if (length > 0 && line[length - 1] == '\r')
+	{
+		length--;
+	}
+
+	valid = g_utf8_make_valid (line, MIN (length, MAX_LINE_LENGTH));
+	g_string_append (str, valid);
+	g_free (valid);
+
+	if (length > MAX_LINE_LENGTH)
+	{
+		g_string_append (str, "…");
+	}
+}
+
+/**
+ * gedit_large_file_get_lines:
+ * @file: a #GeditLargeFile.
+ * @first_line: the first line to get, starting at 0.
+ * @n_lines: the maximum number of lines to get.
+ *
+ * Materializes a window of lines. Invalid UTF-8 sequences are replaced and
+ * very long lines are truncated, so the result can be inserted as-is in a
+ * #GtkTextBuffer. If the file was truncated since it was opened, the lines
+ * past its new end are missing.
+ *
+ * Returns: (transfer full): the lines, separated by '\n', without trailing
+ * newline.
+ */
+gchar *
+gedit_large_file_get_lines (GeditLargeFile *file,
+			    gint64          first_line,
+			    gint            n_lines)
+{
+	GString *str;
+	GString *line_str;
+	LineReader reader = { 0 };
+	gint64 n_available;
+	gint64 line;
+	guint64 offset = 0;
+	gint i;
+
+	g_return_val_if_fail (GEDIT_IS_LARGE_FILE (file), NULL);
+	g_return_val_if_fail (first_line >= 0, NULL);
+
+	str = g_string_new (NULL);
+
+	g_mutex_lock (&file->mutex);
+
+	n_available = file->n_lines;
+
+	if (first_line < n_available)
+	{
+		offset = g_array_index (file->checkpoints,
+					guint64,
+					first_line / LINES_PER_CHECKPOINT);
+	}
+
+	g_mutex_unlock (&file->mutex);
+
+	if (first_line >= n_available ||
+	    !g_seekable_seek (G_SEEKABLE (file->stream), offset, G_SEEK_SET, NULL, NULL))
+	{
+		return g_string_free (str, FALSE);
+	}
+
+	reader.stream = G_INPUT_STREAM (file->stream);
+	reader.buffer = g_malloc (READ_BUFFER_SIZE);
+	reader.remaining = file->length - offset;
+
+	line_str = g_string_new (NULL);
+
+	/* Skip the lines between the checkpoint and @first_line. */
+	for (line = first_line - first_line % LINES_PER_CHECKPOINT; line < first_line; line++)
+	{
+		if (!line_reader_next (&reader, NULL))
+		{
+			break;
+		}
+	}
+
+	for (i = 0; line == first_line && i < n_lines && first_line + i < n_available; i++)
+	{
+		g_string_truncate (line_str, 0);
+
+		if (!line_reader_next (&reader, line_str))
+		{
+			break;
+		}
+
+		if (i > 0)
+		{
+			g_string_append_c (str, '\n');
+		}
+
+		append_line (str, line_str->str, line_str->len);
+	}
+
+	g_string_free (line_str, TRUE);
+	g_free (reader.buffer);
+
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * gedit_large_file_should_use:
+ * @location: a #GFile.
+ * @editor_settings: the org.gnome.gedit.preferences.editor #GSettings.
+ *
+ * Returns: whether @location is a local regular file big enough to be opened
+ * in large file mode, according to the large-file-threshold setting.
+ */
+gboolean
+gedit_large_file_should_use (GFile     *location,
+			     GSettings *editor_settings)
+{
+	GFileInfo *info;
+	guint threshold;
+	gboolean use = FALSE;
+
+	g_return_val_if_fail (G_IS_FILE (location), FALSE);
+	g_return_val_if_fail (G_IS_SETTINGS (editor_settings), FALSE);
+
+	threshold = g_settings_get_uint (editor_settings, GEDIT_SETTINGS_LARGE_FILE_THRESHOLD);
+
+	/* The query is synchronous, so don't do it for remote files. */
+	if (threshold == 0 || !g_file_is_native (location))
+	{
+		return FALSE;
+	}
+
+	info = g_file_query_info (location,
+				  G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE,
+				  G_FILE_QUERY_INFO_NONE,
+				  NULL,
+				  NULL);
+
+	if (info != NULL)
+	{
+		use = (g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR &&
+		       g_file_info_get_size (info) >= (goffset) threshold * 1024 * 1024);
+
+		g_object_unref (info);
+	}
+
+	return use;
+}
+
+/* ex:set ts=8 noet: */
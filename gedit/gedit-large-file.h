@@ -0,0 +1,65 @@
+/*
+ * gedit-large-file.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_LARGE_FILE_H
+#define GEDIT_LARGE_FILE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GEDIT_TYPE_LARGE_FILE (gedit_large_file_get_type ())
+
+G_DECLARE_FINAL_TYPE (GeditLargeFile, gedit_large_file, GEDIT, LARGE_FILE, GObject)
+
+GeditLargeFile	*gedit_large_file_new			(GFile                *location,
+							 GError              **error);
+
+GFile		*gedit_large_file_get_location		(GeditLargeFile       *file);
+
+goffset		 gedit_large_file_get_size		(GeditLargeFile       *file);
+
+void		 gedit_large_file_index_async		(GeditLargeFile       *file,
+							 GCancellable         *cancellable,
+							 GAsyncReadyCallback   callback,
+							 gpointer              user_data);
+
+gboolean	 gedit_large_file_index_finish		(GeditLargeFile       *file,
+							 GAsyncResult         *result,
+							 GError              **error);
+
+gboolean	 gedit_large_file_is_indexing		(GeditLargeFile       *file);
+
+gboolean	 gedit_large_file_is_indexed		(GeditLargeFile       *file);
+
+gint64		 gedit_large_file_get_n_lines		(GeditLargeFile       *file);
+
+gchar		*gedit_large_file_get_lines		(GeditLargeFile       *file,
+							 gint64                first_line,
+							 gint                  n_lines);
+
+gboolean	 gedit_large_file_should_use		(GFile                *location,
+							 GSettings            *editor_settings);
+
+G_END_DECLS
+
+#endif /* GEDIT_LARGE_FILE_H */
+
+/* ex:set ts=8 noet: */
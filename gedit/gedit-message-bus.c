@@ -21,6 +21,7 @@
  */
 
 #include "gedit-message-bus.h"
+#include "gedit-message-private.h"
 
 #include <string.h>
 #include <stdarg.h>
@@ -108,50 +109,88 @@
  *                         NULL);
  * </programlisting>
  * </example>
+ *
+ * Senders of frequent messages can look up the id of the message type once
+ * with gedit_message_bus_lookup_id(), check with
+ * gedit_message_bus_has_listeners() that the message would be received, and
+ * reuse the messages with gedit_message_bus_acquire_message() and
+ * gedit_message_bus_release_message(). Such messages are dispatched without
+ * looking up their type by name.
+ */
+
+/* The (object path, method) pairs are interned in Message structs, which are
+ * kept until the bus is finalized, so that their ids stay valid. A message
+ * created by the bus knows its id, and is then dispatched without hashing its
+ * identifier.
  */
 
+/* The maximum number of released messages kept for each message type */
+#define MESSAGE_POOL_SIZE 8
+
+/* The maximum time spent dispatching the async messages in one go, in
+ * microseconds. The remaining messages are dispatched with a lower priority
+ * than the redraws and the input events.
+ */
+#define DISPATCH_TIME_SLICE 4000
+
 typedef struct
 {
-	gchar *object_path;
-	gchar *method;
-
-	gchar *identifier;
+	/* Interned strings when owned by a Message */
+	const gchar *object_path;
+	const gchar *method;
 } MessageIdentifier;
 
 typedef struct
 {
-	MessageIdentifier *identifier;
+	MessageIdentifier identifier;
+	guint id;
 
-	GList *listeners;
+	/* G_TYPE_INVALID when the message is not registered */
+	GType type;
+
+	GPtrArray *listeners;
+
+	/* The listeners removed while the message is dispatched are only
+	 * flagged, and removed from the array at the end of the dispatch.
+	 */
+	guint dispatching;
+	guint n_removed;
+
+	/* Released messages of @type, to be reused */
+	GPtrArray *pool;
+
+	GeditMessageQueuePolicy policy;
+
+	/* With the merge policy, the arguments compared to merge two messages
+	 * (NULL for all of them) and the links of the pending messages in the
+	 * queue.
+	 */
+	gchar **merge_keys;
+	GPtrArray *pending;
 } Message;
 
 typedef struct
 {
 	guint id;
-	gboolean blocked;
+	guint blocked : 1;
+	guint removed : 1;
 
 	GDestroyNotify destroy_data;
 	GeditMessageCallback callback;
 	gpointer user_data;
 } Listener;
 
-typedef struct
-{
-	Message *message;
-	GList *listener;
-} IdMap;
-
 struct _GeditMessageBusPrivate
 {
-	GHashTable *messages;
-	GHashTable *idmap;
+	GHashTable *messages; /* MessageIdentifier -> Message */
+	GPtrArray *message_ids; /* message id -> Message, 0 is unused */
+	GHashTable *idmap; /* listener id -> Message */
 
-	GList *message_queue;
+	GQueue message_queue;
 	guint idle_id;
+	guint max_queue_length;
 
 	guint next_id;
-
-	GHashTable *types; /* mapping from identifier to GeditMessageType */
 };
 
 /* signals */
@@ -170,44 +209,24 @@ static void gedit_message_bus_dispatch_real (GeditMessageBus *bus,
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditMessageBus, gedit_message_bus, G_TYPE_OBJECT)
 
-static MessageIdentifier *
-message_identifier_new (const gchar *object_path,
-                        const gchar *method)
-{
-	MessageIdentifier *ret;
-
-	ret = g_slice_new (MessageIdentifier);
-
-	ret->object_path = g_strdup (object_path);
-	ret->method = g_strdup (method);
-
-	ret->identifier = gedit_message_type_identifier (object_path, method);
-
-	return ret;
-}
-
-static void
-message_identifier_free (MessageIdentifier *identifier)
-{
-	g_free (identifier->object_path);
-	g_free (identifier->method);
-	g_free (identifier->identifier);
-
-	g_slice_free (MessageIdentifier, identifier);
-}
-
 static guint
 message_identifier_hash (gconstpointer id)
 {
-	return g_str_hash (((MessageIdentifier *)id)->identifier);
+	const MessageIdentifier *identifier = id;
+
+	return g_str_hash (identifier->object_path) * 31 +
+	       g_str_hash (identifier->method);
 }
 
 static gboolean
 message_identifier_equal (gconstpointer id1,
                           gconstpointer id2)
 {
-	return g_str_equal (((MessageIdentifier *)id1)->identifier,
-	                    ((MessageIdentifier *)id2)->identifier);
+	const MessageIdentifier *identifier1 = id1;
+	const MessageIdentifier *identifier2 = id2;
+
+	return g_str_equal (identifier1->object_path, identifier2->object_path) &&
+	       g_str_equal (identifier1->method, identifier2->method);
 }
 
 static void
@@ -222,18 +241,30 @@ listener_free (Listener *listener)
 }
 
 static void
-message_free (Message *message)
+message_clear_pool (Message *message)
 {
-	message_identifier_free (message->identifier);
+	guint i;
 
-	g_list_free_full (message->listeners, (GDestroyNotify) listener_free);
-	g_slice_free (Message, message);
+	for (i = 0; i < message->pool->len; i++)
+	{
+		g_object_unref (g_ptr_array_index (message->pool, i));
+	}
+
+	g_ptr_array_set_size (message->pool, 0);
 }
 
 static void
-message_queue_free (GList *queue)
+message_free (Message *message)
 {
-	g_list_free_full (queue, g_object_unref);
+	g_ptr_array_unref (message->listeners);
+
+	message_clear_pool (message);
+	g_ptr_array_unref (message->pool);
+
+	g_strfreev (message->merge_keys);
+	g_ptr_array_unref (message->pending);
+
+	g_slice_free (Message, message);
 }
 
 static void
@@ -246,11 +277,11 @@ gedit_message_bus_finalize (GObject *object)
 		g_source_remove (bus->priv->idle_id);
 	}
 
-	message_queue_free (bus->priv->message_queue);
+	g_queue_clear_full (&bus->priv->message_queue, g_object_unref);
 
-	g_hash_table_destroy (bus->priv->messages);
 	g_hash_table_destroy (bus->priv->idmap);
-	g_hash_table_destroy (bus->priv->types);
+	g_ptr_array_unref (bus->priv->message_ids);
+	g_hash_table_destroy (bus->priv->messages);
 
 	G_OBJECT_CLASS (gedit_message_bus_parent_class)->finalize (object);
 }
@@ -333,13 +364,20 @@ message_new (GeditMessageBus *bus,
              const gchar     *object_path,
              const gchar     *method)
 {
-	Message *message = g_slice_new (Message);
+	Message *message = g_slice_new0 (Message);
 
-	message->identifier = message_identifier_new (object_path, method);
-	message->listeners = NULL;
+	message->identifier.object_path = g_intern_string (object_path);
+	message->identifier.method = g_intern_string (method);
+	message->id = bus->priv->message_ids->len;
+	message->type = G_TYPE_INVALID;
+	message->listeners = g_ptr_array_new_with_free_func ((GDestroyNotify) listener_free);
+	message->pool = g_ptr_array_new ();
+	message->pending = g_ptr_array_new ();
+
+	g_ptr_array_add (bus->priv->message_ids, message);
 
 	g_hash_table_insert (bus->priv->messages,
-	                     message->identifier,
+	                     &message->identifier,
 	                     message);
 
 	return message;
@@ -351,24 +389,60 @@ lookup_message (GeditMessageBus *bus,
                 const gchar      *method,
                 gboolean          create)
 {
-	MessageIdentifier *identifier;
+	MessageIdentifier identifier = {object_path, method};
 	Message *message;
 
-	identifier = message_identifier_new (object_path, method);
-	message = g_hash_table_lookup (bus->priv->messages, identifier);
-	message_identifier_free (identifier);
+	message = g_hash_table_lookup (bus->priv->messages, &identifier);
 
-	if (!message && !create)
+	if (!message && create)
+	{
+		message = message_new (bus, object_path, method);
+	}
+
+	return message;
+}
+
+static Message *
+lookup_message_by_id (GeditMessageBus *bus,
+                      guint            message_id)
+{
+	if (message_id == 0 || message_id >= bus->priv->message_ids->len)
 	{
 		return NULL;
 	}
 
-	if (!message)
+	return g_ptr_array_index (bus->priv->message_ids, message_id);
+}
+
+static Message *
+lookup_message_for (GeditMessageBus *bus,
+                    GeditMessage    *message)
+{
+	const gchar *object_path;
+	const gchar *method;
+	Message *msg;
+
+	object_path = gedit_message_get_object_path (message);
+	method = gedit_message_get_method (message);
+
+	if (object_path == NULL || method == NULL)
 	{
-		message = message_new (bus, object_path, method);
+		return NULL;
 	}
 
-	return message;
+	/* The id is only valid on the bus which created the message, the
+	 * identifiers being interned strings tell if it is this one.
+	 */
+	msg = lookup_message_by_id (bus, _gedit_message_get_id (message));
+
+	if (msg != NULL &&
+	    msg->identifier.object_path == object_path &&
+	    msg->identifier.method == method)
+	{
+		return msg;
+	}
+
+	return lookup_message (bus, object_path, method, FALSE);
 }
 
 static guint
@@ -379,68 +453,79 @@ add_listener (GeditMessageBus      *bus,
               GDestroyNotify        destroy_data)
 {
 	Listener *listener;
-	IdMap *idmap;
 
-	listener = g_slice_new (Listener);
+	listener = g_slice_new0 (Listener);
 	listener->id = ++bus->priv->next_id;
 	listener->callback = callback;
 	listener->user_data = user_data;
-	listener->blocked = FALSE;
 	listener->destroy_data = destroy_data;
 
-	message->listeners = g_list_append (message->listeners, listener);
-
-	idmap = g_new (IdMap, 1);
-	idmap->message = message;
-	idmap->listener = g_list_last (message->listeners);
+	g_ptr_array_add (message->listeners, listener);
 
-	g_hash_table_insert (bus->priv->idmap, GINT_TO_POINTER (listener->id), idmap);
+	g_hash_table_insert (bus->priv->idmap, GINT_TO_POINTER (listener->id), message);
 
 	return listener->id;
 }
 
+static void
+compact_listeners (Message *message)
+{
+	guint i = message->listeners->len;
+
+	while (i > 0 && message->n_removed > 0)
+	{
+		Listener *listener = g_ptr_array_index (message->listeners, --i);
+
+		if (listener->removed)
+		{
+			g_ptr_array_remove_index (message->listeners, i);
+			message->n_removed--;
+		}
+	}
+}
+
 static void
 remove_listener (GeditMessageBus *bus,
                  Message         *message,
-                 GList		 *listener)
+                 guint            index)
 {
 	Listener *lst;
 
-	lst = (Listener *)listener->data;
+	lst = g_ptr_array_index (message->listeners, index);
 
 	/* remove from idmap */
 	g_hash_table_remove (bus->priv->idmap, GINT_TO_POINTER (lst->id));
-	listener_free (lst);
-
-	/* remove from list of listeners */
-	message->listeners = g_list_delete_link (message->listeners, listener);
 
-	if (!message->listeners)
+	if (message->dispatching > 0)
+	{
+		lst->removed = TRUE;
+		message->n_removed++;
+	}
+	else
 	{
-		/* remove message because it does not have any listeners */
-		g_hash_table_remove (bus->priv->messages, message->identifier);
+		g_ptr_array_remove_index (message->listeners, index);
 	}
 }
 
 static void
 block_listener (GeditMessageBus *bus,
                 Message         *message,
-                GList           *listener)
+                guint            index)
 {
 	Listener *lst;
 
-	lst = listener->data;
+	lst = g_ptr_array_index (message->listeners, index);
 	lst->blocked = TRUE;
 }
 
 static void
 unblock_listener (GeditMessageBus *bus,
                   Message         *message,
-                  GList           *listener)
+                  guint            index)
 {
 	Listener *lst;
 
-	lst = listener->data;
+	lst = g_ptr_array_index (message->listeners, index);
 	lst->blocked = FALSE;
 }
 
@@ -449,34 +534,37 @@ dispatch_message_real (GeditMessageBus *bus,
                        Message         *msg,
                        GeditMessage    *message)
 {
-	GList *item;
+	guint i;
+
+	msg->dispatching++;
 
-	for (item = msg->listeners; item; item = item->next)
+	/* The listeners connected by the callbacks are called too */
+	for (i = 0; i < msg->listeners->len; i++)
 	{
-		Listener *listener = (Listener *)item->data;
+		Listener *listener = g_ptr_array_index (msg->listeners, i);
 
-		if (!listener->blocked)
+		if (!listener->blocked && !listener->removed)
 		{
 			listener->callback (bus, message, listener->user_data);
 		}
 	}
+
+	if (--msg->dispatching == 0 && msg->n_removed > 0)
+	{
+		compact_listeners (msg);
+	}
 }
 
 static void
 gedit_message_bus_dispatch_real (GeditMessageBus *bus,
                                  GeditMessage    *message)
 {
-	const gchar *object_path;
-	const gchar *method;
 	Message *msg;
 
-	object_path = gedit_message_get_object_path (message);
-	method = gedit_message_get_method (message);
-
-	g_return_if_fail (object_path != NULL);
-	g_return_if_fail (method != NULL);
+	g_return_if_fail (gedit_message_get_object_path (message) != NULL);
+	g_return_if_fail (gedit_message_get_method (message) != NULL);
 
-	msg = lookup_message (bus, object_path, method, FALSE);
+	msg = lookup_message_for (bus, message);
 
 	if (msg)
 	{
@@ -488,52 +576,119 @@ static void
 dispatch_message (GeditMessageBus *bus,
                   GeditMessage    *message)
 {
-	g_signal_emit (bus, message_bus_signals[DISPATCH], 0, message);
+	/* Without handlers connected to the signal, the default handler is
+	 * called directly, which saves the marshalling of the emission.
+	 */
+	if (G_LIKELY (!g_signal_has_handler_pending (bus,
+	                                             message_bus_signals[DISPATCH],
+	                                             0,
+	                                             FALSE)))
+	{
+		GEDIT_MESSAGE_BUS_GET_CLASS (bus)->dispatch (bus, message);
+	}
+	else
+	{
+		g_signal_emit (bus, message_bus_signals[DISPATCH], 0, message);
+	}
+}
+
+static gboolean idle_dispatch (GeditMessageBus *bus);
+
+static void
+schedule_dispatch (GeditMessageBus *bus,
+                   gint             priority)
+{
+	bus->priv->idle_id = g_idle_add_full (priority,
+	                                      (GSourceFunc)idle_dispatch,
+	                                      bus,
+	                                      NULL);
 }
 
 static gboolean
 idle_dispatch (GeditMessageBus *bus)
 {
-	GList *list;
-	GList *item;
+	GList *link;
+	gint64 end_time;
 
 	/* make sure to set idle_id to 0 first so that any new async messages
 	   will be queued properly */
 	bus->priv->idle_id = 0;
 
-	/* reverse queue to get correct delivery order */
-	list = g_list_reverse (bus->priv->message_queue);
-	bus->priv->message_queue = NULL;
+	end_time = g_get_monotonic_time () + DISPATCH_TIME_SLICE;
 
-	for (item = list; item; item = item->next)
+	while ((link = g_queue_pop_head_link (&bus->priv->message_queue)) != NULL)
 	{
-		GeditMessage *msg = GEDIT_MESSAGE (item->data);
+		GeditMessage *msg = link->data;
+		Message *message;
+
+		message = lookup_message_for (bus, msg);
+
+		if (message != NULL && message->pending->len > 0)
+		{
+			g_ptr_array_remove (message->pending, link);
+		}
+
+		g_list_free_1 (link);
 
 		dispatch_message (bus, msg);
+		g_object_unref (msg);
+
+		if (g_get_monotonic_time () >= end_time &&
+		    bus->priv->message_queue.length > 0)
+		{
+			break;
+		}
 	}
 
-	message_queue_free (list);
-	return FALSE;
+	/* A flood of messages must not freeze the UI */
+	if (bus->priv->message_queue.length > 0 && bus->priv->idle_id == 0)
+	{
+		schedule_dispatch (bus, G_PRIORITY_DEFAULT_IDLE);
+	}
+
+	return G_SOURCE_REMOVE;
 }
 
-typedef void (*MatchCallback) (GeditMessageBus *, Message *, GList *);
+typedef void (*MatchCallback) (GeditMessageBus *, Message *, guint);
+
+static gboolean
+find_listener (Message *message,
+               guint    id,
+               guint   *index)
+{
+	guint i;
+
+	for (i = 0; i < message->listeners->len; i++)
+	{
+		Listener *listener = g_ptr_array_index (message->listeners, i);
+
+		if (listener->id == id && !listener->removed)
+		{
+			*index = i;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
 
 static void
 process_by_id (GeditMessageBus *bus,
                guint            id,
                MatchCallback    processor)
 {
-	IdMap *idmap;
+	Message *message;
+	guint index;
 
-	idmap = (IdMap *)g_hash_table_lookup (bus->priv->idmap, GINT_TO_POINTER (id));
+	message = g_hash_table_lookup (bus->priv->idmap, GINT_TO_POINTER (id));
 
-	if (idmap == NULL)
+	if (message == NULL || !find_listener (message, id, &index))
 	{
 		g_warning ("No handler registered with id `%d'", id);
 		return;
 	}
 
-	processor (bus, idmap->message, idmap->listener);
+	processor (bus, message, index);
 }
 
 static void
@@ -545,7 +700,7 @@ process_by_match (GeditMessageBus      *bus,
                   MatchCallback         processor)
 {
 	Message *message;
-	GList *item;
+	guint i;
 
 	message = lookup_message (bus, object_path, method, FALSE);
 
@@ -555,14 +710,15 @@ process_by_match (GeditMessageBus      *bus,
 		return;
 	}
 
-	for (item = message->listeners; item; item = item->next)
+	for (i = 0; i < message->listeners->len; i++)
 	{
-		Listener *listener = (Listener *)item->data;
+		Listener *listener = g_ptr_array_index (message->listeners, i);
 
 		if (listener->callback == callback &&
-		    listener->user_data == user_data)
+		    listener->user_data == user_data &&
+		    !listener->removed)
 		{
-			processor (bus, message, item);
+			processor (bus, message, i);
 			return;
 		}
 	}
@@ -570,12 +726,6 @@ process_by_match (GeditMessageBus      *bus,
 	g_warning ("No such handler registered for %s.%s", object_path, method);
 }
 
-static void
-free_type (gpointer data)
-{
-	g_slice_free (GType, data);
-}
-
 static void
 gedit_message_bus_init (GeditMessageBus *self)
 {
@@ -586,15 +736,12 @@ gedit_message_bus_init (GeditMessageBus *self)
 	                                              NULL,
 	                                              (GDestroyNotify) message_free);
 
-	self->priv->idmap = g_hash_table_new_full (g_direct_hash,
-	                                           g_direct_equal,
-	                                           NULL,
-	                                           (GDestroyNotify) g_free);
+	self->priv->message_ids = g_ptr_array_new ();
+	g_ptr_array_add (self->priv->message_ids, NULL);
+
+	self->priv->idmap = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-	self->priv->types = g_hash_table_new_full (message_identifier_hash,
-	                                           message_identifier_equal,
-	                                           (GDestroyNotify) message_identifier_free,
-	                                           (GDestroyNotify) free_type);
+	g_queue_init (&self->priv->message_queue);
 }
 
 /**
@@ -655,25 +802,51 @@ gedit_message_bus_lookup (GeditMessageBus *bus,
                           const gchar	  *object_path,
                           const gchar	  *method)
 {
-	MessageIdentifier *identifier;
-	GType *message_type;
+	Message *message;
 
 	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), G_TYPE_INVALID);
 	g_return_val_if_fail (object_path != NULL, G_TYPE_INVALID);
 	g_return_val_if_fail (method != NULL, G_TYPE_INVALID);
 
-	identifier = message_identifier_new (object_path, method);
-	message_type = g_hash_table_lookup (bus->priv->types, identifier);
-	message_identifier_free (identifier);
+	message = lookup_message (bus, object_path, method, FALSE);
 
-	if (!message_type)
-	{
-		return G_TYPE_INVALID;
-	}
-	else
+	return message != NULL ? message->type : G_TYPE_INVALID;
+}
+
+/**
+ * gedit_message_bus_lookup_id:
+ * @bus: a #GeditMessageBus
+ * @object_path: the object path
+ * @method: the method
+ *
+ * Get the id of the message type registered for @method at @object_path.
+ * The id stays the same for the lifetime of @bus, and can be given to
+ * gedit_message_bus_has_listeners() and gedit_message_bus_acquire_message()
+ * to avoid looking up the message type by its name for each message.
+ *
+ * Return value: the id of the message type, or 0 if no message type is
+ *               registered for @method at @object_path
+ *
+ */
+guint
+gedit_message_bus_lookup_id (GeditMessageBus *bus,
+                             const gchar     *object_path,
+                             const gchar     *method)
+{
+	Message *message;
+
+	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), 0);
+	g_return_val_if_fail (object_path != NULL, 0);
+	g_return_val_if_fail (method != NULL, 0);
+
+	message = lookup_message (bus, object_path, method, FALSE);
+
+	if (message == NULL || message->type == G_TYPE_INVALID)
 	{
-		return *message_type;
+		return 0;
 	}
+
+	return message->id;
 }
 
 /**
@@ -696,28 +869,23 @@ gedit_message_bus_register (GeditMessageBus *bus,
                             const gchar     *object_path,
                             const gchar	    *method)
 {
-	MessageIdentifier *identifier;
-	GType *ntype;
+	Message *message;
 
 	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
 	g_return_if_fail (gedit_message_is_valid_object_path (object_path));
 	g_return_if_fail (g_type_is_a (message_type, GEDIT_TYPE_MESSAGE));
 
-	if (gedit_message_bus_is_registered (bus, object_path, method))
+	message = lookup_message (bus, object_path, method, TRUE);
+
+	if (message->type != G_TYPE_INVALID)
 	{
 		g_warning ("Message type for '%s.%s' is already registered",
 		           object_path,
 		           method);
 	}
 
-	identifier = message_identifier_new (object_path, method);
-	ntype = g_slice_new (GType);
-
-	*ntype = message_type;
-
-	g_hash_table_insert (bus->priv->types,
-	                     identifier,
-	                     ntype);
+	message->type = message_type;
+	message_clear_pool (message);
 
 	g_signal_emit (bus,
 	               message_bus_signals[REGISTERED],
@@ -727,26 +895,22 @@ gedit_message_bus_register (GeditMessageBus *bus,
 }
 
 static void
-gedit_message_bus_unregister_real (GeditMessageBus  *bus,
-                                   const gchar      *object_path,
-                                   const gchar      *method,
-                                   gboolean          remove_from_store)
+gedit_message_bus_unregister_real (GeditMessageBus *bus,
+                                   Message         *message)
 {
-	MessageIdentifier *identifier;
-
-	identifier = message_identifier_new (object_path, method);
-
-	if (!remove_from_store || g_hash_table_remove (bus->priv->types,
-	                                               identifier))
+	if (message->type == G_TYPE_INVALID)
 	{
-		g_signal_emit (bus,
-		               message_bus_signals[UNREGISTERED],
-		               0,
-		               object_path,
-		               method);
+		return;
 	}
 
-	message_identifier_free (identifier);
+	message->type = G_TYPE_INVALID;
+	message_clear_pool (message);
+
+	g_signal_emit (bus,
+	               message_bus_signals[UNREGISTERED],
+	               0,
+	               message->identifier.object_path,
+	               message->identifier.method);
 }
 
 /**
@@ -766,38 +930,18 @@ gedit_message_bus_unregister (GeditMessageBus  *bus,
                               const gchar      *object_path,
                               const gchar      *method)
 {
+	Message *message;
+
 	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
 	g_return_if_fail (object_path != NULL);
 	g_return_if_fail (method != NULL);
 
-	gedit_message_bus_unregister_real (bus,
-	                                   object_path,
-	                                   method,
-	                                   TRUE);
-}
-
-typedef struct
-{
-	GeditMessageBus *bus;
-	const gchar *object_path;
-} UnregisterInfo;
+	message = lookup_message (bus, object_path, method, FALSE);
 
-static gboolean
-unregister_each (MessageIdentifier *identifier,
-                 GType             *gtype,
-                 UnregisterInfo    *info)
-{
-	if (g_strcmp0 (identifier->object_path, info->object_path) == 0)
+	if (message != NULL)
 	{
-		gedit_message_bus_unregister_real (info->bus,
-		                                   identifier->object_path,
-		                                   identifier->method,
-		                                   FALSE);
-
-		return TRUE;
+		gedit_message_bus_unregister_real (bus, message);
 	}
-
-	return FALSE;
 }
 
 /**
@@ -816,14 +960,20 @@ void
 gedit_message_bus_unregister_all (GeditMessageBus *bus,
                                   const gchar     *object_path)
 {
-	UnregisterInfo info = {bus, object_path};
+	guint i;
 
 	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
 	g_return_if_fail (object_path != NULL);
 
-	g_hash_table_foreach_remove (bus->priv->types,
-	                             (GHRFunc)unregister_each,
-	                             &info);
+	for (i = 1; i < bus->priv->message_ids->len; i++)
+	{
+		Message *message = g_ptr_array_index (bus->priv->message_ids, i);
+
+		if (g_str_equal (message->identifier.object_path, object_path))
+		{
+			gedit_message_bus_unregister_real (bus, message);
+		}
+	}
 }
 
 /**
@@ -844,34 +994,11 @@ gedit_message_bus_is_registered (GeditMessageBus  *bus,
                                  const gchar	  *object_path,
                                  const gchar      *method)
 {
-	MessageIdentifier *identifier;
-	gboolean ret;
-
 	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), FALSE);
 	g_return_val_if_fail (object_path != NULL, FALSE);
 	g_return_val_if_fail (method != NULL, FALSE);
 
-	identifier = message_identifier_new (object_path, method);
-	ret = g_hash_table_lookup (bus->priv->types, identifier) != NULL;
-	message_identifier_free (identifier);
-
-	return ret;
-}
-
-typedef struct
-{
-	GeditMessageBusForeach func;
-	gpointer user_data;
-} ForeachInfo;
-
-static void
-foreach_type (MessageIdentifier *identifier,
-              GType              *message_type,
-              ForeachInfo       *info)
-{
-	info->func (identifier->object_path,
-	            identifier->method,
-	            info->user_data);
+	return gedit_message_bus_lookup (bus, object_path, method) != G_TYPE_INVALID;
 }
 
 /**
@@ -888,12 +1015,22 @@ gedit_message_bus_foreach (GeditMessageBus        *bus,
                            GeditMessageBusForeach  func,
                            gpointer		   user_data)
 {
-	ForeachInfo info = {func, user_data};
+	guint i;
 
 	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
 	g_return_if_fail (func != NULL);
 
-	g_hash_table_foreach (bus->priv->types, (GHFunc)foreach_type, &info);
+	for (i = 1; i < bus->priv->message_ids->len; i++)
+	{
+		Message *message = g_ptr_array_index (bus->priv->message_ids, i);
+
+		if (message->type != G_TYPE_INVALID)
+		{
+			func (message->identifier.object_path,
+			      message->identifier.method,
+			      user_data);
+		}
+	}
 }
 
 /**
@@ -1072,22 +1209,344 @@ gedit_message_bus_unblock_by_func (GeditMessageBus      *bus,
 	                  unblock_listener);
 }
 
+/**
+ * gedit_message_bus_has_listeners:
+ * @bus: a #GeditMessageBus
+ * @message_id: the id of a message type, see gedit_message_bus_lookup_id()
+ *
+ * Check whether callbacks are connected for the message type @message_id,
+ * so that senders can skip building messages which nobody would receive.
+ *
+ * Return value: %TRUE if at least one callback is connected
+ *
+ */
+gboolean
+gedit_message_bus_has_listeners (GeditMessageBus *bus,
+                                 guint            message_id)
+{
+	Message *message;
+
+	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), FALSE);
+
+	message = lookup_message_by_id (bus, message_id);
+
+	return message != NULL &&
+	       message->listeners->len > message->n_removed;
+}
+
+/**
+ * gedit_message_bus_acquire_message:
+ * @bus: a #GeditMessageBus
+ * @message_id: the id of a registered message type, see
+ *              gedit_message_bus_lookup_id()
+ *
+ * Get a message of the type registered for @message_id, taken from the
+ * messages released with gedit_message_bus_release_message() when possible.
+ * A reused message keeps the arguments of its previous use, which the caller
+ * is expected to set.
+ *
+ * The message is dispatched without looking up its type by name when it is
+ * sent on @bus.
+ *
+ * Return value: (transfer full): a #GeditMessage
+ *
+ */
+GeditMessage *
+gedit_message_bus_acquire_message (GeditMessageBus *bus,
+                                   guint            message_id)
+{
+	Message *message;
+	GeditMessage *msg;
+
+	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), NULL);
+
+	message = lookup_message_by_id (bus, message_id);
+
+	g_return_val_if_fail (message != NULL, NULL);
+	g_return_val_if_fail (message->type != G_TYPE_INVALID, NULL);
+
+	if (message->pool->len > 0)
+	{
+		msg = g_ptr_array_steal_index_fast (message->pool,
+		                                    message->pool->len - 1);
+	}
+	else
+	{
+		msg = g_object_new (message->type, NULL);
+	}
+
+	_gedit_message_set_identifier (msg,
+	                               message->identifier.object_path,
+	                               message->identifier.method,
+	                               message->id);
+
+	return msg;
+}
+
+/**
+ * gedit_message_bus_release_message:
+ * @bus: a #GeditMessageBus
+ * @message: (transfer full): a #GeditMessage
+ *
+ * Gives back a message acquired with gedit_message_bus_acquire_message(),
+ * to be reused when nothing else holds a reference on it. Otherwise it is
+ * simply unreffed.
+ *
+ */
+void
+gedit_message_bus_release_message (GeditMessageBus *bus,
+                                   GeditMessage    *message)
+{
+	Message *msg;
+
+	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
+	g_return_if_fail (GEDIT_IS_MESSAGE (message));
+
+	msg = lookup_message_for (bus, message);
+
+	if (msg != NULL &&
+	    G_OBJECT_TYPE (message) == msg->type &&
+	    G_OBJECT (message)->ref_count == 1 &&
+	    msg->pool->len < MESSAGE_POOL_SIZE)
+	{
+		g_ptr_array_add (msg->pool, message);
+	}
+	else
+	{
+		g_object_unref (message);
+	}
+}
+
+static gboolean
+message_argument_equal (GeditMessage *message1,
+                        GeditMessage *message2,
+                        GParamSpec   *spec)
+{
+	GValue value1 = G_VALUE_INIT;
+	GValue value2 = G_VALUE_INIT;
+	gboolean ret;
+
+	g_value_init (&value1, spec->value_type);
+	g_value_init (&value2, spec->value_type);
+
+	g_object_get_property (G_OBJECT (message1), spec->name, &value1);
+	g_object_get_property (G_OBJECT (message2), spec->name, &value2);
+
+	ret = g_param_values_cmp (spec, &value1, &value2) == 0;
+
+	g_value_unset (&value1);
+	g_value_unset (&value2);
+
+	return ret;
+}
+
+static gboolean
+message_can_merge (Message      *msg,
+                   GeditMessage *pending,
+                   GeditMessage *message)
+{
+	GObjectClass *klass;
+	gboolean ret = TRUE;
+
+	if (G_OBJECT_TYPE (pending) != G_OBJECT_TYPE (message))
+	{
+		return FALSE;
+	}
+
+	klass = G_OBJECT_GET_CLASS (message);
+
+	if (msg->merge_keys != NULL)
+	{
+		gchar **key;
+
+		for (key = msg->merge_keys; ret && *key != NULL; key++)
+		{
+			GParamSpec *spec;
+
+			spec = g_object_class_find_property (klass, *key);
+
+			if (spec != NULL && (spec->flags & G_PARAM_READABLE) != 0)
+			{
+				ret = message_argument_equal (pending, message, spec);
+			}
+		}
+	}
+	else
+	{
+		GParamSpec **specs;
+		guint n_specs;
+		guint i;
+
+		specs = g_object_class_list_properties (klass, &n_specs);
+
+		for (i = 0; ret && i < n_specs; i++)
+		{
+			/* The object path and the method are the same */
+			if (specs[i]->owner_type != GEDIT_TYPE_MESSAGE &&
+			    (specs[i]->flags & G_PARAM_READABLE) != 0)
+			{
+				ret = message_argument_equal (pending, message, specs[i]);
+			}
+		}
+
+		g_free (specs);
+	}
+
+	return ret;
+}
+
 static void
 send_message_real (GeditMessageBus *bus,
                    GeditMessage    *message)
 {
-	bus->priv->message_queue = g_list_prepend (bus->priv->message_queue,
-	                                           g_object_ref (message));
+	Message *msg;
+
+	msg = lookup_message_for (bus, message);
+
+	if (msg != NULL && msg->policy == GEDIT_MESSAGE_QUEUE_POLICY_MERGE)
+	{
+		guint i;
+
+		for (i = 0; i < msg->pending->len; i++)
+		{
+			GList *link = g_ptr_array_index (msg->pending, i);
+			GeditMessage *pending = link->data;
+
+			if (message_can_merge (msg, pending, message))
+			{
+				/* The newer message takes the place of the
+				 * pending one.
+				 */
+				link->data = g_object_ref (message);
+				g_object_unref (pending);
+				return;
+			}
+		}
+	}
+
+	if (msg != NULL &&
+	    msg->policy == GEDIT_MESSAGE_QUEUE_POLICY_DROP &&
+	    bus->priv->max_queue_length > 0 &&
+	    bus->priv->message_queue.length >= bus->priv->max_queue_length)
+	{
+		return;
+	}
+
+	g_queue_push_tail (&bus->priv->message_queue, g_object_ref (message));
+
+	if (msg != NULL && msg->policy == GEDIT_MESSAGE_QUEUE_POLICY_MERGE)
+	{
+		g_ptr_array_add (msg->pending, bus->priv->message_queue.tail);
+	}
 
 	if (bus->priv->idle_id == 0)
 	{
-		bus->priv->idle_id = g_idle_add_full (G_PRIORITY_HIGH,
-		                                      (GSourceFunc)idle_dispatch,
-		                                      bus,
-		                                      NULL);
+		schedule_dispatch (bus, G_PRIORITY_HIGH);
 	}
 }
 
+/**
+ * GeditMessageQueuePolicy:
+ * @GEDIT_MESSAGE_QUEUE_POLICY_KEEP: every message is queued.
+ * @GEDIT_MESSAGE_QUEUE_POLICY_MERGE: a message replaces a pending message
+ *   of the same type with the same arguments, at its place in the queue.
+ *   The compared arguments can be restricted with
+ *   gedit_message_bus_set_merge_keys().
+ * @GEDIT_MESSAGE_QUEUE_POLICY_DROP: the message is dropped when the queue
+ *   is full, see gedit_message_bus_set_max_queue_length().
+ *
+ * What happens to a message sent asynchronously, see
+ * gedit_message_bus_set_queue_policy().
+ */
+
+/**
+ * gedit_message_bus_set_queue_policy:
+ * @bus: a #GeditMessageBus
+ * @object_path: the object path
+ * @method: the method
+ * @policy: the #GeditMessageQueuePolicy
+ *
+ * Sets how the messages @method at @object_path sent asynchronously are
+ * queued. The merge policy suits messages reporting a state, of which only
+ * the last one matters, see gedit_message_bus_set_merge_keys(), and the drop
+ * policy suits messages which can be
+ * lost when a flood of messages is pending. The default policy keeps every
+ * message. The messages sent synchronously are not affected.
+ *
+ */
+void
+gedit_message_bus_set_queue_policy (GeditMessageBus         *bus,
+                                    const gchar             *object_path,
+                                    const gchar             *method,
+                                    GeditMessageQueuePolicy  policy)
+{
+	Message *message;
+
+	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
+	g_return_if_fail (object_path != NULL);
+	g_return_if_fail (method != NULL);
+
+	message = lookup_message (bus, object_path, method, TRUE);
+	message->policy = policy;
+
+	if (policy != GEDIT_MESSAGE_QUEUE_POLICY_MERGE)
+	{
+		g_ptr_array_set_size (message->pending, 0);
+	}
+}
+
+/**
+ * gedit_message_bus_set_merge_keys:
+ * @bus: a #GeditMessageBus
+ * @object_path: the object path
+ * @method: the method
+ * @keys: (array zero-terminated=1) (allow-none): the names of the arguments
+ *   identifying the state reported by the message, or %NULL for all of them
+ *
+ * Sets the arguments compared to merge the messages @method at @object_path
+ * with the %GEDIT_MESSAGE_QUEUE_POLICY_MERGE policy. A message replaces the
+ * pending message with the same @keys, for example the same document,
+ * whatever its other arguments. By default all the arguments are compared,
+ * so only the identical messages are merged.
+ *
+ */
+void
+gedit_message_bus_set_merge_keys (GeditMessageBus     *bus,
+                                  const gchar         *object_path,
+                                  const gchar         *method,
+                                  const gchar * const *keys)
+{
+	Message *message;
+
+	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
+	g_return_if_fail (object_path != NULL);
+	g_return_if_fail (method != NULL);
+
+	message = lookup_message (bus, object_path, method, TRUE);
+
+	g_strfreev (message->merge_keys);
+	message->merge_keys = g_strdupv ((gchar **) keys);
+}
+
+/**
+ * gedit_message_bus_set_max_queue_length:
+ * @bus: a #GeditMessageBus
+ * @max_length: the maximum number of pending messages, or 0 for no limit
+ *
+ * Sets the number of pending asynchronous messages from which the messages
+ * with the %GEDIT_MESSAGE_QUEUE_POLICY_DROP policy are dropped. The other
+ * messages are still queued. There is no limit by default.
+ *
+ */
+void
+gedit_message_bus_set_max_queue_length (GeditMessageBus *bus,
+                                        guint            max_length)
+{
+	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
+
+	bus->priv->max_queue_length = max_length;
+}
+
 /**
  * gedit_message_bus_send_message:
  * @bus: a #GeditMessageBus
@@ -1137,12 +1596,12 @@ create_message (GeditMessageBus *bus,
                 const gchar     *first_property,
                 va_list          var_args)
 {
-	GType message_type;
+	Message *message;
 	GeditMessage *msg;
 
-	message_type = gedit_message_bus_lookup (bus, object_path, method);
+	message = lookup_message (bus, object_path, method, FALSE);
 
-	if (message_type == G_TYPE_INVALID)
+	if (message == NULL || message->type == G_TYPE_INVALID)
 	{
 		g_warning ("Could not find message type for '%s.%s'",
 		           object_path,
@@ -1151,18 +1610,16 @@ create_message (GeditMessageBus *bus,
 		return NULL;
 	}
 
-	msg = GEDIT_MESSAGE (g_object_new_valist (message_type,
+	msg = GEDIT_MESSAGE (g_object_new_valist (message->type,
 	                                          first_property,
 	                                          var_args));
 
 	if (msg)
 	{
-		g_object_set (msg,
-		              "object_path",
-		              object_path,
-		              "method",
-		              method,
-		              NULL);
+		_gedit_message_set_identifier (msg,
+		                               message->identifier.object_path,
+		                               message->identifier.method,
+		                               message->id);
 	}
 
 	return msg;
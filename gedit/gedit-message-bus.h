@@ -36,6 +36,13 @@ G_BEGIN_DECLS
 #define GEDIT_IS_MESSAGE_BUS_CLASS(klass)	(G_TYPE_CHECK_CLASS_TYPE ((klass), GEDIT_TYPE_MESSAGE_BUS))
 #define GEDIT_MESSAGE_BUS_GET_CLASS(obj)	(G_TYPE_INSTANCE_GET_CLASS ((obj), GEDIT_TYPE_MESSAGE_BUS, GeditMessageBusClass))
 
+typedef enum
+{
+	GEDIT_MESSAGE_QUEUE_POLICY_KEEP,
+	GEDIT_MESSAGE_QUEUE_POLICY_MERGE,
+	GEDIT_MESSAGE_QUEUE_POLICY_DROP
+} GeditMessageQueuePolicy;
+
 typedef struct _GeditMessageBus		GeditMessageBus;
 typedef struct _GeditMessageBusClass	GeditMessageBusClass;
 typedef struct _GeditMessageBusPrivate	GeditMessageBusPrivate;
@@ -78,6 +85,10 @@ GType             gedit_message_bus_lookup             (GeditMessageBus        *
                                                         const gchar            *object_path,
                                                         const gchar            *method);
 
+guint             gedit_message_bus_lookup_id          (GeditMessageBus        *bus,
+                                                        const gchar            *object_path,
+                                                        const gchar            *method);
+
 void              gedit_message_bus_register           (GeditMessageBus        *bus,
                                                         GType                   message_type,
                                                         const gchar            *object_path,
@@ -147,6 +158,28 @@ GeditMessage     *gedit_message_bus_send_sync          (GeditMessageBus        *
                                                         const gchar            *first_property,
                                                         ...) G_GNUC_NULL_TERMINATED;
 
+gboolean          gedit_message_bus_has_listeners      (GeditMessageBus        *bus,
+                                                        guint                   message_id);
+
+GeditMessage     *gedit_message_bus_acquire_message    (GeditMessageBus        *bus,
+                                                        guint                   message_id);
+void              gedit_message_bus_release_message    (GeditMessageBus        *bus,
+                                                        GeditMessage           *message);
+
+void              gedit_message_bus_set_queue_policy   (GeditMessageBus        *bus,
+                                                        const gchar            *object_path,
+                                                        const gchar            *method,
+                                                        GeditMessageQueuePolicy policy);
+
+void              gedit_message_bus_set_merge_keys     (GeditMessageBus        *bus,
+                                                        const gchar            *object_path,
+                                                        const gchar            *method,
+                                                        const gchar * const    *keys);
+
+void              gedit_message_bus_set_max_queue_length
+                                                       (GeditMessageBus        *bus,
+                                                        guint                   max_length);
+
 G_END_DECLS
 
 #endif /* GEDIT_MESSAGE_BUS_H */
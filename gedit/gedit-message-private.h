@@ -0,0 +1,41 @@
+/*
+ * gedit-message-private.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_MESSAGE_PRIVATE_H
+#define GEDIT_MESSAGE_PRIVATE_H
+
+#include "gedit-message.h"
+
+G_BEGIN_DECLS
+
+G_GNUC_INTERNAL
+void		_gedit_message_set_identifier	(GeditMessage *message,
+						 const gchar  *object_path,
+						 const gchar  *method,
+						 guint         message_id);
+
+G_GNUC_INTERNAL
+guint		_gedit_message_get_id		(GeditMessage *message);
+
+G_END_DECLS
+
+#endif /* GEDIT_MESSAGE_PRIVATE_H */
+
+/* ex:set ts=8 noet: */
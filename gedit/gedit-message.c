@@ -21,6 +21,7 @@
  */
 
 #include "gedit-message.h"
+#include "gedit-message-private.h"
 
 #include <string.h>
 
@@ -41,8 +42,19 @@
 
 struct _GeditMessagePrivate
 {
-	gchar *object_path;
-	gchar *method;
+	/* Either the strings interned by the bus which created the message,
+	 * or the owned copies of the properties.
+	 */
+	const gchar *object_path;
+	const gchar *method;
+
+	gchar *owned_object_path;
+	gchar *owned_method;
+
+	/* The id of the message on the bus which created it, see
+	 * gedit_message_bus_lookup_id().
+	 */
+	guint id;
 };
 
 enum
@@ -62,8 +74,8 @@ gedit_message_finalize (GObject *object)
 {
 	GeditMessage *message = GEDIT_MESSAGE (object);
 
-	g_free (message->priv->object_path);
-	g_free (message->priv->method);
+	g_free (message->priv->owned_object_path);
+	g_free (message->priv->owned_method);
 
 	G_OBJECT_CLASS (gedit_message_parent_class)->finalize (object);
 }
@@ -103,12 +115,16 @@ gedit_message_set_property (GObject      *object,
 	switch (prop_id)
 	{
 		case PROP_OBJECT_PATH:
-			g_free (msg->priv->object_path);
-			msg->priv->object_path = g_value_dup_string (value);
+			g_free (msg->priv->owned_object_path);
+			msg->priv->owned_object_path = g_value_dup_string (value);
+			msg->priv->object_path = msg->priv->owned_object_path;
+			msg->priv->id = 0;
 			break;
 		case PROP_METHOD:
-			g_free (msg->priv->method);
-			msg->priv->method = g_value_dup_string (value);
+			g_free (msg->priv->owned_method);
+			msg->priv->owned_method = g_value_dup_string (value);
+			msg->priv->method = msg->priv->owned_method;
+			msg->priv->id = 0;
 			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -122,7 +138,6 @@ gedit_message_class_init (GeditMessageClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS(klass);
 
 	object_class->finalize = gedit_message_finalize;
-
 	object_class->get_property = gedit_message_get_property;
 	object_class->set_property = gedit_message_set_property;
 
@@ -195,6 +210,39 @@ gedit_message_get_object_path (GeditMessage *message)
 	return message->priv->object_path;
 }
 
+/*
+ * _gedit_message_set_identifier:
+ * @message: the #GeditMessage
+ * @object_path: the object path interned by the bus
+ * @method: the method interned by the bus
+ * @message_id: the id of the message on its bus
+ *
+ * Sets the identifier of a message created by a bus, without going through
+ * the properties. The strings are not copied, they must be the ones of the
+ * message type in the table of the bus.
+ */
+void
+_gedit_message_set_identifier (GeditMessage *message,
+                               const gchar  *object_path,
+                               const gchar  *method,
+                               guint         message_id)
+{
+	g_return_if_fail (GEDIT_IS_MESSAGE (message));
+
+	g_clear_pointer (&message->priv->owned_object_path, g_free);
+	g_clear_pointer (&message->priv->owned_method, g_free);
+
+	message->priv->object_path = object_path;
+	message->priv->method = method;
+	message->priv->id = message_id;
+}
+
+guint
+_gedit_message_get_id (GeditMessage *message)
+{
+	return message->priv->id;
+}
+
 /**
  * gedit_message_is_valid_object_path:
  * @object_path: (allow-none): the object path
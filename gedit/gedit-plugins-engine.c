@@ -29,18 +29,190 @@
 #include "gedit-debug.h"
 #include "gedit-dirs.h"
 #include "gedit-settings.h"
+#include "gedit-startup-trace.h"
 
 struct _GeditPluginsEngine
 {
 	PeasEngine parent_instance;
 
 	GSettings *plugin_settings;
+
+	/* The enabled plugins which are not loaded yet, with their triggers:
+	 * module name -> NULL-terminated array of triggers.
+	 */
+	GHashTable *deferred_plugins;
+
+	guint deferring : 1;
 };
 
 G_DEFINE_TYPE (GeditPluginsEngine, gedit_plugins_engine, PEAS_TYPE_ENGINE)
 
 static GeditPluginsEngine *default_engine = NULL;
 
+/* The plugins can declare in their .plugin file when they are needed, so that
+ * they are loaded on demand instead of during the startup, which saves the
+ * loading of the Python interpreter when all the Python plugins are deferred:
+ *
+ *   X-Activation=idle;action:win.quickopen;language:python3;
+ *
+ * - "idle": once the first window is painted;
+ * - "action:win.NAME" or "action:app.NAME": when the action is first
+ *   activated, a placeholder action being installed until then;
+ * - "language:ID": when a document of that language is first active.
+ *
+ * A plugin is loaded by the first of its triggers. Only the plugins enabled
+ * when gedit starts are deferred, the ones enabled later are loaded at once.
+ */
+
+static gchar **
+get_plugin_triggers (PeasPluginInfo *info)
+{
+	const gchar *activation;
+	gchar **triggers;
+	gchar **trigger;
+	GPtrArray *result;
+
+	activation = peas_plugin_info_get_external_data (info, "Activation");
+
+	if (activation == NULL)
+	{
+		return NULL;
+	}
+
+	triggers = g_strsplit (activation, ";", -1);
+	result = g_ptr_array_new ();
+
+	for (trigger = triggers; *trigger != NULL; trigger++)
+	{
+		g_strstrip (*trigger);
+
+		if ((*trigger)[0] != '\0')
+		{
+			g_ptr_array_add (result, g_strdup (*trigger));
+		}
+	}
+
+	g_strfreev (triggers);
+
+	if (result->len == 0)
+	{
+		g_ptr_array_free (result, TRUE);
+		return NULL;
+	}
+
+	g_ptr_array_add (result, NULL);
+	return (gchar **) g_ptr_array_free (result, FALSE);
+}
+
+/* GSettings -> "loaded-plugins": the deferred plugins are left out. */
+static gboolean
+active_plugins_get_mapping (GValue   *value,
+                            GVariant *variant,
+                            gpointer  user_data)
+{
+	GeditPluginsEngine *engine = GEDIT_PLUGINS_ENGINE (user_data);
+	GHashTable *active;
+	GHashTableIter iter;
+	gpointer key;
+	const gchar **modules;
+	GPtrArray *loaded;
+	gsize i;
+
+	modules = g_variant_get_strv (variant, NULL);
+	active = g_hash_table_new (g_str_hash, g_str_equal);
+	loaded = g_ptr_array_new ();
+
+	for (i = 0; modules[i] != NULL; i++)
+	{
+		const gchar *module = modules[i];
+		PeasPluginInfo *info;
+
+		g_hash_table_add (active, (gpointer) module);
+
+		if (g_hash_table_contains (engine->deferred_plugins, module))
+		{
+			continue;
+		}
+
+		info = peas_engine_get_plugin_info (PEAS_ENGINE (engine), module);
+
+		if (engine->deferring &&
+		    info != NULL &&
+		    !peas_plugin_info_is_loaded (info))
+		{
+			gchar **triggers = get_plugin_triggers (info);
+
+			if (triggers != NULL)
+			{
+				gedit_debug_message (DEBUG_PLUGINS,
+				                     "Deferring the plugin '%s'",
+				                     module);
+
+				g_hash_table_insert (engine->deferred_plugins,
+				                     g_strdup (module),
+				                     triggers);
+				continue;
+			}
+		}
+
+		g_ptr_array_add (loaded, g_strdup (module));
+	}
+
+	/* The deferred plugins disabled in the meantime */
+	g_hash_table_iter_init (&iter, engine->deferred_plugins);
+
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+	{
+		if (!g_hash_table_contains (active, key))
+		{
+			g_hash_table_iter_remove (&iter);
+		}
+	}
+
+	g_ptr_array_add (loaded, NULL);
+	g_value_take_boxed (value, g_ptr_array_free (loaded, FALSE));
+
+	g_hash_table_unref (active);
+	g_free (modules);
+
+	return TRUE;
+}
+
+/* "loaded-plugins" -> GSettings: the deferred plugins are still enabled. */
+static GVariant *
+active_plugins_set_mapping (const GValue       *value,
+                            const GVariantType *expected_type,
+                            gpointer            user_data)
+{
+	GeditPluginsEngine *engine = GEDIT_PLUGINS_ENGINE (user_data);
+	const gchar * const *loaded;
+	GVariantBuilder builder;
+	GHashTableIter iter;
+	gpointer key;
+	gsize i;
+
+	loaded = g_value_get_boxed (value);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_STRING_ARRAY);
+
+	for (i = 0; loaded != NULL && loaded[i] != NULL; i++)
+	{
+		g_variant_builder_add (&builder, "s", loaded[i]);
+	}
+
+	g_hash_table_iter_init (&iter, engine->deferred_plugins);
+
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+	{
+		if (loaded == NULL || !g_strv_contains (loaded, key))
+		{
+			g_variant_builder_add (&builder, "s", key);
+		}
+	}
+
+	return g_variant_builder_end (&builder);
+}
+
 static void
 gedit_plugins_engine_init (GeditPluginsEngine *engine)
 {
@@ -49,11 +221,15 @@ gedit_plugins_engine_init (GeditPluginsEngine *engine)
 
 	gedit_debug (DEBUG_PLUGINS);
 
+	gedit_startup_trace_begin ("python3-loader");
 	peas_engine_enable_loader (PEAS_ENGINE (engine), "python3");
+	gedit_startup_trace_end ("python3-loader");
 
 	engine->plugin_settings = g_settings_new ("org.gnome.gedit.plugins");
 
 	/* Require gedit's typelib. */
+	gedit_startup_trace_begin ("typelibs");
+
 	typelib_dir = g_build_filename (gedit_dirs_get_gedit_lib_dir (),
 	                                "girepository-1.0",
 	                                NULL);
@@ -85,6 +261,8 @@ gedit_plugins_engine_init (GeditPluginsEngine *engine)
 		error = NULL;
 	}
 
+	gedit_startup_trace_end ("typelibs");
+
 	peas_engine_add_search_path (PEAS_ENGINE (engine),
 	                             gedit_dirs_get_user_plugins_dir (),
 	                             gedit_dirs_get_user_plugins_dir ());
@@ -93,11 +271,43 @@ gedit_plugins_engine_init (GeditPluginsEngine *engine)
 	                             gedit_dirs_get_gedit_plugins_dir (),
 	                             gedit_dirs_get_gedit_plugins_data_dir ());
 
-	g_settings_bind (engine->plugin_settings,
-	                 GEDIT_SETTINGS_ACTIVE_PLUGINS,
-	                 engine,
-	                 "loaded-plugins",
-	                 G_SETTINGS_BIND_DEFAULT);
+	/* Loads the active plugins, except the deferred ones */
+	gedit_startup_trace_begin ("load-plugins");
+
+	engine->deferred_plugins = g_hash_table_new_full (g_str_hash,
+	                                                  g_str_equal,
+	                                                  g_free,
+	                                                  (GDestroyNotify) g_strfreev);
+
+	engine->deferring = TRUE;
+	g_settings_bind_with_mapping (engine->plugin_settings,
+	                              GEDIT_SETTINGS_ACTIVE_PLUGINS,
+	                              engine,
+	                              "loaded-plugins",
+	                              G_SETTINGS_BIND_DEFAULT,
+	                              active_plugins_get_mapping,
+	                              active_plugins_set_mapping,
+	                              engine,
+	                              NULL);
+	engine->deferring = FALSE;
+
+	gedit_startup_trace_end ("load-plugins");
+}
+
+static void
+gedit_plugins_engine_load_plugin (PeasEngine     *engine,
+                                  PeasPluginInfo *info)
+{
+	GeditPluginsEngine *gengine = GEDIT_PLUGINS_ENGINE (engine);
+
+	/* Also when loaded as the dependency of another plugin */
+	if (gengine->deferred_plugins != NULL)
+	{
+		g_hash_table_remove (gengine->deferred_plugins,
+		                     peas_plugin_info_get_module_name (info));
+	}
+
+	PEAS_ENGINE_CLASS (gedit_plugins_engine_parent_class)->load_plugin (engine, info);
 }
 
 static void
@@ -106,6 +316,7 @@ gedit_plugins_engine_dispose (GObject *object)
 	GeditPluginsEngine *engine = GEDIT_PLUGINS_ENGINE (object);
 
 	g_clear_object (&engine->plugin_settings);
+	g_clear_pointer (&engine->deferred_plugins, g_hash_table_unref);
 
 	G_OBJECT_CLASS (gedit_plugins_engine_parent_class)->dispose (object);
 }
@@ -114,8 +325,11 @@ static void
 gedit_plugins_engine_class_init (GeditPluginsEngineClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	PeasEngineClass *engine_class = PEAS_ENGINE_CLASS (klass);
 
 	object_class->dispose = gedit_plugins_engine_dispose;
+
+	engine_class->load_plugin = gedit_plugins_engine_load_plugin;
 }
 
 GeditPluginsEngine *
@@ -133,4 +347,229 @@ gedit_plugins_engine_get_default (void)
 	return default_engine;
 }
 
+static void
+load_deferred_plugins (GeditPluginsEngine *engine,
+                       const gchar        *trigger)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	GPtrArray *modules;
+	guint i;
+
+	if (engine->deferred_plugins == NULL ||
+	    g_hash_table_size (engine->deferred_plugins) == 0)
+	{
+		return;
+	}
+
+	/* The table changes while the plugins are loaded */
+	modules = g_ptr_array_new_with_free_func (g_free);
+
+	g_hash_table_iter_init (&iter, engine->deferred_plugins);
+
+	while (g_hash_table_iter_next (&iter, &key, &value))
+	{
+		if (trigger == NULL || g_strv_contains (value, trigger))
+		{
+			g_ptr_array_add (modules, g_strdup (key));
+		}
+	}
+
+	for (i = 0; i < modules->len; i++)
+	{
+		const gchar *module = g_ptr_array_index (modules, i);
+		PeasPluginInfo *info;
+
+		info = peas_engine_get_plugin_info (PEAS_ENGINE (engine), module);
+
+		gedit_debug_message (DEBUG_PLUGINS,
+		                     "Loading the deferred plugin '%s' on '%s'",
+		                     module,
+		                     trigger != NULL ? trigger : "demand");
+
+		if (info == NULL || !peas_engine_load_plugin (PEAS_ENGINE (engine), info))
+		{
+			/* Not tried again */
+			g_hash_table_remove (engine->deferred_plugins, module);
+		}
+	}
+
+	g_ptr_array_unref (modules);
+}
+
+/**
+ * gedit_plugins_engine_activate_trigger:
+ * @engine: a #GeditPluginsEngine.
+ * @trigger: a trigger, like "idle" or "language:c".
+ *
+ * Loads the deferred plugins waiting for @trigger. This is cheap when no
+ * plugin waits for it.
+ */
+void
+gedit_plugins_engine_activate_trigger (GeditPluginsEngine *engine,
+                                       const gchar        *trigger)
+{
+	g_return_if_fail (GEDIT_IS_PLUGINS_ENGINE (engine));
+	g_return_if_fail (trigger != NULL);
+
+	load_deferred_plugins (engine, trigger);
+}
+
+/**
+ * gedit_plugins_engine_load_deferred_plugins:
+ * @engine: a #GeditPluginsEngine.
+ *
+ * Loads all the deferred plugins, whatever their triggers. This is needed
+ * when the loaded plugins must match the settings, e.g. to show them in the
+ * preferences.
+ */
+void
+gedit_plugins_engine_load_deferred_plugins (GeditPluginsEngine *engine)
+{
+	g_return_if_fail (GEDIT_IS_PLUGINS_ENGINE (engine));
+
+	load_deferred_plugins (engine, NULL);
+}
+
+/**
+ * gedit_plugins_engine_has_deferred_trigger:
+ * @engine: a #GeditPluginsEngine.
+ * @trigger: a trigger.
+ *
+ * Returns: whether a deferred plugin waits for @trigger.
+ */
+gboolean
+gedit_plugins_engine_has_deferred_trigger (GeditPluginsEngine *engine,
+                                           const gchar        *trigger)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	g_return_val_if_fail (GEDIT_IS_PLUGINS_ENGINE (engine), FALSE);
+	g_return_val_if_fail (trigger != NULL, FALSE);
+
+	if (engine->deferred_plugins == NULL)
+	{
+		return FALSE;
+	}
+
+	g_hash_table_iter_init (&iter, engine->deferred_plugins);
+
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+	{
+		if (g_strv_contains (value, trigger))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void
+deferred_action_activate (GSimpleAction *action,
+                          GVariant      *parameter,
+                          GActionMap    *action_map)
+{
+	const gchar *trigger;
+	const gchar *name;
+	GAction *real_action;
+
+	trigger = g_object_get_data (G_OBJECT (action), "gedit-plugins-engine-trigger");
+	name = g_action_get_name (G_ACTION (action));
+
+	/* Keeps the placeholder alive while the plugin replaces it */
+	g_object_ref (action);
+
+	gedit_plugins_engine_activate_trigger (gedit_plugins_engine_get_default (),
+	                                       trigger);
+
+	real_action = g_action_map_lookup_action (action_map, name);
+
+	if (real_action != NULL && real_action != G_ACTION (action))
+	{
+		g_action_activate (real_action, parameter);
+	}
+
+	g_object_unref (action);
+}
+
+/**
+ * gedit_plugins_engine_add_deferred_actions:
+ * @engine: a #GeditPluginsEngine.
+ * @action_map: the #GActionMap of a window or of the application.
+ * @prefix: the prefix of the actions of @action_map, "win" or "app".
+ *
+ * Adds to @action_map a placeholder for each action triggering a deferred
+ * plugin. Activating a placeholder loads the plugins, which are expected to
+ * replace it by the real action, and then activates the real action.
+ */
+void
+gedit_plugins_engine_add_deferred_actions (GeditPluginsEngine *engine,
+                                           GActionMap         *action_map,
+                                           const gchar        *prefix)
+{
+	GHashTableIter iter;
+	gpointer value;
+	gchar *action_prefix;
+	gsize prefix_len;
+
+	g_return_if_fail (GEDIT_IS_PLUGINS_ENGINE (engine));
+	g_return_if_fail (G_IS_ACTION_MAP (action_map));
+	g_return_if_fail (prefix != NULL);
+
+	if (engine->deferred_plugins == NULL ||
+	    g_hash_table_size (engine->deferred_plugins) == 0)
+	{
+		return;
+	}
+
+	action_prefix = g_strconcat ("action:", prefix, ".", NULL);
+	prefix_len = strlen (action_prefix);
+
+	g_hash_table_iter_init (&iter, engine->deferred_plugins);
+
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+	{
+		gchar **trigger;
+
+		for (trigger = value; *trigger != NULL; trigger++)
+		{
+			const gchar *name;
+			GSimpleAction *action;
+
+			if (!g_str_has_prefix (*trigger, action_prefix))
+			{
+				continue;
+			}
+
+			name = *trigger + prefix_len;
+
+			if (!g_action_name_is_valid (name) ||
+			    g_action_map_lookup_action (action_map, name) != NULL)
+			{
+				continue;
+			}
+
+			action = g_simple_action_new (name, NULL);
+			g_object_set_data_full (G_OBJECT (action),
+			                        "gedit-plugins-engine-trigger",
+			                        g_strdup (*trigger),
+			                        g_free);
+
+			g_signal_connect_object (action,
+			                         "activate",
+			                         G_CALLBACK (deferred_action_activate),
+			                         action_map,
+			                         0);
+
+			g_action_map_add_action (action_map, G_ACTION (action));
+			g_object_unref (action);
+		}
+	}
+
+	g_free (action_prefix);
+}
+
 /* ex:set ts=8 noet: */
@@ -22,7 +22,7 @@
 #ifndef GEDIT_PLUGINS_ENGINE_H
 #define GEDIT_PLUGINS_ENGINE_H
 
-#include <glib.h>
+#include <gio/gio.h>
 #include <libpeas/peas.h>
 
 G_BEGIN_DECLS
@@ -32,6 +32,21 @@ G_DECLARE_FINAL_TYPE(GeditPluginsEngine, gedit_plugins_engine, GEDIT, PLUGINS_EN
 
 GeditPluginsEngine	*gedit_plugins_engine_get_default	(void);
 
+void			 gedit_plugins_engine_activate_trigger	(GeditPluginsEngine *engine,
+								 const gchar        *trigger);
+
+void			 gedit_plugins_engine_load_deferred_plugins
+								(GeditPluginsEngine *engine);
+
+gboolean		 gedit_plugins_engine_has_deferred_trigger
+								(GeditPluginsEngine *engine,
+								 const gchar        *trigger);
+
+void			 gedit_plugins_engine_add_deferred_actions
+								(GeditPluginsEngine *engine,
+								 GActionMap         *action_map,
+								 const gchar        *prefix);
+
 G_END_DECLS
 
 #endif  /* GEDIT_PLUGINS_ENGINE_H */
@@ -30,6 +30,7 @@
 
 #include "gedit-debug.h"
 #include "gedit-dirs.h"
+#include "gedit-plugins-engine.h"
 #include "gedit-settings.h"
 
 /*
@@ -826,6 +827,9 @@ setup_font_colors_page (GeditPreferencesDialog *dlg)
 static void
 setup_plugins_page (GeditPreferencesDialog *dlg)
 {
+	/* The deferred plugins must be shown as enabled */
+	gedit_plugins_engine_load_deferred_plugins (gedit_plugins_engine_get_default ());
+
 	gtk_widget_show_all (dlg->plugin_manager);
 }
 
@@ -0,0 +1,502 @@
+/*
+ * gedit-replace-all.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-replace-all.h"
+
+#include <glib/gi18n.h>
+
+#include "gedit-debug.h"
+
+/* gtk_source_search_context_replace_all() blocks the main loop until all the
+ * matches are replaced. Here, the matches are first searched in a worker
+ * thread, on a copy of the buffer text. The replacements are then applied on
+ * the main loop, a few milliseconds at a time, from the last match to the
+ * first one so that the offsets of the remaining matches stay valid. All the
+ * replacements are done inside one user action, so that they can be undone
+ * at once.
+ *
+ * The search uses a GRegex built from the search settings: the search text is
+ * escaped when the regex search is disabled, and the word boundaries are
+ * checked with "\b". GRegex matches with the Unicode properties, so "\b"
+ * knows the non-ASCII letters, but it is not exactly the word boundary test
+ * of GtkSourceSearchContext for a plain-text search, which uses the Pango
+ * word breaks: "don" is a whole word in "don't" for "\b", not for Pango.
+ *
+ * If the buffer is modified by something else during the operation, it is
+ * stopped.
+ */
+
+/* Maximum time spent applying replacements in one main loop iteration. */
+#define APPLY_BUDGET_USEC 8000
+
+/* Number of matches between two checks of the cancellable in the thread. */
+#define CHECK_INTERVAL 4096
+
+typedef struct
+{
+	gint start;
+	gint end;
+
+	/* With references expanded, only when the regex search is enabled. */
+	gchar *replacement;
+} Match;
+
+typedef struct
+{
+	GtkSourceBuffer *buffer;
+	GtkSourceSearchContext *search_context;
+
+	GRegex *regex;
+	gchar *replace_text;
+
+	/* Snapshot of the buffer, used by the thread. */
+	gchar *text;
+	GArray *matches;
+
+	/* The matches are applied from the end. */
+	guint n_remaining;
+	guint n_replaced;
+
+	GeditReplaceAllProgressCallback progress_callback;
+	gpointer progress_callback_data;
+
+	gulong changed_handler_id;
+	guint idle_id;
+
+	guint expand_references : 1;
+	guint applying : 1;
+	guint buffer_modified : 1;
+	guint in_user_action : 1;
+	guint highlight : 1;
+} ReplaceAllData;
+
+static void
+match_clear (Match *match)
+{
+	g_free (match->replacement);
+}
+
+static void
+stop_applying (ReplaceAllData *data)
+{
+	if (data->idle_id != 0)
+	{
+		g_source_remove (data->idle_id);
+		data->idle_id = 0;
+	}
+
+	if (data->changed_handler_id != 0)
+	{
+		g_signal_handler_disconnect (data->buffer, data->changed_handler_id);
+		data->changed_handler_id = 0;
+	}
+
+	if (data->in_user_action)
+	{
+		gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (data->buffer));
+		gtk_source_search_context_set_highlight (data->search_context, data->highlight);
+		data->in_user_action = FALSE;
+	}
+}
+
+static void
+replace_all_data_free (ReplaceAllData *data)
+{
+	if (data != NULL)
+	{
+		stop_applying (data);
+
+		g_object_unref (data->buffer);
+		g_object_unref (data->search_context);
+		g_clear_pointer (&data->regex, g_regex_unref);
+		g_free (data->replace_text);
+		g_free (data->text);
+		g_clear_pointer (&data->matches, g_array_unref);
+
+		g_slice_free (ReplaceAllData, data);
+	}
+}
+
+static GRegex *
+create_regex (GtkSourceSearchSettings  *settings,
+	      GError                  **error)
+{
+	const gchar *search_text;
+	GRegexCompileFlags flags = G_REGEX_MULTILINE;
+	gchar *pattern;
+	GRegex *regex;
+
+	search_text = gtk_source_search_settings_get_search_text (settings);
+
+	if (gtk_source_search_settings_get_regex_enabled (settings))
+	{
+		pattern = g_strdup (search_text);
+	}
+	else
+	{
+		pattern = g_regex_escape_string (search_text, -1);
+	}
+
+	if (gtk_source_search_settings_get_at_word_boundaries (settings))
+	{
+		gchar *tmp = pattern;
+
+		pattern = g_strdup_printf ("\\b(?:%s)\\b", tmp);
+		g_free (tmp);
+	}
+
+	if (!gtk_source_search_settings_get_case_sensitive (settings))
+	{
+		flags |= G_REGEX_CASELESS;
+	}
+
+	regex = g_regex_new (pattern, flags, 0, error);
+	g_free (pattern);
+
+	return regex;
+}
+
+static void
+scan_thread (GTask        *task,
+	     gpointer      source_object,
+	     gpointer      task_data,
+	     GCancellable *cancellable)
+{
+	ReplaceAllData *data = task_data;
+	GMatchInfo *match_info = NULL;
+	const gchar *previous_end = data->text;
+	gint previous_end_offset = 0;
+	GError *error = NULL;
+
+	g_regex_match_full (data->regex, data->text, -1, 0, 0, &match_info, &error);
+
+	while (error == NULL && g_match_info_matches (match_info))
+	{
+		Match match = { 0 };
+		gint start_pos;
+		gint end_pos;
+
+		g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos);
+
+		/* Character offsets, computed incrementally. */
+		match.start = previous_end_offset + g_utf8_pointer_to_offset (previous_end, data->text + start_pos);
+		match.end = match.start + g_utf8_pointer_to_offset (data->text + start_pos, data->text + end_pos);
+
+		previous_end = data->text + end_pos;
+		previous_end_offset = match.end;
+
+		if (data->expand_references)
+		{
+			match.replacement = g_match_info_expand_references (match_info,
+									    data->replace_text,
+									    &error);
+
+			if (error != NULL)
+			{
+				break;
+			}
+		}
+
+		g_array_append_val (data->matches, match);
+
+		if (data->matches->len % CHECK_INTERVAL == 0 &&
+		    g_cancellable_set_error_if_cancelled (cancellable, &error))
+		{
+			break;
+		}
+
+		g_match_info_next (match_info, &error);
+	}
+
+	g_match_info_free (match_info);
+
+	if (error != NULL)
+	{
+		g_task_return_error (task, error);
+		return;
+	}
+
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+return_modified_error (GTask *task)
+{
+	g_task_return_new_error (task,
+				 G_IO_ERROR,
+				 G_IO_ERROR_FAILED,
+				 _("The document has been modified during the replacement"));
+}
+
+static void
+buffer_changed_cb (GtkTextBuffer *buffer,
+		   GTask         *task)
+{
+	ReplaceAllData *data = g_task_get_task_data (task);
+
+	if (data->applying)
+	{
+		return;
+	}
+
+	data->buffer_modified = TRUE;
+
+	/* While the replacements are applied, the operation stops now. During
+	 * the scan, scan_ready_cb() reports the error when the thread is done.
+	 */
+	if (data->idle_id != 0)
+	{
+		stop_applying (data);
+		return_modified_error (task);
+		g_object_unref (task);
+	}
+}
+
+static void
+replace_match (ReplaceAllData *data,
+	       const Match    *match)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (data->buffer);
+	GtkTextIter start;
+	GtkTextIter end;
+	const gchar *replacement;
+
+	replacement = data->expand_references ? match->replacement : data->replace_text;
+
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, match->start);
+	gtk_text_buffer_get_iter_at_offset (buffer, &end, match->end);
+
+	data->applying = TRUE;
+
+	gtk_text_buffer_delete (buffer, &start, &end);
+	gtk_text_buffer_insert (buffer, &start, replacement, -1);
+
+	data->applying = FALSE;
+}
+
+static gboolean
+apply_replacements_cb (GTask *task)
+{
+	ReplaceAllData *data = g_task_get_task_data (task);
+	gint64 start_time;
+
+	if (g_task_return_error_if_cancelled (task))
+	{
+		data->idle_id = 0;
+		stop_applying (data);
+		g_object_unref (task);
+		return G_SOURCE_REMOVE;
+	}
+
+	start_time = g_get_monotonic_time ();
+
+	while (data->n_remaining > 0)
+	{
+		data->n_remaining--;
+		replace_match (data, &g_array_index (data->matches, Match, data->n_remaining));
+		data->n_replaced++;
+
+		if (g_get_monotonic_time () - start_time > APPLY_BUDGET_USEC)
+		{
+			break;
+		}
+	}
+
+	if (data->progress_callback != NULL)
+	{
+		data->progress_callback (data->n_replaced,
+					 data->matches->len,
+					 data->progress_callback_data);
+	}
+
+	if (data->n_remaining > 0)
+	{
+		return G_SOURCE_CONTINUE;
+	}
+
+	gedit_debug_message (DEBUG_COMMANDS, "Replaced %u occurrences", data->n_replaced);
+
+	data->idle_id = 0;
+	stop_applying (data);
+
+	g_task_return_int (task, data->n_replaced);
+	g_object_unref (task);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+scan_ready_cb (GObject      *source_object,
+	       GAsyncResult *result,
+	       gpointer      user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ReplaceAllData *data = g_task_get_task_data (task);
+	GError *error = NULL;
+
+	if (!g_task_propagate_boolean (G_TASK (result), &error))
+	{
+		stop_applying (data);
+		g_task_return_error (task, error);
+		g_object_unref (task);
+		return;
+	}
+
+	if (data->buffer_modified)
+	{
+		stop_applying (data);
+		return_modified_error (task);
+		g_object_unref (task);
+		return;
+	}
+
+	gedit_debug_message (DEBUG_COMMANDS, "Found %u occurrences", data->matches->len);
+
+	if (data->matches->len == 0)
+	{
+		stop_applying (data);
+		g_task_return_int (task, 0);
+		g_object_unref (task);
+		return;
+	}
+
+	data->n_remaining = data->matches->len;
+
+	/* Updating the highlighting on each replacement is slow. */
+	data->highlight = gtk_source_search_context_get_highlight (data->search_context);
+	gtk_source_search_context_set_highlight (data->search_context, FALSE);
+
+	gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (data->buffer));
+	data->in_user_action = TRUE;
+
+	/* The task reference is kept by the idle callback. */
+	data->idle_id = g_idle_add ((GSourceFunc) apply_replacements_cb, task);
+}
+
+static void
+free_snapshot (ReplaceAllData *data)
+{
+	g_clear_pointer (&data->text, g_free);
+}
+
+/*
+ * gedit_replace_all_async:
+ * @search_context: the #GtkSourceSearchContext defining the occurrences.
+ * @replace_text: the replacement text, already unescaped. When the regex search
+ *   is enabled, it can contain references.
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore.
+ * @progress_callback: (nullable): function called on the main loop after each
+ *   batch of replacements.
+ * @progress_callback_data: data passed to @progress_callback.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the request is
+ *   satisfied.
+ * @user_data: user data to pass to @callback.
+ *
+ * Replaces all the occurrences of the search context's buffer, without
+ * blocking the main loop.
+ */
+void
+gedit_replace_all_async (GtkSourceSearchContext          *search_context,
+			 const gchar                     *replace_text,
+			 GCancellable                    *cancellable,
+			 GeditReplaceAllProgressCallback  progress_callback,
+			 gpointer                         progress_callback_data,
+			 GAsyncReadyCallback              callback,
+			 gpointer                         user_data)
+{
+	GtkSourceSearchSettings *settings;
+	ReplaceAllData *data;
+	GTask *task;
+	GTask *scan_task;
+	GtkTextIter start;
+	GtkTextIter end;
+	GError *error = NULL;
+
+	g_return_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search_context));
+	g_return_if_fail (replace_text != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+
+	settings = gtk_source_search_context_get_settings (search_context);
+
+	data = g_slice_new0 (ReplaceAllData);
+	data->search_context = g_object_ref (search_context);
+	data->buffer = g_object_ref (gtk_source_search_context_get_buffer (search_context));
+	data->replace_text = g_strdup (replace_text);
+	data->expand_references = gtk_source_search_settings_get_regex_enabled (settings);
+	data->matches = g_array_new (FALSE, FALSE, sizeof (Match));
+	g_array_set_clear_func (data->matches, (GDestroyNotify) match_clear);
+	data->progress_callback = progress_callback;
+	data->progress_callback_data = progress_callback_data;
+	g_task_set_task_data (task, data, (GDestroyNotify) replace_all_data_free);
+
+	data->regex = create_regex (settings, &error);
+
+	if (data->regex == NULL ||
+	    (data->expand_references &&
+	     !g_regex_check_replacement (replace_text, NULL, &error)))
+	{
+		g_task_return_error (task, error);
+		g_object_unref (task);
+		return;
+	}
+
+	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (data->buffer), &start, &end);
+	data->text = gtk_text_buffer_get_slice (GTK_TEXT_BUFFER (data->buffer), &start, &end, TRUE);
+
+	data->changed_handler_id = g_signal_connect (data->buffer,
+						     "changed",
+						     G_CALLBACK (buffer_changed_cb),
+						     task);
+
+	/* The snapshot is freed as soon as the thread is finished. */
+	scan_task = g_task_new (NULL, cancellable, scan_ready_cb, task);
+	g_task_set_task_data (scan_task, data, (GDestroyNotify) free_snapshot);
+	g_task_run_in_thread (scan_task, scan_thread);
+	g_object_unref (scan_task);
+}
+
+/*
+ * gedit_replace_all_finish:
+ * @result: a #GAsyncResult.
+ * @n_replaced: (out) (optional): the number of occurrences replaced, even on
+ *   error or cancellation.
+ * @error: a location for a #GError, or %NULL.
+ *
+ * Returns: the number of occurrences replaced, or -1 on error.
+ */
+gint
+gedit_replace_all_finish (GAsyncResult  *result,
+			  guint         *n_replaced,
+			  GError       **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, NULL), -1);
+
+	if (n_replaced != NULL)
+	{
+		ReplaceAllData *data = g_task_get_task_data (G_TASK (result));
+		*n_replaced = data->n_replaced;
+	}
+
+	return g_task_propagate_int (G_TASK (result), error);
+}
+
+/* ex:set ts=8 noet: */
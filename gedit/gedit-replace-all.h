@@ -0,0 +1,48 @@
+/*
+ * gedit-replace-all.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_REPLACE_ALL_H
+#define GEDIT_REPLACE_ALL_H
+
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+typedef void (* GeditReplaceAllProgressCallback) (guint    n_replaced,
+						  guint    n_matches,
+						  gpointer user_data);
+
+void		gedit_replace_all_async		(GtkSourceSearchContext          *search_context,
+						 const gchar                     *replace_text,
+						 GCancellable                    *cancellable,
+						 GeditReplaceAllProgressCallback  progress_callback,
+						 gpointer                         progress_callback_data,
+						 GAsyncReadyCallback              callback,
+						 gpointer                         user_data);
+
+gint		gedit_replace_all_finish	(GAsyncResult                    *result,
+						 guint                           *n_replaced,
+						 GError                         **error);
+
+G_END_DECLS
+
+#endif /* GEDIT_REPLACE_ALL_H */
+
+/* ex:set ts=8 noet: */
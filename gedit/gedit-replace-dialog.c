@@ -49,10 +49,13 @@ struct _GeditReplaceDialog
 	GtkWidget *backwards_checkbutton;
 	GtkWidget *wrap_around_checkbutton;
 	GtkWidget *close_button;
+	GtkWidget *replace_all_button;
 
 	GeditDocument *active_document;
 
 	guint idle_update_sensitivity_id;
+
+	guint replace_all_running : 1;
 };
 
 G_DEFINE_TYPE (GeditReplaceDialog, gedit_replace_dialog, GTK_TYPE_DIALOG)
@@ -271,6 +274,12 @@ update_replace_response_sensitivity_cb (GeditReplaceDialog *dialog)
 	GtkTextIter end;
 	gint pos;
 
+	if (dialog->replace_all_running)
+	{
+		dialog->idle_update_sensitivity_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
 	if (has_replace_error (dialog))
 	{
 		gtk_dialog_set_response_sensitive (GTK_DIALOG (dialog),
@@ -347,6 +356,21 @@ update_responses_sensitivity (GeditReplaceDialog *dialog)
 	const gchar *search_text;
 	gboolean sensitive = TRUE;
 
+	/* Only the Replace All response, to stop it. */
+	if (dialog->replace_all_running)
+	{
+		gtk_dialog_set_response_sensitive (GTK_DIALOG (dialog),
+						   GEDIT_REPLACE_DIALOG_FIND_RESPONSE,
+						   FALSE);
+		gtk_dialog_set_response_sensitive (GTK_DIALOG (dialog),
+						   GEDIT_REPLACE_DIALOG_REPLACE_RESPONSE,
+						   FALSE);
+		gtk_dialog_set_response_sensitive (GTK_DIALOG (dialog),
+						   GEDIT_REPLACE_DIALOG_REPLACE_ALL_RESPONSE,
+						   TRUE);
+		return;
+	}
+
 	install_idle_update_sensitivity (dialog);
 
 	search_text = gtk_entry_get_text (GTK_ENTRY (dialog->search_text_entry));
@@ -476,6 +500,12 @@ response_cb (GtkDialog *dialog,
 	GeditReplaceDialog *dlg = GEDIT_REPLACE_DIALOG (dialog);
 	const gchar *str;
 
+	/* The response stops the Replace All. */
+	if (dlg->replace_all_running)
+	{
+		return;
+	}
+
 	switch (response_id)
 	{
 		case GEDIT_REPLACE_DIALOG_REPLACE_RESPONSE:
@@ -545,6 +575,7 @@ gedit_replace_dialog_class_init (GeditReplaceDialogClass *klass)
 	gtk_widget_class_bind_template_child (widget_class, GeditReplaceDialog, backwards_checkbutton);
 	gtk_widget_class_bind_template_child (widget_class, GeditReplaceDialog, wrap_around_checkbutton);
 	gtk_widget_class_bind_template_child (widget_class, GeditReplaceDialog, close_button);
+	gtk_widget_class_bind_template_child (widget_class, GeditReplaceDialog, replace_all_button);
 }
 
 static void
@@ -804,6 +835,39 @@ gedit_replace_dialog_get_backwards (GeditReplaceDialog *dialog)
 	return gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (dialog->backwards_checkbutton));
 }
 
+/* While a Replace All is running, the search can't be changed, and the Replace
+ * All button stops it.
+ */
+void
+gedit_replace_dialog_set_replace_all_running (GeditReplaceDialog *dialog,
+					      gboolean            running)
+{
+	g_return_if_fail (GEDIT_IS_REPLACE_DIALOG (dialog));
+
+	running = running != FALSE;
+
+	if (dialog->replace_all_running == running)
+	{
+		return;
+	}
+
+	dialog->replace_all_running = running;
+
+	gtk_widget_set_sensitive (dialog->grid, !running);
+	gtk_button_set_label (GTK_BUTTON (dialog->replace_all_button),
+			      running ? _("_Stop") : _("Replace _All"));
+
+	update_responses_sensitivity (dialog);
+}
+
+gboolean
+gedit_replace_dialog_get_replace_all_running (GeditReplaceDialog *dialog)
+{
+	g_return_val_if_fail (GEDIT_IS_REPLACE_DIALOG (dialog), FALSE);
+
+	return dialog->replace_all_running;
+}
+
 /* This function returns the original search text. The search text from the
  * search settings has been unescaped, and the escape function is not
  * reciprocal. So to avoid bugs, we have to deal with the original search text.
@@ -51,6 +51,11 @@ gboolean		 gedit_replace_dialog_get_backwards		(GeditReplaceDialog *dialog);
 void			 gedit_replace_dialog_set_replace_error		(GeditReplaceDialog *dialog,
 									 const gchar        *error_msg);
 
+void			 gedit_replace_dialog_set_replace_all_running	(GeditReplaceDialog *dialog,
+									 gboolean            running);
+
+gboolean		 gedit_replace_dialog_get_replace_all_running	(GeditReplaceDialog *dialog);
+
 G_END_DECLS
 
 #endif  /* GEDIT_REPLACE_DIALOG_H  */
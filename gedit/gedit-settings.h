@@ -91,6 +91,8 @@ GSList *	gedit_settings_get_candidate_encodings			(gboolean *default_candidates)
 #define GEDIT_SETTINGS_CANDIDATE_ENCODINGS		"candidate-encodings"
 #define GEDIT_SETTINGS_ACTIVE_PLUGINS			"active-plugins"
 #define GEDIT_SETTINGS_ENSURE_TRAILING_NEWLINE		"ensure-trailing-newline"
+#define GEDIT_SETTINGS_LARGE_FILE_THRESHOLD		"large-file-threshold"
+#define GEDIT_SETTINGS_MAX_CONCURRENT_LOADS		"max-concurrent-loads"
 
 /* window state keys */
 #define GEDIT_SETTINGS_WINDOW_STATE			"state"
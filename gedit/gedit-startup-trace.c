@@ -0,0 +1,279 @@
+/*
+ * gedit-startup-trace.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-startup-trace.h"
+
+#include <gio/gio.h>
+
+#include "gedit-debug.h"
+
+/* The startup trace records when the phases of the startup begin and end,
+ * until the first window is shown with its documents loaded. It is then
+ * written in the Trace Event Format, which can be opened in the
+ * chrome://tracing page of Chromium or in Perfetto.
+ *
+ * The trace is enabled by the GEDIT_STARTUP_TRACE environment variable or by
+ * the --startup-trace option, both giving the file to write. When the
+ * GEDIT_STARTUP_TRACE_QUIT environment variable is set, gedit quits once the
+ * trace is written, to measure the startup time repeatedly.
+ */
+
+typedef struct
+{
+	gchar *name;
+	gint64 time;
+	gchar phase;
+} TraceEvent;
+
+static gint64 start_time;
+static gchar *trace_filename;
+static GArray *trace_events;
+static gboolean quit_when_finished;
+
+static void
+trace_event_clear (TraceEvent *event)
+{
+	g_free (event->name);
+}
+
+/**
+ * gedit_startup_trace_init:
+ *
+ * Takes the time from which the events are measured, it should be called at
+ * the very beginning of main().
+ */
+void
+gedit_startup_trace_init (void)
+{
+	const gchar *filename;
+
+	start_time = g_get_monotonic_time ();
+
+	filename = g_getenv ("GEDIT_STARTUP_TRACE");
+
+	if (filename != NULL && filename[0] != '\0')
+	{
+		gedit_startup_trace_enable (filename);
+	}
+}
+
+/**
+ * gedit_startup_trace_enable:
+ * @filename: the file to write the trace to.
+ *
+ * Starts recording the events. Does nothing if the trace is already written.
+ */
+void
+gedit_startup_trace_enable (const gchar *filename)
+{
+	g_return_if_fail (filename != NULL);
+
+	if (trace_events != NULL)
+	{
+		g_free (trace_filename);
+		trace_filename = g_strdup (filename);
+		return;
+	}
+
+	if (trace_filename != NULL)
+	{
+		return;
+	}
+
+	trace_filename = g_strdup (filename);
+	trace_events = g_array_new (FALSE, FALSE, sizeof (TraceEvent));
+	g_array_set_clear_func (trace_events, (GDestroyNotify) trace_event_clear);
+
+	quit_when_finished = g_getenv ("GEDIT_STARTUP_TRACE_QUIT") != NULL;
+}
+
+/**
+ * gedit_startup_trace_is_enabled:
+ *
+ * Returns: whether the events are recorded.
+ */
+gboolean
+gedit_startup_trace_is_enabled (void)
+{
+	return trace_events != NULL;
+}
+
+static void
+add_event (const gchar *name,
+	   gchar        phase)
+{
+	TraceEvent event;
+
+	if (G_LIKELY (trace_events == NULL))
+	{
+		return;
+	}
+
+	event.name = g_strdup (name);
+	event.time = g_get_monotonic_time ();
+	event.phase = phase;
+
+	g_array_append_val (trace_events, event);
+}
+
+/**
+ * gedit_startup_trace_begin:
+ * @name: the name of the phase.
+ *
+ * Records the beginning of a phase of the startup. The phases can be nested,
+ * but each one must end before its parent.
+ */
+void
+gedit_startup_trace_begin (const gchar *name)
+{
+	add_event (name, 'B');
+}
+
+/**
+ * gedit_startup_trace_end:
+ * @name: the name of the phase.
+ *
+ * Records the end of a phase of the startup.
+ */
+void
+gedit_startup_trace_end (const gchar *name)
+{
+	add_event (name, 'E');
+}
+
+/**
+ * gedit_startup_trace_mark:
+ * @name: the name of the event.
+ *
+ * Records an instant event, like the first window being shown. Only the
+ * first event of a given name is recorded.
+ */
+void
+gedit_startup_trace_mark (const gchar *name)
+{
+	guint i;
+
+	if (G_LIKELY (trace_events == NULL))
+	{
+		return;
+	}
+
+	for (i = 0; i < trace_events->len; i++)
+	{
+		TraceEvent *event = &g_array_index (trace_events, TraceEvent, i);
+
+		if (event->phase == 'i' && g_str_equal (event->name, name))
+		{
+			return;
+		}
+	}
+
+	add_event (name, 'i');
+}
+
+static void
+append_json_string (GString     *json,
+		    const gchar *str)
+{
+	g_string_append_c (json, '"');
+
+	for (; *str != '\0'; str++)
+	{
+		guchar c = *str;
+
+		if (c == '"' || c == '\\')
+		{
+			g_string_append_c (json, '\\');
+			g_string_append_c (json, c);
+		}
+		else if (c < 0x20)
+		{
+			g_string_append_printf (json, "\\u%04x", c);
+		}
+		else
+		{
+			g_string_append_c (json, c);
+		}
+	}
+
+	g_string_append_c (json, '"');
+}
+
+/**
+ * gedit_startup_trace_finish:
+ *
+ * Writes the trace and stops recording the events.
+ */
+void
+gedit_startup_trace_finish (void)
+{
+	GString *json;
+	GError *error = NULL;
+	guint i;
+
+	if (trace_events == NULL)
+	{
+		return;
+	}
+
+	json = g_string_new ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	for (i = 0; i < trace_events->len; i++)
+	{
+		TraceEvent *event = &g_array_index (trace_events, TraceEvent, i);
+
+		g_string_append (json, "{\"name\":");
+		append_json_string (json, event->name);
+		g_string_append_printf (json,
+					",\"cat\":\"startup\",\"ph\":\"%c\",\"ts\":%" G_GINT64_FORMAT ",\"pid\":1,\"tid\":1%s}%s\n",
+					event->phase,
+					event->time - start_time,
+					event->phase == 'i' ? ",\"s\":\"g\"" : "",
+					i + 1 < trace_events->len ? "," : "");
+	}
+
+	g_string_append (json, "]}\n");
+
+	if (!g_file_set_contents (trace_filename, json->str, json->len, &error))
+	{
+		g_warning ("Could not write the startup trace: %s", error->message);
+		g_error_free (error);
+	}
+	else
+	{
+		gedit_debug_message (DEBUG_APP,
+				     "Startup trace of %u events written to %s",
+				     trace_events->len,
+				     trace_filename);
+	}
+
+	g_string_free (json, TRUE);
+
+	/* The trace filename is kept so that it is not enabled again. */
+	g_array_unref (trace_events);
+	trace_events = NULL;
+
+	if (quit_when_finished && g_application_get_default () != NULL)
+	{
+		g_application_quit (g_application_get_default ());
+	}
+}
+
+/* ex:set ts=8 noet: */
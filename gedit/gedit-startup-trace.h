@@ -0,0 +1,46 @@
+/*
+ * gedit-startup-trace.h
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_STARTUP_TRACE_H
+#define GEDIT_STARTUP_TRACE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void		 gedit_startup_trace_init		(void);
+
+void		 gedit_startup_trace_enable		(const gchar *filename);
+
+gboolean	 gedit_startup_trace_is_enabled		(void);
+
+void		 gedit_startup_trace_begin		(const gchar *name);
+
+void		 gedit_startup_trace_end		(const gchar *name);
+
+void		 gedit_startup_trace_mark		(const gchar *name);
+
+void		 gedit_startup_trace_finish		(void);
+
+G_END_DECLS
+
+#endif /* GEDIT_STARTUP_TRACE_H */
+
+/* ex:set ts=8 noet: */
@@ -41,6 +41,15 @@ void		 _gedit_tab_load			(GeditTab                *tab,
 							 gint                     column_pos,
 							 gboolean                 create);
 
+void		 _gedit_tab_load_deferred		(GeditTab                *tab,
+							 GFile                   *location,
+							 const GtkSourceEncoding *encoding,
+							 gint                     line_pos,
+							 gint                     column_pos,
+							 gboolean                 create);
+
+void		 _gedit_tab_start_deferred_load		(GeditTab                *tab);
+
 void		 _gedit_tab_load_stream			(GeditTab                *tab,
 							 GInputStream            *location,
 							 const GtkSourceEncoding *encoding,
@@ -74,6 +83,8 @@ gboolean	 _gedit_tab_get_can_close		(GeditTab                 *tab);
 
 GeditViewFrame	*_gedit_tab_get_view_frame		(GeditTab                 *tab);
 
+gboolean	 _gedit_tab_get_large_file_mode		(GeditTab                 *tab);
+
 G_END_DECLS
 
 #endif  /* GEDIT_TAB_PRIVATE_H */
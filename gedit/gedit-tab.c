@@ -39,9 +39,20 @@
 #include "gedit-enum-types.h"
 #include "gedit-settings.h"
 #include "gedit-view-frame.h"
+#include "gedit-large-file.h"
+#include "gedit-large-file-view.h"
+#include "gedit-encoding-detector.h"
+#include "gedit-journal.h"
+#include "gedit-startup-trace.h"
 
 #define GEDIT_TAB_KEY "GEDIT_TAB_KEY"
 
+/* The file loader and saver report their progress for each chunk, i.e.
+ * every few kilobytes. Updating the progress bar that often only wastes CPU
+ * time on big files.
+ */
+#define PROGRESS_UPDATE_INTERVAL_USEC (G_USEC_PER_SEC / 20)
+
 struct _GeditTab
 {
 	GtkBox parent_instance;
@@ -58,6 +69,23 @@ struct _GeditTab
 	GeditPrintJob *print_job;
 	GtkWidget *print_preview;
 
+	/* Monotonic time of the last update of the progress info bar. */
+	gint64 progress_update_time;
+
+	/* Set when the file is shown in the read-only large file mode, in
+	 * which case the document stays empty and the frame hidden.
+	 */
+	GeditLargeFile *large_file;
+	GtkWidget *large_file_view;
+	GCancellable *large_file_cancellable;
+
+	/* Loading parameters of a GEDIT_TAB_STATE_DEFERRED tab, the location
+	 * is the one of the GtkSourceFile.
+	 */
+	const GtkSourceEncoding *deferred_encoding;
+	gint deferred_line_pos;
+	gint deferred_column_pos;
+
 	GtkSourceFileSaverFlags save_flags;
 
 	guint idle_scroll;
@@ -65,12 +93,30 @@ struct _GeditTab
 	gint auto_save_interval;
 	guint auto_save_timeout;
 
+	/* Records the changes between two file savings, so that the auto-save
+	 * doesn't need to save the whole file each time.
+	 */
+	GeditJournal *journal;
+	guint64 journal_n_records_at_last_auto_save;
+
+	/* The location whose journal is taken by this tab, with
+	 * gedit_journal_claim().
+	 */
+	GFile *journal_location;
+
+	/* The records of a journal left by a previous gedit instance, while
+	 * the user is asked whether to restore them.
+	 */
+	GBytes *journal_records;
+
 	GCancellable *cancellable;
 
 	guint editable : 1;
 	guint auto_save : 1;
 
 	guint ask_if_externally_modified : 1;
+	guint deferred_create : 1;
+	guint journal_recovery_pending : 1;
 };
 
 typedef struct _SaverData SaverData;
@@ -110,9 +156,32 @@ struct _LoaderData
 	GTimer *timer;
 	gint line_pos;
 	gint column_pos;
+
+	/* For a loading task waiting in the pending_loads queue. */
+	const GtkSourceEncoding *scheduled_encoding;
+	gulong pending_cancelled_id;
+
+	/* Result of the encoding detection done before launching the loader. */
+	const GtkSourceEncoding *detected_encoding;
+	gint64 detection_usec;
+
 	guint user_requested_encoding : 1;
+	guint encoding_detection_done : 1;
+
+	/* Whether the loading task holds one of the running loads slots. */
+	guint holds_load_slot : 1;
 };
 
+/* File loadings started with _gedit_tab_load() are throttled: at most
+ * max-concurrent-loads loaders run at the same time, the other loading tasks
+ * wait in pending_loads, in order. Otherwise opening hundreds of files at once
+ * floods the main loop with the loaders' callbacks, and the first tab becomes
+ * editable only when all the files are loaded. A tab that is mapped (i.e. the
+ * active tab of a notebook) skips the queue.
+ */
+static GQueue pending_loads = G_QUEUE_INIT;
+static guint n_running_loads = 0;
+
 G_DEFINE_TYPE (GeditTab, gedit_tab, GTK_TYPE_BOX)
 
 enum
@@ -143,6 +212,8 @@ static void launch_loader (GTask                   *loading_task,
 
 static void launch_saver (GTask *saving_task);
 
+static void show_journal_recovery_info_bar (GeditTab *tab);
+
 static SaverData *
 saver_data_new (void)
 {
@@ -193,6 +264,195 @@ loader_data_free (LoaderData *data)
 	}
 }
 
+static guint
+get_max_concurrent_loads (void)
+{
+	GSettings *editor_settings;
+
+	editor_settings = _gedit_settings_peek_editor_settings (_gedit_settings_get_singleton ());
+
+	return MAX (1, g_settings_get_uint (editor_settings, GEDIT_SETTINGS_MAX_CONCURRENT_LOADS));
+}
+
+static void
+disconnect_pending_cancelled (GTask *loading_task)
+{
+	LoaderData *data = g_task_get_task_data (loading_task);
+
+	if (data->pending_cancelled_id != 0)
+	{
+		g_cancellable_disconnect (g_task_get_cancellable (loading_task),
+					  data->pending_cancelled_id);
+		data->pending_cancelled_id = 0;
+	}
+}
+
+static void
+start_scheduled_loader (GTask *loading_task)
+{
+	LoaderData *data = g_task_get_task_data (loading_task);
+
+	disconnect_pending_cancelled (loading_task);
+
+	data->holds_load_slot = TRUE;
+	n_running_loads++;
+
+	launch_loader (loading_task, data->scheduled_encoding);
+}
+
+static void
+start_pending_loads (void)
+{
+	guint max_loads = get_max_concurrent_loads ();
+
+	while (n_running_loads < max_loads &&
+	       !g_queue_is_empty (&pending_loads))
+	{
+		start_scheduled_loader (g_queue_pop_head (&pending_loads));
+	}
+}
+
+static gboolean
+return_cancelled_load_cb (gpointer user_data)
+{
+	GTask *loading_task = G_TASK (user_data);
+
+	g_task_return_boolean (loading_task, FALSE);
+	g_object_unref (loading_task);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+pending_load_cancelled_cb (GCancellable *cancellable,
+			   GTask        *loading_task)
+{
+	LoaderData *data = g_task_get_task_data (loading_task);
+	GList *link;
+
+	/* The handler can't be disconnected while it runs, and it is not
+	 * called again.
+	 */
+	data->pending_cancelled_id = 0;
+
+	link = g_queue_find (&pending_loads, loading_task);
+
+	if (link == NULL)
+	{
+		return;
+	}
+
+	gedit_debug_message (DEBUG_TAB, "Pending load cancelled");
+
+	g_queue_delete_link (&pending_loads, link);
+
+	/* Like a cancelled loader, but not during the "cancelled" emission,
+	 * which can come from a new load of the same tab.
+	 */
+	g_idle_add (return_cancelled_load_cb, loading_task);
+}
+
+static void
+schedule_loader (GTask                   *loading_task,
+		 const GtkSourceEncoding *encoding)
+{
+	LoaderData *data = g_task_get_task_data (loading_task);
+
+	data->scheduled_encoding = encoding;
+
+	if (gtk_widget_get_mapped (GTK_WIDGET (data->tab)))
+	{
+		start_scheduled_loader (loading_task);
+		return;
+	}
+
+	g_queue_push_tail (&pending_loads, loading_task);
+
+	/* A cancelled loading task leaves the queue right away, instead of
+	 * waiting for a slot to fail.
+	 */
+	if (g_task_get_cancellable (loading_task) != NULL)
+	{
+		data->pending_cancelled_id = g_cancellable_connect (g_task_get_cancellable (loading_task),
+								    G_CALLBACK (pending_load_cancelled_cb),
+								    loading_task,
+								    NULL);
+	}
+
+	start_pending_loads ();
+}
+
+static void
+release_load_slot (LoaderData *data)
+{
+	if (data->holds_load_slot)
+	{
+		data->holds_load_slot = FALSE;
+
+		g_assert (n_running_loads > 0);
+		n_running_loads--;
+
+		start_pending_loads ();
+	}
+}
+
+static GList *
+find_pending_load (GeditTab *tab)
+{
+	GList *l;
+
+	for (l = pending_loads.head; l != NULL; l = l->next)
+	{
+		LoaderData *data = g_task_get_task_data (l->data);
+
+		if (data->tab == tab)
+		{
+			return l;
+		}
+	}
+
+	return NULL;
+}
+
+/* The tab is visible, so its file must be loaded before the pending ones. */
+static void
+tab_mapped_cb (GtkWidget *widget,
+	       gpointer   user_data)
+{
+	GList *link;
+
+	_gedit_tab_start_deferred_load (GEDIT_TAB (widget));
+
+	link = find_pending_load (GEDIT_TAB (widget));
+
+	if (link != NULL)
+	{
+		GTask *loading_task = link->data;
+
+		g_queue_delete_link (&pending_loads, link);
+		start_scheduled_loader (loading_task);
+	}
+}
+
+static void
+cancel_pending_load (GeditTab *tab)
+{
+	GList *link;
+
+	link = find_pending_load (tab);
+
+	if (link != NULL)
+	{
+		GTask *loading_task = link->data;
+
+		g_queue_delete_link (&pending_loads, link);
+		disconnect_pending_cancelled (loading_task);
+
+		g_task_return_boolean (loading_task, FALSE);
+		g_object_unref (loading_task);
+	}
+}
+
 static void
 set_editable (GeditTab *tab,
 	      gboolean  editable)
@@ -204,8 +464,12 @@ set_editable (GeditTab *tab,
 
 	view = gedit_tab_get_view (tab);
 
+	/* The changes of a journal apply on the file content, so the document
+	 * stays read-only until the user has decided what to do with them.
+	 */
 	val = (tab->state == GEDIT_TAB_STATE_NORMAL &&
-	       tab->editable);
+	       tab->editable &&
+	       !tab->journal_recovery_pending);
 
 	gtk_text_view_set_editable (GTK_TEXT_VIEW (view), val);
 }
@@ -259,6 +523,92 @@ update_auto_save_timeout (GeditTab *tab)
 	}
 }
 
+/* Takes the journal of @location, only one tab can write the journal of a
+ * given file.
+ */
+static gboolean
+claim_journal (GeditTab *tab,
+	       GFile    *location)
+{
+	if (tab->journal_location != NULL)
+	{
+		if (g_file_equal (tab->journal_location, location))
+		{
+			return TRUE;
+		}
+
+		gedit_journal_unclaim (tab->journal_location);
+		g_clear_object (&tab->journal_location);
+	}
+
+	if (!gedit_journal_claim (location))
+	{
+		return FALSE;
+	}
+
+	tab->journal_location = g_object_ref (location);
+	return TRUE;
+}
+
+static void
+unclaim_journal (GeditTab *tab)
+{
+	if (tab->journal_location != NULL)
+	{
+		gedit_journal_unclaim (tab->journal_location);
+		g_clear_object (&tab->journal_location);
+	}
+}
+
+/* The journal must start when the buffer content is the same as the file. */
+static void
+update_journal (GeditTab *tab)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+	GFile *location;
+
+	if (tab->journal != NULL ||
+	    tab->journal_recovery_pending ||
+	    tab->large_file != NULL ||
+	    tab->state != GEDIT_TAB_STATE_NORMAL ||
+	    !tab->auto_save)
+	{
+		return;
+	}
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+	location = gtk_source_file_get_location (file);
+
+	if (location == NULL ||
+	    gtk_source_file_is_readonly (file) ||
+	    gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (doc)) ||
+	    !claim_journal (tab, location))
+	{
+		return;
+	}
+
+	tab->journal = gedit_journal_new (GTK_TEXT_BUFFER (doc), location);
+	tab->journal_n_records_at_last_auto_save = 0;
+}
+
+static void
+discard_journal (GeditTab *tab)
+{
+	if (tab->journal != NULL)
+	{
+		gedit_journal_discard (gedit_journal_get_location (tab->journal));
+		g_clear_object (&tab->journal);
+	}
+
+	/* During a recovery, the journal of the previous instance is kept. */
+	if (!tab->journal_recovery_pending)
+	{
+		unclaim_journal (tab);
+	}
+}
+
 static void
 gedit_tab_get_property (GObject    *object,
 		        guint       prop_id,
@@ -327,7 +677,17 @@ gedit_tab_dispose (GObject *object)
 	g_clear_object (&tab->editor_settings);
 	g_clear_object (&tab->print_job);
 	g_clear_object (&tab->print_preview);
+	g_clear_object (&tab->large_file);
+	g_clear_pointer (&tab->journal_records, g_bytes_unref);
 
+	/* The user has decided what to do with the changes when closing the
+	 * tab, they don't need to be recovered.
+	 */
+	discard_journal (tab);
+	unclaim_journal (tab);
+	tab->journal_recovery_pending = FALSE;
+
+	cancel_pending_load (tab);
 	remove_auto_save_timeout (tab);
 
 	if (tab->idle_scroll != 0)
@@ -342,6 +702,12 @@ gedit_tab_dispose (GObject *object)
 		g_clear_object (&tab->cancellable);
 	}
 
+	if (tab->large_file_cancellable != NULL)
+	{
+		g_cancellable_cancel (tab->large_file_cancellable);
+		g_clear_object (&tab->large_file_cancellable);
+	}
+
 	G_OBJECT_CLASS (gedit_tab_parent_class)->dispose (object);
 }
 
@@ -356,6 +722,10 @@ gedit_tab_grab_focus (GtkWidget *widget)
 	{
 		gtk_widget_grab_focus (tab->info_bar);
 	}
+	else if (tab->large_file_view != NULL)
+	{
+		gtk_widget_grab_focus (tab->large_file_view);
+	}
 	else
 	{
 		GeditView *view = gedit_tab_get_view (tab);
@@ -512,7 +882,8 @@ set_view_properties_according_to_state (GeditTab      *tab,
 	view = gedit_tab_get_view (tab);
 
 	val = ((state == GEDIT_TAB_STATE_NORMAL) &&
-	       tab->editable);
+	       tab->editable &&
+	       !tab->journal_recovery_pending);
 	gtk_text_view_set_editable (GTK_TEXT_VIEW (view), val);
 
 	val = ((state != GEDIT_TAB_STATE_LOADING) &&
@@ -542,13 +913,15 @@ gedit_tab_set_state (GeditTab      *tab,
 
 	/* Hide or show the document.
 	 * For GEDIT_TAB_STATE_LOADING_ERROR, tab->frame is either shown or
-	 * hidden, depending on the error.
+	 * hidden, depending on the error. In large file mode, the frame is
+	 * replaced by the large file view.
 	 */
 	if (state == GEDIT_TAB_STATE_SHOWING_PRINT_PREVIEW)
 	{
 		gtk_widget_hide (GTK_WIDGET (tab->frame));
 	}
-	else if (state != GEDIT_TAB_STATE_LOADING_ERROR)
+	else if (state != GEDIT_TAB_STATE_LOADING_ERROR &&
+		 tab->large_file_view == NULL)
 	{
 		gtk_widget_show (GTK_WIDGET (tab->frame));
 	}
@@ -557,6 +930,7 @@ gedit_tab_set_state (GeditTab      *tab,
 				       state);
 
 	update_auto_save_timeout (tab);
+	update_journal (tab);
 
 	g_object_notify_by_pspec (G_OBJECT (tab), properties[PROP_STATE]);
 	g_object_notify_by_pspec (G_OBJECT (tab), properties[PROP_CAN_CLOSE]);
@@ -617,6 +991,12 @@ set_info_bar (GeditTab        *tab,
 		gtk_widget_hide (tab->info_bar_hidden);
 
 		tab->info_bar = NULL;
+
+		/* The journal recovery waited for the previous info bar. */
+		if (tab->journal_recovery_pending && tab->journal_records != NULL)
+		{
+			show_journal_recovery_info_bar (tab);
+		}
 	}
 	else
 	{
@@ -764,6 +1144,7 @@ show_loading_info_bar (GTask *loading_task)
 	gchar *msg = NULL;
 	gchar *name_markup;
 	gchar *dirname_markup;
+	const gchar *icon_name;
 	gint len;
 
 	if (data->tab->info_bar != NULL)
@@ -830,7 +1211,7 @@ show_loading_info_bar (GTask *loading_task)
 			msg = g_strdup_printf (_("Reverting %s"), name_markup);
 		}
 
-		bar = tepl_progress_info_bar_new ("document-revert", msg, TRUE);
+		icon_name = "document-revert";
 	}
 	else
 	{
@@ -850,9 +1231,35 @@ show_loading_info_bar (GTask *loading_task)
 			msg = g_strdup_printf (_("Loading %s"), name_markup);
 		}
 
-		bar = tepl_progress_info_bar_new ("document-open", msg, TRUE);
+		icon_name = "document-open";
 	}
 
+	if (data->detected_encoding != NULL)
+	{
+		gchar *charset;
+		gchar *detection_markup;
+		gchar *full_msg;
+
+		charset = gtk_source_encoding_to_string (data->detected_encoding);
+
+		/* Translators: %s is an encoding (e.g. "Western (ISO-8859-15)")
+		 * and %.1f a duration in milliseconds.
+		 */
+		detection_markup = g_markup_printf_escaped (_("Encoding %s detected in %.1f ms"),
+							    charset,
+							    data->detection_usec / 1000.0);
+
+		full_msg = g_strdup_printf ("%s\n<small>%s</small>", msg, detection_markup);
+
+		g_free (msg);
+		msg = full_msg;
+
+		g_free (detection_markup);
+		g_free (charset);
+	}
+
+	bar = tepl_progress_info_bar_new (icon_name, msg, TRUE);
+
 	g_signal_connect_object (bar,
 				 "response",
 				 G_CALLBACK (load_cancelled),
@@ -951,12 +1358,26 @@ info_bar_set_progress (GeditTab *tab,
 		       goffset   total_size)
 {
 	TeplProgressInfoBar *progress_info_bar;
+	gint64 now;
 
 	if (tab->info_bar == NULL)
 	{
 		return;
 	}
 
+	now = g_get_monotonic_time ();
+
+	/* The final update is always shown. When the total size is unknown,
+	 * there is no final update, only the time counts.
+	 */
+	if (now - tab->progress_update_time < PROGRESS_UPDATE_INTERVAL_USEC &&
+	    !(total_size > 0 && size >= total_size))
+	{
+		return;
+	}
+
+	tab->progress_update_time = now;
+
 	gedit_debug_message (DEBUG_TAB, "%" G_GOFFSET_FORMAT "/%" G_GOFFSET_FORMAT, size, total_size);
 
 	g_return_if_fail (TEPL_IS_PROGRESS_INFO_BAR (tab->info_bar));
@@ -967,7 +1388,7 @@ info_bar_set_progress (GeditTab *tab,
 	{
 		gdouble frac = (gdouble)size / (gdouble)total_size;
 
-		tepl_progress_info_bar_set_fraction (progress_info_bar, frac);
+		tepl_progress_info_bar_set_fraction (progress_info_bar, MIN (frac, 1.0));
 	}
 	else if (size != 0)
 	{
@@ -1002,7 +1423,7 @@ should_show_progress_info (GTimer  **timer,
 	 * accurate (it takes initially more time for the first bytes, the
 	 * following chunks should arrive more quickly, as a rough guess).
 	 */
-	if (elapsed_time < 0.5)
+	if (elapsed_time < 0.5 || size == 0)
 	{
 		return FALSE;
 	}
@@ -1373,6 +1794,11 @@ gedit_tab_init (GeditTab *tab)
 			  "drop-uris",
 			  G_CALLBACK (on_drop_uris),
 			  tab);
+
+	g_signal_connect (tab,
+			  "map",
+			  G_CALLBACK (tab_mapped_cb),
+			  NULL);
 }
 
 GeditTab *
@@ -1451,6 +1877,33 @@ _gedit_tab_get_name (GeditTab *tab)
 	return tab_name;
 }
 
+/* The encoding that will most probably be used to load the file of a
+ * deferred tab.
+ */
+static const GtkSourceEncoding *
+get_deferred_encoding (GeditTab *tab)
+{
+	GeditDocument *doc;
+	gchar *charset;
+	const GtkSourceEncoding *encoding = NULL;
+
+	if (tab->deferred_encoding != NULL)
+	{
+		return tab->deferred_encoding;
+	}
+
+	doc = gedit_tab_get_document (tab);
+	charset = gedit_document_get_metadata (doc, GEDIT_METADATA_ATTRIBUTE_ENCODING);
+
+	if (charset != NULL)
+	{
+		encoding = gtk_source_encoding_get_from_charset (charset);
+		g_free (charset);
+	}
+
+	return encoding;
+}
+
 gchar *
 _gedit_tab_get_tooltip (GeditTab *tab)
 {
@@ -1497,8 +1950,20 @@ _gedit_tab_get_tooltip (GeditTab *tab)
 						ruri_markup);
 			break;
 		default:
-			content_type = gedit_document_get_content_type (doc);
-			mime_type = gedit_document_get_mime_type (doc);
+			if (tab->state == GEDIT_TAB_STATE_DEFERRED)
+			{
+				/* The file is not loaded yet, so the content
+				 * type can only be guessed from the file name.
+				 */
+				content_type = g_content_type_guess (ruri, NULL, 0, NULL);
+				mime_type = g_content_type_get_mime_type (content_type);
+			}
+			else
+			{
+				content_type = gedit_document_get_content_type (doc);
+				mime_type = gedit_document_get_mime_type (doc);
+			}
+
 			content_description = g_content_type_get_description (content_type);
 
 			if (content_description == NULL)
@@ -1511,8 +1976,15 @@ _gedit_tab_get_tooltip (GeditTab *tab)
 			g_free (mime_type);
 			g_free (content_description);
 
-			file = gedit_document_get_file (doc);
-			enc = gtk_source_file_get_encoding (file);
+			if (tab->state == GEDIT_TAB_STATE_DEFERRED)
+			{
+				enc = get_deferred_encoding (tab);
+			}
+			else
+			{
+				file = gedit_document_get_file (doc);
+				enc = gtk_source_file_get_encoding (file);
+			}
 
 			if (enc == NULL)
 			{
@@ -1780,6 +2252,172 @@ successful_load (GTask *loading_task)
 	g_signal_emit_by_name (doc, "loaded");
 }
 
+static void
+end_journal_recovery (GeditTab *tab)
+{
+	tab->journal_recovery_pending = FALSE;
+	g_clear_pointer (&tab->journal_records, g_bytes_unref);
+
+	/* Back to the editability set by the rest of the tab, e.g. read-only
+	 * when the file is already open in another window.
+	 */
+	set_editable (tab, tab->editable);
+}
+
+static void
+journal_recovery_info_bar_response (GtkWidget *info_bar,
+				    gint       response_id,
+				    GeditTab  *tab)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+	GFile *location;
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+	location = gtk_source_file_get_location (file);
+
+	if (response_id == GTK_RESPONSE_YES)
+	{
+		GeditJournal *journal;
+		GError *error = NULL;
+
+		/* The restored changes stay in the journal file, the new
+		 * changes are appended to it.
+		 */
+		journal = gedit_journal_new (GTK_TEXT_BUFFER (doc), location);
+
+		if (gedit_journal_replay (journal, tab->journal_records, &error))
+		{
+			g_clear_object (&tab->journal);
+			tab->journal = journal;
+			tab->journal_n_records_at_last_auto_save = 0;
+		}
+		else
+		{
+			g_warning ("Impossible to restore the unsaved changes: %s", error->message);
+			g_error_free (error);
+
+			gedit_journal_discard (location);
+			g_object_unref (journal);
+		}
+	}
+	else
+	{
+		gedit_journal_discard (location);
+	}
+
+	end_journal_recovery (tab);
+	set_info_bar (tab, NULL, GTK_RESPONSE_NONE);
+
+	update_journal (tab);
+}
+
+static void
+show_journal_recovery_info_bar (GeditTab *tab)
+{
+	TeplInfoBar *info_bar;
+	GeditDocument *doc;
+	gchar *name;
+	gchar *primary_msg;
+
+	doc = gedit_tab_get_document (tab);
+	name = gedit_document_get_short_name_for_display (doc);
+
+	primary_msg = g_strdup_printf (_("Unsaved changes to “%s” have been found."),
+				       name);
+	g_free (name);
+
+	info_bar = tepl_info_bar_new_simple (GTK_MESSAGE_QUESTION,
+					     primary_msg,
+					     _("gedit was not closed properly. Do you want to restore the changes?"));
+	g_free (primary_msg);
+
+	gtk_info_bar_add_button (GTK_INFO_BAR (info_bar),
+				 _("_Restore"),
+				 GTK_RESPONSE_YES);
+	gtk_info_bar_add_button (GTK_INFO_BAR (info_bar),
+				 _("_Discard"),
+				 GTK_RESPONSE_NO);
+
+	set_info_bar (tab, GTK_WIDGET (info_bar), GTK_RESPONSE_YES);
+
+	g_signal_connect (info_bar,
+			  "response",
+			  G_CALLBACK (journal_recovery_info_bar_response),
+			  tab);
+}
+
+static void
+journal_loaded_cb (GObject      *source_object,
+		   GAsyncResult *result,
+		   GeditTab     *tab)
+{
+	GBytes *records;
+	GError *error = NULL;
+
+	records = gedit_journal_load_finish (result, &error);
+
+	if (error != NULL)
+	{
+		gedit_debug_message (DEBUG_TAB, "Journal loading error: %s", error->message);
+		g_error_free (error);
+	}
+
+	/* The recovery has been aborted in the meantime, by a revert or
+	 * because the tab has been closed.
+	 */
+	if (!tab->journal_recovery_pending)
+	{
+		g_clear_pointer (&records, g_bytes_unref);
+		g_object_unref (tab);
+		return;
+	}
+
+	if (records != NULL)
+	{
+		tab->journal_records = records;
+
+		/* Another info bar is not replaced, the question is asked
+		 * when it is closed.
+		 */
+		if (tab->info_bar == NULL)
+		{
+			show_journal_recovery_info_bar (tab);
+		}
+	}
+	else
+	{
+		end_journal_recovery (tab);
+		update_journal (tab);
+	}
+
+	g_object_unref (tab);
+}
+
+/* Looks for the journal of a previous gedit instance that crashed. The
+ * document stays read-only until the user has decided what to do with the
+ * changes, since they apply on the file content.
+ */
+static void
+start_journal_recovery (GeditTab *tab,
+			GFile    *location)
+{
+	/* The file is already open in another tab, which has the journal. */
+	if (!claim_journal (tab, location))
+	{
+		return;
+	}
+
+	tab->journal_recovery_pending = TRUE;
+	set_editable (tab, tab->editable);
+
+	gedit_journal_load_async (location,
+				  NULL,
+				  (GAsyncReadyCallback) journal_loaded_cb,
+				  g_object_ref (tab));
+}
+
 static void
 load_cb (GtkSourceFileLoader *loader,
 	 GAsyncResult        *result,
@@ -1795,6 +2433,8 @@ load_cb (GtkSourceFileLoader *loader,
 
 	gtk_source_file_loader_load_finish (loader, result, &error);
 
+	release_load_slot (data);
+
 	if (error != NULL)
 	{
 		gedit_debug_message (DEBUG_TAB, "File loading error: %s", error->message);
@@ -1920,9 +2560,18 @@ load_cb (GtkSourceFileLoader *loader,
 
 	g_assert (error == NULL);
 
+	if (data->tab->state == GEDIT_TAB_STATE_LOADING &&
+	    location != NULL &&
+	    !create_named_new_doc)
+	{
+		start_journal_recovery (data->tab, location);
+	}
+
 	gedit_tab_set_state (data->tab, GEDIT_TAB_STATE_NORMAL);
 	successful_load (loading_task);
 
+	gedit_startup_trace_mark ("first-document-loaded");
+
 	if (!create_named_new_doc)
 	{
 		gedit_recent_add_document (doc);
@@ -1978,6 +2627,36 @@ get_candidate_encodings (GeditTab *tab)
 	return candidates;
 }
 
+static void
+encoding_detected_cb (GObject      *source_object,
+		      GAsyncResult *result,
+		      GTask        *loading_task)
+{
+	LoaderData *data = g_task_get_task_data (loading_task);
+	GError *error = NULL;
+
+	data->detected_encoding = gedit_encoding_detect_finish (result,
+								&data->detection_usec,
+								&error);
+	data->encoding_detection_done = TRUE;
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		release_load_slot (data);
+
+		g_task_return_boolean (loading_task, FALSE);
+		g_object_unref (loading_task);
+
+		g_error_free (error);
+		return;
+	}
+
+	/* Other errors are reported by the file loader. */
+	g_clear_error (&error);
+
+	launch_loader (loading_task, NULL);
+}
+
 static void
 launch_loader (GTask                   *loading_task,
 	       const GtkSourceEncoding *encoding)
@@ -1993,8 +2672,35 @@ launch_loader (GTask                   *loading_task,
 	}
 	else
 	{
+		GFile *location = gtk_source_file_loader_get_location (data->loader);
+
 		data->user_requested_encoding = FALSE;
 		candidate_encodings = get_candidate_encodings (data->tab);
+
+		/* Find the right candidate on samples of the file, in a worker
+		 * thread, so that the file loader converts the file only once.
+		 * The detection is done only for local files, reading the
+		 * samples of a remote file costs more than it saves.
+		 */
+		if (!data->encoding_detection_done &&
+		    location != NULL &&
+		    g_file_is_native (location))
+		{
+			gedit_encoding_detect_async (location,
+						     candidate_encodings,
+						     g_task_get_cancellable (loading_task),
+						     (GAsyncReadyCallback) encoding_detected_cb,
+						     loading_task);
+
+			g_slist_free (candidate_encodings);
+			return;
+		}
+
+		if (data->detected_encoding != NULL)
+		{
+			candidate_encodings = g_slist_prepend (candidate_encodings,
+							       (gpointer) data->detected_encoding);
+		}
 	}
 
 	gtk_source_file_loader_set_candidate_encodings (data->loader, candidate_encodings);
@@ -2059,7 +2765,7 @@ load_async (GeditTab                *tab,
 
 	_gedit_document_set_create (doc, create);
 
-	launch_loader (loading_task, encoding);
+	schedule_loader (loading_task, encoding);
 }
 
 static gboolean
@@ -2071,6 +2777,94 @@ load_finish (GeditTab     *tab,
 	return g_task_propagate_boolean (G_TASK (result), NULL);
 }
 
+static void
+large_file_indexed_cb (GeditLargeFile *large_file,
+		       GAsyncResult   *result,
+		       gpointer        user_data)
+{
+	GError *error = NULL;
+
+	if (!gedit_large_file_index_finish (large_file, result, &error))
+	{
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		{
+			g_warning ("Large file indexing error: %s", error->message);
+		}
+
+		g_error_free (error);
+	}
+}
+
+/* Opens @location in the read-only large file mode: the file is mapped in
+ * memory and shown in a GeditLargeFileView, the GtkTextBuffer is not filled.
+ * Returns FALSE if the file cannot be mapped, in which case the normal file
+ * loader should be used.
+ */
+static gboolean
+load_large_file (GeditTab *tab,
+		 GFile    *location,
+		 gint      line_pos)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+	GeditLargeFile *large_file;
+	GError *error = NULL;
+
+	g_return_val_if_fail (tab->state == GEDIT_TAB_STATE_NORMAL, FALSE);
+	g_return_val_if_fail (tab->large_file == NULL, FALSE);
+
+	large_file = gedit_large_file_new (location, &error);
+
+	if (large_file == NULL)
+	{
+		gedit_debug_message (DEBUG_TAB, "Large file mode not possible: %s", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+	gtk_source_file_set_location (file, location);
+	_gedit_document_set_create (doc, FALSE);
+
+	g_signal_emit_by_name (doc, "load");
+
+	/* The indexing goes on after the load, until the tab is closed. */
+	tab->large_file = large_file;
+	tab->large_file_cancellable = g_cancellable_new ();
+	gedit_large_file_index_async (large_file,
+				      tab->large_file_cancellable,
+				      (GAsyncReadyCallback) large_file_indexed_cb,
+				      NULL);
+
+	tab->large_file_view = gedit_large_file_view_new (large_file);
+
+	gtk_widget_hide (GTK_WIDGET (tab->frame));
+	gtk_box_pack_end (GTK_BOX (tab), tab->large_file_view, TRUE, TRUE, 0);
+	gtk_widget_show (tab->large_file_view);
+
+	set_editable (tab, FALSE);
+
+	/* The file is not loaded in the buffer, so there is nothing to
+	 * compare with the file on disk.
+	 */
+	tab->ask_if_externally_modified = FALSE;
+
+	if (line_pos > 0)
+	{
+		gedit_large_file_view_goto_line (GEDIT_LARGE_FILE_VIEW (tab->large_file_view),
+						 line_pos - 1);
+	}
+
+	gedit_recent_add_document (doc);
+	g_signal_emit_by_name (doc, "loaded");
+
+	/* The load is done. */
+	g_clear_object (&tab->cancellable);
+
+	return TRUE;
+}
+
 void
 _gedit_tab_load (GeditTab                *tab,
 		 GFile                   *location,
@@ -2087,6 +2881,16 @@ _gedit_tab_load (GeditTab                *tab,
 
 	tab->cancellable = g_cancellable_new ();
 
+	/* An explicitly requested encoding means that the user wants the file
+	 * to be converted, which needs the normal file loader.
+	 */
+	if (encoding == NULL &&
+	    gedit_large_file_should_use (location, tab->editor_settings) &&
+	    load_large_file (tab, location, line_pos))
+	{
+		return;
+	}
+
 	load_async (tab,
 		    location,
 		    encoding,
@@ -2098,6 +2902,79 @@ _gedit_tab_load (GeditTab                *tab,
 		    NULL);
 }
 
+/* Creates a tab shell for @location: the tab name and tooltip are available
+ * right away, from the location and the metadata, but the file is loaded only
+ * when the tab is shown for the first time. This keeps the memory usage low
+ * when a lot of files are opened at once.
+ */
+void
+_gedit_tab_load_deferred (GeditTab                *tab,
+			  GFile                   *location,
+			  const GtkSourceEncoding *encoding,
+			  gint                     line_pos,
+			  gint                     column_pos,
+			  gboolean                 create)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+
+	g_return_if_fail (GEDIT_IS_TAB (tab));
+	g_return_if_fail (G_IS_FILE (location));
+	g_return_if_fail (tab->state == GEDIT_TAB_STATE_NORMAL);
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+
+	/* Setting the location loads the metadata. */
+	gtk_source_file_set_location (file, location);
+	_gedit_document_set_create (doc, create);
+	_gedit_document_set_deferred (doc, TRUE);
+
+	tab->deferred_encoding = encoding;
+	tab->deferred_line_pos = line_pos;
+	tab->deferred_column_pos = column_pos;
+	tab->deferred_create = create != FALSE;
+
+	gedit_tab_set_state (tab, GEDIT_TAB_STATE_DEFERRED);
+}
+
+void
+_gedit_tab_start_deferred_load (GeditTab *tab)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+	GFile *location;
+
+	g_return_if_fail (GEDIT_IS_TAB (tab));
+
+	if (tab->state != GEDIT_TAB_STATE_DEFERRED)
+	{
+		return;
+	}
+
+	gedit_debug (DEBUG_TAB);
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+	location = gtk_source_file_get_location (file);
+	g_return_if_fail (location != NULL);
+
+	g_object_ref (location);
+
+	_gedit_document_set_deferred (doc, FALSE);
+	gedit_tab_set_state (tab, GEDIT_TAB_STATE_NORMAL);
+
+	_gedit_tab_load (tab,
+			 location,
+			 tab->deferred_encoding,
+			 tab->deferred_line_pos,
+			 tab->deferred_column_pos,
+			 tab->deferred_create);
+
+	tab->deferred_encoding = NULL;
+	g_object_unref (location);
+}
+
 static void
 load_stream_async (GeditTab                *tab,
 		   GInputStream            *stream,
@@ -2183,6 +3060,7 @@ revert_async (GeditTab            *tab,
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 	g_return_if_fail (tab->state == GEDIT_TAB_STATE_NORMAL ||
 	                  tab->state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION);
+	g_return_if_fail (tab->large_file == NULL);
 
 	if (tab->state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION)
 	{
@@ -2220,6 +3098,18 @@ _gedit_tab_revert (GeditTab *tab)
 
 	tab->cancellable = g_cancellable_new ();
 
+	/* The changes are thrown away. */
+	discard_journal (tab);
+
+	if (tab->journal_recovery_pending)
+	{
+		GeditDocument *doc = gedit_tab_get_document (tab);
+		GtkSourceFile *file = gedit_document_get_file (doc);
+
+		gedit_journal_discard (gtk_source_file_get_location (file));
+		end_journal_recovery (tab);
+	}
+
 	revert_async (tab,
 		      tab->cancellable,
 		      (GAsyncReadyCallback) load_finish,
@@ -2373,6 +3263,11 @@ save_cb (GtkSourceFileSaver *saver,
 	{
 		gedit_recent_add_document (doc);
 
+		/* The changes are now in the file. A new journal is started
+		 * when the state becomes normal.
+		 */
+		discard_journal (tab);
+
 		gedit_tab_set_state (tab, GEDIT_TAB_STATE_NORMAL);
 
 		tab->ask_if_externally_modified = TRUE;
@@ -2457,6 +3352,7 @@ _gedit_tab_save_async (GeditTab            *tab,
 	g_return_if_fail (tab->state == GEDIT_TAB_STATE_NORMAL ||
 	                  tab->state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION ||
 	                  tab->state == GEDIT_TAB_STATE_SHOWING_PRINT_PREVIEW);
+	g_return_if_fail (tab->large_file == NULL);
 
 	/* The Save and Save As window actions are insensitive when the print
 	 * preview is shown, but it's still possible to save several documents
@@ -2553,6 +3449,22 @@ gedit_tab_auto_save (GeditTab *tab)
 		return G_SOURCE_REMOVE;
 	}
 
+	/* While the user is editing, the changes are safe in the journal,
+	 * whose cost depends only on the size of the changes. The whole file
+	 * is saved only when the document has not changed during a whole
+	 * auto-save interval, which also starts a new journal.
+	 */
+	if (tab->journal != NULL &&
+	    gedit_journal_get_n_records (tab->journal) != tab->journal_n_records_at_last_auto_save)
+	{
+		gedit_debug_message (DEBUG_TAB, "Flush the journal");
+
+		tab->journal_n_records_at_last_auto_save = gedit_journal_get_n_records (tab->journal);
+		gedit_journal_flush (tab->journal);
+
+		return G_SOURCE_CONTINUE;
+	}
+
 	/* Set auto_save_timeout to 0 since the timeout is going to be destroyed */
 	tab->auto_save_timeout = 0;
 
@@ -2597,6 +3509,7 @@ _gedit_tab_save_as_async (GeditTab                 *tab,
 	g_return_if_fail (tab->state == GEDIT_TAB_STATE_NORMAL ||
 	                  tab->state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION ||
 	                  tab->state == GEDIT_TAB_STATE_SHOWING_PRINT_PREVIEW);
+	g_return_if_fail (tab->large_file == NULL);
 	g_return_if_fail (G_IS_FILE (location));
 	g_return_if_fail (encoding != NULL);
 
@@ -2929,7 +3842,8 @@ _gedit_tab_get_can_close (GeditTab *tab)
 	g_return_val_if_fail (GEDIT_IS_TAB (tab), FALSE);
 
 	/* if we are loading or reverting, the tab can be closed */
-	if (tab->state == GEDIT_TAB_STATE_LOADING ||
+	if (tab->state == GEDIT_TAB_STATE_DEFERRED ||
+	    tab->state == GEDIT_TAB_STATE_LOADING ||
 	    tab->state == GEDIT_TAB_STATE_LOADING_ERROR ||
 	    tab->state == GEDIT_TAB_STATE_REVERTING ||
 	    tab->state == GEDIT_TAB_STATE_REVERTING_ERROR) /* CHECK: I'm not sure this is the right behavior for REVERTING ERROR */
@@ -2993,6 +3907,16 @@ gedit_tab_set_auto_save_enabled	(GeditTab *tab,
 	{
 		tab->auto_save = enable;
 		update_auto_save_timeout (tab);
+
+		if (enable)
+		{
+			update_journal (tab);
+		}
+		else
+		{
+			discard_journal (tab);
+		}
+
 		return;
 	}
 }
@@ -3056,4 +3980,16 @@ _gedit_tab_get_view_frame (GeditTab *tab)
 	return tab->frame;
 }
 
+/* Returns whether @tab shows its file in the read-only large file mode. In
+ * that case the #GeditDocument is empty, so it must not be saved, reverted or
+ * printed.
+ */
+gboolean
+_gedit_tab_get_large_file_mode (GeditTab *tab)
+{
+	g_return_val_if_fail (GEDIT_IS_TAB (tab), FALSE);
+
+	return tab->large_file != NULL;
+}
+
 /* ex:set ts=8 noet: */
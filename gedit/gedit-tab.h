@@ -27,6 +27,29 @@
 
 G_BEGIN_DECLS
 
+/**
+ * GeditTabState:
+ * @GEDIT_TAB_STATE_NORMAL: the document is loaded and can be edited.
+ * @GEDIT_TAB_STATE_LOADING: the file is being loaded.
+ * @GEDIT_TAB_STATE_REVERTING: the file is being reverted.
+ * @GEDIT_TAB_STATE_SAVING: the document is being saved.
+ * @GEDIT_TAB_STATE_PRINTING: the document is being printed.
+ * @GEDIT_TAB_STATE_SHOWING_PRINT_PREVIEW: the print preview is shown.
+ * @GEDIT_TAB_STATE_LOADING_ERROR: the loading failed.
+ * @GEDIT_TAB_STATE_REVERTING_ERROR: the reverting failed.
+ * @GEDIT_TAB_STATE_SAVING_ERROR: the saving failed.
+ * @GEDIT_TAB_STATE_GENERIC_ERROR: another operation failed.
+ * @GEDIT_TAB_STATE_CLOSING: the tab is being closed.
+ * @GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION: the file has been
+ *   modified by another program, and the user is asked what to do.
+ * @GEDIT_TAB_STATE_DEFERRED: the file is not loaded yet. It is loaded when
+ *   the tab is shown for the first time. Until then, the #GeditDocument has
+ *   its location and metadata, but its buffer is empty: its content must not
+ *   be read or modified.
+ * @GEDIT_TAB_NUM_OF_STATES: the number of states, not a valid state.
+ *
+ * The state of a #GeditTab, see gedit_tab_get_state().
+ */
 typedef enum
 {
 	GEDIT_TAB_STATE_NORMAL = 0,
@@ -41,6 +64,7 @@ typedef enum
 	GEDIT_TAB_STATE_GENERIC_ERROR,
 	GEDIT_TAB_STATE_CLOSING,
 	GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION,
+	GEDIT_TAB_STATE_DEFERRED,
 	GEDIT_TAB_NUM_OF_STATES /* This is not a valid state */
 } GeditTabState;
 
@@ -74,6 +74,18 @@ struct _GeditWindowPrivate
 	guint 	        language_changed_id;
 	guint           wrap_mode_changed_id;
 
+	/* statusbar and actions updates, done once per frame */
+	guint           update_tick_id;
+	guint           pending_updates;
+
+	/* visual column of the cursor, cached for its line */
+	GeditView      *column_view;
+	gint            column_line;
+	gint            column_offset;
+	gint            column_visual;
+	gint            shown_line;
+	gint            shown_col;
+
 	/* Headerbars */
 	GtkWidget      *titlebar_paned;
 	GtkWidget      *side_headerbar;
@@ -54,6 +54,7 @@
 #include "gedit-status-menu-button.h"
 #include "gedit-settings.h"
 #include "gedit-menu-stack-switcher.h"
+#include "gedit-startup-trace.h"
 
 enum
 {
@@ -87,10 +88,23 @@ static const GtkTargetEntry drop_types [] = {
 	{ "text/uri-list", 0, TARGET_URI_LIST}
 };
 
+/* The parts of the window synced with the active tab in update_tick_cb() */
+enum
+{
+	UPDATE_CURSOR_POSITION = 1 << 0,
+	UPDATE_OVERWRITE_MODE  = 1 << 1,
+	UPDATE_LANGUAGE        = 1 << 2,
+	UPDATE_TAB_WIDTH       = 1 << 3,
+	UPDATE_ACTIONS         = 1 << 4
+};
+
 G_DEFINE_TYPE_WITH_PRIVATE (GeditWindow, gedit_window, GTK_TYPE_APPLICATION_WINDOW)
 
 /* Prototypes */
 static void remove_actions (GeditWindow *window);
+static void queue_update   (GeditWindow *window,
+			    guint        updates);
+static void update_actions_sensitivity (GeditWindow *window);
 
 static void
 gedit_window_get_property (GObject    *object,
@@ -186,6 +200,15 @@ gedit_window_dispose (GObject *object)
 		window->priv->bottom_panel_item_removed_handler_id = 0;
 	}
 
+	if (window->priv->update_tick_id != 0)
+	{
+		gtk_widget_remove_tick_callback (GTK_WIDGET (window),
+						 window->priv->update_tick_id);
+		window->priv->update_tick_id = 0;
+	}
+
+	window->priv->pending_updates = 0;
+
 	/* First of all, force collection so that plugins
 	 * really drop some of the references.
 	 */
@@ -351,6 +374,15 @@ gedit_window_key_press_event (GtkWidget   *widget,
 	/* handle mnemonics and accelerators */
 	if (!handled)
 	{
+		/* Several key presses can be handled before the next frame
+		 * syncs the actions, e.g. when undo is repeated: the
+		 * accelerators must see their current sensitivity.
+		 */
+		if (GEDIT_WINDOW (widget)->priv->pending_updates & UPDATE_ACTIONS)
+		{
+			update_actions_sensitivity (GEDIT_WINDOW (widget));
+		}
+
 		handled = gtk_window_activate_key (window, event);
 	}
 
@@ -569,9 +601,13 @@ update_actions_sensitivity (GeditWindow *window)
 	gboolean empty_search = FALSE;
 	GtkClipboard *clipboard;
 	gboolean enable_syntax_highlighting;
+	gboolean large_file_mode = FALSE;
 
 	gedit_debug (DEBUG_WINDOW);
 
+	/* An update done right away makes a queued one useless */
+	window->priv->pending_updates &= ~UPDATE_ACTIONS;
+
 	notebook = gedit_multi_notebook_get_active_notebook (window->priv->multi_notebook);
 	tab = gedit_multi_notebook_get_active_tab (window->priv->multi_notebook);
 	num_notebooks = gedit_multi_notebook_get_n_notebooks (window->priv->multi_notebook);
@@ -586,6 +622,7 @@ update_actions_sensitivity (GeditWindow *window)
 		tab_number = gtk_notebook_page_num (GTK_NOTEBOOK (notebook), GTK_WIDGET (tab));
 		editable = gtk_text_view_get_editable (GTK_TEXT_VIEW (view));
 		empty_search = _gedit_document_get_empty_search (doc);
+		large_file_mode = _gedit_tab_get_large_file_mode (tab);
 	}
 
 	clipboard = gtk_widget_get_clipboard (GTK_WIDGET (window), GDK_SELECTION_CLIPBOARD);
@@ -594,20 +631,22 @@ update_actions_sensitivity (GeditWindow *window)
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
 	                             ((state == GEDIT_TAB_STATE_NORMAL) ||
 	                              (state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION)) &&
-	                             (file != NULL) && !gtk_source_file_is_readonly (file));
+	                             (file != NULL) && !gtk_source_file_is_readonly (file) &&
+	                             !large_file_mode);
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "save-as");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
 	                             ((state == GEDIT_TAB_STATE_NORMAL) ||
 	                              (state == GEDIT_TAB_STATE_SAVING_ERROR) ||
 	                              (state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION)) &&
-	                             (doc != NULL));
+	                             (doc != NULL) && !large_file_mode);
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "revert");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
 	                             ((state == GEDIT_TAB_STATE_NORMAL) ||
 	                              (state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION)) &&
-	                             (doc != NULL) && !gedit_document_is_untitled (doc));
+	                             (doc != NULL) && !gedit_document_is_untitled (doc) &&
+	                             !large_file_mode);
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "reopen-closed-tab");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action), (window->priv->closed_docs_stack != NULL));
@@ -616,7 +655,7 @@ update_actions_sensitivity (GeditWindow *window)
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
 	                             ((state == GEDIT_TAB_STATE_NORMAL) ||
 	                              (state == GEDIT_TAB_STATE_SHOWING_PRINT_PREVIEW)) &&
-	                             (doc != NULL));
+	                             (doc != NULL) && !large_file_mode);
 
 	action = g_action_map_lookup_action (G_ACTION_MAP (window), "close");
 	g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
@@ -937,6 +976,86 @@ bracket_matched_cb (GtkSourceBuffer           *buffer,
 	}
 }
 
+/* Same as gtk_source_view_get_visual_column(), but reusing the column computed
+ * last time when the cursor stays on the same line: otherwise the whole start
+ * of the line is walked at each cursor move.
+ */
+static gint
+get_visual_column (GeditWindow       *window,
+		   GeditView         *view,
+		   const GtkTextIter *iter)
+{
+	GeditWindowPrivate *priv = window->priv;
+	gint line;
+	gint offset;
+	gint column = -1;
+
+	line = gtk_text_iter_get_line (iter);
+	offset = gtk_text_iter_get_line_offset (iter);
+
+	if (priv->column_view == view && priv->column_line == line)
+	{
+		GtkTextIter pos = *iter;
+		gint delta = offset - priv->column_offset;
+		gint i;
+
+		if (delta >= 0)
+		{
+			guint tab_width;
+
+			tab_width = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
+			column = priv->column_visual;
+
+			gtk_text_iter_backward_chars (&pos, delta);
+
+			for (i = 0; i < delta; i++)
+			{
+				if (gtk_text_iter_get_char (&pos) == '\t')
+					column += tab_width - (column % tab_width);
+				else
+					column++;
+
+				gtk_text_iter_forward_char (&pos);
+			}
+		}
+		else
+		{
+			/* Going back over characters other than tabs is
+			 * simple, else compute the column from scratch. */
+			column = priv->column_visual + delta;
+
+			for (i = 0; i < -delta; i++)
+			{
+				if (gtk_text_iter_get_char (&pos) == '\t')
+				{
+					column = -1;
+					break;
+				}
+
+				gtk_text_iter_forward_char (&pos);
+			}
+		}
+	}
+
+	if (column < 0)
+	{
+		column = gtk_source_view_get_visual_column (GTK_SOURCE_VIEW (view), iter);
+	}
+
+	priv->column_view = view;
+	priv->column_line = line;
+	priv->column_offset = offset;
+	priv->column_visual = column;
+
+	return column;
+}
+
+static void
+invalidate_visual_column (GeditWindow *window)
+{
+	window->priv->column_view = NULL;
+}
+
 static void
 update_cursor_position_statusbar (GtkTextBuffer *buffer,
 				  GeditWindow   *window)
@@ -958,7 +1077,13 @@ update_cursor_position_statusbar (GtkTextBuffer *buffer,
 					  gtk_text_buffer_get_insert (buffer));
 
 	line = 1 + gtk_text_iter_get_line (&iter);
-	col = 1 + gtk_source_view_get_visual_column (GTK_SOURCE_VIEW (view), &iter);
+	col = 1 + get_visual_column (window, view, &iter);
+
+	if (line == window->priv->shown_line && col == window->priv->shown_col)
+		return;
+
+	window->priv->shown_line = line;
+	window->priv->shown_col = col;
 
 	if ((line >= 0) || (col >= 0))
 	{
@@ -972,6 +1097,26 @@ update_cursor_position_statusbar (GtkTextBuffer *buffer,
 	g_free (msg);
 }
 
+static void
+cursor_moved (GeditDocument *doc,
+	      GeditWindow   *window)
+{
+	if (doc == gedit_window_get_active_document (window))
+	{
+		queue_update (window, UPDATE_CURSOR_POSITION);
+	}
+}
+
+static void
+buffer_changed (GeditDocument *doc,
+		GeditWindow   *window)
+{
+	if (doc == gedit_window_get_active_document (window))
+	{
+		invalidate_visual_column (window);
+	}
+}
+
 static void
 set_overwrite_mode (GeditWindow *window,
                     gboolean     overwrite)
@@ -992,7 +1137,7 @@ overwrite_mode_changed (GtkTextView *view,
 	if (view != GTK_TEXT_VIEW (gedit_window_get_active_view (window)))
 		return;
 
-	set_overwrite_mode (window, gtk_text_view_get_overwrite (view));
+	queue_update (window, UPDATE_OVERWRITE_MODE);
 }
 
 #define MAX_TITLE_LENGTH 100
@@ -1139,42 +1284,168 @@ set_title (GeditWindow *window)
 #undef MAX_TITLE_LENGTH
 
 static void
-tab_width_changed (GObject     *object,
-		   GParamSpec  *pspec,
-		   GeditWindow *window)
+update_tab_width_label (GeditWindow *window,
+			GeditView   *view)
 {
-	guint new_tab_width;
+	guint tab_width;
 	gchar *label;
 
-	new_tab_width = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (object));
+	tab_width = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
 
-	label = g_strdup_printf (_("Tab Width: %u"), new_tab_width);
+	label = g_strdup_printf (_("Tab Width: %u"), tab_width);
 	gedit_status_menu_button_set_label (GEDIT_STATUS_MENU_BUTTON (window->priv->tab_width_button), label);
 	g_free (label);
 }
 
+static void
+tab_width_changed (GObject     *object,
+		   GParamSpec  *pspec,
+		   GeditWindow *window)
+{
+	/* The visual column of the cursor depends on the tab width */
+	invalidate_visual_column (window);
+
+	queue_update (window, UPDATE_TAB_WIDTH | UPDATE_CURSOR_POSITION);
+}
+
+static void
+update_language_label (GeditWindow   *window,
+		       GeditDocument *doc)
+{
+	GtkSourceLanguage *language;
+	const gchar *label;
+
+	language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (doc));
+
+	if (language)
+		label = gtk_source_language_get_name (language);
+	else
+		label = _("Plain Text");
+
+	gedit_status_menu_button_set_label (GEDIT_STATUS_MENU_BUTTON (window->priv->language_button), label);
+}
+
 static void
 language_changed (GObject     *object,
 		  GParamSpec  *pspec,
 		  GeditWindow *window)
 {
 	GtkSourceLanguage *new_language;
-	const gchar *label;
 
 	new_language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (object));
 
 	if (new_language)
-		label = gtk_source_language_get_name (new_language);
-	else
-		label = _("Plain Text");
+	{
+		gchar *trigger;
 
-	gedit_status_menu_button_set_label (GEDIT_STATUS_MENU_BUTTON (window->priv->language_button), label);
+		trigger = g_strconcat ("language:",
+		                       gtk_source_language_get_id (new_language),
+		                       NULL);
+		gedit_plugins_engine_activate_trigger (gedit_plugins_engine_get_default (),
+		                                       trigger);
+		g_free (trigger);
+	}
+
+	queue_update (window, UPDATE_LANGUAGE);
 
 	peas_extension_set_foreach (window->priv->extensions,
 	                            (PeasExtensionSetForeachFunc) extension_update_state,
 	                            window);
 }
 
+static void
+flush_updates (GeditWindow *window)
+{
+	GeditView *view;
+	GeditDocument *doc;
+	guint updates;
+
+	updates = window->priv->pending_updates;
+	window->priv->pending_updates = 0;
+
+	if (window->priv->dispose_has_run)
+		return;
+
+	if (updates & UPDATE_ACTIONS)
+	{
+		update_actions_sensitivity (window);
+	}
+
+	view = gedit_window_get_active_view (window);
+	if (view == NULL)
+		return;
+
+	doc = GEDIT_DOCUMENT (gtk_text_view_get_buffer (GTK_TEXT_VIEW (view)));
+
+	if (updates & UPDATE_CURSOR_POSITION)
+	{
+		update_cursor_position_statusbar (GTK_TEXT_BUFFER (doc), window);
+	}
+
+	if (updates & UPDATE_OVERWRITE_MODE)
+	{
+		set_overwrite_mode (window, gtk_text_view_get_overwrite (GTK_TEXT_VIEW (view)));
+	}
+
+	if (updates & UPDATE_TAB_WIDTH)
+	{
+		update_tab_width_label (window, view);
+	}
+
+	if (updates & UPDATE_LANGUAGE)
+	{
+		update_language_label (window, doc);
+	}
+}
+
+static gboolean
+update_tick_cb (GtkWidget     *widget,
+		GdkFrameClock *frame_clock,
+		gpointer       user_data)
+{
+	GeditWindow *window = GEDIT_WINDOW (widget);
+
+	window->priv->update_tick_id = 0;
+	flush_updates (window);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Syncs the given parts of the window with the active tab, before the next
+ * frame is drawn, so that e.g. holding down an arrow key updates the statusbar
+ * and the actions once per frame instead of once per cursor move.
+ * The frame clock does not tick for a window which is not mapped, in that case
+ * everything pending is synced right away.
+ */
+static void
+queue_update (GeditWindow *window,
+	      guint        updates)
+{
+	window->priv->pending_updates |= updates;
+
+	if (!gtk_widget_get_mapped (GTK_WIDGET (window)))
+	{
+		if (window->priv->update_tick_id != 0)
+		{
+			gtk_widget_remove_tick_callback (GTK_WIDGET (window),
+							 window->priv->update_tick_id);
+			window->priv->update_tick_id = 0;
+		}
+
+		flush_updates (window);
+		return;
+	}
+
+	if (window->priv->update_tick_id == 0)
+	{
+		window->priv->update_tick_id =
+			gtk_widget_add_tick_callback (GTK_WIDGET (window),
+						      update_tick_cb,
+						      NULL,
+						      NULL);
+	}
+}
+
 static void
 update_statusbar_wrap_mode_checkbox_from_view (GeditWindow *window,
                                                GeditView   *view)
@@ -1332,11 +1603,7 @@ update_statusbar (GeditWindow *window,
 
 		doc = GEDIT_DOCUMENT (gtk_text_view_get_buffer (GTK_TEXT_VIEW (new_view)));
 
-		/* sync the statusbar */
-		update_cursor_position_statusbar (GTK_TEXT_BUFFER (doc),
-						  window);
-
-		set_overwrite_mode (window, gtk_text_view_get_overwrite (GTK_TEXT_VIEW (new_view)));
+		invalidate_visual_column (window);
 
 		gtk_widget_show (window->priv->line_col_button);
 		gtk_widget_show (window->priv->tab_width_button);
@@ -1352,8 +1619,13 @@ update_statusbar (GeditWindow *window,
 								      G_CALLBACK (language_changed),
 								      window);
 
+		/* sync the statusbar */
+		queue_update (window,
+			      UPDATE_CURSOR_POSITION |
+			      UPDATE_OVERWRITE_MODE |
+			      UPDATE_TAB_WIDTH);
+
 		/* call it for the first time */
-		tab_width_changed (G_OBJECT (new_view), NULL, window);
 		language_changed (G_OBJECT (doc), NULL, window);
 	}
 }
@@ -1377,6 +1649,8 @@ tab_switched (GeditMultiNotebook *mnb,
 	if (new_tab == NULL || window->priv->dispose_has_run)
 		return;
 
+	_gedit_tab_start_deferred_load (new_tab);
+
 	set_title (window);
 	update_actions_sensitivity (window);
 
@@ -1564,11 +1838,11 @@ load_uris_from_drop (GeditWindow  *window,
 	}
 
 	locations = g_slist_reverse (locations);
-	loaded = gedit_commands_load_locations (window,
-	                                        locations,
-	                                        NULL,
-	                                        0,
-	                                        0);
+	loaded = _gedit_cmd_load_locations_deferred (window,
+	                                             locations,
+	                                             NULL,
+	                                             0,
+	                                             0);
 
 	g_slist_free (loaded);
 	g_slist_free_full (locations, g_object_unref);
@@ -1782,7 +2056,7 @@ empty_search_notify_cb (GeditDocument *doc,
 {
 	if (doc == gedit_window_get_active_document (window))
 	{
-		update_actions_sensitivity (window);
+		queue_update (window, UPDATE_ACTIONS);
 	}
 }
 
@@ -1793,7 +2067,7 @@ can_undo (GeditDocument *doc,
 {
 	if (doc == gedit_window_get_active_document (window))
 	{
-		update_actions_sensitivity (window);
+		queue_update (window, UPDATE_ACTIONS);
 	}
 }
 
@@ -1804,7 +2078,7 @@ can_redo (GeditDocument *doc,
 {
 	if (doc == gedit_window_get_active_document (window))
 	{
-		update_actions_sensitivity (window);
+		queue_update (window, UPDATE_ACTIONS);
 	}
 }
 
@@ -1815,7 +2089,7 @@ selection_changed (GeditDocument *doc,
 {
 	if (doc == gedit_window_get_active_document (window))
 	{
-		update_actions_sensitivity (window);
+		queue_update (window, UPDATE_ACTIONS);
 	}
 }
 
@@ -1886,7 +2160,11 @@ on_tab_added (GeditMultiNotebook *multi,
 			  window);
 	g_signal_connect (doc,
 			  "tepl-cursor-moved",
-			  G_CALLBACK (update_cursor_position_statusbar),
+			  G_CALLBACK (cursor_moved),
+			  window);
+	g_signal_connect (doc,
+			  "changed",
+			  G_CALLBACK (buffer_changed),
 			  window);
 	g_signal_connect (doc,
 			  "notify::empty-search",
@@ -1986,7 +2264,10 @@ on_tab_removed (GeditMultiNotebook *multi,
 					      G_CALLBACK (bracket_matched_cb),
 					      window);
 	g_signal_handlers_disconnect_by_func (doc,
-					      G_CALLBACK (update_cursor_position_statusbar),
+					      G_CALLBACK (cursor_moved),
+					      window);
+	g_signal_handlers_disconnect_by_func (doc,
+					      G_CALLBACK (buffer_changed),
 					      window);
 	g_signal_handlers_disconnect_by_func (doc,
 					      G_CALLBACK (empty_search_notify_cb),
@@ -2543,7 +2824,22 @@ extension_added (PeasExtensionSet *extensions,
 		 PeasExtension    *exten,
 		 GeditWindow      *window)
 {
+	gchar *trace_name = NULL;
+
+	if (gedit_startup_trace_is_enabled ())
+	{
+		trace_name = g_strdup_printf ("window-activatable %s",
+		                              peas_plugin_info_get_module_name (info));
+		gedit_startup_trace_begin (trace_name);
+	}
+
 	gedit_window_activatable_activate (GEDIT_WINDOW_ACTIVATABLE (exten));
+
+	if (trace_name != NULL)
+	{
+		gedit_startup_trace_end (trace_name);
+		g_free (trace_name);
+	}
 }
 
 static void
@@ -2867,6 +3163,10 @@ gedit_window_init (GeditWindow *window)
 	                            (PeasExtensionSetForeachFunc) extension_added,
 	                            window);
 
+	gedit_plugins_engine_add_deferred_actions (gedit_plugins_engine_get_default (),
+	                                           G_ACTION_MAP (window),
+	                                           "win");
+
 	/* set visibility of panels.
 	 * This needs to be done after plugins activatation */
 	init_panels_visibility (window);
@@ -3043,6 +3343,39 @@ gedit_window_create_tab_from_location (GeditWindow             *window,
 	return process_create_tab (window, notebook, tab, jump_to);
 }
 
+/* Like gedit_window_create_tab_from_location() without jump_to, but the file
+ * is loaded only when the tab is shown for the first time.
+ */
+GeditTab *
+_gedit_window_create_deferred_tab_from_location (GeditWindow             *window,
+						 GFile                   *location,
+						 const GtkSourceEncoding *encoding,
+						 gint                     line_pos,
+						 gint                     column_pos,
+						 gboolean                 create)
+{
+	GtkWidget *notebook;
+	GeditTab *tab;
+
+	g_return_val_if_fail (GEDIT_IS_WINDOW (window), NULL);
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+
+	gedit_debug (DEBUG_WINDOW);
+
+	tab = _gedit_tab_new ();
+
+	_gedit_tab_load_deferred (tab,
+				  location,
+				  encoding,
+				  line_pos,
+				  column_pos,
+				  create);
+
+	notebook = _gedit_window_get_notebook (window);
+
+	return process_create_tab (window, notebook, tab, FALSE);
+}
+
 /**
  * gedit_window_create_tab_from_stream:
  * @window: a #GeditWindow
@@ -169,6 +169,14 @@ gboolean	 _gedit_window_is_fullscreen		(GeditWindow         *window);
 
 GList		*_gedit_window_get_all_tabs		(GeditWindow         *window);
 
+GeditTab	*_gedit_window_create_deferred_tab_from_location
+							(GeditWindow             *window,
+							 GFile                   *location,
+							 const GtkSourceEncoding *encoding,
+							 gint                     line_pos,
+							 gint                     column_pos,
+							 gboolean                 create);
+
 GFile		*_gedit_window_pop_last_closed_doc	(GeditWindow         *window);
 
 G_END_DECLS
@@ -36,6 +36,7 @@
 #include "gedit-debug.h"
 #include "gedit-factory.h"
 #include "gedit-settings.h"
+#include "gedit-startup-trace.h"
 
 #ifdef G_OS_WIN32
 #include <gmodule.h>
@@ -137,6 +138,9 @@ main (int argc, char *argv[])
 	/* NOTE: we should not make any calls to the gedit API before the
 	 * private library is loaded.
 	 */
+	gedit_startup_trace_init ();
+
+	gedit_startup_trace_begin ("init");
 	gedit_dirs_init ();
 
 	setup_i18n ();
@@ -148,6 +152,7 @@ main (int argc, char *argv[])
 	                    "application-id", "org.gnome.gedit",
 	                    "flags", G_APPLICATION_HANDLES_COMMAND_LINE | G_APPLICATION_HANDLES_OPEN,
 	                    NULL);
+	gedit_startup_trace_end ("init");
 
 	status = g_application_run (G_APPLICATION (app), argc, argv);
 
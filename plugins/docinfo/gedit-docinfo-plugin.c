@@ -22,10 +22,7 @@
 
 #include "gedit-docinfo-plugin.h"
 
-#include <string.h> /* For strlen (...) */
-
 #include <glib/gi18n.h>
-#include <pango/pango-break.h>
 #include <gmodule.h>
 
 #include <gedit/gedit-app.h>
@@ -36,6 +33,8 @@
 #include <gedit/gedit-app-activatable.h>
 #include <gedit/gedit-window-activatable.h>
 
+#include "gedit-docinfo-stats.h"
+
 struct _GeditDocinfoPluginPrivate
 {
 	GeditWindow *window;
@@ -62,6 +61,9 @@ struct _GeditDocinfoPluginPrivate
 	GtkWidget *selected_chars_ns_label;
 	GtkWidget *selected_bytes_label;
 
+	/* The document whose statistics are shown in the dialog. */
+	GeditDocument *stats_doc;
+
 	GeditApp  *app;
 	GeditMenuExtension *menu_ext;
 };
@@ -87,58 +89,14 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditDocinfoPlugin,
 				G_ADD_PRIVATE_DYNAMIC (GeditDocinfoPlugin))
 
 static void
-calculate_info (GeditDocument *doc,
-		GtkTextIter   *start,
-		GtkTextIter   *end,
-		gint          *chars,
-		gint          *words,
-		gint          *white_chars,
-		gint          *bytes)
+set_label_count (GtkWidget *label,
+		 gint64     count)
 {
-	gchar *text;
-
-	gedit_debug (DEBUG_PLUGINS);
-
-	text = gtk_text_buffer_get_slice (GTK_TEXT_BUFFER (doc),
-					  start,
-					  end,
-					  TRUE);
-
-	*chars = g_utf8_strlen (text, -1);
-	*bytes = strlen (text);
-
-	if (*chars > 0)
-	{
-		PangoLogAttr *attrs;
-		gint i;
-
-		attrs = g_new0 (PangoLogAttr, *chars + 1);
-
-		pango_get_log_attrs (text,
-				     -1,
-				     0,
-				     pango_language_from_string ("C"),
-				     attrs,
-				     *chars + 1);
-
-		for (i = 0; i < (*chars); i++)
-		{
-			if (attrs[i].is_white)
-				++(*white_chars);
-
-			if (attrs[i].is_word_start)
-				++(*words);
-		}
-
-		g_free (attrs);
-	}
-	else
-	{
-		*white_chars = 0;
-		*words = 0;
-	}
+	gchar *tmp_str;
 
-	g_free (text);
+	tmp_str = g_strdup_printf ("%" G_GINT64_FORMAT, count);
+	gtk_label_set_text (GTK_LABEL (label), tmp_str);
+	g_free (tmp_str);
 }
 
 static void
@@ -146,63 +104,57 @@ update_document_info (GeditDocinfoPlugin *plugin,
 		      GeditDocument      *doc)
 {
 	GeditDocinfoPluginPrivate *priv;
-	GtkTextIter start, end;
-	gint words = 0;
-	gint chars = 0;
-	gint white_chars = 0;
-	gint lines = 0;
-	gint bytes = 0;
+	GeditDocinfoStats *stats;
+	GeditDocinfoCounts counts;
+	gint64 lines;
 	gchar *doc_name;
-	gchar *tmp_str;
 
 	gedit_debug (DEBUG_PLUGINS);
 
 	priv = plugin->priv;
 
-	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc),
-				    &start,
-				    &end);
-
-	lines = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (doc));
-
-	calculate_info (doc,
-			&start, &end,
-			&chars, &words, &white_chars, &bytes);
-
-	if (chars == 0)
-	{
-		lines = 0;
-	}
-
-	gedit_debug_message (DEBUG_PLUGINS, "Chars: %d", chars);
-	gedit_debug_message (DEBUG_PLUGINS, "Lines: %d", lines);
-	gedit_debug_message (DEBUG_PLUGINS, "Words: %d", words);
-	gedit_debug_message (DEBUG_PLUGINS, "Chars non-space: %d", chars - white_chars);
-	gedit_debug_message (DEBUG_PLUGINS, "Bytes: %d", bytes);
-
 	doc_name = gedit_document_get_short_name_for_display (doc);
 	gtk_header_bar_set_subtitle (GTK_HEADER_BAR (priv->header_bar), doc_name);
 	g_free (doc_name);
 
-	tmp_str = g_strdup_printf("%d", lines);
-	gtk_label_set_text (GTK_LABEL (priv->document_lines_label), tmp_str);
-	g_free (tmp_str);
+	stats = gedit_docinfo_stats_get_for_buffer (GTK_TEXT_BUFFER (doc));
 
-	tmp_str = g_strdup_printf("%d", words);
-	gtk_label_set_text (GTK_LABEL (priv->document_words_label), tmp_str);
-	g_free (tmp_str);
+	/* The labels are updated by stats_ready_cb() when the counting is
+	 * finished. Until then they must not show the counts of the document
+	 * previously shown.
+	 */
+	if (!gedit_docinfo_stats_is_ready (stats))
+	{
+		gedit_debug_message (DEBUG_PLUGINS, "Counting in progress");
+
+		gtk_label_set_text (GTK_LABEL (priv->document_lines_label), "…");
+		gtk_label_set_text (GTK_LABEL (priv->document_words_label), "…");
+		gtk_label_set_text (GTK_LABEL (priv->document_chars_label), "…");
+		gtk_label_set_text (GTK_LABEL (priv->document_chars_ns_label), "…");
+		gtk_label_set_text (GTK_LABEL (priv->document_bytes_label), "…");
+		return;
+	}
 
-	tmp_str = g_strdup_printf("%d", chars);
-	gtk_label_set_text (GTK_LABEL (priv->document_chars_label), tmp_str);
-	g_free (tmp_str);
+	gedit_docinfo_stats_get_counts (stats, &counts);
 
-	tmp_str = g_strdup_printf("%d", chars - white_chars);
-	gtk_label_set_text (GTK_LABEL (priv->document_chars_ns_label), tmp_str);
-	g_free (tmp_str);
+	lines = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (doc));
 
-	tmp_str = g_strdup_printf("%d", bytes);
-	gtk_label_set_text (GTK_LABEL (priv->document_bytes_label), tmp_str);
-	g_free (tmp_str);
+	if (counts.chars == 0)
+	{
+		lines = 0;
+	}
+
+	gedit_debug_message (DEBUG_PLUGINS, "Chars: %" G_GINT64_FORMAT, counts.chars);
+	gedit_debug_message (DEBUG_PLUGINS, "Lines: %" G_GINT64_FORMAT, lines);
+	gedit_debug_message (DEBUG_PLUGINS, "Words: %" G_GINT64_FORMAT, counts.words);
+	gedit_debug_message (DEBUG_PLUGINS, "Chars non-space: %" G_GINT64_FORMAT, counts.chars - counts.white_chars);
+	gedit_debug_message (DEBUG_PLUGINS, "Bytes: %" G_GINT64_FORMAT, counts.bytes);
+
+	set_label_count (priv->document_lines_label, lines);
+	set_label_count (priv->document_words_label, counts.words);
+	set_label_count (priv->document_chars_label, counts.chars);
+	set_label_count (priv->document_chars_ns_label, counts.chars - counts.white_chars);
+	set_label_count (priv->document_bytes_label, counts.bytes);
 }
 
 static void
@@ -212,12 +164,8 @@ update_selection_info (GeditDocinfoPlugin *plugin,
 	GeditDocinfoPluginPrivate *priv;
 	gboolean sel;
 	GtkTextIter start, end;
-	gint words = 0;
-	gint chars = 0;
-	gint white_chars = 0;
-	gint lines = 0;
-	gint bytes = 0;
-	gchar *tmp_str;
+	GeditDocinfoCounts counts = { 0 };
+	gint64 lines = 0;
 
 	gedit_debug (DEBUG_PLUGINS);
 
@@ -229,17 +177,18 @@ update_selection_info (GeditDocinfoPlugin *plugin,
 
 	if (sel)
 	{
+		GeditDocinfoStats *stats;
+
 		lines = gtk_text_iter_get_line (&end) - gtk_text_iter_get_line (&start) + 1;
 
-		calculate_info (doc,
-				&start, &end,
-				&chars, &words, &white_chars, &bytes);
+		stats = gedit_docinfo_stats_get_for_buffer (GTK_TEXT_BUFFER (doc));
+		gedit_docinfo_stats_count_range (stats, &start, &end, &counts);
 
-		gedit_debug_message (DEBUG_PLUGINS, "Selected chars: %d", chars);
-		gedit_debug_message (DEBUG_PLUGINS, "Selected lines: %d", lines);
-		gedit_debug_message (DEBUG_PLUGINS, "Selected words: %d", words);
-		gedit_debug_message (DEBUG_PLUGINS, "Selected chars non-space: %d", chars - white_chars);
-		gedit_debug_message (DEBUG_PLUGINS, "Selected bytes: %d", bytes);
+		gedit_debug_message (DEBUG_PLUGINS, "Selected chars: %" G_GINT64_FORMAT, counts.chars);
+		gedit_debug_message (DEBUG_PLUGINS, "Selected lines: %" G_GINT64_FORMAT, lines);
+		gedit_debug_message (DEBUG_PLUGINS, "Selected words: %" G_GINT64_FORMAT, counts.words);
+		gedit_debug_message (DEBUG_PLUGINS, "Selected chars non-space: %" G_GINT64_FORMAT, counts.chars - counts.white_chars);
+		gedit_debug_message (DEBUG_PLUGINS, "Selected bytes: %" G_GINT64_FORMAT, counts.bytes);
 
 		gtk_widget_set_sensitive (priv->selection_label, TRUE);
 		gtk_widget_set_sensitive (priv->selected_words_label, TRUE);
@@ -260,28 +209,75 @@ update_selection_info (GeditDocinfoPlugin *plugin,
 		gtk_widget_set_sensitive (priv->selected_chars_ns_label, FALSE);
 	}
 
-	if (chars == 0)
+	if (counts.chars == 0)
 		lines = 0;
 
-	tmp_str = g_strdup_printf("%d", lines);
-	gtk_label_set_text (GTK_LABEL (priv->selected_lines_label), tmp_str);
-	g_free (tmp_str);
+	set_label_count (priv->selected_lines_label, lines);
+	set_label_count (priv->selected_words_label, counts.words);
+	set_label_count (priv->selected_chars_label, counts.chars);
+	set_label_count (priv->selected_chars_ns_label, counts.chars - counts.white_chars);
+	set_label_count (priv->selected_bytes_label, counts.bytes);
+}
 
-	tmp_str = g_strdup_printf("%d", words);
-	gtk_label_set_text (GTK_LABEL (priv->selected_words_label), tmp_str);
-	g_free (tmp_str);
+static void
+stats_ready_cb (GeditDocinfoStats  *stats,
+		GeditDocinfoPlugin *plugin)
+{
+	GeditDocinfoPluginPrivate *priv = plugin->priv;
 
-	tmp_str = g_strdup_printf("%d", chars);
-	gtk_label_set_text (GTK_LABEL (priv->selected_chars_label), tmp_str);
-	g_free (tmp_str);
+	gedit_debug (DEBUG_PLUGINS);
 
-	tmp_str = g_strdup_printf("%d", chars - white_chars);
-	gtk_label_set_text (GTK_LABEL (priv->selected_chars_ns_label), tmp_str);
-	g_free (tmp_str);
+	if (priv->dialog != NULL && priv->stats_doc != NULL)
+	{
+		update_document_info (plugin, priv->stats_doc);
+		update_selection_info (plugin, priv->stats_doc);
+	}
+}
 
-	tmp_str = g_strdup_printf("%d", bytes);
-	gtk_label_set_text (GTK_LABEL (priv->selected_bytes_label), tmp_str);
-	g_free (tmp_str);
+static void
+set_stats_doc (GeditDocinfoPlugin *plugin,
+	       GeditDocument      *doc)
+{
+	GeditDocinfoPluginPrivate *priv = plugin->priv;
+
+	if (priv->stats_doc == doc)
+	{
+		return;
+	}
+
+	if (priv->stats_doc != NULL)
+	{
+		GeditDocinfoStats *stats;
+
+		stats = gedit_docinfo_stats_get_for_buffer (GTK_TEXT_BUFFER (priv->stats_doc));
+		gedit_docinfo_stats_set_ready_func (stats, NULL, NULL);
+
+		g_object_remove_weak_pointer (G_OBJECT (priv->stats_doc),
+					      (gpointer *) &priv->stats_doc);
+	}
+
+	priv->stats_doc = doc;
+
+	if (doc != NULL)
+	{
+		GeditDocinfoStats *stats;
+
+		g_object_add_weak_pointer (G_OBJECT (doc),
+					   (gpointer *) &priv->stats_doc);
+
+		stats = gedit_docinfo_stats_get_for_buffer (GTK_TEXT_BUFFER (doc));
+		gedit_docinfo_stats_set_ready_func (stats,
+						    (GeditDocinfoStatsReadyFunc) stats_ready_cb,
+						    plugin);
+	}
+}
+
+static void
+docinfo_dialog_destroy_cb (GtkWidget          *dialog,
+			   GeditDocinfoPlugin *plugin)
+{
+	plugin->priv->dialog = NULL;
+	set_stats_doc (plugin, NULL);
 }
 
 static void
@@ -314,6 +310,7 @@ docinfo_dialog_response_cb (GtkDialog          *widget,
 
 			doc = gedit_window_get_active_document (priv->window);
 
+			set_stats_doc (plugin, doc);
 			update_document_info (plugin, doc);
 			update_selection_info (plugin, doc);
 
@@ -362,8 +359,8 @@ create_docinfo_dialog (GeditDocinfoPlugin *plugin)
 
 	g_signal_connect (priv->dialog,
 			  "destroy",
-			  G_CALLBACK (gtk_widget_destroyed),
-			  &priv->dialog);
+			  G_CALLBACK (docinfo_dialog_destroy_cb),
+			  plugin);
 	g_signal_connect (priv->dialog,
 			  "response",
 			  G_CALLBACK (docinfo_dialog_response_cb),
@@ -419,6 +416,7 @@ docinfo_cb (GAction            *action,
 		gtk_widget_show (GTK_WIDGET (priv->dialog));
 	}
 
+	set_stats_doc (plugin, doc);
 	update_document_info (plugin, doc);
 	update_selection_info (plugin, doc);
 }
@@ -571,11 +569,30 @@ static void
 gedit_docinfo_plugin_window_deactivate (GeditWindowActivatable *activatable)
 {
 	GeditDocinfoPluginPrivate *priv;
+	GList *docs;
+	GList *l;
 
 	gedit_debug (DEBUG_PLUGINS);
 
 	priv = GEDIT_DOCINFO_PLUGIN (activatable)->priv;
 
+	if (priv->dialog != NULL)
+	{
+		gtk_widget_destroy (priv->dialog);
+	}
+
+	set_stats_doc (GEDIT_DOCINFO_PLUGIN (activatable), NULL);
+
+	/* The statistics engines use the code of the plugin. */
+	docs = gedit_window_get_documents (priv->window);
+
+	for (l = docs; l != NULL; l = l->next)
+	{
+		gedit_docinfo_stats_remove_from_buffer (GTK_TEXT_BUFFER (l->data));
+	}
+
+	g_list_free (docs);
+
 	g_action_map_remove_action (G_ACTION_MAP (priv->window), "docinfo");
 }
 
@@ -0,0 +1,1089 @@
+/*
+ * gedit-docinfo-stats.c
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-docinfo-stats.h"
+
+#include <string.h>
+#include <pango/pango-break.h>
+
+#include <gedit/gedit-debug.h>
+
+/* The buffer is split into blocks of whole lines, delimited by text marks so
+ * that the blocks follow the changes done to the buffer. The counts of each
+ * block are kept, and only the blocks touched by a change are counted again,
+ * in an idle callback. A block never holds more than a few hundred lines, so
+ * the temporary memory needed to count it is small.
+ *
+ * Since a word can't span several lines, the counts of the blocks can simply
+ * be added. A block is counted in slices of about SLICE_CHARS characters, cut
+ * where a word can't continue, so that a very long line (minified code for
+ * instance) is counted over several idle iterations.
+ *
+ * The pure ASCII lines are counted without Pango. The fast path is checked
+ * against pango_get_log_attrs() on a set of probe strings the first time it
+ * is needed, and is only used for the lines on which they agree: the rules
+ * for the punctuation inside words have changed between Pango versions.
+ */
+
+#define BLOCK_LINES 512
+
+#define SLICE_CHARS 65536
+
+/* Maximum time spent counting the blocks in one idle iteration. */
+#define IDLE_BUDGET_USEC 5000
+
+#define STATS_KEY "GeditDocinfoStatsKey"
+
+typedef struct
+{
+	/* The block contains the text between its mark and the mark of the
+	 * next block, or the end of the buffer.
+	 */
+	GtkTextMark *start;
+	GeditDocinfoCounts counts;
+
+	/* While a dirty block is counted, where to resume and the counts of
+	 * the text before.
+	 */
+	GtkTextMark *resume;
+	GeditDocinfoCounts partial;
+
+	guint dirty : 1;
+} Block;
+
+typedef enum
+{
+	/* Pango is always used. */
+	FAST_PATH_NONE,
+
+	/* For the lines without punctuation that can be inside a word. */
+	FAST_PATH_STRICT,
+
+	/* For all the ASCII lines. */
+	FAST_PATH_FULL
+} FastPath;
+
+typedef enum
+{
+	CLASS_OTHER,
+	CLASS_LETTER,
+	CLASS_NUMERIC,
+	CLASS_EXTEND_NUM_LET,
+	CLASS_MID_LETTER,
+	CLASS_MID_NUM_LET,
+	CLASS_MID_NUM
+} CharClass;
+
+/* The ASCII characters of the classes other than letter, numeric and
+ * other.
+ */
+#define IN_WORD_PUNCTUATION "_:.',;"
+
+/* The probes of the FAST_PATH_STRICT mode. The ones of FAST_PATH_FULL are
+ * generated from IN_WORD_PUNCTUATION.
+ */
+static const gchar * const strict_probes[] =
+{
+	"hello world",
+	"abc123 def456 7x",
+	"a-b+c*d/e",
+	"x(y)[z]{w}<v>",
+	"\"quoted\" #tag @name $var %d &amp ~home ^caret |pipe `tick` ?!=",
+	" \t \f a \r\n",
+	"\x01\x1f\x7f",
+};
+
+struct _GeditDocinfoStats
+{
+	/* Weak pointer. */
+	GtkTextBuffer *buffer;
+
+	GPtrArray *blocks;
+	guint n_dirty_blocks;
+
+	guint idle_id;
+
+	GeditDocinfoStatsReadyFunc ready_func;
+	gpointer ready_data;
+};
+
+static void
+count_with_pango (const gchar        *text,
+		  gsize               length,
+		  GeditDocinfoCounts *counts)
+{
+	PangoLogAttr *attrs;
+	glong n_chars;
+	glong i;
+
+	n_chars = g_utf8_strlen (text, length);
+
+	counts->chars += n_chars;
+	counts->bytes += length;
+
+	if (n_chars == 0)
+	{
+		return;
+	}
+
+	attrs = g_new0 (PangoLogAttr, n_chars + 1);
+
+	pango_get_log_attrs (text,
+			     length,
+			     0,
+			     pango_language_from_string ("C"),
+			     attrs,
+			     n_chars + 1);
+
+	for (i = 0; i < n_chars; i++)
+	{
+		if (attrs[i].is_white)
+			counts->white_chars++;
+
+		if (attrs[i].is_word_start)
+			counts->words++;
+	}
+
+	g_free (attrs);
+}
+
+/* The word boundary classes of the Unicode text segmentation algorithm,
+ * restricted to ASCII.
+ */
+static CharClass
+get_ascii_class (guchar c)
+{
+	if (g_ascii_isalpha (c))
+		return CLASS_LETTER;
+
+	if (g_ascii_isdigit (c))
+		return CLASS_NUMERIC;
+
+	switch (c)
+	{
+		case '_':
+			return CLASS_EXTEND_NUM_LET;
+		case ':':
+			return CLASS_MID_LETTER;
+		case '.':
+		case '\'':
+			return CLASS_MID_NUM_LET;
+		case ',':
+		case ';':
+			return CLASS_MID_NUM;
+		default:
+			return CLASS_OTHER;
+	}
+}
+
+static gboolean
+is_ascii (const gchar *text,
+	  gsize        length)
+{
+	guint64 acc = 0;
+	gsize i = 0;
+
+	/* Eight bytes at a time, without branches in the loop. */
+	for (; i + sizeof (guint64) <= length; i += sizeof (guint64))
+	{
+		guint64 word;
+
+		memcpy (&word, text + i, sizeof (guint64));
+		acc |= word;
+	}
+
+	for (; i < length; i++)
+	{
+		acc |= (guchar) text[i];
+	}
+
+	return (acc & G_GUINT64_CONSTANT (0x8080808080808080)) == 0;
+}
+
+static gboolean
+has_in_word_punctuation (const gchar *text,
+			 gsize        length)
+{
+	gsize i;
+
+	for (i = 0; i < length; i++)
+	{
+		if (get_ascii_class (text[i]) >= CLASS_EXTEND_NUM_LET)
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void
+count_ascii_line (const gchar        *text,
+		  gsize               length,
+		  GeditDocinfoCounts *counts)
+{
+	gboolean in_word = FALSE;
+	CharClass word_class = CLASS_OTHER;
+	gsize i;
+
+	counts->chars += length;
+	counts->bytes += length;
+
+	for (i = 0; i < length; i++)
+	{
+		guchar c = text[i];
+		CharClass char_class;
+
+		counts->white_chars += (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f');
+
+		char_class = get_ascii_class (c);
+
+		switch (char_class)
+		{
+			case CLASS_LETTER:
+			case CLASS_NUMERIC:
+				if (!in_word)
+				{
+					counts->words++;
+					in_word = TRUE;
+				}
+
+				word_class = char_class;
+				break;
+
+			case CLASS_EXTEND_NUM_LET:
+				/* Joins the surrounding letters and numbers, but
+				 * is not a word by itself.
+				 */
+				break;
+
+			case CLASS_MID_LETTER:
+			case CLASS_MID_NUM_LET:
+			case CLASS_MID_NUM:
+			{
+				CharClass next_class;
+
+				next_class = i + 1 < length ? get_ascii_class (text[i + 1]) : CLASS_OTHER;
+
+				/* e.g. "can't", "e.g" or "3.14". */
+				if (in_word &&
+				    next_class == word_class &&
+				    ((word_class == CLASS_LETTER && char_class != CLASS_MID_NUM) ||
+				     (word_class == CLASS_NUMERIC && char_class != CLASS_MID_LETTER)))
+				{
+					break;
+				}
+
+				in_word = FALSE;
+				break;
+			}
+
+			default:
+				in_word = FALSE;
+				break;
+		}
+	}
+}
+
+static gboolean
+probe_agrees (const gchar *text)
+{
+	GeditDocinfoCounts fast = { 0 };
+	GeditDocinfoCounts pango = { 0 };
+
+	count_ascii_line (text, strlen (text), &fast);
+	count_with_pango (text, strlen (text), &pango);
+
+	return memcmp (&fast, &pango, sizeof (GeditDocinfoCounts)) == 0;
+}
+
+static FastPath
+check_fast_path (void)
+{
+	const gchar *contexts = "a1 ";
+	const gchar *c;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (strict_probes); i++)
+	{
+		if (!probe_agrees (strict_probes[i]))
+		{
+			return FAST_PATH_NONE;
+		}
+	}
+
+	/* Each punctuation character alone, doubled, at the start and at the
+	 * end, between letters, numbers and spaces.
+	 */
+	for (c = IN_WORD_PUNCTUATION; *c != '\0'; c++)
+	{
+		const gchar *before;
+
+		for (before = contexts; *before != '\0'; before++)
+		{
+			const gchar *after;
+			gchar probe[8];
+
+			g_snprintf (probe, sizeof (probe), "%c%c", *c, *before);
+
+			if (!probe_agrees (probe))
+			{
+				return FAST_PATH_STRICT;
+			}
+
+			g_snprintf (probe, sizeof (probe), "%c%c", *before, *c);
+
+			if (!probe_agrees (probe))
+			{
+				return FAST_PATH_STRICT;
+			}
+
+			for (after = contexts; *after != '\0'; after++)
+			{
+				g_snprintf (probe, sizeof (probe), "%c%c%c", *before, *c, *after);
+
+				if (!probe_agrees (probe))
+				{
+					return FAST_PATH_STRICT;
+				}
+
+				g_snprintf (probe, sizeof (probe), "%c%c%c%c", *before, *c, *c, *after);
+
+				if (!probe_agrees (probe))
+				{
+					return FAST_PATH_STRICT;
+				}
+			}
+		}
+	}
+
+	return FAST_PATH_FULL;
+}
+
+static FastPath
+get_fast_path (void)
+{
+	static gsize fast_path = 0;
+
+	if (g_once_init_enter (&fast_path))
+	{
+		FastPath value = check_fast_path ();
+
+		gedit_debug_message (DEBUG_PLUGINS, "ASCII fast path mode: %d", value);
+
+		/* 0 is reserved by g_once_init_enter(). */
+		g_once_init_leave (&fast_path, value + 1);
+	}
+
+	return fast_path - 1;
+}
+
+static void
+count_text (const gchar        *text,
+	    gsize               length,
+	    GeditDocinfoCounts *counts)
+{
+	FastPath fast_path = get_fast_path ();
+	const gchar *end = text + length;
+	const gchar *pango_start = text;
+	const gchar *line = text;
+
+	if (fast_path == FAST_PATH_NONE)
+	{
+		count_with_pango (text, length, counts);
+		return;
+	}
+
+	/* The lines that can't take the fast path are given to Pango
+	 * together.
+	 */
+	while (line < end)
+	{
+		const gchar *newline;
+		const gchar *line_end;
+
+		newline = memchr (line, '\n', end - line);
+		line_end = newline != NULL ? newline + 1 : end;
+
+		if (is_ascii (line, line_end - line) &&
+		    (fast_path == FAST_PATH_FULL ||
+		     !has_in_word_punctuation (line, line_end - line)))
+		{
+			if (pango_start < line)
+			{
+				count_with_pango (pango_start, line - pango_start, counts);
+			}
+
+			count_ascii_line (line, line_end - line, counts);
+			pango_start = line_end;
+		}
+
+		line = line_end;
+	}
+
+	if (pango_start < end)
+	{
+		count_with_pango (pango_start, end - pango_start, counts);
+	}
+}
+
+static void
+count_range (GtkTextBuffer      *buffer,
+	     const GtkTextIter  *start,
+	     const GtkTextIter  *end,
+	     GeditDocinfoCounts *counts)
+{
+	gchar *text;
+
+	text = gtk_text_buffer_get_slice (buffer, start, end, TRUE);
+	count_text (text, strlen (text), counts);
+	g_free (text);
+}
+
+/* After a character that always ends a word, and before an ASCII character,
+ * which can't be a combining mark.
+ */
+static gboolean
+is_slice_boundary (const GtkTextIter *iter)
+{
+	GtkTextIter prev = *iter;
+
+	if (gtk_text_iter_get_char (iter) >= 0x80 ||
+	    !gtk_text_iter_backward_char (&prev))
+	{
+		return FALSE;
+	}
+
+	switch (gtk_text_iter_get_char (&prev))
+	{
+		case '\n':
+		case ' ':
+		case '\t':
+		case '(':
+		case ')':
+		case '[':
+		case ']':
+		case '{':
+		case '}':
+		case '<':
+		case '>':
+		case '=':
+		case '"':
+			return TRUE;
+		default:
+			return FALSE;
+	}
+}
+
+/* Moves @iter about SLICE_CHARS characters forward, to a slice boundary, or
+ * to @end. A line without any boundary is not split.
+ */
+static void
+forward_slice (GtkTextIter       *iter,
+	       const GtkTextIter *end)
+{
+	gtk_text_iter_forward_chars (iter, SLICE_CHARS);
+
+	while (gtk_text_iter_compare (iter, end) < 0 &&
+	       !is_slice_boundary (iter))
+	{
+		gtk_text_iter_forward_char (iter);
+	}
+
+	if (gtk_text_iter_compare (iter, end) > 0)
+	{
+		*iter = *end;
+	}
+}
+
+static void
+add_counts (GeditDocinfoCounts       *counts,
+	    const GeditDocinfoCounts *other)
+{
+	counts->chars += other->chars;
+	counts->words += other->words;
+	counts->white_chars += other->white_chars;
+	counts->bytes += other->bytes;
+}
+
+static Block *
+block_new (GtkTextBuffer     *buffer,
+	   const GtkTextIter *start)
+{
+	Block *block;
+
+	block = g_slice_new0 (Block);
+	block->start = gtk_text_buffer_create_mark (buffer, NULL, start, TRUE);
+	block->dirty = TRUE;
+
+	return block;
+}
+
+static void
+block_free (Block *block)
+{
+	g_slice_free (Block, block);
+}
+
+static void
+block_reset_progress (GeditDocinfoStats *stats,
+		      Block             *block)
+{
+	if (block->resume != NULL)
+	{
+		gtk_text_buffer_delete_mark (stats->buffer, block->resume);
+		block->resume = NULL;
+	}
+
+	memset (&block->partial, 0, sizeof (GeditDocinfoCounts));
+}
+
+static void
+get_block_bounds (GeditDocinfoStats *stats,
+		  guint              index,
+		  GtkTextIter       *start,
+		  GtkTextIter       *end)
+{
+	Block *block = g_ptr_array_index (stats->blocks, index);
+
+	gtk_text_buffer_get_iter_at_mark (stats->buffer, start, block->start);
+
+	if (index + 1 < stats->blocks->len)
+	{
+		Block *next = g_ptr_array_index (stats->blocks, index + 1);
+
+		gtk_text_buffer_get_iter_at_mark (stats->buffer, end, next->start);
+	}
+	else
+	{
+		gtk_text_buffer_get_end_iter (stats->buffer, end);
+	}
+}
+
+/* Returns the index of the last block starting at or before @offset, which is
+ * the block where a text inserted at @offset goes, since the marks have a
+ * left gravity.
+ */
+static guint
+find_block (GeditDocinfoStats *stats,
+	    gint               offset)
+{
+	guint low = 0;
+	guint high = stats->blocks->len;
+
+	while (high - low > 1)
+	{
+		guint middle = low + (high - low) / 2;
+		Block *block = g_ptr_array_index (stats->blocks, middle);
+		GtkTextIter iter;
+
+		gtk_text_buffer_get_iter_at_mark (stats->buffer, &iter, block->start);
+
+		if (gtk_text_iter_get_offset (&iter) <= offset)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+/* The counting of the block, if in progress, starts again. */
+static void
+set_block_dirty (GeditDocinfoStats *stats,
+		 Block             *block)
+{
+	block_reset_progress (stats, block);
+
+	if (!block->dirty)
+	{
+		block->dirty = TRUE;
+		stats->n_dirty_blocks++;
+	}
+}
+
+/* Splits a block that became too big, at line boundaries. */
+static void
+split_block (GeditDocinfoStats *stats,
+	     guint              index)
+{
+	GtkTextIter iter;
+	GtkTextIter end;
+	guint n_lines;
+
+	get_block_bounds (stats, index, &iter, &end);
+
+	n_lines = gtk_text_iter_get_line (&end) - gtk_text_iter_get_line (&iter);
+
+	if (n_lines <= 2 * BLOCK_LINES)
+	{
+		return;
+	}
+
+	while (gtk_text_iter_forward_lines (&iter, BLOCK_LINES) &&
+	       gtk_text_iter_get_line (&end) - gtk_text_iter_get_line (&iter) >= BLOCK_LINES)
+	{
+		index++;
+		g_ptr_array_insert (stats->blocks, index, block_new (stats->buffer, &iter));
+		stats->n_dirty_blocks++;
+	}
+}
+
+/* A deletion can join the first line of a block with the last line of the
+ * previous block. The block mark is moved back to the start of the line, so
+ * that a word is never split between two blocks.
+ */
+static void
+align_dirty_blocks (GeditDocinfoStats *stats)
+{
+	guint i;
+
+	for (i = 1; i < stats->blocks->len; i++)
+	{
+		Block *block = g_ptr_array_index (stats->blocks, i);
+		GtkTextIter iter;
+
+		if (!block->dirty)
+		{
+			continue;
+		}
+
+		gtk_text_buffer_get_iter_at_mark (stats->buffer, &iter, block->start);
+
+		if (!gtk_text_iter_starts_line (&iter))
+		{
+			gtk_text_iter_set_line_offset (&iter, 0);
+			gtk_text_buffer_move_mark (stats->buffer, block->start, &iter);
+			block_reset_progress (stats, block);
+
+			set_block_dirty (stats, g_ptr_array_index (stats->blocks, i - 1));
+		}
+	}
+}
+
+static void
+notify_ready (GeditDocinfoStats *stats)
+{
+	if (stats->ready_func != NULL)
+	{
+		stats->ready_func (stats, stats->ready_data);
+	}
+}
+
+/* Counts the block slice by slice, from where it was left. Returns %FALSE if
+ * the time budget is exceeded before the end of the block.
+ */
+static gboolean
+count_block (GeditDocinfoStats *stats,
+	     Block             *block,
+	     GtkTextIter       *start,
+	     const GtkTextIter *end,
+	     gint64             start_time)
+{
+	while (!gtk_text_iter_equal (start, end))
+	{
+		GtkTextIter slice_end = *start;
+
+		forward_slice (&slice_end, end);
+		count_range (stats->buffer, start, &slice_end, &block->partial);
+		*start = slice_end;
+
+		if (!gtk_text_iter_equal (start, end) &&
+		    g_get_monotonic_time () - start_time > IDLE_BUDGET_USEC)
+		{
+			if (block->resume == NULL)
+			{
+				block->resume = gtk_text_buffer_create_mark (stats->buffer, NULL, start, TRUE);
+			}
+			else
+			{
+				gtk_text_buffer_move_mark (stats->buffer, block->resume, start);
+			}
+
+			return FALSE;
+		}
+	}
+
+	block->counts = block->partial;
+	block_reset_progress (stats, block);
+
+	return TRUE;
+}
+
+static gboolean
+count_dirty_blocks_cb (gpointer user_data)
+{
+	GeditDocinfoStats *stats = user_data;
+	gint64 start_time;
+	guint i;
+
+	start_time = g_get_monotonic_time ();
+
+	align_dirty_blocks (stats);
+
+	for (i = 0; i < stats->blocks->len && stats->n_dirty_blocks > 0; i++)
+	{
+		Block *block = g_ptr_array_index (stats->blocks, i);
+		GtkTextIter start;
+		GtkTextIter end;
+
+		if (!block->dirty)
+		{
+			continue;
+		}
+
+		get_block_bounds (stats, i, &start, &end);
+
+		/* The text of the block has been deleted. */
+		if (i > 0 && gtk_text_iter_equal (&start, &end))
+		{
+			block_reset_progress (stats, block);
+			gtk_text_buffer_delete_mark (stats->buffer, block->start);
+			g_ptr_array_remove_index (stats->blocks, i);
+			stats->n_dirty_blocks--;
+			i--;
+			continue;
+		}
+
+		if (block->resume == NULL)
+		{
+			split_block (stats, i);
+			get_block_bounds (stats, i, &start, &end);
+		}
+		else
+		{
+			gtk_text_buffer_get_iter_at_mark (stats->buffer, &start, block->resume);
+		}
+
+		if (!count_block (stats, block, &start, &end, start_time))
+		{
+			break;
+		}
+
+		block->dirty = FALSE;
+		stats->n_dirty_blocks--;
+
+		if (g_get_monotonic_time () - start_time > IDLE_BUDGET_USEC)
+		{
+			break;
+		}
+	}
+
+	if (stats->n_dirty_blocks > 0)
+	{
+		return G_SOURCE_CONTINUE;
+	}
+
+	gedit_debug_message (DEBUG_PLUGINS, "Statistics ready, %u blocks", stats->blocks->len);
+
+	stats->idle_id = 0;
+	notify_ready (stats);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_counting (GeditDocinfoStats *stats)
+{
+	if (stats->idle_id == 0 && stats->n_dirty_blocks > 0)
+	{
+		stats->idle_id = g_idle_add_full (G_PRIORITY_LOW,
+						  count_dirty_blocks_cb,
+						  stats,
+						  NULL);
+	}
+}
+
+/* The handlers are called before the default ones, so the offsets are the
+ * ones before the change.
+ */
+static void
+insert_text_cb (GtkTextBuffer     *buffer,
+		GtkTextIter       *location,
+		const gchar       *text,
+		gint               length,
+		GeditDocinfoStats *stats)
+{
+	guint index;
+
+	index = find_block (stats, gtk_text_iter_get_offset (location));
+	set_block_dirty (stats, g_ptr_array_index (stats->blocks, index));
+
+	schedule_counting (stats);
+}
+
+static void
+delete_range_cb (GtkTextBuffer     *buffer,
+		 GtkTextIter       *start,
+		 GtkTextIter       *end,
+		 GeditDocinfoStats *stats)
+{
+	guint first;
+	guint last;
+	guint i;
+
+	first = find_block (stats, gtk_text_iter_get_offset (start));
+	last = find_block (stats, gtk_text_iter_get_offset (end));
+
+	for (i = first; i <= last; i++)
+	{
+		set_block_dirty (stats, g_ptr_array_index (stats->blocks, i));
+	}
+
+	schedule_counting (stats);
+}
+
+static void
+create_blocks (GeditDocinfoStats *stats)
+{
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_start_iter (stats->buffer, &iter);
+
+	do
+	{
+		g_ptr_array_add (stats->blocks, block_new (stats->buffer, &iter));
+		stats->n_dirty_blocks++;
+	}
+	while (gtk_text_iter_forward_lines (&iter, BLOCK_LINES));
+}
+
+static GeditDocinfoStats *
+stats_new (GtkTextBuffer *buffer)
+{
+	GeditDocinfoStats *stats;
+
+	stats = g_slice_new0 (GeditDocinfoStats);
+	stats->blocks = g_ptr_array_new_with_free_func ((GDestroyNotify) block_free);
+
+	stats->buffer = buffer;
+	g_object_add_weak_pointer (G_OBJECT (buffer), (gpointer *) &stats->buffer);
+
+	create_blocks (stats);
+
+	g_signal_connect (buffer,
+			  "insert-text",
+			  G_CALLBACK (insert_text_cb),
+			  stats);
+
+	g_signal_connect (buffer,
+			  "delete-range",
+			  G_CALLBACK (delete_range_cb),
+			  stats);
+
+	schedule_counting (stats);
+
+	return stats;
+}
+
+static void
+stats_free (GeditDocinfoStats *stats)
+{
+	if (stats->idle_id != 0)
+	{
+		g_source_remove (stats->idle_id);
+	}
+
+	/* When the buffer is finalized, the weak pointer has already been
+	 * cleared and the marks are freed with the buffer.
+	 */
+	if (stats->buffer != NULL)
+	{
+		guint i;
+
+		g_signal_handlers_disconnect_by_data (stats->buffer, stats);
+
+		for (i = 0; i < stats->blocks->len; i++)
+		{
+			Block *block = g_ptr_array_index (stats->blocks, i);
+
+			block_reset_progress (stats, block);
+			gtk_text_buffer_delete_mark (stats->buffer, block->start);
+		}
+
+		g_object_remove_weak_pointer (G_OBJECT (stats->buffer), (gpointer *) &stats->buffer);
+	}
+
+	g_ptr_array_unref (stats->blocks);
+	g_slice_free (GeditDocinfoStats, stats);
+}
+
+/**
+ * gedit_docinfo_stats_get_for_buffer:
+ * @buffer: a #GtkTextBuffer.
+ *
+ * Gets the statistics engine of @buffer. It is created, and starts counting,
+ * on the first call. It is freed with @buffer.
+ *
+ * Returns: (transfer none): the statistics engine of @buffer.
+ */
+GeditDocinfoStats *
+gedit_docinfo_stats_get_for_buffer (GtkTextBuffer *buffer)
+{
+	GeditDocinfoStats *stats;
+
+	g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+
+	stats = g_object_get_data (G_OBJECT (buffer), STATS_KEY);
+
+	if (stats == NULL)
+	{
+		stats = stats_new (buffer);
+		g_object_set_data_full (G_OBJECT (buffer),
+					STATS_KEY,
+					stats,
+					(GDestroyNotify) stats_free);
+	}
+
+	return stats;
+}
+
+/* Must be called for each buffer before the plugin is unloaded. */
+void
+gedit_docinfo_stats_remove_from_buffer (GtkTextBuffer *buffer)
+{
+	g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+
+	g_object_set_data (G_OBJECT (buffer), STATS_KEY, NULL);
+}
+
+/**
+ * gedit_docinfo_stats_is_ready:
+ * @stats: a #GeditDocinfoStats.
+ *
+ * Returns: whether all the blocks have been counted since the last change.
+ */
+gboolean
+gedit_docinfo_stats_is_ready (GeditDocinfoStats *stats)
+{
+	g_return_val_if_fail (stats != NULL, FALSE);
+
+	return stats->n_dirty_blocks == 0;
+}
+
+/**
+ * gedit_docinfo_stats_set_ready_func:
+ * @stats: a #GeditDocinfoStats.
+ * @func: (nullable): the function to call when the counting is finished.
+ * @user_data: data to pass to @func.
+ */
+void
+gedit_docinfo_stats_set_ready_func (GeditDocinfoStats          *stats,
+				    GeditDocinfoStatsReadyFunc  func,
+				    gpointer                    user_data)
+{
+	g_return_if_fail (stats != NULL);
+
+	stats->ready_func = func;
+	stats->ready_data = user_data;
+}
+
+/**
+ * gedit_docinfo_stats_get_counts:
+ * @stats: a #GeditDocinfoStats.
+ * @counts: (out): the counts of the whole buffer.
+ *
+ * The counts are exact only when gedit_docinfo_stats_is_ready() returns
+ * %TRUE.
+ */
+void
+gedit_docinfo_stats_get_counts (GeditDocinfoStats  *stats,
+				GeditDocinfoCounts *counts)
+{
+	guint i;
+
+	g_return_if_fail (stats != NULL);
+	g_return_if_fail (counts != NULL);
+
+	memset (counts, 0, sizeof (GeditDocinfoCounts));
+
+	for (i = 0; i < stats->blocks->len; i++)
+	{
+		Block *block = g_ptr_array_index (stats->blocks, i);
+
+		add_counts (counts, &block->counts);
+	}
+}
+
+/**
+ * gedit_docinfo_stats_count_range:
+ * @stats: a #GeditDocinfoStats.
+ * @start: the start of the range.
+ * @end: the end of the range.
+ * @counts: (out): the counts of the range.
+ *
+ * Only the text at the range boundaries is counted, the counts of the blocks
+ * fully inside the range are reused. The blocks that have not been counted
+ * yet are counted right away.
+ */
+void
+gedit_docinfo_stats_count_range (GeditDocinfoStats  *stats,
+				 const GtkTextIter  *start,
+				 const GtkTextIter  *end,
+				 GeditDocinfoCounts *counts)
+{
+	GtkTextIter block_start;
+	GtkTextIter block_end;
+	guint first;
+	guint last;
+	guint i;
+
+	g_return_if_fail (stats != NULL);
+	g_return_if_fail (start != NULL);
+	g_return_if_fail (end != NULL);
+	g_return_if_fail (counts != NULL);
+
+	memset (counts, 0, sizeof (GeditDocinfoCounts));
+
+	first = find_block (stats, gtk_text_iter_get_offset (start));
+	last = find_block (stats, gtk_text_iter_get_offset (end));
+
+	if (first == last)
+	{
+		count_range (stats->buffer, start, end, counts);
+		return;
+	}
+
+	get_block_bounds (stats, first, &block_start, &block_end);
+	count_range (stats->buffer, start, &block_end, counts);
+
+	for (i = first + 1; i < last; i++)
+	{
+		Block *block = g_ptr_array_index (stats->blocks, i);
+
+		if (block->dirty)
+		{
+			get_block_bounds (stats, i, &block_start, &block_end);
+			count_range (stats->buffer, &block_start, &block_end, counts);
+		}
+		else
+		{
+			add_counts (counts, &block->counts);
+		}
+	}
+
+	get_block_bounds (stats, last, &block_start, &block_end);
+	count_range (stats->buffer, &block_start, end, counts);
+}
+
+/* ex:set ts=8 noet: */
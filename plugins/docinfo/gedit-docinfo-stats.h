@@ -0,0 +1,61 @@
+/*
+ * gedit-docinfo-stats.h
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_DOCINFO_STATS_H
+#define GEDIT_DOCINFO_STATS_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GeditDocinfoStats GeditDocinfoStats;
+
+typedef struct
+{
+	gint64 chars;
+	gint64 words;
+	gint64 white_chars;
+	gint64 bytes;
+} GeditDocinfoCounts;
+
+typedef void (* GeditDocinfoStatsReadyFunc) (GeditDocinfoStats *stats,
+					     gpointer           user_data);
+
+GeditDocinfoStats	*gedit_docinfo_stats_get_for_buffer	(GtkTextBuffer              *buffer);
+
+void			 gedit_docinfo_stats_remove_from_buffer	(GtkTextBuffer              *buffer);
+
+gboolean		 gedit_docinfo_stats_is_ready		(GeditDocinfoStats          *stats);
+
+void			 gedit_docinfo_stats_set_ready_func	(GeditDocinfoStats          *stats,
+								 GeditDocinfoStatsReadyFunc  func,
+								 gpointer                    user_data);
+
+void			 gedit_docinfo_stats_get_counts		(GeditDocinfoStats          *stats,
+								 GeditDocinfoCounts         *counts);
+
+void			 gedit_docinfo_stats_count_range	(GeditDocinfoStats          *stats,
+								 const GtkTextIter          *start,
+								 const GtkTextIter          *end,
+								 GeditDocinfoCounts         *counts);
+
+G_END_DECLS
+
+#endif /* GEDIT_DOCINFO_STATS_H */
+/* ex:set ts=8 noet: */
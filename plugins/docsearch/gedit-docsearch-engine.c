@@ -0,0 +1,628 @@
+/*
+ * gedit-docsearch-engine.c
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-docsearch-engine.h"
+
+#include <string.h>
+
+#include <gedit/gedit-debug.h>
+#include <gedit/gedit-tab.h>
+
+/* Each document is searched in a thread pool shared by all the searches,
+ * on a copy of its text taken on the main thread, so the total time is close
+ * to the time needed for the biggest document. The hits are sent to the main
+ * thread by batches, as soon as they are found.
+ *
+ * The copies are taken when the documents are pushed to the pool, and at
+ * most MAX_RUNNING_JOBS documents of a search are pushed at once: the next
+ * one is pushed when the last batch of a document arrives. So starting a
+ * search doesn't copy all the buffers at once, only a few copies are kept
+ * in memory, and the documents not copied yet are dropped when the search is
+ * cancelled.
+ *
+ * The documents are only used on the main thread: the references taken when
+ * the search starts are released with the last batch of each document.
+ *
+ * The document of a tab in the GEDIT_TAB_STATE_DEFERRED state is not loaded
+ * yet and its buffer is empty, so its file is read by the worker instead.
+ * The files that can't be read, that are bigger than MAX_FILE_SIZE, or that
+ * are not valid UTF-8, are counted as skipped.
+ *
+ * A matching error, for example when the regex backtracks too much, stops
+ * the search of the document and is returned once all the documents are
+ * searched.
+ */
+
+#define BATCH_SIZE 256
+
+#define MAX_RUNNING_JOBS (2 * g_get_num_processors ())
+
+/* The files of the deferred documents that are bigger are not read, they
+ * would likely be opened in the large file mode anyway.
+ */
+#define MAX_FILE_SIZE (16 * 1024 * 1024)
+
+/* To keep the results list usable. */
+#define MAX_HITS_PER_DOCUMENT 10000
+
+#define MAX_LINE_TEXT_BYTES 256
+
+typedef struct
+{
+	gint ref_count;
+
+	GRegex *regex;
+	GCancellable *cancellable;
+	GMainContext *context;
+
+	GeditDocsearchHitsFunc hits_func;
+	gpointer hits_func_data;
+
+	/* Only used on the main thread. */
+	GTask *task;
+	GQueue documents;
+	guint n_pending_documents;
+	guint n_running_jobs;
+	guint n_hits;
+	guint n_skipped;
+	GError *error;
+} Search;
+
+typedef struct
+{
+	Search *search;
+	GeditDocument *document;
+
+	/* The text of the document, or the location of the file to read for
+	 * a deferred document.
+	 */
+	gchar *text;
+	GFile *location;
+} DocumentJob;
+
+typedef struct
+{
+	guint n_hits;
+	guint n_skipped;
+} SearchResult;
+
+typedef struct
+{
+	Search *search;
+	GeditDocument *document;
+	GArray *hits;
+
+	/* Whether it is the last batch of the document. */
+	guint last : 1;
+
+	/* Whether the document could not be searched. */
+	guint skipped : 1;
+
+	/* For the last batch, the error which stopped the search of the
+	 * document.
+	 */
+	GError *error;
+} Batch;
+
+static GThreadPool *search_pool = NULL;
+
+static void search_document (gpointer data,
+			     gpointer user_data);
+
+static Search *
+search_ref (Search *search)
+{
+	g_atomic_int_inc (&search->ref_count);
+	return search;
+}
+
+static void
+search_unref (Search *search)
+{
+	if (g_atomic_int_dec_and_test (&search->ref_count))
+	{
+		g_regex_unref (search->regex);
+		g_clear_object (&search->cancellable);
+		g_main_context_unref (search->context);
+		g_clear_error (&search->error);
+
+		/* Already returned. */
+		g_warn_if_fail (search->task == NULL);
+		g_warn_if_fail (g_queue_is_empty (&search->documents));
+
+		g_slice_free (Search, search);
+	}
+}
+
+static void
+hit_clear (GeditDocsearchHit *hit)
+{
+	g_free (hit->line_text);
+}
+
+static Batch *
+batch_new (Search        *search,
+	   GeditDocument *document)
+{
+	Batch *batch;
+
+	batch = g_slice_new0 (Batch);
+	batch->search = search_ref (search);
+	batch->document = document;
+	batch->hits = g_array_sized_new (FALSE, FALSE, sizeof (GeditDocsearchHit), BATCH_SIZE);
+	g_array_set_clear_func (batch->hits, (GDestroyNotify) hit_clear);
+
+	return batch;
+}
+
+static void
+batch_free (Batch *batch)
+{
+	g_array_unref (batch->hits);
+	g_clear_error (&batch->error);
+	search_unref (batch->search);
+	g_slice_free (Batch, batch);
+}
+
+static void
+search_result_free (gpointer data)
+{
+	g_slice_free (SearchResult, data);
+}
+
+static void
+complete_search (Search *search)
+{
+	GTask *task = search->task;
+
+	search->task = NULL;
+
+	gedit_debug_message (DEBUG_PLUGINS, "Search finished, %u hits, %u documents skipped",
+			     search->n_hits, search->n_skipped);
+
+	if (g_task_return_error_if_cancelled (task))
+	{
+		g_clear_error (&search->error);
+	}
+	else if (search->error != NULL)
+	{
+		g_task_return_error (task, search->error);
+		search->error = NULL;
+	}
+	else
+	{
+		SearchResult *result;
+
+		result = g_slice_new (SearchResult);
+		result->n_hits = search->n_hits;
+		result->n_skipped = search->n_skipped;
+
+		g_task_return_pointer (task, result, search_result_free);
+	}
+
+	g_object_unref (task);
+}
+
+static DocumentJob *
+document_job_new (Search        *search,
+		  GeditDocument *document)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (document);
+	GeditTab *tab;
+	DocumentJob *job;
+
+	job = g_slice_new0 (DocumentJob);
+	job->search = search_ref (search);
+	job->document = document;
+
+	tab = gedit_tab_get_from_document (document);
+
+	if (tab != NULL &&
+	    gedit_tab_get_state (tab) == GEDIT_TAB_STATE_DEFERRED)
+	{
+		GtkSourceFile *file;
+		GFile *location;
+
+		file = gedit_document_get_file (document);
+		location = gtk_source_file_get_location (file);
+
+		/* Searched as an empty document without location. */
+		job->location = location != NULL ? g_object_ref (location) : NULL;
+		job->text = location != NULL ? NULL : g_strdup ("");
+	}
+	else
+	{
+		GtkTextIter start;
+		GtkTextIter end;
+
+		gtk_text_buffer_get_bounds (buffer, &start, &end);
+		job->text = gtk_text_buffer_get_slice (buffer, &start, &end, TRUE);
+	}
+
+	return job;
+}
+
+/* Pushes the next documents to the pool, or drops them if the search is
+ * cancelled.
+ */
+static void
+push_documents (Search *search)
+{
+	while (search->n_running_jobs < MAX_RUNNING_JOBS &&
+	       !g_queue_is_empty (&search->documents))
+	{
+		GeditDocument *document = g_queue_pop_head (&search->documents);
+
+		if (g_cancellable_is_cancelled (search->cancellable))
+		{
+			g_object_unref (document);
+			search->n_pending_documents--;
+			continue;
+		}
+
+		search->n_running_jobs++;
+		g_thread_pool_push (search_pool, document_job_new (search, document), NULL);
+	}
+}
+
+static gboolean
+deliver_batch_cb (gpointer user_data)
+{
+	Batch *batch = user_data;
+	Search *search = batch->search;
+
+	if (batch->hits->len > 0 &&
+	    !g_cancellable_is_cancelled (search->cancellable))
+	{
+		search->n_hits += batch->hits->len;
+
+		search->hits_func (batch->document,
+				   (const GeditDocsearchHit *) batch->hits->data,
+				   batch->hits->len,
+				   search->hits_func_data);
+	}
+
+	if (batch->last)
+	{
+		if (batch->skipped)
+		{
+			search->n_skipped++;
+		}
+
+		if (batch->error != NULL && search->error == NULL)
+		{
+			search->error = batch->error;
+			batch->error = NULL;
+		}
+
+		g_object_unref (batch->document);
+
+		search->n_running_jobs--;
+		search->n_pending_documents--;
+
+		push_documents (search);
+
+		if (search->n_pending_documents == 0)
+		{
+			complete_search (search);
+		}
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+send_batch (Batch    *batch,
+	    gboolean  last)
+{
+	batch->last = last != FALSE;
+
+	g_main_context_invoke_full (batch->search->context,
+				    G_PRIORITY_DEFAULT,
+				    deliver_batch_cb,
+				    batch,
+				    (GDestroyNotify) batch_free);
+}
+
+static gchar *
+get_line_text (const gchar *line_start,
+	       const gchar *text_end)
+{
+	const gchar *line_end;
+
+	line_end = memchr (line_start, '\n', text_end - line_start);
+
+	if (line_end == NULL)
+	{
+		line_end = text_end;
+	}
+
+	if (line_end > line_start && line_end[-1] == '\r')
+	{
+		line_end--;
+	}
+
+	if (line_end - line_start > MAX_LINE_TEXT_BYTES)
+	{
+		/* Don't cut a character. */
+		line_end = g_utf8_find_prev_char (line_start, line_start + MAX_LINE_TEXT_BYTES + 1);
+	}
+
+	return g_strndup (line_start, line_end - line_start);
+}
+
+static void
+search_document (gpointer data,
+		 gpointer user_data)
+{
+	DocumentJob *job = data;
+	Search *search = job->search;
+	const gchar *text;
+	const gchar *text_end;
+	const gchar *scanned;
+	const gchar *line_start;
+	gint line = 0;
+	guint n_hits = 0;
+	GMatchInfo *match_info = NULL;
+	GError *error = NULL;
+	Batch *batch;
+
+	batch = batch_new (search, job->document);
+
+	if (g_cancellable_is_cancelled (search->cancellable))
+	{
+		goto out;
+	}
+
+	if (job->text == NULL)
+	{
+		GFileInfo *info;
+		gsize length;
+
+		info = g_file_query_info (job->location,
+					  G_FILE_ATTRIBUTE_STANDARD_SIZE,
+					  G_FILE_QUERY_INFO_NONE,
+					  search->cancellable,
+					  NULL);
+
+		if (info != NULL &&
+		    g_file_info_get_size (info) > MAX_FILE_SIZE)
+		{
+			gedit_debug_message (DEBUG_PLUGINS, "File too big, skipped");
+			g_object_unref (info);
+			batch->skipped = TRUE;
+			goto out;
+		}
+
+		g_clear_object (&info);
+
+		if (!g_file_load_contents (job->location,
+					   search->cancellable,
+					   &job->text,
+					   &length,
+					   NULL,
+					   NULL))
+		{
+			batch->skipped = TRUE;
+			goto out;
+		}
+
+		/* The line and offsets of the hits must be the ones of the
+		 * buffer once the file is loaded, other encodings would need
+		 * the conversion done by the file loader.
+		 */
+		if (!g_utf8_validate (job->text, length, NULL) ||
+		    strlen (job->text) != length)
+		{
+			gedit_debug_message (DEBUG_PLUGINS, "Not UTF-8, skipped");
+			batch->skipped = TRUE;
+			goto out;
+		}
+	}
+
+	text = job->text;
+	text_end = text + strlen (text);
+	scanned = text;
+	line_start = text;
+
+	g_regex_match_full (search->regex, text, text_end - text, 0, 0, &match_info, &error);
+
+	while (error == NULL &&
+	       g_match_info_matches (match_info) &&
+	       n_hits < MAX_HITS_PER_DOCUMENT)
+	{
+		GeditDocsearchHit hit;
+		const gchar *newline;
+		gint start_pos;
+		gint end_pos;
+
+		g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos);
+
+		/* Count the lines incrementally. */
+		while ((newline = memchr (scanned, '\n', text + start_pos - scanned)) != NULL)
+		{
+			line++;
+			scanned = newline + 1;
+			line_start = scanned;
+		}
+
+		scanned = text + start_pos;
+
+		hit.line = line;
+		hit.line_offset = g_utf8_pointer_to_offset (line_start, text + start_pos);
+		hit.length = g_utf8_pointer_to_offset (text + start_pos, text + end_pos);
+		hit.line_text = get_line_text (line_start, text_end);
+
+		g_array_append_val (batch->hits, hit);
+		n_hits++;
+
+		if (batch->hits->len == BATCH_SIZE)
+		{
+			if (g_cancellable_is_cancelled (search->cancellable))
+			{
+				break;
+			}
+
+			send_batch (batch, FALSE);
+			batch = batch_new (search, job->document);
+		}
+
+		g_match_info_next (match_info, &error);
+	}
+
+	g_match_info_free (match_info);
+
+	if (error != NULL)
+	{
+		gedit_debug_message (DEBUG_PLUGINS, "Matching error: %s", error->message);
+		batch->error = error;
+	}
+
+out:
+	send_batch (batch, TRUE);
+
+	search_unref (job->search);
+	g_free (job->text);
+	g_clear_object (&job->location);
+	g_slice_free (DocumentJob, job);
+}
+
+/**
+ * gedit_docsearch_run_async:
+ * @documents: (element-type GeditDocument): the documents to search.
+ * @regex: the #GRegex to search.
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore.
+ * @hits_func: function called on the main thread with the hits, by batches.
+ * @hits_func_data: data passed to @hits_func.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when all the
+ *   documents have been searched.
+ * @user_data: user data to pass to @callback.
+ *
+ * Searches @regex in all @documents in parallel. The documents of the tabs
+ * which are not loaded yet are searched in their files.
+ *
+ * If matching fails in a document, for example because the regex backtracks
+ * too much, the other documents are still searched, and the first error is
+ * returned by gedit_docsearch_run_finish().
+ */
+void
+gedit_docsearch_run_async (GList                  *documents,
+			   GRegex                 *regex,
+			   GCancellable           *cancellable,
+			   GeditDocsearchHitsFunc  hits_func,
+			   gpointer                hits_func_data,
+			   GAsyncReadyCallback     callback,
+			   gpointer                user_data)
+{
+	GTask *task;
+	Search *search;
+	GList *l;
+
+	g_return_if_fail (regex != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (hits_func != NULL);
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+
+	if (documents == NULL)
+	{
+		g_task_return_pointer (task, g_slice_new0 (SearchResult), search_result_free);
+		g_object_unref (task);
+		return;
+	}
+
+	search = g_slice_new0 (Search);
+	search->ref_count = 1;
+	search->regex = g_regex_ref (regex);
+	search->cancellable = cancellable != NULL ? g_object_ref (cancellable) : NULL;
+	search->context = g_main_context_ref_thread_default ();
+	search->hits_func = hits_func;
+	search->hits_func_data = hits_func_data;
+	search->task = task;
+
+	if (search_pool == NULL)
+	{
+		search_pool = g_thread_pool_new (search_document,
+						 NULL,
+						 g_get_num_processors (),
+						 FALSE,
+						 NULL);
+	}
+
+	for (l = documents; l != NULL; l = l->next)
+	{
+		g_queue_push_tail (&search->documents, g_object_ref (l->data));
+		search->n_pending_documents++;
+	}
+
+	push_documents (search);
+
+	/* Cancelled before any document was pushed. */
+	if (search->n_pending_documents == 0)
+	{
+		complete_search (search);
+	}
+
+	search_unref (search);
+}
+
+/**
+ * gedit_docsearch_run_finish:
+ * @result: a #GAsyncResult.
+ * @n_skipped: (out) (optional): return location for the number of documents
+ *   whose file could not be read, or %NULL.
+ * @error: a location for a #GError, or %NULL.
+ *
+ * Returns: the number of hits.
+ */
+guint
+gedit_docsearch_run_finish (GAsyncResult  *result,
+			    guint         *n_skipped,
+			    GError       **error)
+{
+	SearchResult *search_result;
+	guint n_hits;
+
+	g_return_val_if_fail (g_task_is_valid (result, NULL), 0);
+
+	if (n_skipped != NULL)
+	{
+		*n_skipped = 0;
+	}
+
+	search_result = g_task_propagate_pointer (G_TASK (result), error);
+
+	if (search_result == NULL)
+	{
+		return 0;
+	}
+
+	n_hits = search_result->n_hits;
+
+	if (n_skipped != NULL)
+	{
+		*n_skipped = search_result->n_skipped;
+	}
+
+	search_result_free (search_result);
+
+	return n_hits;
+}
+
+/* ex:set ts=8 noet: */
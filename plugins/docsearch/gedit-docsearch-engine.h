@@ -0,0 +1,58 @@
+/*
+ * gedit-docsearch-engine.h
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_DOCSEARCH_ENGINE_H
+#define GEDIT_DOCSEARCH_ENGINE_H
+
+#include <gedit/gedit-document.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+	/* Line number and character offsets in the line, starting at 0. */
+	gint line;
+	gint line_offset;
+	gint length;
+
+	/* The beginning of the line, for display. */
+	gchar *line_text;
+} GeditDocsearchHit;
+
+typedef void (* GeditDocsearchHitsFunc) (GeditDocument           *document,
+					 const GeditDocsearchHit *hits,
+					 guint                    n_hits,
+					 gpointer                 user_data);
+
+void	gedit_docsearch_run_async	(GList                  *documents,
+					 GRegex                 *regex,
+					 GCancellable           *cancellable,
+					 GeditDocsearchHitsFunc  hits_func,
+					 gpointer                hits_func_data,
+					 GAsyncReadyCallback     callback,
+					 gpointer                user_data);
+
+guint	gedit_docsearch_run_finish	(GAsyncResult           *result,
+					 guint                  *n_skipped,
+					 GError                **error);
+
+G_END_DECLS
+
+#endif /* GEDIT_DOCSEARCH_ENGINE_H */
+/* ex:set ts=8 noet: */
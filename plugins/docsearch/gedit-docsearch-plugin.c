@@ -0,0 +1,823 @@
+/*
+ * gedit-docsearch-plugin.c
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gedit-docsearch-plugin.h"
+
+#include <glib/gi18n.h>
+#include <tepl/tepl.h>
+
+#include <gedit/gedit-debug.h>
+#include <gedit/gedit-app.h>
+#include <gedit/gedit-tab.h>
+#include <gedit/gedit-view.h>
+#include <gedit/gedit-window.h>
+#include <gedit/gedit-app-activatable.h>
+#include <gedit/gedit-window-activatable.h>
+
+#include "gedit-docsearch-engine.h"
+
+static void gedit_app_activatable_iface_init (GeditAppActivatableInterface *iface);
+static void gedit_window_activatable_iface_init (GeditWindowActivatableInterface *iface);
+
+struct _GeditDocsearchPluginPrivate
+{
+	GeditWindow *window;
+
+	GSimpleAction *action;
+	GtkWidget *panel;
+	GtkWidget *search_entry;
+	GtkWidget *match_case_checkbutton;
+	GtkWidget *regex_checkbutton;
+	GtkWidget *status_label;
+	GtkWidget *treeview;
+	GtkListStore *store;
+
+	/* The documents that have rows in the store. The rows are removed
+	 * when a document is finalized.
+	 */
+	GHashTable *documents;
+
+	GCancellable *cancellable;
+
+	GeditApp *app;
+	GeditMenuExtension *menu_ext;
+};
+
+enum
+{
+	PROP_0,
+	PROP_WINDOW,
+	PROP_APP
+};
+
+enum
+{
+	COLUMN_LOCATION,
+	COLUMN_TEXT,
+	COLUMN_DOCUMENT,
+	COLUMN_LINE,
+	COLUMN_LINE_OFFSET,
+	COLUMN_LENGTH,
+	N_COLUMNS
+};
+
+G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditDocsearchPlugin,
+				gedit_docsearch_plugin,
+				PEAS_TYPE_EXTENSION_BASE,
+				0,
+				G_IMPLEMENT_INTERFACE_DYNAMIC (GEDIT_TYPE_APP_ACTIVATABLE,
+							       gedit_app_activatable_iface_init)
+				G_IMPLEMENT_INTERFACE_DYNAMIC (GEDIT_TYPE_WINDOW_ACTIVATABLE,
+							       gedit_window_activatable_iface_init)
+				G_ADD_PRIVATE_DYNAMIC (GeditDocsearchPlugin))
+
+static void
+document_finalized_cb (gpointer  user_data,
+		       GObject  *where_the_document_was)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (user_data);
+	GtkTreeModel *model = GTK_TREE_MODEL (plugin->priv->store);
+	GtkTreeIter iter;
+	gboolean valid;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	g_hash_table_remove (plugin->priv->documents, where_the_document_was);
+
+	valid = gtk_tree_model_get_iter_first (model, &iter);
+
+	while (valid)
+	{
+		gpointer document;
+
+		gtk_tree_model_get (model, &iter, COLUMN_DOCUMENT, &document, -1);
+
+		if (document == where_the_document_was)
+		{
+			valid = gtk_list_store_remove (plugin->priv->store, &iter);
+		}
+		else
+		{
+			valid = gtk_tree_model_iter_next (model, &iter);
+		}
+	}
+}
+
+static void
+clear_results (GeditDocsearchPlugin *plugin)
+{
+	GeditDocsearchPluginPrivate *priv = plugin->priv;
+	GHashTableIter iter;
+	gpointer document;
+
+	g_hash_table_iter_init (&iter, priv->documents);
+
+	while (g_hash_table_iter_next (&iter, &document, NULL))
+	{
+		g_object_weak_unref (G_OBJECT (document), document_finalized_cb, plugin);
+	}
+
+	g_hash_table_remove_all (priv->documents);
+
+	gtk_list_store_clear (priv->store);
+}
+
+static void
+cancel_search (GeditDocsearchPlugin *plugin)
+{
+	if (plugin->priv->cancellable != NULL)
+	{
+		g_cancellable_cancel (plugin->priv->cancellable);
+		g_clear_object (&plugin->priv->cancellable);
+	}
+}
+
+static void
+hits_cb (GeditDocument           *document,
+	 const GeditDocsearchHit *hits,
+	 guint                    n_hits,
+	 gpointer                 user_data)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (user_data);
+	GeditDocsearchPluginPrivate *priv = plugin->priv;
+	gchar *name;
+	guint i;
+
+	if (!g_hash_table_contains (priv->documents, document))
+	{
+		g_hash_table_add (priv->documents, document);
+		g_object_weak_ref (G_OBJECT (document), document_finalized_cb, plugin);
+	}
+
+	name = gedit_document_get_short_name_for_display (document);
+
+	for (i = 0; i < n_hits; i++)
+	{
+		gchar *location;
+
+		location = g_strdup_printf ("%s:%d", name, hits[i].line + 1);
+
+		gtk_list_store_insert_with_values (priv->store, NULL, -1,
+						   COLUMN_LOCATION, location,
+						   COLUMN_TEXT, hits[i].line_text,
+						   COLUMN_DOCUMENT, document,
+						   COLUMN_LINE, hits[i].line,
+						   COLUMN_LINE_OFFSET, hits[i].line_offset,
+						   COLUMN_LENGTH, hits[i].length,
+						   -1);
+
+		g_free (location);
+	}
+
+	g_free (name);
+}
+
+static void
+search_ready_cb (GObject      *source_object,
+		 GAsyncResult *result,
+		 gpointer      user_data)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (user_data);
+	GError *error = NULL;
+	guint n_hits;
+	guint n_skipped;
+
+	n_hits = gedit_docsearch_run_finish (result, &n_skipped, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		/* Another search has been started, or the plugin has been
+		 * deactivated.
+		 */
+		g_error_free (error);
+	}
+	else if (error != NULL)
+	{
+		gtk_label_set_text (GTK_LABEL (plugin->priv->status_label), error->message);
+		g_error_free (error);
+	}
+	else
+	{
+		gchar *text;
+		guint n_documents;
+
+		n_documents = g_hash_table_size (plugin->priv->documents);
+
+		if (n_hits == 0)
+		{
+			text = g_strdup (_("No matches"));
+		}
+		else
+		{
+			/* Translators: the first part of the sentence, followed
+			 * by "in %u documents".
+			 */
+			gchar *matches = g_strdup_printf (ngettext ("%u match", "%u matches", n_hits), n_hits);
+
+			/* Translators: the first %s is "%u matches". */
+			text = g_strdup_printf (ngettext ("%s in %u document", "%s in %u documents", n_documents),
+						matches, n_documents);
+			g_free (matches);
+		}
+
+		/* The files of the tabs not loaded yet are searched on disk,
+		 * the ones which can't be read must not be silently ignored.
+		 */
+		if (n_skipped > 0)
+		{
+			gchar *skipped;
+			gchar *full_text;
+
+			skipped = g_strdup_printf (ngettext ("%u document could not be searched",
+							     "%u documents could not be searched",
+							     n_skipped),
+						   n_skipped);
+
+			/* Translators: the first %s is the search result, the
+			 * second one is "%u documents could not be searched".
+			 */
+			full_text = g_strdup_printf (_("%s (%s)"), text, skipped);
+
+			g_free (skipped);
+			g_free (text);
+			text = full_text;
+		}
+
+		gtk_label_set_text (GTK_LABEL (plugin->priv->status_label), text);
+		g_free (text);
+
+		g_clear_object (&plugin->priv->cancellable);
+	}
+
+	g_object_unref (plugin);
+}
+
+static void
+start_search (GeditDocsearchPlugin *plugin)
+{
+	GeditDocsearchPluginPrivate *priv = plugin->priv;
+	const gchar *text;
+	gchar *pattern;
+	GRegexCompileFlags flags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+	GRegex *regex;
+	GError *error = NULL;
+	GList *documents;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	cancel_search (plugin);
+	clear_results (plugin);
+
+	text = gtk_entry_get_text (GTK_ENTRY (priv->search_entry));
+
+	if (text[0] == '\0')
+	{
+		gtk_label_set_text (GTK_LABEL (priv->status_label), "");
+		return;
+	}
+
+	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->regex_checkbutton)))
+	{
+		pattern = g_strdup (text);
+	}
+	else
+	{
+		pattern = g_regex_escape_string (text, -1);
+	}
+
+	if (!gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->match_case_checkbutton)))
+	{
+		flags |= G_REGEX_CASELESS;
+	}
+
+	regex = g_regex_new (pattern, flags, 0, &error);
+	g_free (pattern);
+
+	if (regex == NULL)
+	{
+		gtk_label_set_text (GTK_LABEL (priv->status_label), error->message);
+		g_error_free (error);
+		return;
+	}
+
+	gtk_label_set_text (GTK_LABEL (priv->status_label), _("Searching…"));
+
+	priv->cancellable = g_cancellable_new ();
+
+	documents = gedit_app_get_documents (GEDIT_APP (g_application_get_default ()));
+
+	gedit_docsearch_run_async (documents,
+				   regex,
+				   priv->cancellable,
+				   hits_cb,
+				   plugin,
+				   search_ready_cb,
+				   g_object_ref (plugin));
+
+	g_list_free (documents);
+	g_regex_unref (regex);
+}
+
+static void
+search_changed_cb (GeditDocsearchPlugin *plugin)
+{
+	start_search (plugin);
+}
+
+static void
+select_hit (GeditTab *tab,
+	    gint      line,
+	    gint      line_offset,
+	    gint      length)
+{
+	GtkTextBuffer *buffer;
+	GeditView *view;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	buffer = GTK_TEXT_BUFFER (gedit_tab_get_document (tab));
+
+	/* The document may have been modified since the search. */
+	if (line < gtk_text_buffer_get_line_count (buffer))
+	{
+		gtk_text_buffer_get_iter_at_line (buffer, &start, line);
+		line_offset = MIN (line_offset, gtk_text_iter_get_chars_in_line (&start));
+		gtk_text_iter_set_line_offset (&start, line_offset);
+
+		end = start;
+		gtk_text_iter_forward_chars (&end, length);
+
+		gtk_text_buffer_select_range (buffer, &start, &end);
+	}
+
+	view = gedit_tab_get_view (tab);
+	tepl_view_scroll_to_cursor (TEPL_VIEW (view));
+	gtk_widget_grab_focus (GTK_WIDGET (view));
+}
+
+/* A hit found in the file of a document which was not loaded yet. */
+typedef struct
+{
+	gulong handler_id;
+	gint line;
+	gint line_offset;
+	gint length;
+} PendingHit;
+
+static void
+pending_hit_free (gpointer  data,
+		  GClosure *closure)
+{
+	g_slice_free (PendingHit, data);
+}
+
+static void
+document_loaded_cb (GeditDocument *document,
+		    PendingHit    *pending)
+{
+	GeditTab *tab;
+	gint line = pending->line;
+	gint line_offset = pending->line_offset;
+	gint length = pending->length;
+
+	/* Frees @pending. */
+	g_signal_handler_disconnect (document, pending->handler_id);
+
+	tab = gedit_tab_get_from_document (document);
+
+	if (tab != NULL && gedit_tab_get_state (tab) == GEDIT_TAB_STATE_NORMAL)
+	{
+		select_hit (tab, line, line_offset, length);
+	}
+}
+
+static void
+row_activated_cb (GtkTreeView          *treeview,
+		  GtkTreePath          *path,
+		  GtkTreeViewColumn    *column,
+		  GeditDocsearchPlugin *plugin)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL (plugin->priv->store);
+	GtkTreeIter iter;
+	gpointer document;
+	gint line;
+	gint line_offset;
+	gint length;
+	GeditTab *tab;
+	GtkWidget *window;
+	GeditTabState state;
+
+	if (!gtk_tree_model_get_iter (model, &iter, path))
+	{
+		return;
+	}
+
+	gtk_tree_model_get (model, &iter,
+			    COLUMN_DOCUMENT, &document,
+			    COLUMN_LINE, &line,
+			    COLUMN_LINE_OFFSET, &line_offset,
+			    COLUMN_LENGTH, &length,
+			    -1);
+
+	if (!g_hash_table_contains (plugin->priv->documents, document))
+	{
+		return;
+	}
+
+	tab = gedit_tab_get_from_document (GEDIT_DOCUMENT (document));
+
+	if (tab == NULL)
+	{
+		return;
+	}
+
+	window = gtk_widget_get_toplevel (GTK_WIDGET (tab));
+
+	if (GEDIT_IS_WINDOW (window))
+	{
+		gedit_window_set_active_tab (GEDIT_WINDOW (window), tab);
+		gtk_window_present (GTK_WINDOW (window));
+	}
+
+	state = gedit_tab_get_state (tab);
+
+	/* Showing a deferred tab starts its loading, the hit is selected
+	 * once the document is loaded.
+	 */
+	if (state == GEDIT_TAB_STATE_DEFERRED ||
+	    state == GEDIT_TAB_STATE_LOADING)
+	{
+		PendingHit *pending;
+
+		pending = g_slice_new (PendingHit);
+		pending->line = line;
+		pending->line_offset = line_offset;
+		pending->length = length;
+		pending->handler_id = g_signal_connect_data (document,
+							     "loaded",
+							     G_CALLBACK (document_loaded_cb),
+							     pending,
+							     pending_hit_free,
+							     G_CONNECT_AFTER);
+		return;
+	}
+
+	select_hit (tab, line, line_offset, length);
+}
+
+static GtkWidget *
+create_treeview (GeditDocsearchPlugin *plugin)
+{
+	GtkWidget *treeview;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	treeview = gtk_tree_view_new_with_model (GTK_TREE_MODEL (plugin->priv->store));
+	gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (treeview), FALSE);
+	gtk_tree_view_set_enable_search (GTK_TREE_VIEW (treeview), FALSE);
+
+	renderer = gtk_cell_renderer_text_new ();
+	column = gtk_tree_view_column_new_with_attributes (_("Location"), renderer,
+							   "text", COLUMN_LOCATION,
+							   NULL);
+	gtk_tree_view_append_column (GTK_TREE_VIEW (treeview), column);
+
+	renderer = gtk_cell_renderer_text_new ();
+	g_object_set (renderer,
+		      "family", "Monospace",
+		      "ellipsize", PANGO_ELLIPSIZE_END,
+		      NULL);
+	column = gtk_tree_view_column_new_with_attributes (_("Text"), renderer,
+							   "text", COLUMN_TEXT,
+							   NULL);
+	gtk_tree_view_column_set_expand (column, TRUE);
+	gtk_tree_view_append_column (GTK_TREE_VIEW (treeview), column);
+
+	g_signal_connect (treeview,
+			  "row-activated",
+			  G_CALLBACK (row_activated_cb),
+			  plugin);
+
+	return treeview;
+}
+
+static void
+create_panel (GeditDocsearchPlugin *plugin)
+{
+	GeditDocsearchPluginPrivate *priv = plugin->priv;
+	GtkWidget *hbox;
+	GtkWidget *scrolled_window;
+
+	priv->store = gtk_list_store_new (N_COLUMNS,
+					  G_TYPE_STRING,
+					  G_TYPE_STRING,
+					  G_TYPE_POINTER,
+					  G_TYPE_INT,
+					  G_TYPE_INT,
+					  G_TYPE_INT);
+
+	priv->panel = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
+	gtk_container_set_border_width (GTK_CONTAINER (priv->panel), 6);
+
+	hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
+	gtk_box_pack_start (GTK_BOX (priv->panel), hbox, FALSE, FALSE, 0);
+
+	priv->search_entry = gtk_search_entry_new ();
+	gtk_entry_set_placeholder_text (GTK_ENTRY (priv->search_entry), _("Search in all documents"));
+	gtk_entry_set_width_chars (GTK_ENTRY (priv->search_entry), 30);
+	gtk_box_pack_start (GTK_BOX (hbox), priv->search_entry, FALSE, FALSE, 0);
+
+	priv->match_case_checkbutton = gtk_check_button_new_with_mnemonic (_("_Match case"));
+	gtk_box_pack_start (GTK_BOX (hbox), priv->match_case_checkbutton, FALSE, FALSE, 0);
+
+	priv->regex_checkbutton = gtk_check_button_new_with_mnemonic (_("Re_gular expression"));
+	gtk_box_pack_start (GTK_BOX (hbox), priv->regex_checkbutton, FALSE, FALSE, 0);
+
+	priv->status_label = gtk_label_new (NULL);
+	gtk_label_set_ellipsize (GTK_LABEL (priv->status_label), PANGO_ELLIPSIZE_END);
+	gtk_widget_set_halign (priv->status_label, GTK_ALIGN_END);
+	gtk_box_pack_end (GTK_BOX (hbox), priv->status_label, TRUE, TRUE, 0);
+
+	scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scrolled_window), GTK_SHADOW_IN);
+	gtk_box_pack_start (GTK_BOX (priv->panel), scrolled_window, TRUE, TRUE, 0);
+
+	priv->treeview = create_treeview (plugin);
+	gtk_container_add (GTK_CONTAINER (scrolled_window), priv->treeview);
+
+	g_signal_connect_swapped (priv->search_entry,
+				  "search-changed",
+				  G_CALLBACK (search_changed_cb),
+				  plugin);
+	g_signal_connect_swapped (priv->search_entry,
+				  "activate",
+				  G_CALLBACK (search_changed_cb),
+				  plugin);
+	g_signal_connect_swapped (priv->match_case_checkbutton,
+				  "toggled",
+				  G_CALLBACK (search_changed_cb),
+				  plugin);
+	g_signal_connect_swapped (priv->regex_checkbutton,
+				  "toggled",
+				  G_CALLBACK (search_changed_cb),
+				  plugin);
+
+	gtk_widget_show_all (priv->panel);
+}
+
+static void
+search_documents_cb (GAction              *action,
+		     GVariant             *parameter,
+		     GeditDocsearchPlugin *plugin)
+{
+	GeditDocsearchPluginPrivate *priv = plugin->priv;
+	GtkWidget *bottom_panel;
+	GeditDocument *doc;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	/* Search the selected text, if any. */
+	doc = gedit_window_get_active_document (priv->window);
+
+	if (doc != NULL &&
+	    gtk_text_buffer_get_selection_bounds (GTK_TEXT_BUFFER (doc), &start, &end) &&
+	    gtk_text_iter_get_line (&start) == gtk_text_iter_get_line (&end))
+	{
+		gchar *text;
+
+		text = gtk_text_buffer_get_text (GTK_TEXT_BUFFER (doc), &start, &end, FALSE);
+		gtk_entry_set_text (GTK_ENTRY (priv->search_entry), text);
+		g_free (text);
+	}
+
+	bottom_panel = gedit_window_get_bottom_panel (priv->window);
+	gtk_stack_set_visible_child (GTK_STACK (bottom_panel), priv->panel);
+	gtk_widget_show (bottom_panel);
+
+	gtk_widget_grab_focus (priv->search_entry);
+}
+
+static void
+gedit_docsearch_plugin_app_activate (GeditAppActivatable *activatable)
+{
+	GeditDocsearchPluginPrivate *priv;
+	GMenuItem *item;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	priv = GEDIT_DOCSEARCH_PLUGIN (activatable)->priv;
+
+	priv->menu_ext = gedit_app_activatable_extend_menu (activatable, "search-section-1");
+	item = g_menu_item_new (_("Search in All _Documents…"), "win.search-documents");
+	gedit_menu_extension_append_menu_item (priv->menu_ext, item);
+	g_object_unref (item);
+}
+
+static void
+gedit_docsearch_plugin_app_deactivate (GeditAppActivatable *activatable)
+{
+	GeditDocsearchPluginPrivate *priv;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	priv = GEDIT_DOCSEARCH_PLUGIN (activatable)->priv;
+
+	g_clear_object (&priv->menu_ext);
+}
+
+static void
+gedit_docsearch_plugin_window_activate (GeditWindowActivatable *activatable)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (activatable);
+	GeditDocsearchPluginPrivate *priv = plugin->priv;
+	GtkWidget *bottom_panel;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	priv->documents = g_hash_table_new (NULL, NULL);
+
+	create_panel (plugin);
+
+	bottom_panel = gedit_window_get_bottom_panel (priv->window);
+	gtk_stack_add_titled (GTK_STACK (bottom_panel),
+			      priv->panel,
+			      "GeditDocsearchPanel",
+			      _("Search Results"));
+
+	priv->action = g_simple_action_new ("search-documents", NULL);
+	g_signal_connect (priv->action, "activate",
+			  G_CALLBACK (search_documents_cb), plugin);
+	g_action_map_add_action (G_ACTION_MAP (priv->window),
+				 G_ACTION (priv->action));
+}
+
+static void
+gedit_docsearch_plugin_window_deactivate (GeditWindowActivatable *activatable)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (activatable);
+	GeditDocsearchPluginPrivate *priv = plugin->priv;
+	GtkWidget *bottom_panel;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	cancel_search (plugin);
+	clear_results (plugin);
+
+	g_action_map_remove_action (G_ACTION_MAP (priv->window), "search-documents");
+
+	bottom_panel = gedit_window_get_bottom_panel (priv->window);
+	gtk_container_remove (GTK_CONTAINER (bottom_panel), priv->panel);
+	priv->panel = NULL;
+}
+
+static void
+gedit_docsearch_plugin_init (GeditDocsearchPlugin *plugin)
+{
+	gedit_debug_message (DEBUG_PLUGINS, "GeditDocsearchPlugin initializing");
+
+	plugin->priv = gedit_docsearch_plugin_get_instance_private (plugin);
+}
+
+static void
+gedit_docsearch_plugin_dispose (GObject *object)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (object);
+
+	gedit_debug_message (DEBUG_PLUGINS, "GeditDocsearchPlugin disposing");
+
+	g_clear_object (&plugin->priv->action);
+	g_clear_object (&plugin->priv->store);
+	g_clear_object (&plugin->priv->cancellable);
+	g_clear_object (&plugin->priv->window);
+	g_clear_object (&plugin->priv->menu_ext);
+	g_clear_object (&plugin->priv->app);
+
+	G_OBJECT_CLASS (gedit_docsearch_plugin_parent_class)->dispose (object);
+}
+
+static void
+gedit_docsearch_plugin_finalize (GObject *object)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (object);
+
+	gedit_debug_message (DEBUG_PLUGINS, "GeditDocsearchPlugin finalizing");
+
+	if (plugin->priv->documents != NULL)
+	{
+		g_hash_table_unref (plugin->priv->documents);
+	}
+
+	G_OBJECT_CLASS (gedit_docsearch_plugin_parent_class)->finalize (object);
+}
+
+static void
+gedit_docsearch_plugin_set_property (GObject      *object,
+				     guint         prop_id,
+				     const GValue *value,
+				     GParamSpec   *pspec)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (object);
+
+	switch (prop_id)
+	{
+		case PROP_WINDOW:
+			plugin->priv->window = GEDIT_WINDOW (g_value_dup_object (value));
+			break;
+		case PROP_APP:
+			plugin->priv->app = GEDIT_APP (g_value_dup_object (value));
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gedit_docsearch_plugin_get_property (GObject    *object,
+				     guint       prop_id,
+				     GValue     *value,
+				     GParamSpec *pspec)
+{
+	GeditDocsearchPlugin *plugin = GEDIT_DOCSEARCH_PLUGIN (object);
+
+	switch (prop_id)
+	{
+		case PROP_WINDOW:
+			g_value_set_object (value, plugin->priv->window);
+			break;
+		case PROP_APP:
+			g_value_set_object (value, plugin->priv->app);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+			break;
+	}
+}
+
+static void
+gedit_docsearch_plugin_class_init (GeditDocsearchPluginClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gedit_docsearch_plugin_dispose;
+	object_class->finalize = gedit_docsearch_plugin_finalize;
+	object_class->set_property = gedit_docsearch_plugin_set_property;
+	object_class->get_property = gedit_docsearch_plugin_get_property;
+
+	g_object_class_override_property (object_class, PROP_WINDOW, "window");
+	g_object_class_override_property (object_class, PROP_APP, "app");
+}
+
+static void
+gedit_docsearch_plugin_class_finalize (GeditDocsearchPluginClass *klass)
+{
+}
+
+static void
+gedit_app_activatable_iface_init (GeditAppActivatableInterface *iface)
+{
+	iface->activate = gedit_docsearch_plugin_app_activate;
+	iface->deactivate = gedit_docsearch_plugin_app_deactivate;
+}
+
+static void
+gedit_window_activatable_iface_init (GeditWindowActivatableInterface *iface)
+{
+	iface->activate = gedit_docsearch_plugin_window_activate;
+	iface->deactivate = gedit_docsearch_plugin_window_deactivate;
+}
+
+G_MODULE_EXPORT void
+peas_register_types (PeasObjectModule *module)
+{
+	gedit_docsearch_plugin_register_type (G_TYPE_MODULE (module));
+
+	peas_object_module_register_extension_type (module,
+						    GEDIT_TYPE_APP_ACTIVATABLE,
+						    GEDIT_TYPE_DOCSEARCH_PLUGIN);
+	peas_object_module_register_extension_type (module,
+						    GEDIT_TYPE_WINDOW_ACTIVATABLE,
+						    GEDIT_TYPE_DOCSEARCH_PLUGIN);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,125 @@
+# -*- coding: utf-8 -*-
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with this program; if not, write to the Free Software
+#    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+"""
+Compares the time taken to find the links of a compiler log by the
+LinkParser and by running each of its regular expressions in turn.
+
+Usage: benchlinkparsing.py [LOG]
+
+Without LOG, a build log of about 200000 lines is generated.
+"""
+
+import sys
+import time
+import linkparsing
+
+# Write the output the way the output panel receives it
+CHUNK_SIZE = 0x10000
+ROUNDS = 5
+
+REGEXPS = (linkparsing.REGEXP_STANDARD,
+           linkparsing.REGEXP_PYTHON,
+           linkparsing.REGEXP_VALAC,
+           linkparsing.REGEXP_BASH,
+           linkparsing.REGEXP_RUBY,
+           linkparsing.REGEXP_PERL,
+           linkparsing.REGEXP_MCS)
+
+LOG_LINES = (
+    "[%(i)d/2000] Compiling C object gedit/libgedit.so.p/gedit-file-%(i)d.c.o",
+    "gedit/gedit-file-%(i)d.c: In function 'gedit_file_%(i)d_init':",
+    "gedit/gedit-file-%(i)d.c:%(i)d:12: warning: unused variable 'tmp' [-Wunused-variable]",
+    "  %(i)d |         gint tmp;",
+    "      |              ^~~",
+    "cc -Igedit/libgedit.so.p -Igedit -I.. -I/usr/include/glib-2.0 -fPIC -O2 -g -MD -c gedit-file-%(i)d.c",
+)
+
+
+def generate_log(n_lines):
+    lines = []
+
+    for i in range(n_lines // len(LOG_LINES)):
+        for line in LOG_LINES:
+            lines.append(line % {'i': i})
+
+    return '\n'.join(lines) + '\n'
+
+
+def split_chunks(text):
+    chunks = []
+    start = 0
+
+    while start < len(text):
+        end = text.find('\n', start + CHUNK_SIZE)
+        end = len(text) if end == -1 else end + 1
+        chunks.append(text[start:end])
+        start = end
+
+    return chunks
+
+
+def parse_separately(parsers, chunk):
+    links = []
+
+    for parser in parsers:
+        links.extend(parser.parse(chunk))
+
+    return links
+
+
+def bench(name, func, chunks):
+    best = None
+
+    for i in range(ROUNDS):
+        start = time.perf_counter()
+        n_links = 0
+
+        for chunk in chunks:
+            n_links += len(func(chunk))
+
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+
+    print("%-24s %8.1f ms %8d links" % (name, best * 1000, n_links))
+    return best
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], encoding='utf-8', errors='replace') as f:
+            text = f.read()
+    else:
+        text = generate_log(200000)
+
+    chunks = split_chunks(text)
+    print("%d lines, %d chunks" % (text.count('\n'), len(chunks)))
+
+    parser = linkparsing.LinkParser()
+    separate = [linkparsing.RegexpLinkParser(regexp) for regexp in REGEXPS]
+
+    combined_time = bench("combined expressions", parser.parse, chunks)
+    separate_time = bench("one pass per regexp",
+                          lambda chunk: parse_separately(separate, chunk),
+                          chunks)
+
+    print("speedup: %.2fx" % (separate_time / combined_time))
+
+
+if __name__ == '__main__':
+    main()
+
+# ex:ts=4:et:
@@ -42,6 +42,10 @@ class Capture(GObject.Object):
 
     WRITE_BUFFER_SIZE = 0x4000
 
+    # The maximum amount of output read before returning to the main loop,
+    # the lines read at once are emitted together
+    READ_BUFFER_SIZE = 0x10000
+
     __gsignals__ = {
         'stdout-line': (GObject.SignalFlags.RUN_LAST, GObject.TYPE_NONE, (GObject.TYPE_STRING,)),
         'stderr-line': (GObject.SignalFlags.RUN_LAST, GObject.TYPE_NONE, (GObject.TYPE_STRING,)),
@@ -183,16 +187,32 @@ class Capture(GObject.Object):
     def handle_source(self, source, condition, signalname):
         if condition & (GObject.IO_IN | GObject.IO_PRI):
             status = GLib.IOStatus.NORMAL
-            while status == GLib.IOStatus.NORMAL:
+            lines = []
+            size = 0
+
+            # A tool writing a lot must not keep the main loop busy, the
+            # rest is read the next time
+            while status == GLib.IOStatus.NORMAL and size < self.READ_BUFFER_SIZE:
                 try:
                     (status, buf, length, terminator_pos) = source.read_line()
                 except Exception as e:
-                    return False
+                    status = None
+                    break
                 if buf:
-                    self.emit(signalname, buf)
-            if status != GLib.IOStatus.AGAIN:
+                    lines.append(buf)
+                    size += length
+
+            if lines:
+                self.emit(signalname, ''.join(lines))
+
+            if status not in (GLib.IOStatus.NORMAL, GLib.IOStatus.AGAIN):
                 return False
 
+            # The read stopped at READ_BUFFER_SIZE, the data still in the
+            # pipe must be read before the hang up is honoured
+            if status == GLib.IOStatus.NORMAL:
+                return True
+
         if condition & ~(GObject.IO_IN | GObject.IO_PRI):
             return False
 
@@ -306,6 +306,7 @@ def capture_begin_execute_panel(capture, panel, view, label):
 
     panel['stop'].set_sensitive(True)
     panel.clear()
+    panel.start_log()
     panel.write(_("Running tool:"), panel.italic_tag)
     panel.write(" %s\n\n" % label, panel.bold_tag)
 
@@ -342,6 +343,8 @@ def capture_end_execute_panel(capture, exit_code, panel, view, output_type):
         panel.write("\n" + _("Exited") + ":", panel.italic_tag)
         panel.write(" %d\n" % exit_code, panel.bold_tag)
 
+    panel.end_log()
+
 
 def capture_stdout_line_panel(capture, line, panel):
     panel.write(line)
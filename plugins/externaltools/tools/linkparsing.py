@@ -60,10 +60,15 @@ class LinkParser:
     register in this class cunstructor using the method add_parser. If you want
     to add a regular expression then just call add_regexp in this class
     constructor and provide your regexp string as argument.
+
+    The regular expressions are compiled together, so that the text is only
+    scanned once whatever their number.
     """
 
     def __init__(self):
         self._providers = []
+        self._regexps = []
+        self._combined = None
         self.add_regexp(REGEXP_STANDARD)
         self.add_regexp(REGEXP_PYTHON)
         self.add_regexp(REGEXP_VALAC)
@@ -84,7 +89,8 @@ class LinkParser:
         a group named ln. To read more about this look at the documentation
         for the RegexpLinkParser constructor.
         """
-        self.add_parser(RegexpLinkParser(regexp))
+        self._regexps.append(regexp)
+        self._combined = None
 
     def parse(self, text):
         """
@@ -98,8 +104,14 @@ class LinkParser:
         if text is None:
             raise ValueError("text can not be None")
 
+        if self._combined is None and self._regexps:
+            self._combined = CombinedRegexpLinkParser(self._regexps)
+
         links = []
 
+        if self._combined is not None:
+            links.extend(self._combined.parse(text))
+
         for provider in self._providers:
             links.extend(provider.parse(text))
 
@@ -161,6 +173,75 @@ class RegexpLinkParser(AbstractLinkParser):
 
         return links
 
+class CombinedRegexpLinkParser(AbstractLinkParser):
+    """
+    A parser finding the links of several regular expressions at once. The
+    regular expressions follow the rules of the RegexpLinkParser ones.
+
+    The expressions anchored at the start of a line are compiled into a
+    single expression, with the anchor put in front of all of them, so that
+    the positions which are not at the start of a line are skipped at once.
+    Mixing the expressions which are not anchored in it would make every
+    position go through all the alternatives, so they are compiled into a
+    second expression. At a given position, the expressions are tried in the
+    order in which they were given and the first one matching wins.
+    """
+
+    def __init__(self, regexps):
+        anchored = []
+        unanchored = []
+        self._groups = {}
+
+        for i, regexp in enumerate(regexps):
+            # The group names must be unique in the combined expressions
+            renamed = re.sub(r"\(\?P<(\w+)>",
+                             lambda m: "(?P<%s_%d>" % (m.group(1), i),
+                             regexp).lstrip()
+
+            name = "re_%d" % i
+
+            if renamed.startswith("^"):
+                anchored.append("(?P<%s>\n%s\n)" % (name, renamed[1:]))
+            else:
+                unanchored.append("(?P<%s>\n%s\n)" % (name, renamed))
+
+            col = "col_%d" % i
+            if not re.search(r"\(\?P<col>", regexp):
+                col = None
+
+            self._groups[name] = ("lnk_%d" % i, "pth_%d" % i, "ln_%d" % i, col)
+
+        self._res = []
+
+        if anchored:
+            self._res.append(re.compile("^(?:%s)" % "|".join(anchored),
+                                        re.MULTILINE | re.VERBOSE))
+
+        if unanchored:
+            self._res.append(re.compile("|".join(unanchored),
+                                        re.MULTILINE | re.VERBOSE))
+
+    def parse(self, text):
+        links = []
+
+        for regexp in self._res:
+            for m in regexp.finditer(text):
+                # The group of the whole alternative is the last one to close
+                lnk, pth, ln, col = self._groups[m.lastgroup]
+
+                if col is not None and m.group(col) is not None:
+                    col_nr = m.group(col)
+                else:
+                    col_nr = 0
+
+                links.append(Link(m.group(pth), m.group(ln), col_nr,
+                                  m.start(lnk), m.end(lnk)))
+
+        if len(self._res) > 1:
+            links.sort(key=lambda link: link.start)
+
+        return links
+
 # gcc 'test.c:13: warning: ...'
 # grep 'test.c:5:int main(...'
 # javac 'Test.java:13: ...'
@@ -20,6 +20,9 @@
 __all__ = ('OutputPanel', 'UniqueById')
 
 import os
+import queue
+import tempfile
+import threading
 from weakref import WeakKeyDictionary
 from .capture import *
 import re
@@ -35,6 +38,9 @@ try:
 except:
     _ = lambda s: s
 
+# The output written during this time is inserted at once, in ms
+FLUSH_INTERVAL = 16
+
 class UniqueById:
     __shared_state = WeakKeyDictionary()
 
@@ -73,6 +79,7 @@ class OutputPanel(UniqueById):
         self['view'].connect('button-press-event', self.on_view_button_press_event)
 
         self.panel = self["output-panel"]
+        self.panel.connect('destroy', self.on_panel_destroy)
         self.font_changed()
 
         buffer = self['view'].get_buffer()
@@ -98,10 +105,25 @@ class OutputPanel(UniqueById):
 
         self.process = None
 
+        # The output not inserted yet, as (text, tag) pairs
+        self.pending = []
+        self.flush_id = 0
+        self.scroll_id = 0
+
+        # The number of characters removed from the start of the buffer, the
+        # links are kept with their offsets in the whole output
+        self.trimmed = 0
         self.links = []
+        self.generation = 0
+
+        self.log_file = None
+        self.log_path = None
 
         self.link_parser = linkparsing.LinkParser()
+        self.link_queue = None
+        self.link_thread = None
         self.file_lookup = filelookup.FileLookup(window)
+        self.lookup_cache = {}
 
     def get_profile_settings(self):
         #FIXME return either the gnome-terminal settings or the gedit one
@@ -131,43 +153,241 @@ class OutputPanel(UniqueById):
             self.process.stop(-1)
 
     def scroll_to_end(self):
+        self.scroll_id = 0
         iter = self['view'].get_buffer().get_end_iter()
         self['view'].scroll_to_iter(iter, 0.0, False, 0.5, 0.5)
         return False  # don't requeue this handler
 
     def clear(self):
+        if self.flush_id:
+            GLib.source_remove(self.flush_id)
+            self.flush_id = 0
+
+        self.pending = []
         self['view'].get_buffer().set_text("")
+        self.trimmed = 0
         self.links = []
+        self.lookup_cache = {}
+
+        # The links still being parsed belong to the previous output
+        self.generation += 1
+
+    def start_log(self):
+        """
+        Saves the whole output of the tool to a file if the panel only keeps
+        its last lines.
+        """
+        self.end_log(False)
+
+        if not self.profile_settings.get_boolean("save-full-log"):
+            return
+
+        # Each run has its own file, several windows can run tools at once
+        logdir = os.path.join(GLib.get_user_cache_dir(), 'gedit', 'external-tools')
+
+        try:
+            os.makedirs(logdir, mode=0o700, exist_ok=True)
+            fd, self.log_path = tempfile.mkstemp(prefix='output-', suffix='.log', dir=logdir)
+            self.log_file = open(fd, 'w', encoding='utf-8')
+        except OSError:
+            self.log_file = None
+            self.remove_log()
+
+    def end_log(self, notify=True):
+        if self.log_file is None:
+            self.remove_log()
+            return
+
+        try:
+            self.log_file.close()
+        except OSError:
+            pass
+
+        self.log_file = None
+
+        # Whether lines were removed is only known once the output is in
+        if notify and self.flush_id:
+            GLib.source_remove(self.flush_id)
+            self.flush()
+
+        # The log is kept until the next run only if it has more than the
+        # panel
+        if notify and self.trimmed > 0:
+            self.write(_("The full output was saved to %s") % (self.log_path, ) + "\n",
+                       self.italic_tag)
+        else:
+            self.remove_log()
+
+    def remove_log(self):
+        if self.log_path is None:
+            return
+
+        try:
+            os.unlink(self.log_path)
+        except OSError:
+            pass
+
+        self.log_path = None
 
     def visible(self):
         panel = self.window.get_bottom_panel()
         return panel.props.visible and panel.props.visible_child == self.panel
 
     def write(self, text, tag=None):
+        if self.log_file is not None:
+            try:
+                self.log_file.write(text)
+            except OSError:
+                self.end_log(False)
+
+        # The output is inserted once per frame, whatever the number of
+        # chunks written by the tool
+        self.pending.append((text, tag))
+
+        if not self.flush_id:
+            self.flush_id = GLib.timeout_add(FLUSH_INTERVAL, self.flush)
+
+    def flush(self):
+        self.flush_id = 0
+
+        if not self.pending:
+            return False
+
         buffer = self['view'].get_buffer()
+        pending = self.pending
+        self.pending = []
 
-        end_iter = buffer.get_end_iter()
-        insert = buffer.create_mark(None, end_iter, True)
+        # The consecutive chunks with the same tag are inserted together
+        runs = []
 
-        if tag is None:
-            buffer.insert(end_iter, text)
-        else:
-            buffer.insert_with_tags(end_iter, text, tag)
+        for text, tag in pending:
+            if runs and runs[-1][1] is tag:
+                runs[-1][0].append(text)
+            else:
+                runs.append(([text], tag))
+
+        for texts, tag in runs:
+            text = ''.join(texts)
+            end_iter = buffer.get_end_iter()
+            offset = self.trimmed + end_iter.get_offset()
+
+            if tag is None:
+                buffer.insert(end_iter, text)
+            else:
+                buffer.insert_with_tags(end_iter, text, tag)
+
+            self.parse_links(offset, text)
+
+        self.trim()
+
+        if not self.scroll_id:
+            self.scroll_id = GLib.idle_add(self.scroll_to_end)
+
+        return False
+
+    def trim(self):
+        max_lines = self.profile_settings.get_int("max-lines")
+
+        if max_lines <= 0:
+            return
+
+        buffer = self['view'].get_buffer()
+        extra = buffer.get_line_count() - max_lines
+
+        # Trimming by large steps avoids moving the whole buffer content
+        # each time a line is written
+        if extra < max(max_lines // 10, 1):
+            return
+
+        start = buffer.get_start_iter()
+        end = buffer.get_iter_at_line(extra)
+
+        self.trimmed += end.get_offset()
+        buffer.delete(start, end)
+
+        self.links = [lnk for lnk in self.links if lnk.end > self.trimmed]
+
+    def parse_links(self, offset, text):
+        # The links are found in a thread, then checked and tagged here
+        if self.link_queue is None:
+            self.link_queue = queue.Queue()
+
+            self.link_thread = threading.Thread(target=self.parse_links_thread,
+                                                args=(self.link_queue, ),
+                                                daemon=True)
+            self.link_thread.start()
+
+        self.link_queue.put((self.generation, offset, text))
+
+    def stop_link_parsing(self):
+        if self.link_queue is None:
+            return
+
+        # None tells the thread to stop once the queued output is parsed
+        self.link_queue.put(None)
+        self.link_thread.join()
+
+        self.link_queue = None
+        self.link_thread = None
+
+        # The links parsed but not tagged yet are dropped
+        self.generation += 1
+
+    def deactivate(self):
+        self.stop_link_parsing()
+        self.end_log(False)
+
+        if self.flush_id:
+            GLib.source_remove(self.flush_id)
+            self.flush_id = 0
+
+        if self.scroll_id:
+            GLib.source_remove(self.scroll_id)
+            self.scroll_id = 0
+
+    def on_panel_destroy(self, widget):
+        self.deactivate()
+
+    def parse_links_thread(self, link_queue):
+        while True:
+            item = link_queue.get()
+
+            if item is None:
+                break
+
+            generation, offset, text = item
+            links = self.link_parser.parse(text)
+
+            if links:
+                GLib.idle_add(self.on_links_parsed, generation, offset, links)
+
+    def lookup_file(self, path):
+        if path not in self.lookup_cache:
+            self.lookup_cache[path] = self.file_lookup.lookup(path)
+
+        return self.lookup_cache[path]
+
+    def on_links_parsed(self, generation, offset, links):
+        if generation != self.generation:
+            return False
+
+        buffer = self['view'].get_buffer()
 
-        # find all links and apply the appropriate tag for them
-        links = self.link_parser.parse(text)
         for lnk in links:
-            insert_iter = buffer.get_iter_at_mark(insert)
-            lnk.start = insert_iter.get_offset() + lnk.start
-            lnk.end = insert_iter.get_offset() + lnk.end
+            lnk.start = offset + lnk.start
+            lnk.end = offset + lnk.end
 
-            start_iter = buffer.get_iter_at_offset(lnk.start)
-            end_iter = buffer.get_iter_at_offset(lnk.end)
+            # The line was already removed from the panel
+            if lnk.start < self.trimmed:
+                continue
+
+            start_iter = buffer.get_iter_at_offset(lnk.start - self.trimmed)
+            end_iter = buffer.get_iter_at_offset(lnk.end - self.trimmed)
 
             tag = None
 
             # if the link points to an existing file then it is a valid link
-            if self.file_lookup.lookup(lnk.path) is not None:
+            if self.lookup_file(lnk.path) is not None:
                 self.links.append(lnk)
                 tag = self.link_tag
             else:
@@ -175,8 +395,7 @@ class OutputPanel(UniqueById):
 
             buffer.apply_tag(tag, start_iter, end_iter)
 
-        buffer.delete_mark(insert)
-        GLib.idle_add(self.scroll_to_end)
+        return False
 
     def show(self):
         panel = self.window.get_bottom_panel()
@@ -219,7 +438,7 @@ class OutputPanel(UniqueById):
         (over_text, iter_at_xy) = view.get_iter_at_location(buff_x, buff_y)
         if not over_text:
             return None
-        offset = iter_at_xy.get_offset()
+        offset = iter_at_xy.get_offset() + self.trimmed
 
         # find the first link that contains the offset
         for lnk in self.links:
@@ -0,0 +1,636 @@
+/*
+ * gedit-file-browser-listing-cache.c - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "gedit-file-browser-listing-cache.h"
+
+/* The listing of a directory is saved in the user cache directory, in a
+ * file named after the checksum of its location. It contains the
+ * modification time of the directory at the time it was enumerated, and
+ * for each child its name, whether it is a directory, a hidden file or a
+ * backup file and its content type. The content types are only saved once, in a table at
+ * the beginning of the file.
+ *
+ * The store shows the cached listing at once, and enumerates the directory
+ * again only if its modification time changed.
+ *
+ * The modification time of a listing file is updated each time it is
+ * used. Once per session, the listings not used for MAX_AGE_DAYS are
+ * removed, then the least recently used ones until the listings take at
+ * most MAX_TOTAL_SIZE. The listing of a local directory which no longer
+ * exists is removed when it is loaded.
+ */
+
+#define LISTING_MAGIC "GEDITFBL"
+#define LISTING_VERSION 2
+
+#define ENTRY_FLAG_DIRECTORY	(1 << 0)
+#define ENTRY_FLAG_HIDDEN	(1 << 1)
+#define ENTRY_FLAG_BACKUP	(1 << 2)
+
+#define NO_CONTENT_TYPE G_MAXUINT16
+
+#define MAX_AGE_DAYS	30
+#define MAX_TOTAL_SIZE	(16 * 1024 * 1024)
+
+typedef struct
+{
+	GList   *infos;
+	guint64  mtime;
+	guint32  mtime_usec;
+} Listing;
+
+typedef struct
+{
+	gchar   *path;
+	GString *data;
+} SaveData;
+
+typedef struct
+{
+	gchar  *path;
+	gint64  mtime;
+	gint64  size;
+} CacheFile;
+
+static gchar *
+get_cache_dir (void)
+{
+	return g_build_filename (g_get_user_cache_dir (),
+				 "gedit",
+				 "file-browser-listings",
+				 NULL);
+}
+
+static gchar *
+get_cache_path (GFile *directory)
+{
+	gchar *uri;
+	gchar *checksum;
+	gchar *dirname;
+	gchar *path;
+
+	uri = g_file_get_uri (directory);
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+
+	dirname = get_cache_dir ();
+	path = g_build_filename (dirname, checksum, NULL);
+
+	g_free (dirname);
+	g_free (checksum);
+	g_free (uri);
+
+	return path;
+}
+
+static void
+cache_file_free (CacheFile *file)
+{
+	g_free (file->path);
+	g_slice_free (CacheFile, file);
+}
+
+static gint
+compare_cache_files (gconstpointer a,
+		     gconstpointer b)
+{
+	const CacheFile *file_a = *(const CacheFile **) a;
+	const CacheFile *file_b = *(const CacheFile **) b;
+
+	/* Most recently used first */
+	if (file_a->mtime != file_b->mtime)
+	{
+		return file_a->mtime > file_b->mtime ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/* Removes the listings not used for MAX_AGE_DAYS, and the least recently
+ * used ones beyond MAX_TOTAL_SIZE */
+static void
+prune_cache (void)
+{
+	gchar *dirname;
+	GDir *dir;
+	const gchar *name;
+	GPtrArray *files;
+	gint64 min_mtime;
+	gint64 total_size = 0;
+	guint i;
+
+	dirname = get_cache_dir ();
+	dir = g_dir_open (dirname, 0, NULL);
+
+	if (dir == NULL)
+	{
+		g_free (dirname);
+		return;
+	}
+
+	files = g_ptr_array_new_with_free_func ((GDestroyNotify) cache_file_free);
+	min_mtime = g_get_real_time () / G_USEC_PER_SEC - MAX_AGE_DAYS * 24 * 60 * 60;
+
+	while ((name = g_dir_read_name (dir)) != NULL)
+	{
+		gchar *path = g_build_filename (dirname, name, NULL);
+		GStatBuf buf;
+		CacheFile *file;
+
+		if (g_stat (path, &buf) != 0 || !S_ISREG (buf.st_mode))
+		{
+			g_free (path);
+			continue;
+		}
+
+		if (buf.st_mtime < min_mtime)
+		{
+			g_unlink (path);
+			g_free (path);
+			continue;
+		}
+
+		file = g_slice_new (CacheFile);
+		file->path = path;
+		file->mtime = buf.st_mtime;
+		file->size = buf.st_size;
+		g_ptr_array_add (files, file);
+	}
+
+	g_ptr_array_sort (files, compare_cache_files);
+
+	for (i = 0; i < files->len; i++)
+	{
+		CacheFile *file = g_ptr_array_index (files, i);
+
+		total_size += file->size;
+
+		if (total_size > MAX_TOTAL_SIZE)
+		{
+			g_unlink (file->path);
+		}
+	}
+
+	g_ptr_array_unref (files);
+	g_dir_close (dir);
+	g_free (dirname);
+}
+
+static void
+listing_free (Listing *listing)
+{
+	g_list_free_full (listing->infos, g_object_unref);
+	g_slice_free (Listing, listing);
+}
+
+static gboolean
+read_data (const gchar **p,
+	   const gchar  *end,
+	   gpointer      dest,
+	   gsize         size)
+{
+	if ((gsize) (end - *p) < size)
+	{
+		return FALSE;
+	}
+
+	memcpy (dest, *p, size);
+	*p += size;
+
+	return TRUE;
+}
+
+static gchar *
+read_string (const gchar **p,
+	     const gchar  *end)
+{
+	guint16 length;
+	gchar *str;
+
+	if (!read_data (p, end, &length, sizeof (length)) ||
+	    (gsize) (end - *p) < length)
+	{
+		return NULL;
+	}
+
+	str = g_strndup (*p, length);
+	*p += length;
+
+	return str;
+}
+
+static Listing *
+listing_parse (const gchar *contents,
+	       gsize        length)
+{
+	Listing *listing;
+	const gchar *p = contents;
+	const gchar *end = contents + length;
+	guint32 version;
+	guint32 n_content_types;
+	guint32 n_entries;
+	GPtrArray *content_types = NULL;
+	guint32 i;
+
+	if (length < strlen (LISTING_MAGIC) ||
+	    memcmp (p, LISTING_MAGIC, strlen (LISTING_MAGIC)) != 0)
+	{
+		return NULL;
+	}
+
+	p += strlen (LISTING_MAGIC);
+
+	listing = g_slice_new0 (Listing);
+
+	if (!read_data (&p, end, &version, sizeof (version)) ||
+	    version != LISTING_VERSION ||
+	    !read_data (&p, end, &listing->mtime, sizeof (listing->mtime)) ||
+	    !read_data (&p, end, &listing->mtime_usec, sizeof (listing->mtime_usec)) ||
+	    !read_data (&p, end, &n_content_types, sizeof (n_content_types)) ||
+	    n_content_types > NO_CONTENT_TYPE)
+	{
+		goto error;
+	}
+
+	content_types = g_ptr_array_new_full (n_content_types, g_object_unref);
+
+	/* The icons are looked up once per content type */
+	for (i = 0; i < n_content_types; i++)
+	{
+		gchar *content_type = read_string (&p, end);
+		GFileInfo *info;
+
+		if (content_type == NULL)
+		{
+			goto error;
+		}
+
+		info = g_file_info_new ();
+		g_file_info_set_content_type (info, content_type);
+		g_file_info_take_icon (info, g_content_type_get_icon (content_type));
+		g_ptr_array_add (content_types, info);
+
+		g_free (content_type);
+	}
+
+	if (!read_data (&p, end, &n_entries, sizeof (n_entries)))
+	{
+		goto error;
+	}
+
+	for (i = 0; i < n_entries; i++)
+	{
+		GFileInfo *info;
+		guint8 flags;
+		guint16 content_type;
+		gchar *name;
+
+		if (!read_data (&p, end, &flags, sizeof (flags)) ||
+		    !read_data (&p, end, &content_type, sizeof (content_type)) ||
+		    (content_type != NO_CONTENT_TYPE && content_type >= content_types->len) ||
+		    (name = read_string (&p, end)) == NULL)
+		{
+			goto error;
+		}
+
+		if (content_type != NO_CONTENT_TYPE)
+		{
+			info = g_file_info_dup (g_ptr_array_index (content_types, content_type));
+		}
+		else
+		{
+			info = g_file_info_new ();
+		}
+
+		g_file_info_set_name (info, name);
+		g_file_info_set_file_type (info,
+					   (flags & ENTRY_FLAG_DIRECTORY) ? G_FILE_TYPE_DIRECTORY
+									  : G_FILE_TYPE_REGULAR);
+		g_file_info_set_is_hidden (info, (flags & ENTRY_FLAG_HIDDEN) != 0);
+		g_file_info_set_is_backup (info, (flags & ENTRY_FLAG_BACKUP) != 0);
+
+		listing->infos = g_list_prepend (listing->infos, info);
+
+		g_free (name);
+	}
+
+	listing->infos = g_list_reverse (listing->infos);
+
+	g_ptr_array_unref (content_types);
+	return listing;
+
+error:
+	if (content_types != NULL)
+	{
+		g_ptr_array_unref (content_types);
+	}
+
+	listing_free (listing);
+	return NULL;
+}
+
+static void
+load_thread (GTask        *task,
+	     gpointer      source_object,
+	     gpointer      task_data,
+	     GCancellable *cancellable)
+{
+	GFile *directory = task_data;
+	Listing *listing = NULL;
+	gchar *path;
+	gchar *contents;
+	gsize length;
+
+	path = get_cache_path (directory);
+
+	if (!g_task_return_error_if_cancelled (task))
+	{
+		if (g_file_get_contents (path, &contents, &length, NULL))
+		{
+			listing = listing_parse (contents, length);
+
+			if (listing == NULL)
+			{
+				g_warning ("The file browser listing cache %s is corrupted", path);
+				g_unlink (path);
+			}
+			else if (g_file_is_native (directory) &&
+				 !g_file_query_exists (directory, cancellable))
+			{
+				listing_free (listing);
+				listing = NULL;
+				g_unlink (path);
+			}
+			else
+			{
+				/* Mark the listing as recently used */
+				g_utime (path, NULL);
+			}
+
+			g_free (contents);
+		}
+
+		g_task_return_pointer (task, listing, (GDestroyNotify) listing_free);
+	}
+
+	g_free (path);
+}
+
+/*
+ * gedit_file_browser_listing_cache_load_async:
+ * @directory: a #GFile
+ * @io_priority: the I/O priority of the request
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: the callback to call when the listing is loaded
+ * @user_data: the data to pass to @callback
+ *
+ * Loads the cached listing of @directory in a thread.
+ */
+void
+gedit_file_browser_listing_cache_load_async (GFile               *directory,
+					     gint                 io_priority,
+					     GCancellable        *cancellable,
+					     GAsyncReadyCallback  callback,
+					     gpointer             user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (G_IS_FILE (directory));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	g_task_set_priority (task, io_priority);
+	g_task_set_task_data (task, g_object_ref (directory), g_object_unref);
+
+	g_task_run_in_thread (task, load_thread);
+	g_object_unref (task);
+}
+
+/*
+ * gedit_file_browser_listing_cache_load_finish:
+ * @result: a #GAsyncResult
+ * @infos: (out) (transfer full): the #GFileInfo of the children
+ * @mtime: (out): the modification time of the directory
+ * @mtime_usec: (out): the microseconds of the modification time
+ *
+ * The infos contain the name, the file type, whether the file is hidden or
+ * a backup, the content type and the icon of the children.
+ *
+ * Returns: %TRUE if the directory has a valid cached listing.
+ */
+gboolean
+gedit_file_browser_listing_cache_load_finish (GAsyncResult  *result,
+					      GList        **infos,
+					      guint64       *mtime,
+					      guint32       *mtime_usec)
+{
+	Listing *listing;
+
+	g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+	g_return_val_if_fail (infos != NULL, FALSE);
+
+	listing = g_task_propagate_pointer (G_TASK (result), NULL);
+
+	if (listing == NULL)
+	{
+		return FALSE;
+	}
+
+	*infos = listing->infos;
+	listing->infos = NULL;
+
+	if (mtime != NULL)
+	{
+		*mtime = listing->mtime;
+	}
+
+	if (mtime_usec != NULL)
+	{
+		*mtime_usec = listing->mtime_usec;
+	}
+
+	listing_free (listing);
+	return TRUE;
+}
+
+static void
+save_data_free (SaveData *data)
+{
+	g_free (data->path);
+	g_string_free (data->data, TRUE);
+	g_slice_free (SaveData, data);
+}
+
+static void
+save_thread (GTask        *task,
+	     gpointer      source_object,
+	     gpointer      task_data,
+	     GCancellable *cancellable)
+{
+	static gsize pruned = 0;
+	SaveData *data = task_data;
+	gchar *dirname;
+	GError *error = NULL;
+
+	dirname = g_path_get_dirname (data->path);
+	g_mkdir_with_parents (dirname, 0700);
+
+	if (!g_file_set_contents (data->path, data->data->str, data->data->len, &error))
+	{
+		g_warning ("Could not save the file browser listing cache: %s", error->message);
+		g_error_free (error);
+	}
+
+	if (g_once_init_enter (&pruned))
+	{
+		prune_cache ();
+		g_once_init_leave (&pruned, 1);
+	}
+
+	g_free (dirname);
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+append_string (GString     *data,
+	       const gchar *str)
+{
+	guint16 length = MIN (strlen (str), G_MAXUINT16);
+
+	g_string_append_len (data, (const gchar *) &length, sizeof (length));
+	g_string_append_len (data, str, length);
+}
+
+/*
+ * gedit_file_browser_listing_cache_save:
+ * @directory: a #GFile
+ * @mtime: the modification time of @directory when it was enumerated
+ * @mtime_usec: the microseconds of the modification time
+ * @infos: the #GFileInfo of the children
+ *
+ * Saves the listing of @directory in the background. Only the name, the
+ * file type, whether the file is hidden or a backup and the content type
+ * are saved.
+ */
+void
+gedit_file_browser_listing_cache_save (GFile   *directory,
+				       guint64  mtime,
+				       guint32  mtime_usec,
+				       GList   *infos)
+{
+	SaveData *data;
+	GTask *task;
+	GHashTable *content_types;
+	GPtrArray *content_types_order;
+	GString *entries;
+	guint32 version = LISTING_VERSION;
+	guint32 n_content_types;
+	guint32 n_entries = 0;
+
+	g_return_if_fail (G_IS_FILE (directory));
+
+	content_types = g_hash_table_new (g_str_hash, g_str_equal);
+	content_types_order = g_ptr_array_new ();
+	entries = g_string_new (NULL);
+
+	for (GList *item = infos; item; item = item->next)
+	{
+		GFileInfo *info = G_FILE_INFO (item->data);
+		const gchar *content_type = g_file_info_get_content_type (info);
+		guint16 content_type_index = NO_CONTENT_TYPE;
+		guint8 flags = 0;
+
+		if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+		{
+			flags |= ENTRY_FLAG_DIRECTORY;
+		}
+
+		if (g_file_info_get_is_hidden (info))
+		{
+			flags |= ENTRY_FLAG_HIDDEN;
+		}
+
+		if (g_file_info_get_is_backup (info))
+		{
+			flags |= ENTRY_FLAG_BACKUP;
+		}
+
+		if (content_type != NULL)
+		{
+			gpointer value;
+
+			if (g_hash_table_lookup_extended (content_types, content_type, NULL, &value))
+			{
+				content_type_index = GPOINTER_TO_UINT (value);
+			}
+			else if (content_types_order->len < NO_CONTENT_TYPE)
+			{
+				content_type_index = content_types_order->len;
+				g_hash_table_insert (content_types,
+						     (gpointer) content_type,
+						     GUINT_TO_POINTER (content_type_index));
+				g_ptr_array_add (content_types_order, (gpointer) content_type);
+			}
+		}
+
+		g_string_append_len (entries, (const gchar *) &flags, sizeof (flags));
+		g_string_append_len (entries, (const gchar *) &content_type_index, sizeof (content_type_index));
+		append_string (entries, g_file_info_get_name (info));
+
+		n_entries++;
+	}
+
+	n_content_types = content_types_order->len;
+
+	data = g_slice_new (SaveData);
+	data->path = get_cache_path (directory);
+	data->data = g_string_sized_new (64 + n_content_types * 32 + entries->len);
+
+	g_string_append_len (data->data, LISTING_MAGIC, strlen (LISTING_MAGIC));
+	g_string_append_len (data->data, (const gchar *) &version, sizeof (version));
+	g_string_append_len (data->data, (const gchar *) &mtime, sizeof (mtime));
+	g_string_append_len (data->data, (const gchar *) &mtime_usec, sizeof (mtime_usec));
+	g_string_append_len (data->data, (const gchar *) &n_content_types, sizeof (n_content_types));
+
+	for (guint i = 0; i < content_types_order->len; i++)
+	{
+		append_string (data->data, g_ptr_array_index (content_types_order, i));
+	}
+
+	g_string_append_len (data->data, (const gchar *) &n_entries, sizeof (n_entries));
+	g_string_append_len (data->data, entries->str, entries->len);
+
+	g_hash_table_unref (content_types);
+	g_ptr_array_unref (content_types_order);
+	g_string_free (entries, TRUE);
+
+	task = g_task_new (NULL, NULL, NULL, NULL);
+	g_task_set_priority (task, G_PRIORITY_LOW);
+	g_task_set_task_data (task, data, (GDestroyNotify) save_data_free);
+
+	g_task_run_in_thread (task, save_thread);
+	g_object_unref (task);
+}
+
+/* ex:set ts=8 noet: */
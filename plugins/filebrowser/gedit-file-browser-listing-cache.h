@@ -0,0 +1,46 @@
+/*
+ * gedit-file-browser-listing-cache.h - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_FILE_BROWSER_LISTING_CACHE_H
+#define GEDIT_FILE_BROWSER_LISTING_CACHE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+void		 gedit_file_browser_listing_cache_load_async	(GFile                *directory,
+								 gint                  io_priority,
+								 GCancellable         *cancellable,
+								 GAsyncReadyCallback   callback,
+								 gpointer              user_data);
+gboolean	 gedit_file_browser_listing_cache_load_finish	(GAsyncResult         *result,
+								 GList               **infos,
+								 guint64              *mtime,
+								 guint32              *mtime_usec);
+void		 gedit_file_browser_listing_cache_save		(GFile                *directory,
+								 guint64               mtime,
+								 guint32               mtime_usec,
+								 GList                *infos);
+
+G_END_DECLS
+
+#endif /* GEDIT_FILE_BROWSER_LISTING_CACHE_H */
+
+/* ex:set ts=8 noet: */
@@ -33,6 +33,7 @@ typedef struct
 {
 	GeditWindow  *window;
 	GeditMessage *message;
+	guint         message_id;
 } MessageCacheData;
 
 typedef struct
@@ -159,13 +160,15 @@ message_cache_data_free (MessageCacheData *data)
 }
 
 static MessageCacheData *
-message_cache_data_new (GeditWindow  *window,
-			GeditMessage *message)
+message_cache_data_new (GeditWindow     *window,
+			GeditMessageBus *bus,
+			const gchar     *method)
 {
 	MessageCacheData *data = g_slice_new (MessageCacheData);
 
 	data->window = window;
-	data->message = message;
+	data->message_id = gedit_message_bus_lookup_id (bus, MESSAGE_OBJECT_PATH, method);
+	data->message = gedit_message_bus_acquire_message (bus, data->message_id);
 
 	return data;
 }
@@ -772,16 +775,19 @@ store_row_inserted (GeditFileBrowserStore *store,
 		    GtkTreeIter           *iter,
 		    MessageCacheData      *data)
 {
+	WindowData *wdata = get_window_data (data->window);
 	guint flags = 0;
 
+	/* Nobody would know the id of the tracked row */
+	if (!gedit_message_bus_has_listeners (wdata->bus, data->message_id))
+		return;
+
 	gtk_tree_model_get (GTK_TREE_MODEL (store), iter,
 			    GEDIT_FILE_BROWSER_STORE_COLUMN_FLAGS, &flags,
 			    -1);
 
 	if (!FILE_IS_DUMMY (flags) && !FILE_IS_FILTERED (flags))
 	{
-		WindowData *wdata = get_window_data (data->window);
-
 		set_item_message (wdata, iter, path, data->message);
 		gedit_message_bus_send_message_sync (wdata->bus, data->message);
 	}
@@ -792,9 +798,15 @@ store_before_row_deleted (GeditFileBrowserStore *store,
                           GtkTreePath           *path,
                           MessageCacheData      *data)
 {
+	WindowData *wdata = get_window_data (data->window);
 	GtkTreeIter iter;
 	guint flags = 0;
 
+	/* Without listeners, no row was tracked since the last one left */
+	if (!gedit_message_bus_has_listeners (wdata->bus, data->message_id) &&
+	    g_hash_table_size (wdata->row_tracking) == 0)
+		return;
+
 	if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path))
 		return;
 
@@ -804,7 +816,6 @@ store_before_row_deleted (GeditFileBrowserStore *store,
 
 	if (!FILE_IS_DUMMY (flags) && !FILE_IS_FILTERED (flags))
 	{
-		WindowData *wdata = get_window_data (data->window);
 		gchar *id;
 
 		set_item_message (wdata, &iter, path, data->message);
@@ -827,6 +838,9 @@ store_virtual_root_changed (GeditFileBrowserStore *store,
 	WindowData *wdata = get_window_data (data->window);
 	GFile *vroot;
 
+	if (!gedit_message_bus_has_listeners (wdata->bus, data->message_id))
+		return;
+
 	vroot = gedit_file_browser_store_get_virtual_root (store);
 
 	if (!vroot)
@@ -851,6 +865,9 @@ store_begin_loading (GeditFileBrowserStore *store,
 	GtkTreePath *path;
 	WindowData *wdata = get_window_data (data->window);
 
+	if (!gedit_message_bus_has_listeners (wdata->bus, data->message_id))
+		return;
+
 	path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), iter);
 
 	set_item_message (wdata, iter, path, data->message);
@@ -867,6 +884,9 @@ store_end_loading (GeditFileBrowserStore *store,
 	GtkTreePath *path;
 	WindowData *wdata = get_window_data (data->window);
 
+	if (!gedit_message_bus_has_listeners (wdata->bus, data->message_id))
+		return;
+
 	path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), iter);
 
 	set_item_message (wdata, iter, path, data->message);
@@ -881,8 +901,6 @@ register_signals (GeditWindow            *window,
 {
 	GeditMessageBus *bus = gedit_window_get_message_bus (window);
 	GeditFileBrowserStore *store;
-
-	GeditMessage *message;
 	WindowData *data;
 
 	/* Register signals */
@@ -913,70 +931,45 @@ register_signals (GeditWindow            *window,
 
 	store = gedit_file_browser_widget_get_browser_store (widget);
 
-	message = g_object_new (GEDIT_TYPE_FILE_BROWSER_MESSAGE_ID_LOCATION,
-	                        "object-path", MESSAGE_OBJECT_PATH,
-	                        "method", "inserted",
-	                        NULL);
-
 	data = get_window_data (window);
 
 	data->row_inserted_id =
 		g_signal_connect_data (store,
 		                       "row-inserted",
 		                       G_CALLBACK (store_row_inserted),
-		                       message_cache_data_new (window, message),
+		                       message_cache_data_new (window, bus, "inserted"),
 		                       (GClosureNotify)message_cache_data_free,
 		                       0);
 
-	message = g_object_new (GEDIT_TYPE_FILE_BROWSER_MESSAGE_ID_LOCATION,
-	                        "object-path", MESSAGE_OBJECT_PATH,
-	                        "method", "deleted",
-	                        NULL);
-
 	data->before_row_deleted_id =
 		g_signal_connect_data (store,
 		                       "before-row-deleted",
 		                       G_CALLBACK (store_before_row_deleted),
-		                       message_cache_data_new (window, message),
+		                       message_cache_data_new (window, bus, "deleted"),
 		                       (GClosureNotify)message_cache_data_free,
 		                       0);
 
-	message = g_object_new (GEDIT_TYPE_FILE_BROWSER_MESSAGE_ID_LOCATION,
-	                        "object-path", MESSAGE_OBJECT_PATH,
-	                        "method", "root_changed",
-	                        NULL);
-
 	data->root_changed_id =
 		g_signal_connect_data (store,
 		                       "notify::virtual-root",
 		                       G_CALLBACK (store_virtual_root_changed),
-		                       message_cache_data_new (window, message),
+		                       message_cache_data_new (window, bus, "root_changed"),
 		                       (GClosureNotify)message_cache_data_free,
 		                       0);
 
-	message = g_object_new (GEDIT_TYPE_FILE_BROWSER_MESSAGE_ID_LOCATION,
-	                        "object-path", MESSAGE_OBJECT_PATH,
-	                        "method", "begin_loading",
-	                        NULL);
-
 	data->begin_loading_id =
 		g_signal_connect_data (store,
 		                       "begin_loading",
 		                       G_CALLBACK (store_begin_loading),
-		                       message_cache_data_new (window, message),
+		                       message_cache_data_new (window, bus, "begin_loading"),
 		                       (GClosureNotify)message_cache_data_free,
 		                       0);
 
-	message = g_object_new (GEDIT_TYPE_FILE_BROWSER_MESSAGE_ID_LOCATION,
-	                        "object-path", MESSAGE_OBJECT_PATH,
-	                        "method", "end_loading",
-	                        NULL);
-
 	data->end_loading_id =
 		g_signal_connect_data (store,
 		                       "end_loading",
 		                       G_CALLBACK (store_end_loading),
-		                       message_cache_data_new (window, message),
+		                       message_cache_data_new (window, bus, "end_loading"),
 		                       (GClosureNotify)message_cache_data_free,
 		                       0);
 }
@@ -36,6 +36,7 @@
 #include "gedit-file-browser-error.h"
 #include "gedit-file-browser-widget.h"
 #include "gedit-file-browser-messages.h"
+#include "gedit-file-browser-search-panel.h"
 
 #define FILEBROWSER_BASE_SETTINGS	"org.gnome.gedit.plugins.filebrowser"
 #define FILEBROWSER_TREE_VIEW		"tree-view"
@@ -46,6 +47,9 @@
 #define FILEBROWSER_FILTER_MODE		"filter-mode"
 #define FILEBROWSER_FILTER_PATTERN	"filter-pattern"
 #define FILEBROWSER_BINARY_PATTERNS	"binary-patterns"
+#define FILEBROWSER_SEARCH_INDEX	"search-index"
+#define FILEBROWSER_LISTING_CACHE	"listing-cache"
+#define FILEBROWSER_PAUSE_BUSY_DIRECTORIES	"pause-busy-directories"
 
 #define NAUTILUS_BASE_SETTINGS		"org.gnome.nautilus.preferences"
 #define NAUTILUS_FALLBACK_SETTINGS	"org.gnome.gedit.plugins.filebrowser.nautilus"
@@ -67,6 +71,9 @@ struct _GeditFileBrowserPluginPrivate
 	gulong                  end_loading_handle;
 
 	guint			click_policy_handle;
+
+	GtkWidget                   *search_panel;
+	GeditFileBrowserSearchIndex *search_index;
 };
 
 enum
@@ -118,6 +125,7 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditFileBrowserPlugin,
 				_gedit_file_browser_store_register_type		(type_module);		\
 				_gedit_file_browser_view_register_type		(type_module);		\
 				_gedit_file_browser_widget_register_type	(type_module);		\
+				_gedit_file_browser_search_panel_register_type	(type_module);		\
 )
 
 static GSettings *
@@ -164,6 +172,7 @@ gedit_file_browser_plugin_dispose (GObject *object)
 	g_clear_object (&plugin->priv->nautilus_settings);
 	g_clear_object (&plugin->priv->terminal_settings);
 	g_clear_object (&plugin->priv->window);
+	g_clear_pointer (&plugin->priv->search_index, gedit_file_browser_search_index_unref);
 
 	G_OBJECT_CLASS (gedit_file_browser_plugin_parent_class)->dispose (object);
 }
@@ -433,6 +442,68 @@ open_in_terminal (GeditFileBrowserWidget *widget,
 	}
 }
 
+static void
+find_in_files (GeditFileBrowserWidget *widget,
+               GFile                  *location,
+               GeditFileBrowserPlugin *plugin)
+{
+	GeditFileBrowserPluginPrivate *priv = plugin->priv;
+	GeditFileBrowserStore *store;
+	GtkWidget *panel;
+
+	if (g_settings_get_boolean (priv->settings, FILEBROWSER_SEARCH_INDEX))
+	{
+		if (priv->search_index == NULL ||
+		    !g_file_equal (gedit_file_browser_search_index_get_root (priv->search_index), location))
+		{
+			g_clear_pointer (&priv->search_index, gedit_file_browser_search_index_unref);
+			priv->search_index = gedit_file_browser_search_index_new (location);
+		}
+	}
+	else
+	{
+		g_clear_pointer (&priv->search_index, gedit_file_browser_search_index_unref);
+	}
+
+	store = gedit_file_browser_widget_get_browser_store (widget);
+
+	gedit_file_browser_search_panel_set_root (GEDIT_FILE_BROWSER_SEARCH_PANEL (priv->search_panel),
+	                                          location,
+	                                          gedit_file_browser_store_get_binary_patterns (store),
+	                                          priv->search_index);
+
+	panel = gedit_window_get_bottom_panel (priv->window);
+	gtk_stack_set_visible_child (GTK_STACK (panel), priv->search_panel);
+	gtk_widget_show (panel);
+
+	gtk_widget_grab_focus (priv->search_panel);
+}
+
+static void
+on_search_location_activated_cb (GeditFileBrowserSearchPanel *search_panel,
+                                 GFile                       *location,
+                                 gint                         line,
+                                 GeditWindow                 *window)
+{
+	gedit_commands_load_location (window, location, NULL, line + 1, 0);
+}
+
+static void
+on_file_changed_cb (GeditFileBrowserStore  *store,
+                    GFile                  *file,
+                    GFile                  *other_file,
+                    GFileMonitorEvent       event_type,
+                    GeditFileBrowserPlugin *plugin)
+{
+	if (plugin->priv->search_index != NULL)
+	{
+		gedit_file_browser_search_index_file_changed (plugin->priv->search_index,
+		                                              file,
+		                                              other_file,
+		                                              event_type);
+	}
+}
+
 static void
 gedit_file_browser_plugin_update_state (GeditWindowActivatable *activatable)
 {
@@ -483,6 +554,11 @@ gedit_file_browser_plugin_activate (GeditWindowActivatable *activatable)
 	                  G_CALLBACK (set_active_root),
 	                  plugin);
 
+	g_signal_connect (priv->tree_widget,
+	                  "find-in-files",
+	                  G_CALLBACK (find_in_files),
+	                  plugin);
+
 	g_settings_bind (priv->settings,
 	                 FILEBROWSER_FILTER_PATTERN,
 	                 priv->tree_widget,
@@ -498,6 +574,22 @@ gedit_file_browser_plugin_activate (GeditWindowActivatable *activatable)
 
 	gtk_widget_show (GTK_WIDGET (priv->tree_widget));
 
+	priv->search_panel = gedit_file_browser_search_panel_new ();
+
+	g_signal_connect (priv->search_panel,
+	                  "location-activated",
+	                  G_CALLBACK (on_search_location_activated_cb),
+	                  priv->window);
+
+	panel = gedit_window_get_bottom_panel (priv->window);
+
+	gtk_stack_add_titled (GTK_STACK (panel),
+	                      priv->search_panel,
+	                      "GeditFileBrowserSearchPanel",
+	                      _("Find in Files"));
+
+	gtk_widget_show (priv->search_panel);
+
 	/* Install nautilus preferences */
 	install_nautilus_prefs (plugin);
 
@@ -521,6 +613,18 @@ gedit_file_browser_plugin_activate (GeditWindowActivatable *activatable)
 	                 FILEBROWSER_BINARY_PATTERNS,
 	                 G_SETTINGS_BIND_GET | G_SETTINGS_BIND_SET);
 
+	g_settings_bind (priv->settings,
+	                 FILEBROWSER_LISTING_CACHE,
+	                 store,
+	                 FILEBROWSER_LISTING_CACHE,
+	                 G_SETTINGS_BIND_GET);
+
+	g_settings_bind (priv->settings,
+	                 FILEBROWSER_PAUSE_BUSY_DIRECTORIES,
+	                 store,
+	                 FILEBROWSER_PAUSE_BUSY_DIRECTORIES,
+	                 G_SETTINGS_BIND_GET);
+
 	g_signal_connect (store,
 	                  "notify::virtual-root",
 	                  G_CALLBACK (on_virtual_root_changed_cb),
@@ -531,6 +635,11 @@ gedit_file_browser_plugin_activate (GeditWindowActivatable *activatable)
 			  G_CALLBACK (on_rename_cb),
 			  priv->window);
 
+	g_signal_connect (store,
+	                  "file-changed",
+	                  G_CALLBACK (on_file_changed_cb),
+	                  plugin);
+
 	g_signal_connect (priv->window,
 	                  "tab-added",
 	                  G_CALLBACK (on_tab_added_cb),
@@ -566,6 +675,14 @@ gedit_file_browser_plugin_deactivate (GeditWindowActivatable *activatable)
 
 	panel = gedit_window_get_side_panel (priv->window);
 	gtk_container_remove (GTK_CONTAINER (panel), GTK_WIDGET (priv->tree_widget));
+
+	gedit_file_browser_search_panel_cancel (GEDIT_FILE_BROWSER_SEARCH_PANEL (priv->search_panel));
+
+	panel = gedit_window_get_bottom_panel (priv->window);
+	gtk_container_remove (GTK_CONTAINER (panel), priv->search_panel);
+	priv->search_panel = NULL;
+
+	g_clear_pointer (&priv->search_index, gedit_file_browser_search_index_unref);
 }
 
 static void
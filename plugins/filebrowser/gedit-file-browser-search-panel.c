@@ -0,0 +1,404 @@
+/*
+ * gedit-file-browser-search-panel.c - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib/gi18n-lib.h>
+
+#include "gedit-file-browser-search-panel.h"
+#include "gedit-file-browser-utils.h"
+
+struct _GeditFileBrowserSearchPanelPrivate
+{
+	GtkWidget    *search_entry;
+	GtkWidget    *match_case_checkbutton;
+	GtkWidget    *status_label;
+	GtkWidget    *treeview;
+	GtkListStore *store;
+
+	GFile                       *root;
+	gchar                      **binary_patterns;
+	GeditFileBrowserSearchIndex *index;
+
+	GCancellable *cancellable;
+};
+
+/* Signals */
+enum
+{
+	LOCATION_ACTIVATED,
+	NUM_SIGNALS
+};
+
+enum
+{
+	COLUMN_LOCATION,
+	COLUMN_NAME,
+	COLUMN_TEXT,
+	COLUMN_LINE,
+	N_COLUMNS
+};
+
+static guint signals[NUM_SIGNALS] = { 0 };
+
+G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditFileBrowserSearchPanel,
+				gedit_file_browser_search_panel,
+				GTK_TYPE_BOX,
+				0,
+				G_ADD_PRIVATE_DYNAMIC (GeditFileBrowserSearchPanel))
+
+static void
+cancel_search (GeditFileBrowserSearchPanel *panel)
+{
+	if (panel->priv->cancellable != NULL)
+	{
+		g_cancellable_cancel (panel->priv->cancellable);
+		g_clear_object (&panel->priv->cancellable);
+	}
+}
+
+static void
+gedit_file_browser_search_panel_dispose (GObject *object)
+{
+	GeditFileBrowserSearchPanel *panel = GEDIT_FILE_BROWSER_SEARCH_PANEL (object);
+
+	cancel_search (panel);
+
+	g_clear_object (&panel->priv->store);
+	g_clear_object (&panel->priv->root);
+	g_clear_pointer (&panel->priv->binary_patterns, g_strfreev);
+	g_clear_pointer (&panel->priv->index, gedit_file_browser_search_index_unref);
+
+	G_OBJECT_CLASS (gedit_file_browser_search_panel_parent_class)->dispose (object);
+}
+
+static void
+gedit_file_browser_search_panel_grab_focus (GtkWidget *widget)
+{
+	GeditFileBrowserSearchPanel *panel = GEDIT_FILE_BROWSER_SEARCH_PANEL (widget);
+
+	gtk_widget_grab_focus (panel->priv->search_entry);
+}
+
+static void
+gedit_file_browser_search_panel_class_init (GeditFileBrowserSearchPanelClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+	object_class->dispose = gedit_file_browser_search_panel_dispose;
+
+	widget_class->grab_focus = gedit_file_browser_search_panel_grab_focus;
+
+	signals[LOCATION_ACTIVATED] =
+	    g_signal_new ("location-activated",
+			  G_OBJECT_CLASS_TYPE (object_class),
+			  G_SIGNAL_RUN_LAST,
+			  G_STRUCT_OFFSET (GeditFileBrowserSearchPanelClass, location_activated),
+			  NULL, NULL, NULL,
+			  G_TYPE_NONE, 2, G_TYPE_FILE, G_TYPE_INT);
+}
+
+static void
+gedit_file_browser_search_panel_class_finalize (GeditFileBrowserSearchPanelClass *klass)
+{
+}
+
+static void
+hits_cb (const GeditFileBrowserSearchHit *hits,
+	 guint                            n_hits,
+	 gpointer                         user_data)
+{
+	GeditFileBrowserSearchPanel *panel = GEDIT_FILE_BROWSER_SEARCH_PANEL (user_data);
+	gchar *path;
+	guint i;
+
+	path = g_file_get_relative_path (panel->priv->root, hits[0].location);
+
+	if (path == NULL)
+	{
+		path = gedit_file_browser_utils_file_basename (hits[0].location);
+	}
+
+	for (i = 0; i < n_hits; i++)
+	{
+		gchar *name;
+
+		name = g_strdup_printf ("%s:%d", path, hits[i].line + 1);
+
+		gtk_list_store_insert_with_values (panel->priv->store, NULL, -1,
+						   COLUMN_LOCATION, hits[i].location,
+						   COLUMN_NAME, name,
+						   COLUMN_TEXT, hits[i].line_text,
+						   COLUMN_LINE, hits[i].line,
+						   -1);
+
+		g_free (name);
+	}
+
+	g_free (path);
+}
+
+static void
+search_ready_cb (GObject      *source_object,
+		 GAsyncResult *result,
+		 gpointer      user_data)
+{
+	GeditFileBrowserSearchPanel *panel = GEDIT_FILE_BROWSER_SEARCH_PANEL (user_data);
+	GError *error = NULL;
+	guint n_hits;
+
+	n_hits = gedit_file_browser_search_finish (result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		/* Another search has been started. */
+		g_error_free (error);
+	}
+	else if (error != NULL)
+	{
+		gtk_label_set_text (GTK_LABEL (panel->priv->status_label), error->message);
+		g_error_free (error);
+	}
+	else
+	{
+		gchar *text;
+
+		if (n_hits == 0)
+		{
+			text = g_strdup (_("No matches"));
+		}
+		else
+		{
+			text = g_strdup_printf (ngettext ("%u match", "%u matches", n_hits), n_hits);
+		}
+
+		gtk_label_set_text (GTK_LABEL (panel->priv->status_label), text);
+		g_free (text);
+
+		g_clear_object (&panel->priv->cancellable);
+	}
+
+	g_object_unref (panel);
+}
+
+static void
+start_search (GeditFileBrowserSearchPanel *panel)
+{
+	GeditFileBrowserSearchPanelPrivate *priv = panel->priv;
+	const gchar *text;
+
+	cancel_search (panel);
+	gtk_list_store_clear (priv->store);
+
+	text = gtk_entry_get_text (GTK_ENTRY (priv->search_entry));
+
+	if (text[0] == '\0' || priv->root == NULL)
+	{
+		gtk_label_set_text (GTK_LABEL (priv->status_label), "");
+		return;
+	}
+
+	gtk_label_set_text (GTK_LABEL (priv->status_label), _("Searching…"));
+
+	priv->cancellable = g_cancellable_new ();
+
+	gedit_file_browser_search_async (priv->root,
+					 text,
+					 gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->match_case_checkbutton)),
+					 (const gchar * const *) priv->binary_patterns,
+					 priv->index,
+					 priv->cancellable,
+					 hits_cb,
+					 panel,
+					 search_ready_cb,
+					 g_object_ref (panel));
+}
+
+static void
+on_row_activated (GtkTreeView                 *treeview,
+		  GtkTreePath                 *path,
+		  GtkTreeViewColumn           *column,
+		  GeditFileBrowserSearchPanel *panel)
+{
+	GtkTreeIter iter;
+	GFile *location;
+	gint line;
+
+	if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (panel->priv->store), &iter, path))
+		return;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (panel->priv->store), &iter,
+			    COLUMN_LOCATION, &location,
+			    COLUMN_LINE, &line,
+			    -1);
+
+	g_signal_emit (panel, signals[LOCATION_ACTIVATED], 0, location, line);
+
+	g_object_unref (location);
+}
+
+static void
+gedit_file_browser_search_panel_init (GeditFileBrowserSearchPanel *panel)
+{
+	GeditFileBrowserSearchPanelPrivate *priv;
+	GtkWidget *hbox;
+	GtkWidget *scrolled_window;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	panel->priv = gedit_file_browser_search_panel_get_instance_private (panel);
+	priv = panel->priv;
+
+	gtk_orientable_set_orientation (GTK_ORIENTABLE (panel), GTK_ORIENTATION_VERTICAL);
+	gtk_box_set_spacing (GTK_BOX (panel), 6);
+	gtk_container_set_border_width (GTK_CONTAINER (panel), 6);
+
+	priv->store = gtk_list_store_new (N_COLUMNS,
+					  G_TYPE_FILE,
+					  G_TYPE_STRING,
+					  G_TYPE_STRING,
+					  G_TYPE_INT);
+
+	hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
+	gtk_box_pack_start (GTK_BOX (panel), hbox, FALSE, FALSE, 0);
+
+	priv->search_entry = gtk_search_entry_new ();
+	gtk_entry_set_placeholder_text (GTK_ENTRY (priv->search_entry), _("Find in files"));
+	gtk_entry_set_width_chars (GTK_ENTRY (priv->search_entry), 30);
+	gtk_box_pack_start (GTK_BOX (hbox), priv->search_entry, FALSE, FALSE, 0);
+
+	priv->match_case_checkbutton = gtk_check_button_new_with_mnemonic (_("_Match case"));
+	gtk_box_pack_start (GTK_BOX (hbox), priv->match_case_checkbutton, FALSE, FALSE, 0);
+
+	priv->status_label = gtk_label_new (NULL);
+	gtk_label_set_ellipsize (GTK_LABEL (priv->status_label), PANGO_ELLIPSIZE_START);
+	gtk_widget_set_halign (priv->status_label, GTK_ALIGN_END);
+	gtk_box_pack_end (GTK_BOX (hbox), priv->status_label, TRUE, TRUE, 0);
+
+	scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scrolled_window), GTK_SHADOW_IN);
+	gtk_box_pack_start (GTK_BOX (panel), scrolled_window, TRUE, TRUE, 0);
+
+	priv->treeview = gtk_tree_view_new_with_model (GTK_TREE_MODEL (priv->store));
+	gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (priv->treeview), FALSE);
+	gtk_tree_view_set_enable_search (GTK_TREE_VIEW (priv->treeview), FALSE);
+	gtk_container_add (GTK_CONTAINER (scrolled_window), priv->treeview);
+
+	renderer = gtk_cell_renderer_text_new ();
+	column = gtk_tree_view_column_new_with_attributes (_("File"), renderer,
+							   "text", COLUMN_NAME,
+							   NULL);
+	gtk_tree_view_append_column (GTK_TREE_VIEW (priv->treeview), column);
+
+	renderer = gtk_cell_renderer_text_new ();
+	g_object_set (renderer,
+		      "family", "Monospace",
+		      "ellipsize", PANGO_ELLIPSIZE_END,
+		      NULL);
+	column = gtk_tree_view_column_new_with_attributes (_("Text"), renderer,
+							   "text", COLUMN_TEXT,
+							   NULL);
+	gtk_tree_view_column_set_expand (column, TRUE);
+	gtk_tree_view_append_column (GTK_TREE_VIEW (priv->treeview), column);
+
+	/* Reading the files is expensive, only search on Enter. */
+	g_signal_connect_swapped (priv->search_entry,
+				  "activate",
+				  G_CALLBACK (start_search),
+				  panel);
+	g_signal_connect_swapped (priv->match_case_checkbutton,
+				  "toggled",
+				  G_CALLBACK (start_search),
+				  panel);
+	g_signal_connect (priv->treeview,
+			  "row-activated",
+			  G_CALLBACK (on_row_activated),
+			  panel);
+
+	gtk_widget_show_all (hbox);
+	gtk_widget_show_all (scrolled_window);
+}
+
+GtkWidget *
+gedit_file_browser_search_panel_new (void)
+{
+	return g_object_new (GEDIT_TYPE_FILE_BROWSER_SEARCH_PANEL, NULL);
+}
+
+/**
+ * gedit_file_browser_search_panel_set_root:
+ * @panel: a #GeditFileBrowserSearchPanel.
+ * @root: the directory to search.
+ * @binary_patterns: (nullable): the patterns of the file names to skip.
+ * @index: (nullable): a #GeditFileBrowserSearchIndex for @root.
+ *
+ * Sets where the next searches take place. A search in progress in another
+ * directory is cancelled.
+ */
+void
+gedit_file_browser_search_panel_set_root (GeditFileBrowserSearchPanel *panel,
+					  GFile                       *root,
+					  const gchar * const         *binary_patterns,
+					  GeditFileBrowserSearchIndex *index)
+{
+	GeditFileBrowserSearchPanelPrivate *priv;
+
+	g_return_if_fail (GEDIT_IS_FILE_BROWSER_SEARCH_PANEL (panel));
+	g_return_if_fail (G_IS_FILE (root));
+
+	priv = panel->priv;
+
+	if (priv->root == NULL || !g_file_equal (priv->root, root))
+	{
+		cancel_search (panel);
+		gtk_list_store_clear (priv->store);
+		gtk_label_set_text (GTK_LABEL (priv->status_label), "");
+
+		g_set_object (&priv->root, root);
+	}
+
+	g_strfreev (priv->binary_patterns);
+	priv->binary_patterns = g_strdupv ((gchar **) binary_patterns);
+
+	if (index != NULL)
+	{
+		gedit_file_browser_search_index_ref (index);
+	}
+
+	g_clear_pointer (&priv->index, gedit_file_browser_search_index_unref);
+	priv->index = index;
+}
+
+void
+gedit_file_browser_search_panel_cancel (GeditFileBrowserSearchPanel *panel)
+{
+	g_return_if_fail (GEDIT_IS_FILE_BROWSER_SEARCH_PANEL (panel));
+
+	cancel_search (panel);
+}
+
+void
+_gedit_file_browser_search_panel_register_type (GTypeModule *type_module)
+{
+	gedit_file_browser_search_panel_register_type (type_module);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,70 @@
+/*
+ * gedit-file-browser-search-panel.h - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_FILE_BROWSER_SEARCH_PANEL_H
+#define GEDIT_FILE_BROWSER_SEARCH_PANEL_H
+
+#include <gtk/gtk.h>
+#include "gedit-file-browser-search.h"
+
+G_BEGIN_DECLS
+#define GEDIT_TYPE_FILE_BROWSER_SEARCH_PANEL		(gedit_file_browser_search_panel_get_type ())
+#define GEDIT_FILE_BROWSER_SEARCH_PANEL(obj)		(G_TYPE_CHECK_INSTANCE_CAST ((obj), GEDIT_TYPE_FILE_BROWSER_SEARCH_PANEL, GeditFileBrowserSearchPanel))
+#define GEDIT_FILE_BROWSER_SEARCH_PANEL_CLASS(klass)	(G_TYPE_CHECK_CLASS_CAST ((klass), GEDIT_TYPE_FILE_BROWSER_SEARCH_PANEL, GeditFileBrowserSearchPanelClass))
+#define GEDIT_IS_FILE_BROWSER_SEARCH_PANEL(obj)		(G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEDIT_TYPE_FILE_BROWSER_SEARCH_PANEL))
+#define GEDIT_IS_FILE_BROWSER_SEARCH_PANEL_CLASS(klass)	(G_TYPE_CHECK_CLASS_TYPE ((klass), GEDIT_TYPE_FILE_BROWSER_SEARCH_PANEL))
+#define GEDIT_FILE_BROWSER_SEARCH_PANEL_GET_CLASS(obj)	(G_TYPE_INSTANCE_GET_CLASS ((obj), GEDIT_TYPE_FILE_BROWSER_SEARCH_PANEL, GeditFileBrowserSearchPanelClass))
+
+typedef struct _GeditFileBrowserSearchPanel        GeditFileBrowserSearchPanel;
+typedef struct _GeditFileBrowserSearchPanelClass   GeditFileBrowserSearchPanelClass;
+typedef struct _GeditFileBrowserSearchPanelPrivate GeditFileBrowserSearchPanelPrivate;
+
+struct _GeditFileBrowserSearchPanel
+{
+	GtkBox parent;
+
+	GeditFileBrowserSearchPanelPrivate *priv;
+};
+
+struct _GeditFileBrowserSearchPanelClass
+{
+	GtkBoxClass parent_class;
+
+	/* Signals */
+	void (* location_activated)	(GeditFileBrowserSearchPanel *panel,
+					 GFile                       *location,
+					 gint                         line);
+};
+
+GType		 gedit_file_browser_search_panel_get_type	(void) G_GNUC_CONST;
+
+GtkWidget	*gedit_file_browser_search_panel_new		(void);
+void		 gedit_file_browser_search_panel_set_root	(GeditFileBrowserSearchPanel *panel,
+								 GFile                       *root,
+								 const gchar * const         *binary_patterns,
+								 GeditFileBrowserSearchIndex *index);
+void		 gedit_file_browser_search_panel_cancel		(GeditFileBrowserSearchPanel *panel);
+
+void		 _gedit_file_browser_search_panel_register_type	(GTypeModule                 *type_module);
+
+G_END_DECLS
+#endif /* GEDIT_FILE_BROWSER_SEARCH_PANEL_H */
+
+/* ex:set ts=8 noet: */
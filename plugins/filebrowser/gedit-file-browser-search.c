@@ -0,0 +1,1405 @@
+/*
+ * gedit-file-browser-search.c - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "gedit-file-browser-search.h"
+#include "gedit-file-browser-utils.h"
+
+/* The directories are walked and the files are searched in a thread pool.
+ * The files are filtered like in the file browser: hidden and backup files,
+ * non-text content types and the binary patterns are skipped.
+ *
+ * The index keeps, for each text file, a bitmap of the hashed trigrams of
+ * its content (with the ASCII letters lowercased). A file can only contain
+ * the searched text if all the trigrams of the text are in its bitmap, so
+ * most of the files don't need to be read again. The bitmaps are a lossy
+ * set: they only give false positives, and the candidate files are always
+ * searched for real.
+ *
+ * The index is saved in the user cache directory and is kept up to date
+ * from the GFileMonitor events of the file browser store. Since the store
+ * only monitors the expanded directories, the tree is walked again from
+ * time to time; the walk only stats the files whose size and modification
+ * time didn't change.
+ */
+
+#define SEARCH_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+			  G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+			  G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
+			  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+			  G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE "," \
+			  G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+			  G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+			  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+/* Bigger files are neither searched nor indexed. */
+#define MAX_FILE_SIZE (8 * 1024 * 1024)
+
+/* The beginning of a file checked for NUL bytes, to detect binary files. */
+#define BINARY_CHECK_SIZE 8192
+
+#define MAX_HITS_PER_FILE 1000
+#define MAX_LINE_TEXT_BYTES 256
+
+#define REVALIDATE_INTERVAL (2 * 60 * G_USEC_PER_SEC)
+
+#define INDEX_MAGIC "GEDITFBI"
+#define INDEX_VERSION 2
+
+/* About 2 bits per 8 bytes of text, from 32 bytes to 4 KiB per file. */
+#define MIN_LOG2_BITS 8
+#define MAX_LOG2_BITS 15
+
+typedef struct
+{
+	/* In microseconds. */
+	gint64  mtime;
+	gint64  size;
+	guint   generation;
+	guint8  log2_bits;
+	guint   binary : 1;
+	guint8 *bits;
+} IndexEntry;
+
+struct _GeditFileBrowserSearchIndex
+{
+	gint ref_count;
+
+	GFile *root;
+	gchar *cache_path;
+
+	GMutex mutex;
+
+	/* The fields below are protected by the mutex. */
+
+	/* Path relative to the root -> IndexEntry. */
+	GHashTable *entries;
+
+	/* Relative paths reported by the file monitors since the last
+	 * search.
+	 */
+	GHashTable *dirty;
+
+	/* The dirty paths taken by the current search. They stay dirty until
+	 * their entry is written back, and go back to @dirty if the search
+	 * doesn't get to them.
+	 */
+	GHashTable *reindexing;
+
+	/* When the whole tree was last walked, 0 if never. */
+	gint64 validated_time;
+
+	guint generation;
+	guint loaded : 1;
+	guint modified : 1;
+};
+
+typedef enum
+{
+	ITEM_DIRECTORY,
+	ITEM_FILE,
+
+	/* To query: a changed file or a candidate from the index. */
+	ITEM_UNKNOWN
+} ItemKind;
+
+typedef struct
+{
+	ItemKind kind;
+	GFile *file;
+	gint64 mtime;
+	gint64 size;
+	guint force_index : 1;
+} WorkItem;
+
+typedef struct
+{
+	gint ref_count;
+
+	GFile *root;
+	GRegex *regex;
+	GArray *trigrams;
+	GPtrArray *binary_pattern_specs;
+	GeditFileBrowserSearchIndex *index;
+	guint generation;
+
+	GCancellable *cancellable;
+	GMainContext *context;
+	GeditFileBrowserSearchHitsFunc hits_func;
+	gpointer hits_func_data;
+
+	GThreadPool *pool;
+	GMutex mutex;
+	GCond cond;
+	guint n_pending_items;
+
+	gint n_hits;
+} Search;
+
+typedef struct
+{
+	Search *search;
+	GArray *hits;
+} Batch;
+
+static void process_item (gpointer data,
+			  gpointer user_data);
+
+static inline guint32
+get_trigram (const guchar *p)
+{
+	return ((guint32) (guchar) g_ascii_tolower (p[0]) << 16) |
+	       ((guint32) (guchar) g_ascii_tolower (p[1]) << 8) |
+	       (guint32) (guchar) g_ascii_tolower (p[2]);
+}
+
+static inline guint32
+hash_trigram (guint32 trigram,
+	      guint8  log2_bits)
+{
+	return (trigram * 2654435761u) >> (32 - log2_bits);
+}
+
+static void
+index_entry_free (IndexEntry *entry)
+{
+	g_free (entry->bits);
+	g_slice_free (IndexEntry, entry);
+}
+
+static void
+index_entry_set_contents (IndexEntry  *entry,
+			  const gchar *contents,
+			  gsize        length)
+{
+	const guchar *text = (const guchar *) contents;
+	gsize i;
+
+	g_clear_pointer (&entry->bits, g_free);
+	entry->log2_bits = 0;
+
+	if (entry->binary)
+	{
+		return;
+	}
+
+	entry->log2_bits = CLAMP (g_bit_storage (length / 4), MIN_LOG2_BITS, MAX_LOG2_BITS);
+	entry->bits = g_malloc0 ((1 << entry->log2_bits) / 8);
+
+	for (i = 0; i + 2 < length; i++)
+	{
+		guint32 hash;
+
+		/* A line never matches across a newline. */
+		if (text[i] == '\n' || text[i + 1] == '\n' || text[i + 2] == '\n')
+		{
+			continue;
+		}
+
+		hash = hash_trigram (get_trigram (text + i), entry->log2_bits);
+		entry->bits[hash >> 3] |= 1 << (hash & 7);
+	}
+}
+
+static gboolean
+index_entry_may_match (IndexEntry *entry,
+		       GArray     *trigrams)
+{
+	guint i;
+
+	if (entry->binary)
+	{
+		return FALSE;
+	}
+
+	for (i = 0; i < trigrams->len; i++)
+	{
+		guint32 hash = hash_trigram (g_array_index (trigrams, guint32, i), entry->log2_bits);
+
+		if ((entry->bits[hash >> 3] & (1 << (hash & 7))) == 0)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * gedit_file_browser_search_index_new:
+ * @root: the directory to index.
+ *
+ * Creates an index of the text files below @root. The index is loaded from
+ * the user cache directory, if it was saved by a previous search, and is
+ * updated by the searches.
+ *
+ * Returns: (transfer full): a new #GeditFileBrowserSearchIndex.
+ */
+GeditFileBrowserSearchIndex *
+gedit_file_browser_search_index_new (GFile *root)
+{
+	GeditFileBrowserSearchIndex *index;
+	gchar *uri;
+	gchar *checksum;
+
+	g_return_val_if_fail (G_IS_FILE (root), NULL);
+
+	index = g_slice_new0 (GeditFileBrowserSearchIndex);
+	index->ref_count = 1;
+	index->root = g_object_ref (root);
+	g_mutex_init (&index->mutex);
+
+	index->entries = g_hash_table_new_full (g_str_hash,
+						g_str_equal,
+						g_free,
+						(GDestroyNotify) index_entry_free);
+	index->dirty = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	index->reindexing = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	uri = g_file_get_uri (root);
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+
+	index->cache_path = g_build_filename (g_get_user_cache_dir (),
+					      "gedit",
+					      "file-browser-index",
+					      checksum,
+					      NULL);
+
+	g_free (checksum);
+	g_free (uri);
+
+	return index;
+}
+
+GeditFileBrowserSearchIndex *
+gedit_file_browser_search_index_ref (GeditFileBrowserSearchIndex *index)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	g_atomic_int_inc (&index->ref_count);
+	return index;
+}
+
+void
+gedit_file_browser_search_index_unref (GeditFileBrowserSearchIndex *index)
+{
+	g_return_if_fail (index != NULL);
+
+	if (g_atomic_int_dec_and_test (&index->ref_count))
+	{
+		g_hash_table_unref (index->entries);
+		g_hash_table_unref (index->dirty);
+		g_hash_table_unref (index->reindexing);
+		g_mutex_clear (&index->mutex);
+		g_free (index->cache_path);
+		g_object_unref (index->root);
+
+		g_slice_free (GeditFileBrowserSearchIndex, index);
+	}
+}
+
+/**
+ * gedit_file_browser_search_index_get_root:
+ * @index: a #GeditFileBrowserSearchIndex.
+ *
+ * Returns: (transfer none): the indexed directory.
+ */
+GFile *
+gedit_file_browser_search_index_get_root (GeditFileBrowserSearchIndex *index)
+{
+	g_return_val_if_fail (index != NULL, NULL);
+
+	return index->root;
+}
+
+/* Called with the mutex locked. */
+static void
+index_remove_path (GeditFileBrowserSearchIndex *index,
+		   const gchar                 *path)
+{
+	GHashTableIter iter;
+	gpointer key;
+	gsize path_length = strlen (path);
+
+	/* The path can be a directory. */
+	g_hash_table_iter_init (&iter, index->entries);
+
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+	{
+		const gchar *entry_path = key;
+
+		if (strncmp (entry_path, path, path_length) == 0 &&
+		    (entry_path[path_length] == '\0' || G_IS_DIR_SEPARATOR (entry_path[path_length])))
+		{
+			g_hash_table_iter_remove (&iter);
+			index->modified = TRUE;
+		}
+	}
+}
+
+/**
+ * gedit_file_browser_search_index_file_changed:
+ * @index: a #GeditFileBrowserSearchIndex.
+ * @file: the file that changed.
+ * @other_file: (nullable): the new location of @file, for a move.
+ * @event_type: the #GFileMonitorEvent.
+ *
+ * Updates @index with an event of a #GFileMonitor. The events for the files
+ * that are not below the root of @index are ignored.
+ */
+void
+gedit_file_browser_search_index_file_changed (GeditFileBrowserSearchIndex *index,
+					      GFile                       *file,
+					      GFile                       *other_file,
+					      GFileMonitorEvent            event_type)
+{
+	gchar *path;
+	gchar *other_path = NULL;
+
+	g_return_if_fail (index != NULL);
+	g_return_if_fail (G_IS_FILE (file));
+
+	path = g_file_get_relative_path (index->root, file);
+
+	if (other_file != NULL)
+	{
+		other_path = g_file_get_relative_path (index->root, other_file);
+	}
+
+	g_mutex_lock (&index->mutex);
+
+	switch (event_type)
+	{
+		case G_FILE_MONITOR_EVENT_CREATED:
+		case G_FILE_MONITOR_EVENT_CHANGED:
+		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+		case G_FILE_MONITOR_EVENT_MOVED_IN:
+			if (path != NULL)
+			{
+				g_hash_table_add (index->dirty, g_steal_pointer (&path));
+			}
+			break;
+
+		case G_FILE_MONITOR_EVENT_DELETED:
+		case G_FILE_MONITOR_EVENT_MOVED_OUT:
+			if (path != NULL)
+			{
+				index_remove_path (index, path);
+			}
+			break;
+
+		case G_FILE_MONITOR_EVENT_MOVED:
+		case G_FILE_MONITOR_EVENT_RENAMED:
+			if (path != NULL)
+			{
+				index_remove_path (index, path);
+			}
+			if (other_path != NULL)
+			{
+				g_hash_table_add (index->dirty, g_steal_pointer (&other_path));
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	g_free (path);
+	g_free (other_path);
+}
+
+static gboolean
+read_data (const gchar **p,
+	   const gchar  *end,
+	   gpointer      dest,
+	   gsize         size)
+{
+	if ((gsize) (end - *p) < size)
+	{
+		return FALSE;
+	}
+
+	memcpy (dest, *p, size);
+	*p += size;
+
+	return TRUE;
+}
+
+/* Called with the mutex locked. */
+static void
+index_load (GeditFileBrowserSearchIndex *index)
+{
+	gchar *contents;
+	gsize length;
+	const gchar *p;
+	const gchar *end;
+	guint32 version;
+	guint32 n_entries;
+	gint64 validated_time;
+	guint32 i;
+
+	if (!g_file_get_contents (index->cache_path, &contents, &length, NULL))
+	{
+		return;
+	}
+
+	p = contents;
+	end = contents + length;
+
+	if (length < strlen (INDEX_MAGIC) ||
+	    memcmp (p, INDEX_MAGIC, strlen (INDEX_MAGIC)) != 0)
+	{
+		goto out;
+	}
+
+	p += strlen (INDEX_MAGIC);
+
+	if (!read_data (&p, end, &version, sizeof (version)) ||
+	    version != INDEX_VERSION ||
+	    !read_data (&p, end, &n_entries, sizeof (n_entries)) ||
+	    !read_data (&p, end, &validated_time, sizeof (validated_time)))
+	{
+		goto out;
+	}
+
+	for (i = 0; i < n_entries; i++)
+	{
+		IndexEntry *entry;
+		guint32 path_length;
+		guint8 binary;
+		gchar *path;
+
+		if (!read_data (&p, end, &path_length, sizeof (path_length)) ||
+		    (gsize) (end - p) < path_length)
+		{
+			goto error;
+		}
+
+		path = g_strndup (p, path_length);
+		p += path_length;
+
+		entry = g_slice_new0 (IndexEntry);
+		g_hash_table_replace (index->entries, path, entry);
+
+		if (!read_data (&p, end, &entry->mtime, sizeof (entry->mtime)) ||
+		    !read_data (&p, end, &entry->size, sizeof (entry->size)) ||
+		    !read_data (&p, end, &binary, sizeof (binary)) ||
+		    !read_data (&p, end, &entry->log2_bits, sizeof (entry->log2_bits)))
+		{
+			goto error;
+		}
+
+		entry->binary = binary != 0;
+
+		if (!entry->binary)
+		{
+			gsize n_bytes;
+
+			if (entry->log2_bits < MIN_LOG2_BITS || entry->log2_bits > MAX_LOG2_BITS)
+			{
+				goto error;
+			}
+
+			n_bytes = (1 << entry->log2_bits) / 8;
+			entry->bits = g_malloc (n_bytes);
+
+			if (!read_data (&p, end, entry->bits, n_bytes))
+			{
+				goto error;
+			}
+		}
+	}
+
+	index->validated_time = validated_time;
+	goto out;
+
+error:
+	g_warning ("The file browser search index %s is corrupted", index->cache_path);
+	g_hash_table_remove_all (index->entries);
+
+out:
+	g_free (contents);
+}
+
+static void
+index_save (GeditFileBrowserSearchIndex *index)
+{
+	GString *data;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	guint32 version = INDEX_VERSION;
+	guint32 n_entries;
+	gsize n_entries_pos;
+	gchar *dirname;
+	GError *error = NULL;
+
+	g_mutex_lock (&index->mutex);
+
+	n_entries = 0;
+
+	data = g_string_sized_new (64 + g_hash_table_size (index->entries) * 128);
+	g_string_append_len (data, INDEX_MAGIC, strlen (INDEX_MAGIC));
+	g_string_append_len (data, (const gchar *) &version, sizeof (version));
+	n_entries_pos = data->len;
+	g_string_append_len (data, (const gchar *) &n_entries, sizeof (n_entries));
+	g_string_append_len (data, (const gchar *) &index->validated_time, sizeof (index->validated_time));
+
+	g_hash_table_iter_init (&iter, index->entries);
+
+	while (g_hash_table_iter_next (&iter, &key, &value))
+	{
+		const gchar *path = key;
+		IndexEntry *entry = value;
+		guint32 path_length = strlen (path);
+		guint8 binary = entry->binary;
+
+		/* Not saved, so that they are indexed again after a
+		 * restart.
+		 */
+		if (g_hash_table_contains (index->dirty, path) ||
+		    g_hash_table_contains (index->reindexing, path))
+		{
+			continue;
+		}
+
+		n_entries++;
+
+		g_string_append_len (data, (const gchar *) &path_length, sizeof (path_length));
+		g_string_append_len (data, path, path_length);
+		g_string_append_len (data, (const gchar *) &entry->mtime, sizeof (entry->mtime));
+		g_string_append_len (data, (const gchar *) &entry->size, sizeof (entry->size));
+		g_string_append_len (data, (const gchar *) &binary, sizeof (binary));
+		g_string_append_len (data, (const gchar *) &entry->log2_bits, sizeof (entry->log2_bits));
+
+		if (!entry->binary)
+		{
+			g_string_append_len (data, (const gchar *) entry->bits, (1 << entry->log2_bits) / 8);
+		}
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	memcpy (data->str + n_entries_pos, &n_entries, sizeof (n_entries));
+
+	dirname = g_path_get_dirname (index->cache_path);
+	g_mkdir_with_parents (dirname, 0700);
+
+	if (!g_file_set_contents (index->cache_path, data->str, data->len, &error))
+	{
+		g_warning ("Could not save the file browser search index: %s", error->message);
+		g_error_free (error);
+	}
+
+	g_free (dirname);
+	g_string_free (data, TRUE);
+}
+
+static Search *
+search_ref (Search *search)
+{
+	g_atomic_int_inc (&search->ref_count);
+	return search;
+}
+
+static void
+search_unref (Search *search)
+{
+	if (g_atomic_int_dec_and_test (&search->ref_count))
+	{
+		g_object_unref (search->root);
+		g_regex_unref (search->regex);
+		g_array_unref (search->trigrams);
+
+		if (search->binary_pattern_specs != NULL)
+		{
+			g_ptr_array_unref (search->binary_pattern_specs);
+		}
+
+		if (search->index != NULL)
+		{
+			gedit_file_browser_search_index_unref (search->index);
+		}
+
+		g_clear_object (&search->cancellable);
+		g_main_context_unref (search->context);
+		g_mutex_clear (&search->mutex);
+		g_cond_clear (&search->cond);
+
+		g_slice_free (Search, search);
+	}
+}
+
+static void
+hit_clear (GeditFileBrowserSearchHit *hit)
+{
+	g_object_unref (hit->location);
+	g_free (hit->line_text);
+}
+
+static void
+batch_free (Batch *batch)
+{
+	g_array_unref (batch->hits);
+	search_unref (batch->search);
+	g_slice_free (Batch, batch);
+}
+
+static gboolean
+deliver_batch_cb (gpointer user_data)
+{
+	Batch *batch = user_data;
+	Search *search = batch->search;
+
+	if (!g_cancellable_is_cancelled (search->cancellable))
+	{
+		search->hits_func ((const GeditFileBrowserSearchHit *) batch->hits->data,
+				   batch->hits->len,
+				   search->hits_func_data);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+push_item (Search   *search,
+	   ItemKind  kind,
+	   GFile    *file,
+	   gint64    mtime,
+	   gint64    size,
+	   gboolean  force_index)
+{
+	WorkItem *item;
+
+	item = g_slice_new0 (WorkItem);
+	item->kind = kind;
+	item->file = g_object_ref (file);
+	item->mtime = mtime;
+	item->size = size;
+	item->force_index = force_index != FALSE;
+
+	g_mutex_lock (&search->mutex);
+	search->n_pending_items++;
+	g_mutex_unlock (&search->mutex);
+
+	g_thread_pool_push (search->pool, item, NULL);
+}
+
+static void
+work_item_free (WorkItem *item)
+{
+	g_object_unref (item->file);
+	g_slice_free (WorkItem, item);
+}
+
+static gint64
+get_mtime (GFileInfo *info)
+{
+	return g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+	       g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+}
+
+/* Returns whether @file has been pushed as a text file. */
+static gboolean
+handle_file_info (Search    *search,
+		  GFile     *file,
+		  GFileInfo *info,
+		  gboolean   force_index)
+{
+	const gchar *content_type;
+	gint64 size;
+
+	if (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info))
+	{
+		return FALSE;
+	}
+
+	switch (g_file_info_get_file_type (info))
+	{
+		case G_FILE_TYPE_DIRECTORY:
+			push_item (search, ITEM_DIRECTORY, file, 0, 0, FALSE);
+			break;
+
+		case G_FILE_TYPE_REGULAR:
+			content_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+			size = g_file_info_get_size (info);
+
+			if (gedit_file_browser_utils_content_type_is_text (content_type) &&
+			    !gedit_file_browser_utils_name_matches_patterns (search->binary_pattern_specs,
+									     g_file_info_get_name (info)) &&
+			    size <= MAX_FILE_SIZE)
+			{
+				push_item (search,
+					   ITEM_FILE,
+					   file,
+					   get_mtime (info),
+					   size,
+					   force_index);
+				return TRUE;
+			}
+			break;
+
+		default:
+			/* Symbolic links are not followed, to avoid cycles. */
+			break;
+	}
+
+	return FALSE;
+}
+
+static void
+process_directory (Search *search,
+		   GFile  *directory)
+{
+	GFileEnumerator *enumerator;
+	GFileInfo *info;
+
+	enumerator = g_file_enumerate_children (directory,
+						SEARCH_ATTRIBUTES,
+						G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+						search->cancellable,
+						NULL);
+
+	if (enumerator == NULL)
+	{
+		return;
+	}
+
+	while ((info = g_file_enumerator_next_file (enumerator, search->cancellable, NULL)) != NULL)
+	{
+		GFile *child;
+
+		child = g_file_get_child (directory, g_file_info_get_name (info));
+		handle_file_info (search, child, info, FALSE);
+
+		g_object_unref (child);
+		g_object_unref (info);
+	}
+
+	g_file_enumerator_close (enumerator, NULL, NULL);
+	g_object_unref (enumerator);
+}
+
+static void
+process_unknown (Search   *search,
+		 WorkItem *item)
+{
+	GFileInfo *info;
+
+	info = g_file_query_info (item->file,
+				  SEARCH_ATTRIBUTES,
+				  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+				  search->cancellable,
+				  NULL);
+
+	if (info != NULL)
+	{
+		gboolean text_file;
+
+		text_file = handle_file_info (search, item->file, info, item->force_index);
+		g_object_unref (info);
+
+		/* A dirty file that is not a text file anymore, or a
+		 * directory, which has no entry.
+		 */
+		if (!text_file && item->force_index && search->index != NULL)
+		{
+			gchar *path = g_file_get_relative_path (search->root, item->file);
+
+			if (path != NULL)
+			{
+				g_mutex_lock (&search->index->mutex);
+				g_hash_table_remove (search->index->entries, path);
+				g_hash_table_remove (search->index->reindexing, path);
+				search->index->modified = TRUE;
+				g_mutex_unlock (&search->index->mutex);
+			}
+
+			g_free (path);
+		}
+	}
+	else if (search->index != NULL)
+	{
+		gchar *path = g_file_get_relative_path (search->root, item->file);
+
+		if (path != NULL)
+		{
+			g_mutex_lock (&search->index->mutex);
+			index_remove_path (search->index, path);
+			g_hash_table_remove (search->index->reindexing, path);
+			g_mutex_unlock (&search->index->mutex);
+		}
+
+		g_free (path);
+	}
+}
+
+static gchar *
+get_line_text (const gchar *line_start,
+	       const gchar *text_end)
+{
+	const gchar *line_end;
+
+	line_end = memchr (line_start, '\n', text_end - line_start);
+
+	if (line_end == NULL)
+	{
+		line_end = text_end;
+	}
+
+	if (line_end > line_start && line_end[-1] == '\r')
+	{
+		line_end--;
+	}
+
+	if (line_end - line_start > MAX_LINE_TEXT_BYTES)
+	{
+		/* Don't cut a character. */
+		line_end = g_utf8_find_prev_char (line_start, line_start + MAX_LINE_TEXT_BYTES + 1);
+	}
+
+	return g_strndup (line_start, line_end - line_start);
+}
+
+static void
+search_contents (Search      *search,
+		 GFile       *file,
+		 const gchar *contents,
+		 gsize        length)
+{
+	const gchar *end = contents + length;
+	const gchar *scanned = contents;
+	const gchar *line_start = contents;
+	GMatchInfo *match_info = NULL;
+	GArray *hits = NULL;
+	gint line = 0;
+
+	g_regex_match_full (search->regex, contents, length, 0, 0, &match_info, NULL);
+
+	while (g_match_info_matches (match_info))
+	{
+		GeditFileBrowserSearchHit hit;
+		const gchar *newline;
+		gint start_pos;
+		gint end_pos;
+
+		g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos);
+
+		while ((newline = memchr (scanned, '\n', contents + start_pos - scanned)) != NULL)
+		{
+			line++;
+			scanned = newline + 1;
+			line_start = scanned;
+		}
+
+		scanned = contents + start_pos;
+
+		if (hits == NULL)
+		{
+			hits = g_array_new (FALSE, FALSE, sizeof (GeditFileBrowserSearchHit));
+			g_array_set_clear_func (hits, (GDestroyNotify) hit_clear);
+		}
+		else if (g_array_index (hits, GeditFileBrowserSearchHit, hits->len - 1).line == line)
+		{
+			/* One hit per line is enough. */
+			g_match_info_next (match_info, NULL);
+			continue;
+		}
+
+		hit.location = g_object_ref (file);
+		hit.line = line;
+		hit.line_text = get_line_text (line_start, end);
+		g_array_append_val (hits, hit);
+
+		if (hits->len == MAX_HITS_PER_FILE)
+		{
+			break;
+		}
+
+		g_match_info_next (match_info, NULL);
+	}
+
+	g_match_info_free (match_info);
+
+	if (hits != NULL)
+	{
+		Batch *batch;
+
+		g_atomic_int_add (&search->n_hits, hits->len);
+
+		batch = g_slice_new (Batch);
+		batch->search = search_ref (search);
+		batch->hits = hits;
+
+		g_main_context_invoke_full (search->context,
+					    G_PRIORITY_DEFAULT,
+					    deliver_batch_cb,
+					    batch,
+					    (GDestroyNotify) batch_free);
+	}
+}
+
+static void
+process_file (Search   *search,
+	      WorkItem *item)
+{
+	GeditFileBrowserSearchIndex *index = search->index;
+	gchar *path = NULL;
+	gchar *contents = NULL;
+	gsize length;
+	gboolean up_to_date = FALSE;
+	gboolean binary;
+
+	if (index != NULL)
+	{
+		path = g_file_get_relative_path (search->root, item->file);
+
+		if (path == NULL)
+		{
+			goto out;
+		}
+	}
+
+	if (index != NULL && !item->force_index)
+	{
+		IndexEntry *entry;
+		gboolean skip = FALSE;
+
+		g_mutex_lock (&index->mutex);
+
+		entry = g_hash_table_lookup (index->entries, path);
+
+		if (entry != NULL &&
+		    entry->mtime == item->mtime &&
+		    entry->size == item->size &&
+		    !g_hash_table_contains (index->reindexing, path))
+		{
+			entry->generation = search->generation;
+			up_to_date = TRUE;
+			skip = !index_entry_may_match (entry, search->trigrams);
+		}
+
+		g_mutex_unlock (&index->mutex);
+
+		if (skip)
+		{
+			goto out;
+		}
+	}
+
+	if (!g_file_load_contents (item->file, search->cancellable, &contents, &length, NULL, NULL))
+	{
+		goto out;
+	}
+
+	binary = memchr (contents, '\0', MIN (length, BINARY_CHECK_SIZE)) != NULL;
+
+	if (index != NULL && !up_to_date)
+	{
+		IndexEntry *entry;
+
+		entry = g_slice_new0 (IndexEntry);
+		entry->mtime = item->mtime;
+		entry->size = item->size;
+		entry->generation = search->generation;
+		entry->binary = binary;
+		index_entry_set_contents (entry, contents, length);
+
+		g_mutex_lock (&index->mutex);
+		g_hash_table_remove (index->reindexing, path);
+		g_hash_table_replace (index->entries, g_steal_pointer (&path), entry);
+		index->modified = TRUE;
+		g_mutex_unlock (&index->mutex);
+	}
+
+	if (!binary && g_utf8_validate (contents, length, NULL))
+	{
+		search_contents (search, item->file, contents, length);
+	}
+
+out:
+	g_free (contents);
+	g_free (path);
+}
+
+static void
+process_item (gpointer data,
+	      gpointer user_data)
+{
+	WorkItem *item = data;
+	Search *search = user_data;
+
+	if (!g_cancellable_is_cancelled (search->cancellable))
+	{
+		switch (item->kind)
+		{
+			case ITEM_DIRECTORY:
+				process_directory (search, item->file);
+				break;
+			case ITEM_FILE:
+				process_file (search, item);
+				break;
+			case ITEM_UNKNOWN:
+				process_unknown (search, item);
+				break;
+			default:
+				g_assert_not_reached ();
+		}
+	}
+
+	work_item_free (item);
+
+	g_mutex_lock (&search->mutex);
+
+	search->n_pending_items--;
+
+	if (search->n_pending_items == 0)
+	{
+		g_cond_signal (&search->cond);
+	}
+
+	g_mutex_unlock (&search->mutex);
+}
+
+/* Returns whether the whole tree needs to be walked. */
+static gboolean
+push_index_items (Search *search)
+{
+	GeditFileBrowserSearchIndex *index = search->index;
+	GPtrArray *dirty_paths;
+	GPtrArray *paths;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	gint64 age;
+	gboolean full_walk;
+	guint i;
+
+	dirty_paths = g_ptr_array_new_with_free_func (g_free);
+	paths = g_ptr_array_new_with_free_func (g_free);
+
+	g_mutex_lock (&index->mutex);
+
+	if (!index->loaded)
+	{
+		index_load (index);
+		index->loaded = TRUE;
+	}
+
+	search->generation = ++index->generation;
+
+	age = g_get_real_time () - index->validated_time;
+	full_walk = index->validated_time == 0 || age < 0 || age > REVALIDATE_INTERVAL;
+
+	/* The changed files are indexed again. Their entries are kept until
+	 * then, for the searches that would be cancelled before.
+	 */
+	g_hash_table_iter_init (&iter, index->dirty);
+
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+	{
+		g_hash_table_iter_steal (&iter);
+		g_hash_table_add (index->reindexing, key);
+
+		if (!full_walk)
+		{
+			g_ptr_array_add (dirty_paths, g_strdup (key));
+		}
+	}
+
+	if (!full_walk)
+	{
+		g_hash_table_iter_init (&iter, index->entries);
+
+		while (g_hash_table_iter_next (&iter, &key, &value))
+		{
+			if (!g_hash_table_contains (index->reindexing, key) &&
+			    index_entry_may_match (value, search->trigrams))
+			{
+				g_ptr_array_add (paths, g_strdup (key));
+			}
+		}
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	for (i = 0; i < dirty_paths->len; i++)
+	{
+		GFile *file;
+
+		file = g_file_resolve_relative_path (search->root, g_ptr_array_index (dirty_paths, i));
+		push_item (search, ITEM_UNKNOWN, file, 0, 0, TRUE);
+		g_object_unref (file);
+	}
+
+	for (i = 0; i < paths->len; i++)
+	{
+		GFile *file;
+
+		file = g_file_resolve_relative_path (search->root, g_ptr_array_index (paths, i));
+		push_item (search, ITEM_UNKNOWN, file, 0, 0, FALSE);
+		g_object_unref (file);
+	}
+
+	g_ptr_array_unref (dirty_paths);
+	g_ptr_array_unref (paths);
+
+	return full_walk;
+}
+
+static void
+finish_index (Search   *search,
+	      gboolean  full_walk)
+{
+	GeditFileBrowserSearchIndex *index = search->index;
+	GHashTableIter iter;
+	gpointer key;
+	gboolean save;
+
+	g_mutex_lock (&index->mutex);
+
+	/* The dirty files that have not been indexed again. */
+	g_hash_table_iter_init (&iter, index->reindexing);
+
+	while (g_hash_table_iter_next (&iter, &key, NULL))
+	{
+		g_hash_table_iter_steal (&iter);
+		g_hash_table_add (index->dirty, key);
+	}
+
+	if (full_walk && !g_cancellable_is_cancelled (search->cancellable))
+	{
+		gpointer value;
+
+		/* Remove the files that have not been seen. */
+		g_hash_table_iter_init (&iter, index->entries);
+
+		while (g_hash_table_iter_next (&iter, NULL, &value))
+		{
+			IndexEntry *entry = value;
+
+			if (entry->generation != search->generation)
+			{
+				g_hash_table_iter_remove (&iter);
+				index->modified = TRUE;
+			}
+		}
+
+		index->validated_time = g_get_real_time ();
+		index->modified = TRUE;
+	}
+
+	save = index->modified;
+	index->modified = FALSE;
+
+	g_mutex_unlock (&index->mutex);
+
+	if (save)
+	{
+		index_save (index);
+	}
+}
+
+static void
+search_thread (GTask        *task,
+	       gpointer      source_object,
+	       gpointer      task_data,
+	       GCancellable *cancellable)
+{
+	Search *search = task_data;
+	gboolean full_walk = TRUE;
+
+	search->pool = g_thread_pool_new (process_item,
+					  search,
+					  g_get_num_processors (),
+					  FALSE,
+					  NULL);
+
+	if (search->index != NULL)
+	{
+		full_walk = push_index_items (search);
+	}
+
+	if (full_walk)
+	{
+		push_item (search, ITEM_DIRECTORY, search->root, 0, 0, FALSE);
+	}
+
+	g_mutex_lock (&search->mutex);
+
+	while (search->n_pending_items > 0)
+	{
+		g_cond_wait (&search->cond, &search->mutex);
+	}
+
+	g_mutex_unlock (&search->mutex);
+
+	g_thread_pool_free (search->pool, FALSE, TRUE);
+	search->pool = NULL;
+
+	if (search->index != NULL)
+	{
+		finish_index (search, full_walk);
+	}
+
+	if (!g_task_return_error_if_cancelled (task))
+	{
+		g_task_return_int (task, g_atomic_int_get (&search->n_hits));
+	}
+}
+
+static GArray *
+get_trigrams (const gchar *text,
+	      gboolean     case_sensitive)
+{
+	const guchar *p = (const guchar *) text;
+	gsize length = strlen (text);
+	GArray *trigrams;
+	gsize i;
+
+	trigrams = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+	for (i = 0; i + 2 < length; i++)
+	{
+		guint32 trigram;
+
+		/* Only the ASCII letters are case folded in the index. */
+		if (!case_sensitive && (p[i] >= 0x80 || p[i + 1] >= 0x80 || p[i + 2] >= 0x80))
+		{
+			continue;
+		}
+
+		trigram = get_trigram (p + i);
+		g_array_append_val (trigrams, trigram);
+	}
+
+	return trigrams;
+}
+
+/**
+ * gedit_file_browser_search_async:
+ * @root: the directory to search.
+ * @text: the text to search.
+ * @case_sensitive: whether the search is case sensitive.
+ * @binary_patterns: (nullable): the patterns of the file names to skip.
+ * @index: (nullable): a #GeditFileBrowserSearchIndex for @root.
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore.
+ * @hits_func: function called on the main thread with the hits of each file.
+ * @hits_func_data: data passed to @hits_func.
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the search
+ *   is finished.
+ * @user_data: user data to pass to @callback.
+ *
+ * Searches @text in the text files below @root. Only the first hit of each
+ * line is reported.
+ */
+void
+gedit_file_browser_search_async (GFile                          *root,
+				 const gchar                    *text,
+				 gboolean                        case_sensitive,
+				 const gchar * const            *binary_patterns,
+				 GeditFileBrowserSearchIndex    *index,
+				 GCancellable                   *cancellable,
+				 GeditFileBrowserSearchHitsFunc  hits_func,
+				 gpointer                        hits_func_data,
+				 GAsyncReadyCallback             callback,
+				 gpointer                        user_data)
+{
+	GTask *task;
+	Search *search;
+	gchar *pattern;
+	GRegexCompileFlags flags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+
+	g_return_if_fail (G_IS_FILE (root));
+	g_return_if_fail (text != NULL && text[0] != '\0');
+	g_return_if_fail (index == NULL || g_file_equal (root, index->root));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (hits_func != NULL);
+
+	if (!case_sensitive)
+	{
+		flags |= G_REGEX_CASELESS;
+	}
+
+	pattern = g_regex_escape_string (text, -1);
+
+	search = g_slice_new0 (Search);
+	search->ref_count = 1;
+	search->root = g_object_ref (root);
+	search->regex = g_regex_new (pattern, flags, 0, NULL);
+	search->trigrams = get_trigrams (text, case_sensitive);
+	search->index = index != NULL ? gedit_file_browser_search_index_ref (index) : NULL;
+	search->cancellable = cancellable != NULL ? g_object_ref (cancellable) : NULL;
+	search->context = g_main_context_ref_thread_default ();
+	search->hits_func = hits_func;
+	search->hits_func_data = hits_func_data;
+	g_mutex_init (&search->mutex);
+	g_cond_init (&search->cond);
+
+	/* An escaped string is always a valid regex. */
+	g_assert (search->regex != NULL);
+
+	if (binary_patterns != NULL)
+	{
+		guint i;
+
+		search->binary_pattern_specs = g_ptr_array_new_with_free_func ((GDestroyNotify) g_pattern_spec_free);
+
+		for (i = 0; binary_patterns[i] != NULL; i++)
+		{
+			g_ptr_array_add (search->binary_pattern_specs, g_pattern_spec_new (binary_patterns[i]));
+		}
+	}
+
+	g_free (pattern);
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	g_task_set_task_data (task, search, (GDestroyNotify) search_unref);
+	g_task_run_in_thread (task, search_thread);
+	g_object_unref (task);
+}
+
+/**
+ * gedit_file_browser_search_finish:
+ * @result: a #GAsyncResult.
+ * @error: a location for a #GError, or %NULL.
+ *
+ * Returns: the number of hits.
+ */
+guint
+gedit_file_browser_search_finish (GAsyncResult  *result,
+				  GError       **error)
+{
+	gssize n_hits;
+
+	g_return_val_if_fail (g_task_is_valid (result, NULL), 0);
+
+	n_hits = g_task_propagate_int (G_TASK (result), error);
+
+	return n_hits > 0 ? n_hits : 0;
+}
+
+/* ex:set ts=8 noet: */
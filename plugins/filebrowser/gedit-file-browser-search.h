@@ -0,0 +1,71 @@
+/*
+ * gedit-file-browser-search.h - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_FILE_BROWSER_SEARCH_H
+#define GEDIT_FILE_BROWSER_SEARCH_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GeditFileBrowserSearchIndex GeditFileBrowserSearchIndex;
+
+typedef struct
+{
+	GFile *location;
+
+	/* Starting at 0. */
+	gint   line;
+
+	/* The beginning of the line, for display. */
+	gchar *line_text;
+} GeditFileBrowserSearchHit;
+
+typedef void (* GeditFileBrowserSearchHitsFunc) (const GeditFileBrowserSearchHit *hits,
+						 guint                            n_hits,
+						 gpointer                         user_data);
+
+GeditFileBrowserSearchIndex	*gedit_file_browser_search_index_new		(GFile                          *root);
+GeditFileBrowserSearchIndex	*gedit_file_browser_search_index_ref		(GeditFileBrowserSearchIndex    *index);
+void				 gedit_file_browser_search_index_unref		(GeditFileBrowserSearchIndex    *index);
+GFile				*gedit_file_browser_search_index_get_root	(GeditFileBrowserSearchIndex    *index);
+void				 gedit_file_browser_search_index_file_changed	(GeditFileBrowserSearchIndex    *index,
+										 GFile                          *file,
+										 GFile                          *other_file,
+										 GFileMonitorEvent               event_type);
+
+void				 gedit_file_browser_search_async		(GFile                          *root,
+										 const gchar                    *text,
+										 gboolean                        case_sensitive,
+										 const gchar * const            *binary_patterns,
+										 GeditFileBrowserSearchIndex    *index,
+										 GCancellable                   *cancellable,
+										 GeditFileBrowserSearchHitsFunc  hits_func,
+										 gpointer                        hits_func_data,
+										 GAsyncReadyCallback             callback,
+										 gpointer                        user_data);
+guint				 gedit_file_browser_search_finish		(GAsyncResult                   *result,
+										 GError                        **error);
+
+G_END_DECLS
+
+#endif /* GEDIT_FILE_BROWSER_SEARCH_H */
+
+/* ex:set ts=8 noet: */
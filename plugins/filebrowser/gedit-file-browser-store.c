@@ -23,12 +23,14 @@
 #include <string.h>
 #include <glib/gi18n-lib.h>
 #include <gio/gio.h>
+#include <gedit/gedit-debug.h>
 #include <gedit/gedit-utils.h>
 
 #include "gedit-file-browser-store.h"
 #include "gedit-file-browser-enum-types.h"
 #include "gedit-file-browser-error.h"
 #include "gedit-file-browser-utils.h"
+#include "gedit-file-browser-listing-cache.h"
 
 #define NODE_IS_DIR(node)		(FILE_IS_DIR((node)->flags))
 #define NODE_IS_HIDDEN(node)		(FILE_IS_HIDDEN((node)->flags))
@@ -39,12 +41,34 @@
 
 #define FILE_BROWSER_NODE_DIR(node)	((FileBrowserNodeDir *)(node))
 
-#define DIRECTORY_LOAD_ITEMS_PER_CALLBACK 100
+/* The first files of a directory are requested by small batches so that
+ * they are shown quickly, the batches then grow up to the maximum. */
+#define DIRECTORY_LOAD_ITEMS_MIN 32
+#define DIRECTORY_LOAD_ITEMS_MAX 1024
+
+/* How many children of an expanded directory are looked at for the
+ * subdirectories to load in the background */
+#define DIRECTORY_PREFETCH_MAX 64
+
+/* The rows of a directory being loaded are inserted at most once per frame */
+#define DIRECTORY_LOAD_FLUSH_INTERVAL (G_USEC_PER_SEC / 60)
+
+/* The monitor events of a directory are applied together, at most once per
+ * DIRECTORY_EVENTS_DELAY ms. A directory that gets more than
+ * DIRECTORY_EVENTS_MAX_RATE events per second isn't monitored for
+ * DIRECTORY_MONITOR_PAUSE s, and it is then listed again. */
+#define DIRECTORY_EVENTS_DELAY 100
+#define DIRECTORY_EVENTS_MAX_RATE 500
+#define DIRECTORY_MONITOR_PAUSE 2
+
+#define DIRECTORY_MTIME_ATTRIBUTES G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+				   G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
 #define STANDARD_ATTRIBUTE_TYPES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
 				 G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
 			 	 G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
 				 G_FILE_ATTRIBUTE_STANDARD_NAME "," \
-				 G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE "," \
+				 G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE "," \
 				 G_FILE_ATTRIBUTE_STANDARD_ICON
 
 typedef struct _FileBrowserNode    FileBrowserNode;
@@ -69,7 +93,30 @@ struct _AsyncNode
 {
 	FileBrowserNodeDir *dir;
 	GCancellable       *cancellable;
-	GSList             *original_children;
+	GHashTable         *original_files;
+
+	/* The children shown from the listing cache that were not
+	 * enumerated yet, with their cached info */
+	GHashTable         *cached;
+	gboolean            from_cache;
+
+	/* The modification time of the directory before the enumeration */
+	gboolean            has_mtime;
+	guint64             mtime;
+	guint32             mtime_usec;
+
+	gint                n_items;
+	gint                io_priority;
+
+	/* Whether a shown directory is listed again */
+	gboolean            resync;
+
+	/* The infos enumerated since the last flush */
+	GQueue              files;
+	gint64              start_time;
+	gint64              first_flush_time;
+	gint64              flush_time;
+	guint               flush_id;
 };
 
 typedef struct {
@@ -85,24 +132,64 @@ struct _FileBrowserNode
 	guint            flags;
 	gchar           *icon_name;
 	gchar           *name;
+	gchar           *collate_key;
 	gchar           *markup;
 
+	/* Interned */
+	const gchar     *content_type;
+
 	GdkPixbuf       *icon;
 	GdkPixbuf       *emblem;
 
 	FileBrowserNode *parent;
+
+	/* Index in the children of the parent */
 	gint             pos;
 	gboolean         inserted;
+
+	/* Whether the node is counted in the rows of the parent */
+	gboolean         row;
 };
 
 struct _FileBrowserNodeDir
 {
 	FileBrowserNode        node;
-	GSList                *children;
+
+	/* The children, kept sorted, and a Fenwick tree over the children
+	 * that are rows of the model. It maps a row to a child and back in
+	 * O(log n), so that big directories don't need to be walked. */
+	GPtrArray             *children;
+	gint                  *rows;
+	gint                   n_rows;
 
 	GCancellable          *cancellable;
 	GFileMonitor          *monitor;
 	GeditFileBrowserStore *model;
+
+	/* Whether the current load is done in the background */
+	gboolean               prefetching;
+
+	/* Whether a background load was already tried */
+	gboolean               prefetched;
+
+	/* Whether the subdirectories are loaded in the background */
+	gboolean               prefetch_children;
+
+	/* Whether it was only loaded in the background, it is then not
+	 * monitored until it is shown */
+	gboolean               unwatched;
+
+	/* The monitor events not applied yet, the last event of each file */
+	GHashTable            *events;
+	guint                  events_id;
+
+	/* Queries the infos of the created files */
+	GCancellable          *events_cancellable;
+
+	/* The number of monitor events since events_time */
+	gint64                 events_time;
+	guint                  n_events;
+	guint                  resume_monitor_id;
 };
 
 struct _GeditFileBrowserStorePrivate
@@ -122,6 +209,9 @@ struct _GeditFileBrowserStorePrivate
 
 	GSList                           *async_handles;
 	MountInfo                        *mount_info;
+
+	gboolean                          listing_cache;
+	gboolean                          pause_busy_directories;
 };
 
 static FileBrowserNode *model_find_node 		    (GeditFileBrowserStore  *model,
@@ -191,6 +281,12 @@ static void model_check_dummy                               (GeditFileBrowserSto
 							     FileBrowserNode        *node);
 static void next_files_async 				    (GFileEnumerator        *enumerator,
 							     AsyncNode              *async);
+static void model_schedule_directory_events                 (FileBrowserNode        *node);
+static void model_resync_directory                          (GeditFileBrowserStore  *model,
+							     FileBrowserNode        *node);
+static void model_load_directory_real                       (GeditFileBrowserStore  *model,
+							     FileBrowserNode        *node,
+							     gboolean                prefetch);
 
 static void delete_files                                    (AsyncData              *data);
 
@@ -210,7 +306,9 @@ enum {
 	PROP_ROOT,
 	PROP_VIRTUAL_ROOT,
 	PROP_FILTER_MODE,
-	PROP_BINARY_PATTERNS
+	PROP_BINARY_PATTERNS,
+	PROP_LISTING_CACHE,
+	PROP_PAUSE_BUSY_DIRECTORIES
 };
 
 /* Signals */
@@ -225,6 +323,7 @@ enum
 	END_REFRESH,
 	UNLOAD,
 	BEFORE_ROW_DELETED,
+	FILE_CHANGED,
 	NUM_SIGNALS
 };
 
@@ -302,6 +401,12 @@ gedit_file_browser_store_get_property (GObject    *object,
 		case PROP_BINARY_PATTERNS:
 			g_value_set_boxed (value, obj->priv->binary_patterns);
 			break;
+		case PROP_LISTING_CACHE:
+			g_value_set_boolean (value, obj->priv->listing_cache);
+			break;
+		case PROP_PAUSE_BUSY_DIRECTORIES:
+			g_value_set_boolean (value, obj->priv->pause_busy_directories);
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -327,6 +432,12 @@ gedit_file_browser_store_set_property (GObject      *object,
 		case PROP_BINARY_PATTERNS:
 			gedit_file_browser_store_set_binary_patterns (obj, g_value_get_boxed (value));
 			break;
+		case PROP_LISTING_CACHE:
+			obj->priv->listing_cache = g_value_get_boolean (value);
+			break;
+		case PROP_PAUSE_BUSY_DIRECTORIES:
+			obj->priv->pause_busy_directories = g_value_get_boolean (value);
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -371,6 +482,20 @@ gedit_file_browser_store_class_init (GeditFileBrowserStoreClass *klass)
 					 		     G_TYPE_STRV,
 					 		     G_PARAM_READWRITE));
 
+	g_object_class_install_property (object_class, PROP_LISTING_CACHE,
+					 g_param_spec_boolean ("listing-cache",
+					 		       "Listing Cache",
+					 		       "Whether the directory listings are cached on disk",
+					 		       TRUE,
+					 		       G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class, PROP_PAUSE_BUSY_DIRECTORIES,
+					 g_param_spec_boolean ("pause-busy-directories",
+					 		       "Pause Busy Directories",
+					 		       "Whether the directories changing too often are no longer monitored for a while",
+					 		       TRUE,
+					 		       G_PARAM_READWRITE));
+
 	model_signals[BEGIN_LOADING] =
 	    g_signal_new ("begin-loading",
 			  G_OBJECT_CLASS_TYPE (object_class),
@@ -433,6 +558,14 @@ gedit_file_browser_store_class_init (GeditFileBrowserStoreClass *klass)
 			  NULL, NULL, NULL,
 			  G_TYPE_NONE, 1,
 			  GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE);
+	model_signals[FILE_CHANGED] =
+	    g_signal_new ("file-changed",
+			  G_OBJECT_CLASS_TYPE (object_class),
+			  G_SIGNAL_RUN_LAST,
+			  G_STRUCT_OFFSET (GeditFileBrowserStoreClass, file_changed),
+			  NULL, NULL, NULL,
+			  G_TYPE_NONE, 3,
+			  G_TYPE_FILE, G_TYPE_FILE, G_TYPE_FILE_MONITOR_EVENT);
 }
 
 static void
@@ -482,6 +615,8 @@ gedit_file_browser_store_init (GeditFileBrowserStore *obj)
 	/* Default filter mode is hiding the hidden files */
 	obj->priv->filter_mode = gedit_file_browser_store_filter_mode_get_default ();
 	obj->priv->sort_func = model_sort_default;
+	obj->priv->listing_cache = TRUE;
+	obj->priv->pause_busy_directories = TRUE;
 }
 
 static gboolean
@@ -524,11 +659,155 @@ model_node_visibility (GeditFileBrowserStore *model,
 }
 
 static gboolean
-model_node_inserted (GeditFileBrowserStore *model,
-		     FileBrowserNode       *node)
+file_browser_node_is_row (FileBrowserNode *node)
+{
+	if (!node->inserted)
+		return FALSE;
+
+	if (NODE_IS_DUMMY (node))
+		return !NODE_IS_HIDDEN (node);
+
+	return !NODE_IS_FILTERED (node);
+}
+
+static void
+file_browser_node_dir_add_rows (FileBrowserNodeDir *dir,
+				gint                pos,
+				gint                delta)
+{
+	gint len = dir->children->len;
+
+	for (gint i = pos + 1; i <= len; i += i & -i)
+		dir->rows[i] += delta;
+
+	dir->n_rows += delta;
+}
+
+/* Returns the number of rows among the children before @pos */
+static gint
+file_browser_node_dir_rows_before (FileBrowserNodeDir *dir,
+				   gint                pos)
+{
+	gint num = 0;
+
+	for (gint i = pos; i > 0; i -= i & -i)
+		num += dir->rows[i];
+
+	return num;
+}
+
+/* Returns the child which is the row @n of @dir */
+static FileBrowserNode *
+file_browser_node_dir_nth_row (FileBrowserNodeDir *dir,
+			       gint                n)
+{
+	gint len = dir->children->len;
+	gint pos = 0;
+
+	if (n < 0 || n >= dir->n_rows)
+		return NULL;
+
+	for (gint mask = 1 << (g_bit_storage (len) - 1); mask > 0; mask >>= 1)
+	{
+		if (pos + mask <= len && dir->rows[pos + mask] <= n)
+		{
+			pos += mask;
+			n -= dir->rows[pos];
+		}
+	}
+
+	return (FileBrowserNode *)g_ptr_array_index (dir->children, pos);
+}
+
+/* Updates the positions of the children starting at @from and rebuilds
+ * the rows, in linear time. */
+static void
+file_browser_node_dir_reindex (FileBrowserNodeDir *dir,
+			       gint                from)
+{
+	gint len = dir->children->len;
+
+	for (gint i = from; i < len; ++i)
+		((FileBrowserNode *)g_ptr_array_index (dir->children, i))->pos = i;
+
+	dir->rows = g_renew (gint, dir->rows, len + 1);
+	dir->rows[0] = 0;
+	dir->n_rows = 0;
+
+	for (gint i = 1; i <= len; ++i)
+	{
+		FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i - 1);
+
+		dir->rows[i] = child->row ? 1 : 0;
+		dir->n_rows += dir->rows[i];
+	}
+
+	for (gint i = 1; i <= len; ++i)
+	{
+		gint parent = i + (i & -i);
+
+		if (parent <= len)
+			dir->rows[parent] += dir->rows[i];
+	}
+}
+
+static void
+file_browser_node_dir_insert (FileBrowserNodeDir *dir,
+			      gint                pos,
+			      FileBrowserNode    *child)
+{
+	g_ptr_array_insert (dir->children, pos, child);
+	file_browser_node_dir_reindex (dir, pos);
+}
+
+static void
+file_browser_node_dir_remove (FileBrowserNodeDir *dir,
+			      FileBrowserNode    *child)
+{
+	gint pos = child->pos;
+
+	g_return_if_fail (pos < (gint)dir->children->len);
+	g_return_if_fail (g_ptr_array_index (dir->children, pos) == child);
+
+	if (pos == (gint)dir->children->len - 1)
+	{
+		/* The rows before the last child don't depend on it */
+		if (child->row)
+			file_browser_node_dir_add_rows (dir, pos, -1);
+
+		g_ptr_array_remove_index (dir->children, pos);
+	}
+	else
+	{
+		g_ptr_array_remove_index (dir->children, pos);
+		file_browser_node_dir_reindex (dir, pos);
+	}
+}
+
+/* Must be called each time the inserted state or the visibility flags of
+ * @node change. */
+static void
+file_browser_node_update_row (FileBrowserNode *node)
+{
+	gboolean row = file_browser_node_is_row (node);
+
+	if (row == node->row)
+		return;
+
+	node->row = row;
+
+	if (node->parent != NULL)
+		file_browser_node_dir_add_rows (FILE_BROWSER_NODE_DIR (node->parent), node->pos, row ? 1 : -1);
+}
+
+static gint
+model_sort_nodes (gconstpointer a,
+		  gconstpointer b,
+		  gpointer      user_data)
 {
-	return node == model->priv->virtual_root ||
-	       (model_node_visibility (model, node) && node->inserted);
+	GeditFileBrowserStore *model = (GeditFileBrowserStore *)user_data;
+
+	return model->priv->sort_func (*(FileBrowserNode **)a, *(FileBrowserNode **)b);
 }
 
 /* Interface implementation */
@@ -578,32 +857,13 @@ gedit_file_browser_store_get_iter (GtkTreeModel *tree_model,
 
 	for (guint i = 0; i < depth; ++i)
 	{
-		GSList *item;
-		gint num = 0;
-
 		if (node == NULL)
 			return FALSE;
 
 		if (!NODE_IS_DIR (node))
 			return FALSE;
 
-		for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-		{
-			FileBrowserNode *child = (FileBrowserNode *)(item->data);
-
-			if (model_node_inserted (model, child))
-			{
-				if (num == indices[i])
-					break;
-
-				num++;
-			}
-		}
-
-		if (item == NULL)
-			return FALSE;
-
-		node = (FileBrowserNode *)(item->data);
+		node = file_browser_node_dir_nth_row (FILE_BROWSER_NODE_DIR (node), indices[i]);
 	}
 
 	iter->user_data = node;
@@ -618,7 +878,6 @@ gedit_file_browser_store_get_path_real (GeditFileBrowserStore *model,
 					FileBrowserNode       *node)
 {
 	GtkTreePath *path = gtk_tree_path_new ();
-	gint num = 0;
 
 	while (node != model->priv->virtual_root)
 	{
@@ -628,32 +887,20 @@ gedit_file_browser_store_get_path_real (GeditFileBrowserStore *model,
 			return NULL;
 		}
 
-		num = 0;
-
-		for (GSList *item = FILE_BROWSER_NODE_DIR (node->parent)->children; item; item = item->next)
+		if (NODE_IS_DUMMY (node) ? NODE_IS_HIDDEN (node) : NODE_IS_FILTERED (node))
 		{
-			FileBrowserNode *check = (FileBrowserNode *)(item->data);
-
-			if (model_node_visibility (model, check) && (check == node || check->inserted))
-			{
-				if (check == node)
-				{
-					gtk_tree_path_prepend_index (path, num);
-					break;
-				}
+			if (NODE_IS_DUMMY (node))
+				g_warning ("Dummy not visible???");
 
-				++num;
-			}
-			else if (check == node)
-			{
-				if (NODE_IS_DUMMY (node))
-					g_warning ("Dummy not visible???");
-
-				gtk_tree_path_free (path);
-				return NULL;
-			}
+			gtk_tree_path_free (path);
+			return NULL;
 		}
 
+		/* The node itself does not need to be inserted yet */
+		gtk_tree_path_prepend_index (path,
+					     file_browser_node_dir_rows_before (FILE_BROWSER_NODE_DIR (node->parent),
+										node->pos));
+
 		node = node->parent;
 	}
 
@@ -720,32 +967,27 @@ static gboolean
 gedit_file_browser_store_iter_next (GtkTreeModel *tree_model,
 				    GtkTreeIter  *iter)
 {
-	GeditFileBrowserStore *model;
 	FileBrowserNode *node;
-	GSList *first;
+	FileBrowserNodeDir *dir;
+	FileBrowserNode *next;
 
 	g_return_val_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model), FALSE);
 	g_return_val_if_fail (iter != NULL, FALSE);
 	g_return_val_if_fail (iter->user_data != NULL, FALSE);
 
-	model = GEDIT_FILE_BROWSER_STORE (tree_model);
 	node = (FileBrowserNode *)(iter->user_data);
 
 	if (node->parent == NULL)
 		return FALSE;
 
-	first = g_slist_next (g_slist_find (FILE_BROWSER_NODE_DIR (node->parent)->children, node));
+	dir = FILE_BROWSER_NODE_DIR (node->parent);
+	next = file_browser_node_dir_nth_row (dir, file_browser_node_dir_rows_before (dir, node->pos + 1));
 
-	for (GSList *item = first; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *)(item->data)))
-		{
-			iter->user_data = item->data;
-			return TRUE;
-		}
-	}
+	if (next == NULL)
+		return FALSE;
 
-	return FALSE;
+	iter->user_data = next;
+	return TRUE;
 }
 
 static gboolean
@@ -772,16 +1014,13 @@ gedit_file_browser_store_iter_children (GtkTreeModel *tree_model,
 	if (!NODE_IS_DIR (node))
 		return FALSE;
 
-	for (GSList *item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *)(item->data)))
-		{
-			iter->user_data = item->data;
-			return TRUE;
-		}
-	}
+	node = file_browser_node_dir_nth_row (FILE_BROWSER_NODE_DIR (node), 0);
 
-	return FALSE;
+	if (node == NULL)
+		return FALSE;
+
+	iter->user_data = node;
+	return TRUE;
 }
 
 static gboolean
@@ -791,13 +1030,7 @@ filter_tree_model_iter_has_child_real (GeditFileBrowserStore *model,
 	if (!NODE_IS_DIR (node))
 		return FALSE;
 
-	for (GSList *item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *)(item->data)))
-			return TRUE;
-	}
-
-	return FALSE;
+	return FILE_BROWSER_NODE_DIR (node)->n_rows > 0;
 }
 
 static gboolean
@@ -826,7 +1059,6 @@ gedit_file_browser_store_iter_n_children (GtkTreeModel *tree_model,
 {
 	FileBrowserNode *node;
 	GeditFileBrowserStore *model;
-	gint num = 0;
 
 	g_return_val_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model), FALSE);
 	g_return_val_if_fail (iter == NULL || iter->user_data != NULL, FALSE);
@@ -841,13 +1073,7 @@ gedit_file_browser_store_iter_n_children (GtkTreeModel *tree_model,
 	if (!NODE_IS_DIR (node))
 		return 0;
 
-	for (GSList *item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *)(item->data)))
-			++num;
-	}
-
-	return num;
+	return FILE_BROWSER_NODE_DIR (node)->n_rows;
 }
 
 static gboolean
@@ -858,7 +1084,6 @@ gedit_file_browser_store_iter_nth_child (GtkTreeModel *tree_model,
 {
 	FileBrowserNode *node;
 	GeditFileBrowserStore *model;
-	gint num = 0;
 
 	g_return_val_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model), FALSE);
 	g_return_val_if_fail (parent == NULL || parent->user_data != NULL, FALSE);
@@ -873,21 +1098,13 @@ gedit_file_browser_store_iter_nth_child (GtkTreeModel *tree_model,
 	if (!NODE_IS_DIR (node))
 		return FALSE;
 
-	for (GSList *item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *)(item->data)))
-		{
-			if (num == n)
-			{
-				iter->user_data = item->data;
-				return TRUE;
-			}
+	node = file_browser_node_dir_nth_row (FILE_BROWSER_NODE_DIR (node), n);
 
-			++num;
-		}
-	}
+	if (node == NULL)
+		return FALSE;
 
-	return FALSE;
+	iter->user_data = node;
+	return TRUE;
 }
 
 static gboolean
@@ -923,6 +1140,7 @@ gedit_file_browser_store_row_inserted (GtkTreeModel *tree_model,
 	FileBrowserNode *node = (FileBrowserNode *)(iter->user_data);
 
 	node->inserted = TRUE;
+	file_browser_node_update_row (node);
 }
 
 static gboolean
@@ -1002,8 +1220,8 @@ model_end_loading (GeditFileBrowserStore *model,
 }
 
 static void
-model_node_update_visibility (GeditFileBrowserStore *model,
-			      FileBrowserNode       *node)
+model_node_update_filtered (GeditFileBrowserStore *model,
+			    FileBrowserNode       *node)
 {
 	GtkTreeIter iter;
 
@@ -1023,24 +1241,12 @@ model_node_update_visibility (GeditFileBrowserStore *model,
 			node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
 			return;
 		}
-		else if (model->priv->binary_patterns != NULL)
+		else if (model->priv->binary_patterns != NULL &&
+			 gedit_file_browser_utils_name_matches_patterns (model->priv->binary_pattern_specs,
+									 node->name))
 		{
-			gssize name_length = strlen (node->name);
-			gchar *name_reversed = g_utf8_strreverse (node->name, name_length);
-
-			for (guint i = 0; i < model->priv->binary_pattern_specs->len; ++i)
-			{
-				GPatternSpec *spec = g_ptr_array_index (model->priv->binary_pattern_specs, i);
-
-				if (g_pattern_match (spec, name_length, node->name, name_reversed))
-				{
-					node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
-					g_free (name_reversed);
-					return;
-				}
-			}
-
-			g_free (name_reversed);
+			node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
+			return;
 		}
 	}
 
@@ -1053,6 +1259,14 @@ model_node_update_visibility (GeditFileBrowserStore *model,
 	}
 }
 
+static void
+model_node_update_visibility (GeditFileBrowserStore *model,
+			      FileBrowserNode       *node)
+{
+	model_node_update_filtered (model, node);
+	file_browser_node_update_row (node);
+}
+
 static gint
 collate_nodes (FileBrowserNode *node1,
 	       FileBrowserNode *node2)
@@ -1067,14 +1281,14 @@ collate_nodes (FileBrowserNode *node1,
 	}
 	else
 	{
-		gchar *k1 = g_utf8_collate_key_for_filename (node1->name, -1);
-		gchar *k2 = g_utf8_collate_key_for_filename (node2->name, -1);
-		gint result = strcmp (k1, k2);
+		/* The keys are only computed once per name */
+		if (node1->collate_key == NULL)
+			node1->collate_key = g_utf8_collate_key_for_filename (node1->name, -1);
 
-		g_free (k1);
-		g_free (k2);
+		if (node2->collate_key == NULL)
+			node2->collate_key = g_utf8_collate_key_for_filename (node2->name, -1);
 
-		return result;
+		return strcmp (node1->collate_key, node2->collate_key);
 	}
 }
 
@@ -1108,37 +1322,44 @@ model_resort_node (GeditFileBrowserStore *model,
 	if (!model_node_visibility (model, node->parent))
 	{
 		/* Just sort the children of the parent */
-		dir->children = g_slist_sort (dir->children, (GCompareFunc)(model->priv->sort_func));
+		g_ptr_array_sort_with_data (dir->children, model_sort_nodes, model);
+		file_browser_node_dir_reindex (dir, 0);
 	}
 	else
 	{
 		GtkTreeIter iter;
 		GtkTreePath *path;
+		gint *oldorder;
 		gint *neworder;
 		gint pos = 0;
 
 		/* Store current positions */
-		for (GSList *item = dir->children; item; item = item->next)
+		oldorder = g_new (gint, dir->children->len);
+
+		for (guint i = 0; i < dir->children->len; ++i)
 		{
-			FileBrowserNode *child = (FileBrowserNode *)(item->data);
+			FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
 
 			if (model_node_visibility (model, child))
-				child->pos = pos++;
+				oldorder[i] = pos++;
 		}
 
-		dir->children = g_slist_sort (dir->children, (GCompareFunc)(model->priv->sort_func));
+		g_ptr_array_sort_with_data (dir->children, model_sort_nodes, model);
 		neworder = g_new (gint, pos);
 		pos = 0;
 
 		/* Store the new positions */
-		for (GSList *item = dir->children; item; item = item->next)
+		for (guint i = 0; i < dir->children->len; ++i)
 		{
-			FileBrowserNode *child = (FileBrowserNode *)(item->data);
+			FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
 
 			if (model_node_visibility (model, child))
-				neworder[pos++] = child->pos;
+				neworder[pos++] = oldorder[child->pos];
 		}
 
+		g_free (oldorder);
+		file_browser_node_dir_reindex (dir, 0);
+
 		iter.user_data = node->parent;
 		path = gedit_file_browser_store_get_path_real (model, node->parent);
 
@@ -1209,6 +1430,7 @@ row_deleted (GeditFileBrowserStore *model,
 
 	hidden = FILE_IS_HIDDEN (node->flags);
 	node->flags &= ~GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
+	file_browser_node_update_row (node);
 
 	/* Create temporary copies of the path as the signals may alter it */
 
@@ -1221,6 +1443,8 @@ row_deleted (GeditFileBrowserStore *model,
 	if (hidden)
 		node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
 
+	file_browser_node_update_row (node);
+
 	copy = gtk_tree_path_copy (path);
 	gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), copy);
 	gtk_tree_path_free (copy);
@@ -1234,7 +1458,6 @@ model_refilter_node (GeditFileBrowserStore  *model,
 	gboolean old_visible;
 	gboolean new_visible;
 	FileBrowserNodeDir *dir;
-	GSList *item;
 	GtkTreeIter iter;
 	GtkTreePath *tmppath = NULL;
 	gboolean in_tree;
@@ -1264,8 +1487,8 @@ model_refilter_node (GeditFileBrowserStore  *model,
 
 		dir = FILE_BROWSER_NODE_DIR (node);
 
-		for (item = dir->children; item; item = item->next)
-			model_refilter_node (model, (FileBrowserNode *)(item->data), path);
+		for (guint i = 0; i < dir->children->len; ++i)
+			model_refilter_node (model, (FileBrowserNode *)g_ptr_array_index (dir->children, i), path);
 
 		if (in_tree)
 			gtk_tree_path_up (*path);
@@ -1311,6 +1534,7 @@ file_browser_node_set_name (FileBrowserNode *node)
 {
 	g_free (node->name);
 	g_free (node->markup);
+	g_clear_pointer (&node->collate_key, g_free);
 
 	if (node->file)
 		node->name = gedit_file_browser_utils_file_basename (node->file);
@@ -1358,6 +1582,8 @@ file_browser_node_dir_new (GeditFileBrowserStore *model,
 
 	node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_DIRECTORY;
 
+	FILE_BROWSER_NODE_DIR (node)->children = g_ptr_array_new ();
+	FILE_BROWSER_NODE_DIR (node)->rows = g_new0 (gint, 1);
 	FILE_BROWSER_NODE_DIR (node)->model = model;
 
 	return node;
@@ -1367,19 +1593,60 @@ static void
 file_browser_node_free_children (GeditFileBrowserStore *model,
 				 FileBrowserNode       *node)
 {
+	FileBrowserNodeDir *dir;
+	GPtrArray *children;
+
 	if (node == NULL || !NODE_IS_DIR (node))
 		return;
 
-	for (GSList *item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-		file_browser_node_free (model, (FileBrowserNode *)(item->data));
+	dir = FILE_BROWSER_NODE_DIR (node);
+	children = dir->children;
+
+	dir->children = g_ptr_array_new ();
+	file_browser_node_dir_reindex (dir, 0);
 
-	g_slist_free (FILE_BROWSER_NODE_DIR (node)->children);
-	FILE_BROWSER_NODE_DIR (node)->children = NULL;
+	for (guint i = 0; i < children->len; ++i)
+		file_browser_node_free (model, (FileBrowserNode *)g_ptr_array_index (children, i));
+
+	g_ptr_array_unref (children);
 
 	/* This node is no longer loaded */
 	node->flags &= ~GEDIT_FILE_BROWSER_STORE_FLAG_LOADED;
 }
 
+static void
+file_browser_node_dir_stop_monitor (FileBrowserNodeDir *dir)
+{
+	if (dir->monitor)
+	{
+		g_file_monitor_cancel (dir->monitor);
+		g_object_unref (dir->monitor);
+
+		dir->monitor = NULL;
+	}
+
+	if (dir->events_id != 0)
+	{
+		g_source_remove (dir->events_id);
+		dir->events_id = 0;
+	}
+
+	if (dir->events_cancellable != NULL)
+	{
+		g_cancellable_cancel (dir->events_cancellable);
+		g_clear_object (&dir->events_cancellable);
+	}
+
+	if (dir->events != NULL)
+		g_hash_table_remove_all (dir->events);
+
+	if (dir->resume_monitor_id != 0)
+	{
+		g_source_remove (dir->resume_monitor_id);
+		dir->resume_monitor_id = 0;
+	}
+}
+
 static void
 file_browser_node_free (GeditFileBrowserStore *model,
 			FileBrowserNode       *node)
@@ -1396,16 +1663,18 @@ file_browser_node_free (GeditFileBrowserStore *model,
 			g_cancellable_cancel (dir->cancellable);
 			g_object_unref (dir->cancellable);
 
-			model_end_loading (model, node);
+			if (!dir->prefetching)
+				model_end_loading (model, node);
 		}
 
 		file_browser_node_free_children (model, node);
+		file_browser_node_dir_stop_monitor (dir);
 
-		if (dir->monitor)
-		{
-			g_file_monitor_cancel (dir->monitor);
-			g_object_unref (dir->monitor);
-		}
+		if (dir->events != NULL)
+			g_hash_table_unref (dir->events);
+
+		g_ptr_array_unref (dir->children);
+		g_free (dir->rows);
 	}
 
 	if (node->file)
@@ -1422,6 +1691,7 @@ file_browser_node_free (GeditFileBrowserStore *model,
 
 	g_free (node->icon_name);
 	g_free (node->name);
+	g_free (node->collate_key);
 	g_free (node->markup);
 
 	if (NODE_IS_DIR (node))
@@ -1449,14 +1719,15 @@ model_remove_node_children (GeditFileBrowserStore *model,
 {
 	FileBrowserNodeDir *dir;
 	GtkTreePath *path_child;
-	GSList *list;
+	GPtrArray *copy;
+	guint first = 0;
 
 	if (node == NULL || !NODE_IS_DIR (node))
 		return;
 
 	dir = FILE_BROWSER_NODE_DIR (node);
 
-	if (dir->children == NULL)
+	if (dir->children->len == 0)
 		return;
 
 	if (!model_node_visibility (model, node))
@@ -1475,12 +1746,20 @@ model_remove_node_children (GeditFileBrowserStore *model,
 
 	gtk_tree_path_down (path_child);
 
-	list = g_slist_copy (dir->children);
+	copy = g_ptr_array_copy (dir->children, NULL, NULL);
 
-	for (GSList *item = list; item; item = item->next)
-		model_remove_node (model, (FileBrowserNode *)(item->data), path_child, free_nodes);
+	/* Remove the dummy first, and then the other children from the
+	   end, so that the children still to be removed are not moved */
+	if (NODE_IS_DUMMY ((FileBrowserNode *)g_ptr_array_index (copy, 0)))
+	{
+		model_remove_node (model, (FileBrowserNode *)g_ptr_array_index (copy, 0), path_child, free_nodes);
+		first = 1;
+	}
 
-	g_slist_free (list);
+	for (guint i = copy->len; i > first; --i)
+		model_remove_node (model, (FileBrowserNode *)g_ptr_array_index (copy, i - 1), NULL, free_nodes);
+
+	g_ptr_array_unref (copy);
 	gtk_tree_path_free (path_child);
 }
 
@@ -1524,8 +1803,7 @@ model_remove_node (GeditFileBrowserStore *model,
 
 	/* Remove the node from the parents children list */
 	if (free_nodes && parent)
-		FILE_BROWSER_NODE_DIR (node->parent)->children =
-			g_slist_remove (FILE_BROWSER_NODE_DIR (node->parent)->children, node);
+		file_browser_node_dir_remove (FILE_BROWSER_NODE_DIR (parent), node);
 
 	/* If this is the virtual root, than set the parent as the virtual root */
 	if (node == model->priv->virtual_root)
@@ -1538,48 +1816,117 @@ model_remove_node (GeditFileBrowserStore *model,
 		file_browser_node_free (model, node);
 }
 
-/**
- * model_clear:
- * @model: the #GeditFileBrowserStore
- * @free_nodes: whether to also remove the nodes from memory
- *
- * Removes all nodes from the model. This function is used
- * to remove all the nodes from the _model_. Don't use it to just free the
- * nodes in the model.
- */
+/* Removes and frees the @nodes children of @parent, which must be in the
+ * order of the children. The rows are deleted from the last one so that
+ * the paths of the others don't change, and the children are compacted
+ * once instead of once per node. */
 static void
-model_clear (GeditFileBrowserStore *model,
-	     gboolean               free_nodes)
+model_remove_nodes_batch (GeditFileBrowserStore *model,
+			  FileBrowserNode       *parent,
+			  GPtrArray             *nodes)
 {
-	GtkTreePath *path = gtk_tree_path_new ();
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
+	gint first;
+	gint j;
+	guint k = 0;
 
-	model_remove_node_children (model, model->priv->virtual_root, path, free_nodes);
-	gtk_tree_path_free (path);
+	if (nodes->len == 0)
+		return;
 
-	/* Remove the dummy if there is one */
-	if (model->priv->virtual_root)
+	/* Removing the virtual root changes it */
+	for (guint i = 0; i < nodes->len; ++i)
 	{
-		FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (model->priv->virtual_root);
+		FileBrowserNode *node = (FileBrowserNode *)g_ptr_array_index (nodes, i);
 
-		if (dir->children != NULL)
+		if (node == model->priv->virtual_root ||
+		    node_has_parent (model->priv->virtual_root, node))
 		{
-			FileBrowserNode *dummy = (FileBrowserNode *)(dir->children->data);
+			for (guint l = nodes->len; l > 0; --l)
+				model_remove_node (model, (FileBrowserNode *)g_ptr_array_index (nodes, l - 1), NULL, TRUE);
 
-			if (NODE_IS_DUMMY (dummy) && model_node_visibility (model, dummy))
-			{
-				path = gtk_tree_path_new_first ();
-				row_deleted (model, dummy, path);
-				gtk_tree_path_free (path);
-			}
+			return;
 		}
 	}
-}
 
-static void
-file_browser_node_unload (GeditFileBrowserStore *model,
-			  FileBrowserNode       *node,
-			  gboolean               remove_children)
-{
+	for (guint i = nodes->len; i > 0; --i)
+	{
+		FileBrowserNode *node = (FileBrowserNode *)g_ptr_array_index (nodes, i - 1);
+		GtkTreePath *path = gedit_file_browser_store_get_path_real (model, node);
+
+		model_remove_node_children (model, node, path, TRUE);
+
+		if (path != NULL && model_node_visibility (model, node))
+			row_deleted (model, node, path);
+
+		if (path != NULL)
+			gtk_tree_path_free (path);
+	}
+
+	first = ((FileBrowserNode *)g_ptr_array_index (nodes, 0))->pos;
+	j = first;
+
+	for (guint i = first; i < dir->children->len; ++i)
+	{
+		FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
+
+		if (k < nodes->len && child == g_ptr_array_index (nodes, k))
+			++k;
+		else
+			dir->children->pdata[j++] = child;
+	}
+
+	g_ptr_array_set_size (dir->children, j);
+	file_browser_node_dir_reindex (dir, first);
+
+	for (guint i = 0; i < nodes->len; ++i)
+		file_browser_node_free (model, (FileBrowserNode *)g_ptr_array_index (nodes, i));
+
+	if (model_node_visibility (model, parent))
+		model_check_dummy (model, parent);
+}
+
+/**
+ * model_clear:
+ * @model: the #GeditFileBrowserStore
+ * @free_nodes: whether to also remove the nodes from memory
+ *
+ * Removes all nodes from the model. This function is used
+ * to remove all the nodes from the _model_. Don't use it to just free the
+ * nodes in the model.
+ */
+static void
+model_clear (GeditFileBrowserStore *model,
+	     gboolean               free_nodes)
+{
+	GtkTreePath *path = gtk_tree_path_new ();
+
+	model_remove_node_children (model, model->priv->virtual_root, path, free_nodes);
+	gtk_tree_path_free (path);
+
+	/* Remove the dummy if there is one */
+	if (model->priv->virtual_root)
+	{
+		FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (model->priv->virtual_root);
+
+		if (dir->children->len > 0)
+		{
+			FileBrowserNode *dummy = (FileBrowserNode *)g_ptr_array_index (dir->children, 0);
+
+			if (NODE_IS_DUMMY (dummy) && model_node_visibility (model, dummy))
+			{
+				path = gtk_tree_path_new_first ();
+				row_deleted (model, dummy, path);
+				gtk_tree_path_free (path);
+			}
+		}
+	}
+}
+
+static void
+file_browser_node_unload (GeditFileBrowserStore *model,
+			  FileBrowserNode       *node,
+			  gboolean               remove_children)
+{
 	FileBrowserNodeDir *dir;
 
 	if (node == NULL)
@@ -1598,17 +1945,14 @@ file_browser_node_unload (GeditFileBrowserStore *model,
 		g_cancellable_cancel (dir->cancellable);
 		g_object_unref (dir->cancellable);
 
-		model_end_loading (model, node);
+		if (!dir->prefetching)
+			model_end_loading (model, node);
+
 		dir->cancellable = NULL;
+		dir->prefetching = FALSE;
 	}
 
-	if (dir->monitor)
-	{
-		g_file_monitor_cancel (dir->monitor);
-		g_object_unref (dir->monitor);
-
-		dir->monitor = NULL;
-	}
+	file_browser_node_dir_stop_monitor (dir);
 
 	node->flags &= ~GEDIT_FILE_BROWSER_STORE_FLAG_LOADED;
 }
@@ -1736,23 +2080,24 @@ model_check_dummy (GeditFileBrowserStore *model,
 		GtkTreePath *path;
 		guint flags;
 
-		if (dir->children == NULL)
+		if (dir->children->len == 0)
 		{
 			model_add_dummy_node (model, node);
 			return;
 		}
 
-		dummy = (FileBrowserNode *)(dir->children->data);
+		dummy = (FileBrowserNode *)g_ptr_array_index (dir->children, 0);
 
 		if (!NODE_IS_DUMMY (dummy))
 		{
 			dummy = model_create_dummy_node (model, node);
-			dir->children = g_slist_prepend (dir->children, dummy);
+			file_browser_node_dir_insert (dir, 0, dummy);
 		}
 
 		if (!model_node_visibility (model, node))
 		{
 			dummy->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
+			file_browser_node_update_row (dummy);
 			return;
 		}
 
@@ -1760,10 +2105,12 @@ model_check_dummy (GeditFileBrowserStore *model,
 		   for real children */
 		flags = dummy->flags;
 		dummy->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
+		file_browser_node_update_row (dummy);
 
 		if (!filter_tree_model_iter_has_child_real (model, node))
 		{
 			dummy->flags &= ~GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
+			file_browser_node_update_row (dummy);
 
 			if (FILE_IS_HIDDEN (flags))
 			{
@@ -1796,11 +2143,21 @@ insert_node_sorted (GeditFileBrowserStore *model,
 		    FileBrowserNode       *parent)
 {
 	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
+	gint low = 0;
+	gint high = dir->children->len;
 
-	if (model->priv->sort_func == NULL)
-		dir->children = g_slist_append (dir->children, child);
-	else
-		dir->children = g_slist_insert_sorted (dir->children, child, (GCompareFunc)(model->priv->sort_func));
+	/* Insert after the children which are not sorted after child */
+	while (model->priv->sort_func != NULL && low < high)
+	{
+		gint mid = low + (high - low) / 2;
+
+		if (model->priv->sort_func (g_ptr_array_index (dir->children, mid), child) > 0)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	file_browser_node_dir_insert (dir, low, child);
 }
 
 static void
@@ -1830,88 +2187,82 @@ model_add_node (GeditFileBrowserStore *model,
 
 static void
 model_add_nodes_batch (GeditFileBrowserStore *model,
-		       GSList                *children,
+		       GPtrArray             *nodes,
 		       FileBrowserNode       *parent)
 {
 	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
-	GSList *sorted_children = g_slist_sort (children, (GCompareFunc)model->priv->sort_func);
-	GSList *child = sorted_children;
-	GSList *prev = NULL;
-	GSList *l = dir->children;
+	GPtrArray *children;
+	guint i = 0;
+	guint j = 0;
+
+	g_ptr_array_sort_with_data (nodes, model_sort_nodes, model);
 
 	model_check_dummy (model, parent);
 
-	while (child)
-	{
-		FileBrowserNode *node = child->data;
-		GtkTreeIter iter;
-		GtkTreePath *path;
+	/* Merge the sorted nodes into the children */
+	children = g_ptr_array_sized_new (dir->children->len + nodes->len);
 
-		/* Reached the end of the first list, just append the second */
-		if (l == NULL)
+	while (i < dir->children->len && j < nodes->len)
+	{
+		if (model->priv->sort_func (g_ptr_array_index (dir->children, i),
+					    g_ptr_array_index (nodes, j)) > 0)
 		{
-			dir->children = g_slist_concat (dir->children, child);
+			g_ptr_array_add (children, g_ptr_array_index (nodes, j++));
+		}
+		else
+		{
+			g_ptr_array_add (children, g_ptr_array_index (dir->children, i++));
+		}
+	}
 
-			for (l = child; l; l = l->next)
-			{
-				if (model_node_visibility (model, parent) &&
-				    model_node_visibility (model, l->data))
-				{
-					iter.user_data = l->data;
-					path = gedit_file_browser_store_get_path_real (model, l->data);
+	for (; i < dir->children->len; ++i)
+		g_ptr_array_add (children, g_ptr_array_index (dir->children, i));
 
-					/* Emit row inserted */
-					row_inserted (model, &path, &iter);
-					gtk_tree_path_free (path);
-				}
+	for (; j < nodes->len; ++j)
+		g_ptr_array_add (children, g_ptr_array_index (nodes, j));
 
-				model_check_dummy (model, l->data);
-			}
+	g_ptr_array_unref (dir->children);
+	dir->children = children;
+	file_browser_node_dir_reindex (dir, 0);
 
-			break;
-		}
+	/* The new nodes only become rows once inserted, so the paths of the
+	   ones inserted before don't depend on the ones after */
+	for (j = 0; j < nodes->len; ++j)
+	{
+		FileBrowserNode *node = (FileBrowserNode *)g_ptr_array_index (nodes, j);
 
-		if (model->priv->sort_func (l->data, node) > 0)
+		if (model_node_visibility (model, parent) &&
+		    model_node_visibility (model, node))
 		{
-			GSList *next_child;
+			GtkTreeIter iter;
+			GtkTreePath *path;
 
-			if (prev == NULL)
-			{
-				/* Prepend to the list */
-				dir->children = g_slist_prepend (dir->children, child);
-			}
-			else
-			{
-				prev->next = child;
-			}
+			iter.user_data = node;
+			path = gedit_file_browser_store_get_path_real (model, node);
 
-			next_child = child->next;
-			prev = child;
-			child->next = l;
-			child = next_child;
+			/* The path is not used afterwards, so it doesn't
+			   need to be tracked like in row_inserted() */
+			gtk_tree_model_row_inserted (GTK_TREE_MODEL (model), path, &iter);
+			gtk_tree_path_free (path);
+		}
 
-			if (model_node_visibility (model, parent) &&
-			    model_node_visibility (model, node))
-			{
-				iter.user_data = node;
-				path = gedit_file_browser_store_get_path_real (model, node);
+		model_check_dummy (model, node);
+	}
+}
 
-				/* Emit row inserted */
-				row_inserted (model, &path, &iter);
-				gtk_tree_path_free (path);
-			}
+/* Only the fast content type is queried, guessed from the name, so that
+ * listing a directory doesn't read every file. The infos made from the
+ * nodes and read from the listing cache have a content type instead. */
+static gchar const *
+file_info_get_content_type (GFileInfo *info)
+{
+	if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE))
+		return g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
 
-			model_check_dummy (model, node);
+	if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE))
+		return g_file_info_get_content_type (info);
 
-			/* Try again at the same l position with the next child */
-		}
-		else
-		{
-			/* Move to the next item in the list */
-			prev = l;
-			l = l->next;
-		}
-	}
+	return NULL;
 }
 
 static gchar const *
@@ -1922,7 +2273,7 @@ backup_content_type (GFileInfo *info)
 	if (!g_file_info_get_is_backup (info))
 		return NULL;
 
-	content = g_file_info_get_content_type (info);
+	content = file_info_get_content_type (info);
 
 	if (!content || g_content_type_equals (content, "application/x-trash"))
 		return "text/plain";
@@ -1930,34 +2281,6 @@ backup_content_type (GFileInfo *info)
 	return content;
 }
 
-static gboolean
-content_type_is_text (gchar const *content_type)
-{
-#ifdef G_OS_WIN32
-	gchar *mime;
-	gboolean ret;
-#endif
-
-	if (!content_type || g_content_type_is_unknown (content_type))
-		return TRUE;
-
-#ifndef G_OS_WIN32
-	return g_content_type_is_a (content_type, "text/plain");
-#else
-	if (g_content_type_is_a (content_type, "text"))
-		return TRUE;
-
-	/* This covers a rare case in which on Windows the PerceivedType is
-	   not set to "text" but the Content Type is set to text/plain */
-	mime = g_content_type_get_mime_type (content_type);
-	ret = g_strcmp0 (mime, "text/plain");
-
-	g_free (mime);
-
-	return ret;
-#endif
-}
-
 static void
 file_browser_node_set_from_info (GeditFileBrowserStore *model,
 				 FileBrowserNode       *node,
@@ -1997,18 +2320,16 @@ file_browser_node_set_from_info (GeditFileBrowserStore *model,
 	if (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info))
 		node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
 
+	if (!(content = backup_content_type (info)))
+		content = file_info_get_content_type (info);
+
+	/* Kept for the listing cache */
+	node->content_type = g_intern_string (content);
+
 	if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
-	{
 		node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_DIRECTORY;
-	}
-	else
-	{
-		if (!(content = backup_content_type (info)))
-			content = g_file_info_get_content_type (info);
-
-		if (content_type_is_text (content))
-			node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_TEXT;
-	}
+	else if (gedit_file_browser_utils_content_type_is_text (content))
+		node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_TEXT;
 
 	model_recomposite_icon_real (model, node, info);
 
@@ -2030,12 +2351,12 @@ file_browser_node_set_from_info (GeditFileBrowserStore *model,
 }
 
 static FileBrowserNode *
-node_list_contains_file (GSList *children,
-			 GFile  *file)
+node_list_contains_file (GPtrArray *children,
+			 GFile     *file)
 {
-	for (GSList *item = children; item; item = item->next)
+	for (guint i = 0; i < children->len; ++i)
 	{
-		FileBrowserNode *node = (FileBrowserNode *)(item->data);
+		FileBrowserNode *node = (FileBrowserNode *)g_ptr_array_index (children, i);
 
 		if (node->file != NULL && g_file_equal (node->file, file))
 			return node;
@@ -2093,16 +2414,39 @@ model_add_node_from_file (GeditFileBrowserStore *model,
 	return node;
 }
 
-/* We pass in a copy of the list of parent->children so that we do
- * not have to check if a file already exists among the ones we just
- * added */
+/* Whether the cached info of a child is still up to date */
+static gboolean
+cached_info_equal (GFileInfo *cached,
+		   GFileInfo *info)
+{
+	gchar const *content;
+
+	if ((g_file_info_get_file_type (cached) == G_FILE_TYPE_DIRECTORY) !=
+	    (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY))
+		return FALSE;
+
+	if (g_file_info_get_is_hidden (cached) !=
+	    (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info)))
+		return FALSE;
+
+	if (!(content = backup_content_type (info)))
+		content = file_info_get_content_type (info);
+
+	return g_strcmp0 (file_info_get_content_type (cached), content) == 0;
+}
+
+/* We pass in the set of the files of parent->children before the
+ * load so that we do not have to check if a file already exists
+ * among the ones we just added. The children shown from the listing
+ * cache are in @cached, they are replaced if they changed. */
 static void
 model_add_nodes_from_files (GeditFileBrowserStore *model,
 			    FileBrowserNode       *parent,
-			    GSList                *original_children,
+			    GHashTable            *original_files,
+			    GHashTable            *cached,
 			    GList                 *files)
 {
-	GSList *nodes = NULL;
+	GPtrArray *nodes = g_ptr_array_new ();
 
 	for (GList *item = files; item; item = item->next)
 	{
@@ -2133,84 +2477,660 @@ model_add_nodes_from_files (GeditFileBrowserStore *model,
 		}
 
 		file = g_file_get_child (parent->file, name);
-		if (!(node = node_list_contains_file (original_children, file)))
+
+		if (cached != NULL)
+		{
+			GFileInfo *cached_info = g_hash_table_lookup (cached, file);
+
+			if (cached_info != NULL && !cached_info_equal (cached_info, info))
+			{
+				node = node_list_contains_file (FILE_BROWSER_NODE_DIR (parent)->children, file);
+
+				if (node != NULL)
+					model_remove_node (model, node, NULL, TRUE);
+
+				g_hash_table_remove (original_files, file);
+			}
+
+			g_hash_table_remove (cached, file);
+		}
+
+		if (!g_hash_table_contains (original_files, file))
 		{
 			if (type == G_FILE_TYPE_DIRECTORY)
 				node = file_browser_node_dir_new (model, file, parent);
 			else
 				node = file_browser_node_new (file, parent);
 
-			file_browser_node_set_from_info (model, node, info, FALSE);
+			file_browser_node_set_from_info (model, node, info, FALSE);
+
+			g_ptr_array_add (nodes, node);
+		}
+
+		g_object_unref (file);
+		g_object_unref (info);
+	}
+
+	if (nodes->len > 0)
+		model_add_nodes_batch (model, nodes, parent);
+
+	g_ptr_array_unref (nodes);
+}
+
+static FileBrowserNode *
+model_add_node_from_dir (GeditFileBrowserStore *model,
+			 FileBrowserNode       *parent,
+			 GFile                 *file)
+{
+	FileBrowserNode *node;
+
+	/* Check if it already exists */
+	if ((node = node_list_contains_file (FILE_BROWSER_NODE_DIR (parent)->children, file)) == NULL)
+	{
+		node = file_browser_node_dir_new (model, file, parent);
+		file_browser_node_set_from_info (model, node, NULL, FALSE);
+
+		if (node->name == NULL)
+			file_browser_node_set_name (node);
+
+		node->icon_name = g_strdup ("folder-symbolic");
+
+		model_add_node (model, node, parent);
+	}
+
+	return node;
+}
+
+static void
+object_list_free (GList *list)
+{
+	g_list_free_full (list, g_object_unref);
+}
+
+static void
+query_created_files_thread (GTask        *task,
+			    gpointer      source_object,
+			    gpointer      task_data,
+			    GCancellable *cancellable)
+{
+	GList *files = task_data;
+	GList *infos = NULL;
+
+	for (GList *item = files; item; item = item->next)
+	{
+		GFileInfo *info;
+
+		if (g_cancellable_is_cancelled (cancellable))
+			break;
+
+		info = g_file_query_info (G_FILE (item->data),
+					  STANDARD_ATTRIBUTE_TYPES,
+					  G_FILE_QUERY_INFO_NONE,
+					  cancellable,
+					  NULL);
+
+		/* The file may be gone already */
+		if (info != NULL)
+			infos = g_list_prepend (infos, info);
+	}
+
+	g_task_return_pointer (task, infos, (GDestroyNotify)object_list_free);
+}
+
+static void
+model_query_created_files_cb (GObject         *source_object,
+			      GAsyncResult    *result,
+			      FileBrowserNode *node)
+{
+	FileBrowserNodeDir *dir;
+	GHashTable *original_files;
+	GList *infos;
+	GList *files = NULL;
+
+	/* The node may be freed */
+	if (g_cancellable_is_cancelled (g_task_get_cancellable (G_TASK (result))))
+		return;
+
+	dir = FILE_BROWSER_NODE_DIR (node);
+	infos = g_task_propagate_pointer (G_TASK (result), NULL);
+	g_clear_object (&dir->events_cancellable);
+
+	original_files = g_hash_table_new_full (g_file_hash,
+						(GEqualFunc)g_file_equal,
+						g_object_unref,
+						NULL);
+
+	for (guint i = 0; i < dir->children->len; ++i)
+	{
+		FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
+
+		if (child->file != NULL)
+			g_hash_table_add (original_files, g_object_ref (child->file));
+	}
+
+	for (GList *item = infos; item; item = item->next)
+	{
+		GFileInfo *info = G_FILE_INFO (item->data);
+		GFile *file = g_file_get_child (node->file, g_file_info_get_name (info));
+
+		/* Deleted while it was queried */
+		if (GPOINTER_TO_INT (g_hash_table_lookup (dir->events, file)) == G_FILE_MONITOR_EVENT_DELETED)
+			g_object_unref (info);
+		else
+			files = g_list_prepend (files, info);
+
+		g_object_unref (file);
+	}
+
+	/* The infos are now owned by model_add_nodes_from_files() */
+	model_add_nodes_from_files (dir->model, node, original_files, NULL, files);
+	model_check_dummy (dir->model, node);
+
+	g_list_free (files);
+	g_list_free (infos);
+	g_hash_table_unref (original_files);
+
+	/* The events received in the meantime */
+	if (g_hash_table_size (dir->events) > 0)
+		model_schedule_directory_events (node);
+}
+
+/* Applies the events gathered since the last time in one go: the deleted
+ * children are removed together, and the created files are queried in a
+ * thread and then inserted together. */
+static void
+model_apply_directory_events (GeditFileBrowserStore *model,
+			      FileBrowserNode       *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+	GHashTableIter iter;
+	gpointer file;
+	gpointer event;
+	GList *created = NULL;
+	gboolean deleted = FALSE;
+
+	gedit_debug_message (DEBUG_PLUGINS,
+			     "Applying %u changes in %s",
+			     g_hash_table_size (dir->events),
+			     node->name);
+
+	g_hash_table_iter_init (&iter, dir->events);
+
+	while (g_hash_table_iter_next (&iter, &file, &event))
+	{
+		if (GPOINTER_TO_INT (event) == G_FILE_MONITOR_EVENT_CREATED)
+			created = g_list_prepend (created, g_object_ref (file));
+		else
+			deleted = TRUE;
+	}
+
+	if (deleted)
+	{
+		GPtrArray *removed = g_ptr_array_new ();
+
+		for (guint i = 0; i < dir->children->len; ++i)
+		{
+			FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
+
+			if (child->file != NULL &&
+			    GPOINTER_TO_INT (g_hash_table_lookup (dir->events, child->file)) == G_FILE_MONITOR_EVENT_DELETED)
+			{
+				g_ptr_array_add (removed, child);
+			}
+		}
+
+		model_remove_nodes_batch (model, node, removed);
+		g_ptr_array_unref (removed);
+	}
+
+	g_hash_table_remove_all (dir->events);
+
+	if (created != NULL)
+	{
+		GTask *task;
+
+		dir->events_cancellable = g_cancellable_new ();
+
+		task = g_task_new (NULL,
+				   dir->events_cancellable,
+				   (GAsyncReadyCallback)model_query_created_files_cb,
+				   node);
+		g_task_set_task_data (task, created, (GDestroyNotify)object_list_free);
+		g_task_run_in_thread (task, query_created_files_thread);
+		g_object_unref (task);
+	}
+}
+
+static gboolean
+directory_events_cb (FileBrowserNode *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+
+	dir->events_id = 0;
+	model_apply_directory_events (dir->model, node);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+model_schedule_directory_events (FileBrowserNode *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+
+	/* The created files still being queried are applied first */
+	if (dir->events_id != 0 || dir->events_cancellable != NULL)
+		return;
+
+	dir->events_id = g_timeout_add (DIRECTORY_EVENTS_DELAY,
+					(GSourceFunc)directory_events_cb,
+					node);
+}
+
+static gboolean
+resume_monitor_cb (FileBrowserNode *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+
+	dir->resume_monitor_id = 0;
+	model_resync_directory (dir->model, node);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Stops monitoring a directory that changes too often for a while,
+ * it is listed again afterwards */
+static void
+model_pause_monitor (GeditFileBrowserStore *model,
+		     FileBrowserNode       *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+
+	gedit_debug_message (DEBUG_PLUGINS,
+			     "Too many changes in %s, not monitoring it for %d s",
+			     node->name,
+			     DIRECTORY_MONITOR_PAUSE);
+
+	file_browser_node_dir_stop_monitor (dir);
+
+	dir->resume_monitor_id = g_timeout_add_seconds (DIRECTORY_MONITOR_PAUSE,
+							(GSourceFunc)resume_monitor_cb,
+							node);
+}
+
+static void
+on_directory_monitor_event (GFileMonitor      *monitor,
+			    GFile             *file,
+			    GFile             *other_file,
+			    GFileMonitorEvent  event_type,
+			    FileBrowserNode   *parent)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
+	gint64 now;
+
+	/* Forward all the events, they are also useful for the files that
+	 * are not shown, e.g. to keep the search index up to date.
+	 */
+	g_signal_emit (dir->model, model_signals[FILE_CHANGED], 0, file, other_file, event_type);
+
+	now = g_get_monotonic_time ();
+
+	if (now - dir->events_time >= G_USEC_PER_SEC)
+	{
+		dir->events_time = now;
+		dir->n_events = 0;
+	}
+
+	if (++dir->n_events > DIRECTORY_EVENTS_MAX_RATE && dir->model->priv->pause_busy_directories)
+	{
+		model_pause_monitor (dir->model, parent);
+		return;
+	}
+
+	/* The changes of the content don't change the listing */
+	if (event_type != G_FILE_MONITOR_EVENT_CREATED &&
+	    event_type != G_FILE_MONITOR_EVENT_DELETED)
+		return;
+
+	if (dir->events == NULL)
+	{
+		dir->events = g_hash_table_new_full (g_file_hash,
+						     (GEqualFunc)g_file_equal,
+						     g_object_unref,
+						     NULL);
+	}
+
+	/* Only the last event of a file matters */
+	g_hash_table_replace (dir->events, g_object_ref (file), GINT_TO_POINTER (event_type));
+	model_schedule_directory_events (parent);
+}
+
+static void
+async_node_free (AsyncNode *async)
+{
+	g_object_unref (async->cancellable);
+	g_hash_table_unref (async->original_files);
+
+	if (async->cached != NULL)
+		g_hash_table_unref (async->cached);
+
+	if (async->flush_id != 0)
+		g_source_remove (async->flush_id);
+
+	g_queue_clear_full (&async->files, g_object_unref);
+	g_slice_free (AsyncNode, async);
+}
+
+static AsyncNode *
+async_node_new (FileBrowserNodeDir *dir,
+		gint                io_priority)
+{
+	AsyncNode *async;
+
+	async = g_slice_new0 (AsyncNode);
+	async->dir = dir;
+	async->cancellable = g_object_ref (dir->cancellable);
+	async->n_items = DIRECTORY_LOAD_ITEMS_MIN;
+	async->io_priority = io_priority;
+	async->start_time = g_get_monotonic_time ();
+	async->original_files = g_hash_table_new_full (g_file_hash,
+						       (GEqualFunc)g_file_equal,
+						       g_object_unref,
+						       NULL);
+
+	for (guint i = 0; i < dir->children->len; ++i)
+	{
+		FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
+
+		if (child->file != NULL)
+			g_hash_table_add (async->original_files, g_object_ref (child->file));
+	}
+
+	return async;
+}
+
+/* Must not be called once the load is cancelled, the directory may be
+ * gone */
+static gint
+async_node_get_io_priority (AsyncNode *async)
+{
+	/* A background load is no longer one once its directory is shown */
+	if (!async->dir->prefetching)
+		async->io_priority = G_PRIORITY_DEFAULT;
+
+	return async->io_priority;
+}
+
+static void
+async_node_flush (AsyncNode *async)
+{
+	GList *files = async->files.head;
+
+	if (async->flush_id != 0)
+	{
+		g_source_remove (async->flush_id);
+		async->flush_id = 0;
+	}
+
+	async->flush_time = g_get_monotonic_time ();
+
+	if (files == NULL)
+		return;
+
+	if (async->first_flush_time == 0)
+		async->first_flush_time = async->flush_time;
+
+	/* The infos are now owned by model_add_nodes_from_files() */
+	g_queue_init (&async->files);
+
+	model_add_nodes_from_files (async->dir->model,
+				    (FileBrowserNode *)async->dir,
+				    async->original_files,
+				    async->cached,
+				    files);
+
+	g_list_free (files);
+}
+
+static gboolean
+async_node_flush_timeout_cb (AsyncNode *async)
+{
+	async->flush_id = 0;
+
+	/* The directory may already be unloaded, the enumerator callback
+	 * frees @async */
+	if (!g_cancellable_is_cancelled (async->cancellable))
+		async_node_flush (async);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Flushes the queued infos once the flush interval elapsed, even if the
+ * enumerator is slow to return the next files */
+static void
+async_node_queue_flush (AsyncNode *async)
+{
+	gint64 elapsed;
+
+	if (async->flush_id != 0)
+		return;
+
+	elapsed = g_get_monotonic_time () - async->flush_time;
+
+	async->flush_id = g_timeout_add (MAX (DIRECTORY_LOAD_FLUSH_INTERVAL - elapsed, 0) / 1000,
+					 (GSourceFunc)async_node_flush_timeout_cb,
+					 async);
+}
+
+/* Loads the next subdirectory of @node in the background, one at a time,
+ * so that expanding it is instant. */
+static void
+model_prefetch_next (GeditFileBrowserStore *model,
+		     FileBrowserNode       *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+	guint n_children;
+
+	if (!dir->prefetch_children || !NODE_LOADED (node) || dir->cancellable != NULL)
+		return;
+
+	n_children = MIN (dir->children->len, DIRECTORY_PREFETCH_MAX);
+
+	for (guint i = 0; i < n_children; ++i)
+	{
+		FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
+		FileBrowserNodeDir *child_dir;
+
+		if (!NODE_IS_DIR (child) || NODE_IS_FILTERED (child))
+			continue;
+
+		child_dir = FILE_BROWSER_NODE_DIR (child);
+
+		/* Wait for the current load */
+		if (child_dir->cancellable != NULL)
+			return;
+
+		if (!NODE_LOADED (child) && !child_dir->prefetched)
+		{
+			model_load_directory_real (model, child, TRUE);
+			return;
+		}
+	}
+
+	dir->prefetch_children = FALSE;
+}
+
+static void
+model_prefetch_children (GeditFileBrowserStore *model,
+			 FileBrowserNode       *node)
+{
+	/* Only local and network mounted file systems are worth it */
+	if (!g_file_is_native (node->file))
+		return;
+
+	FILE_BROWSER_NODE_DIR (node)->prefetch_children = TRUE;
+	model_prefetch_next (model, node);
+}
+
+/* Removes the children shown from the listing cache that were not
+ * enumerated */
+static void
+model_remove_stale_nodes (GeditFileBrowserStore *model,
+			  AsyncNode             *async)
+{
+	FileBrowserNodeDir *dir = async->dir;
+	GPtrArray *stale;
+
+	if (async->cached == NULL || g_hash_table_size (async->cached) == 0)
+		return;
 
-			nodes = g_slist_prepend (nodes, node);
-		}
+	stale = g_ptr_array_new ();
 
-		g_object_unref (file);
-		g_object_unref (info);
+	for (guint i = 0; i < dir->children->len; ++i)
+	{
+		FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
+
+		if (child->file != NULL && g_hash_table_contains (async->cached, child->file))
+			g_ptr_array_add (stale, child);
 	}
 
-	if (nodes)
-		model_add_nodes_batch (model, nodes, parent);
+	model_remove_nodes_batch (model, (FileBrowserNode *)dir, stale);
+	g_ptr_array_unref (stale);
 }
 
-static FileBrowserNode *
-model_add_node_from_dir (GeditFileBrowserStore *model,
-			 FileBrowserNode       *parent,
-			 GFile                 *file)
+/* Returns the info of @node as saved in the listing cache */
+static GFileInfo *
+file_browser_node_get_info (FileBrowserNode *node)
 {
-	FileBrowserNode *node;
+	GFileInfo *info;
+	gchar *name;
 
-	/* Check if it already exists */
-	if ((node = node_list_contains_file (FILE_BROWSER_NODE_DIR (parent)->children, file)) == NULL)
-	{
-		node = file_browser_node_dir_new (model, file, parent);
-		file_browser_node_set_from_info (model, node, NULL, FALSE);
+	name = g_file_get_basename (node->file);
 
-		if (node->name == NULL)
-			file_browser_node_set_name (node);
+	info = g_file_info_new ();
+	g_file_info_set_name (info, name);
+	g_file_info_set_file_type (info, NODE_IS_DIR (node) ? G_FILE_TYPE_DIRECTORY
+							    : G_FILE_TYPE_REGULAR);
+	g_file_info_set_is_hidden (info, NODE_IS_HIDDEN (node));
 
-		node->icon_name = g_strdup ("folder-symbolic");
+	if (node->content_type != NULL)
+		g_file_info_set_content_type (info, node->content_type);
 
-		model_add_node (model, node, parent);
-	}
+	g_free (name);
 
-	return node;
+	return info;
 }
 
 static void
-on_directory_monitor_event (GFileMonitor      *monitor,
-			    GFile             *file,
-			    GFile             *other_file,
-			    GFileMonitorEvent  event_type,
-			    FileBrowserNode   *parent)
+model_save_listing (GeditFileBrowserStore *model,
+		    AsyncNode             *async)
 {
-	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
-	FileBrowserNode *node;
+	FileBrowserNodeDir *dir = async->dir;
+	GList *infos = NULL;
+
+	if (!model->priv->listing_cache || !async->has_mtime)
+		return;
 
-	switch (event_type)
+	for (guint i = dir->children->len; i > 0; --i)
 	{
-		case G_FILE_MONITOR_EVENT_DELETED:
-			node = node_list_contains_file (dir->children, file);
+		FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i - 1);
 
-			if (node != NULL)
-				model_remove_node (dir->model, node, NULL, TRUE);
-			break;
-		case G_FILE_MONITOR_EVENT_CREATED:
-			if (g_file_query_exists (file, NULL))
-				model_add_node_from_file (dir->model, parent, file, NULL);
+		if (child->file != NULL)
+			infos = g_list_prepend (infos, file_browser_node_get_info (child));
+	}
 
-			break;
-		default:
-			break;
+	gedit_file_browser_listing_cache_save (((FileBrowserNode *)dir)->file,
+					       async->mtime,
+					       async->mtime_usec,
+					       infos);
+
+	g_list_free_full (infos, g_object_unref);
+}
+
+static void
+model_monitor_directory (FileBrowserNode *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+
+/*
+ * FIXME: This is temporarly, it is a bug in gio:
+ * http://bugzilla.gnome.org/show_bug.cgi?id=565924
+ */
+#ifndef G_OS_WIN32
+	if (g_file_is_native (node->file) && dir->monitor == NULL)
+	{
+		dir->monitor = g_file_monitor_directory (node->file,
+							 G_FILE_MONITOR_NONE,
+							 NULL,
+							 NULL);
+		if (dir->monitor != NULL)
+		{
+			g_signal_connect (dir->monitor,
+					  "changed",
+					  G_CALLBACK (on_directory_monitor_event),
+					  node);
+		}
 	}
+#endif
 }
 
+/* Finishes a successful load, @enumerated is FALSE if the cached
+ * listing was up to date */
 static void
-async_node_free (AsyncNode *async)
+model_load_directory_done (AsyncNode *async,
+			   gboolean   enumerated)
 {
-	g_object_unref (async->cancellable);
-	g_slist_free (async->original_children);
-	g_slice_free (AsyncNode, async);
+	FileBrowserNodeDir *dir = async->dir;
+	FileBrowserNode *parent = (FileBrowserNode *)dir;
+	gboolean prefetching;
+	gboolean resync = async->resync;
+
+	async_node_flush (async);
+
+	if (enumerated)
+	{
+		model_remove_stale_nodes (dir->model, async);
+		model_save_listing (dir->model, async);
+	}
+
+	gedit_debug_message (DEBUG_PLUGINS,
+			     "Loaded %u children%s, first rows after %" G_GINT64_FORMAT " ms, "
+			     "all rows after %" G_GINT64_FORMAT " ms",
+			     dir->children->len,
+			     enumerated ? "" : " from the cache",
+			     (MAX (async->first_flush_time, async->start_time) - async->start_time) / 1000,
+			     (async->flush_time - async->start_time) / 1000);
+
+	async_node_free (async);
+
+	/* We're done loading */
+	g_object_unref (dir->cancellable);
+	dir->cancellable = NULL;
+
+	prefetching = dir->prefetching;
+	dir->prefetching = FALSE;
+
+	/* The prefetched directories are not monitored, there can be many of
+	 * them, and most are never shown */
+	dir->unwatched = prefetching && !resync;
+
+	if (!dir->unwatched)
+		model_monitor_directory (parent);
+
+	model_check_dummy (dir->model, parent);
+
+	if (!prefetching)
+	{
+		model_end_loading (dir->model, parent);
+		model_prefetch_children (dir->model, parent);
+	}
+	else
+	{
+		/* It may have been expanded while it was listed again */
+		model_prefetch_next (dir->model, parent);
+	}
+
+	if (parent->parent != NULL)
+		model_prefetch_next (dir->model, parent->parent);
 }
 
 static void
@@ -2227,53 +3147,38 @@ model_iterate_next_files_cb (GFileEnumerator *enumerator,
 	{
 		g_file_enumerator_close (enumerator, NULL, NULL);
 		g_object_unref (enumerator);
-		async_node_free (async);
 
 		if (!error)
 		{
-			/* We're done loading */
-			g_object_unref (dir->cancellable);
-			dir->cancellable = NULL;
-
-/*
- * FIXME: This is temporarly, it is a bug in gio:
- * http://bugzilla.gnome.org/show_bug.cgi?id=565924
- */
-#ifndef G_OS_WIN32
-			if (g_file_is_native (parent->file) && dir->monitor == NULL)
-			{
-				dir->monitor = g_file_monitor_directory (parent->file,
-									 G_FILE_MONITOR_NONE,
-									 NULL,
-									 NULL);
-				if (dir->monitor != NULL)
-				{
-					g_signal_connect (dir->monitor,
-							  "changed",
-							  G_CALLBACK (on_directory_monitor_event),
-							  parent);
-				}
-			}
-#endif
-
-			model_check_dummy (dir->model, parent);
-			model_end_loading (dir->model, parent);
+			model_load_directory_done (async, TRUE);
 		}
 		else
 		{
+			async_node_free (async);
+
 			/* Simply return if we were cancelled */
 			if (error->domain == G_IO_ERROR && error->code == G_IO_ERROR_CANCELLED)
+			{
+				g_error_free (error);
 				return;
+			}
 
-			/* Otherwise handle the error appropriately */
-			g_signal_emit (dir->model,
-				       model_signals[ERROR],
-				       0,
-				       GEDIT_FILE_BROWSER_ERROR_LOAD_DIRECTORY,
-				       error->message);
+			/* The errors of a background load are reported when
+			   the directory is expanded and loaded again */
+			if (!dir->prefetching)
+			{
+				g_signal_emit (dir->model,
+					       model_signals[ERROR],
+					       0,
+					       GEDIT_FILE_BROWSER_ERROR_LOAD_DIRECTORY,
+					       error->message);
+			}
 
 			file_browser_node_unload (dir->model, (FileBrowserNode *)parent, TRUE);
 			g_error_free (error);
+
+			if (parent->parent != NULL)
+				model_prefetch_next (dir->model, parent->parent);
 		}
 	}
 	else if (g_cancellable_is_cancelled (async->cancellable))
@@ -2285,9 +3190,25 @@ model_iterate_next_files_cb (GFileEnumerator *enumerator,
 	}
 	else
 	{
-		model_add_nodes_from_files (dir->model, parent, async->original_children, files);
+		for (GList *item = files; item; item = item->next)
+			g_queue_push_tail (&async->files, item->data);
 
 		g_list_free (files);
+
+		/* The directory keeps producing files, ask for more at once */
+		async->n_items = MIN (async->n_items * 2, DIRECTORY_LOAD_ITEMS_MAX);
+
+		/* The first rows are shown as soon as possible */
+		if (async->first_flush_time == 0 ||
+		    g_get_monotonic_time () - async->flush_time >= DIRECTORY_LOAD_FLUSH_INTERVAL)
+		{
+			async_node_flush (async);
+		}
+		else
+		{
+			async_node_queue_flush (async);
+		}
+
 		next_files_async (enumerator, async);
 	}
 }
@@ -2297,8 +3218,8 @@ next_files_async (GFileEnumerator *enumerator,
 		  AsyncNode       *async)
 {
 	g_file_enumerator_next_files_async (enumerator,
-					    DIRECTORY_LOAD_ITEMS_PER_CALLBACK,
-					    G_PRIORITY_DEFAULT,
+					    async->n_items,
+					    async_node_get_io_priority (async),
 					    async->cancellable,
 					    (GAsyncReadyCallback)model_iterate_next_files_cb,
 					    async);
@@ -2322,17 +3243,24 @@ model_iterate_children_cb (GFile        *file,
 	{
 		/* Simply return if we were cancelled or if the dir is not there */
 		FileBrowserNodeDir *dir = async->dir;
+		FileBrowserNode *node = (FileBrowserNode *)dir;
 
 		/* Otherwise handle the error appropriately */
-		g_signal_emit (dir->model,
-			       model_signals[ERROR],
-			       0,
-			       GEDIT_FILE_BROWSER_ERROR_LOAD_DIRECTORY,
-			       error->message);
+		if (!dir->prefetching)
+		{
+			g_signal_emit (dir->model,
+				       model_signals[ERROR],
+				       0,
+				       GEDIT_FILE_BROWSER_ERROR_LOAD_DIRECTORY,
+				       error->message);
+		}
 
-		file_browser_node_unload (dir->model, (FileBrowserNode *)dir, TRUE);
+		file_browser_node_unload (dir->model, node, TRUE);
 		g_error_free (error);
 		async_node_free (async);
+
+		if (node->parent != NULL)
+			model_prefetch_next (dir->model, node->parent);
 	}
 	else
 	{
@@ -2341,8 +3269,137 @@ model_iterate_children_cb (GFile        *file,
 }
 
 static void
-model_load_directory (GeditFileBrowserStore *model,
-		      FileBrowserNode       *node)
+model_enumerate_children (AsyncNode *async)
+{
+	g_file_enumerate_children_async (((FileBrowserNode *)async->dir)->file,
+					 STANDARD_ATTRIBUTE_TYPES,
+					 G_FILE_QUERY_INFO_NONE,
+					 async_node_get_io_priority (async),
+					 async->cancellable,
+					 (GAsyncReadyCallback)model_iterate_children_cb,
+					 async);
+}
+
+static void
+model_query_mtime_cb (GFile        *file,
+		      GAsyncResult *result,
+		      AsyncNode    *async)
+{
+	GFileInfo *info;
+
+	if (g_cancellable_is_cancelled (async->cancellable))
+	{
+		async_node_free (async);
+		return;
+	}
+
+	info = g_file_query_info_finish (file, result, NULL);
+	async->has_mtime = info != NULL &&
+			   g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+	if (async->has_mtime)
+	{
+		guint64 mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+		guint32 mtime_usec = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+		/* The directory didn't change since the cached listing */
+		if (async->from_cache &&
+		    async->mtime == mtime &&
+		    async->mtime_usec == mtime_usec)
+		{
+			g_object_unref (info);
+			g_hash_table_remove_all (async->cached);
+			model_load_directory_done (async, FALSE);
+			return;
+		}
+
+		async->mtime = mtime;
+		async->mtime_usec = mtime_usec;
+	}
+
+	g_clear_object (&info);
+	model_enumerate_children (async);
+}
+
+static void
+model_listing_cache_load_cb (GObject      *source_object,
+			     GAsyncResult *result,
+			     AsyncNode    *async)
+{
+	FileBrowserNode *parent;
+	GList *infos = NULL;
+	GHashTableIter iter;
+	gpointer file;
+
+	if (g_cancellable_is_cancelled (async->cancellable))
+	{
+		async_node_free (async);
+		return;
+	}
+
+	parent = (FileBrowserNode *)async->dir;
+
+	/* The modification time of the cached listing is kept in the
+	 * async node until the directory is queried */
+	if (gedit_file_browser_listing_cache_load_finish (result,
+							  &infos,
+							  &async->mtime,
+							  &async->mtime_usec))
+	{
+		async->from_cache = TRUE;
+		async->cached = g_hash_table_new_full (g_file_hash,
+						       (GEqualFunc)g_file_equal,
+						       g_object_unref,
+						       g_object_unref);
+
+		for (GList *item = infos; item; item = item->next)
+		{
+			GFileInfo *info = G_FILE_INFO (item->data);
+
+			file = g_file_get_child (parent->file, g_file_info_get_name (info));
+
+			/* The nodes that were already there are left alone */
+			if (g_hash_table_contains (async->original_files, file))
+				g_object_unref (file);
+			else
+				g_hash_table_insert (async->cached, file, g_object_ref (info));
+		}
+
+		/* The infos are now owned by model_add_nodes_from_files() */
+		model_add_nodes_from_files (async->dir->model,
+					    parent,
+					    async->original_files,
+					    NULL,
+					    infos);
+		g_list_free (infos);
+
+		g_hash_table_iter_init (&iter, async->cached);
+
+		while (g_hash_table_iter_next (&iter, &file, NULL))
+			g_hash_table_add (async->original_files, g_object_ref (file));
+
+		async->first_flush_time = g_get_monotonic_time ();
+
+		gedit_debug_message (DEBUG_PLUGINS,
+				     "Showed %u cached children after %" G_GINT64_FORMAT " ms",
+				     g_hash_table_size (async->cached),
+				     (async->first_flush_time - async->start_time) / 1000);
+	}
+
+	/* The directory is enumerated again only if it changed */
+	g_file_query_info_async (parent->file,
+				 DIRECTORY_MTIME_ATTRIBUTES,
+				 G_FILE_QUERY_INFO_NONE,
+				 async_node_get_io_priority (async),
+				 async->cancellable,
+				 (GAsyncReadyCallback)model_query_mtime_cb,
+				 async);
+}
+
+static void
+model_load_directory_real (GeditFileBrowserStore *model,
+			   FileBrowserNode       *node,
+			   gboolean               prefetch)
 {
 	FileBrowserNodeDir *dir;
 	AsyncNode *async;
@@ -2356,23 +3413,112 @@ model_load_directory (GeditFileBrowserStore *model,
 		file_browser_node_unload (dir->model, node, TRUE);
 
 	node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_LOADED;
-	model_begin_loading (model, node);
+
+	/* A background load doesn't show that the browser is busy */
+	dir->prefetching = prefetch;
+
+	if (prefetch)
+		dir->prefetched = TRUE;
+	else
+		model_begin_loading (model, node);
 
 	dir->cancellable = g_cancellable_new ();
+	async = async_node_new (dir, prefetch ? G_PRIORITY_LOW : G_PRIORITY_DEFAULT);
 
-	async = g_slice_new (AsyncNode);
-	async->dir = dir;
-	async->cancellable = g_object_ref (dir->cancellable);
-	async->original_children = g_slist_copy (dir->children);
+	/* Start loading async, the cached listing is shown first */
+	if (model->priv->listing_cache)
+	{
+		gedit_file_browser_listing_cache_load_async (node->file,
+							     async->io_priority,
+							     async->cancellable,
+							     (GAsyncReadyCallback)model_listing_cache_load_cb,
+							     async);
+	}
+	else
+	{
+		model_enumerate_children (async);
+	}
+}
 
-	/* Start loading async */
-	g_file_enumerate_children_async (node->file,
-					 STANDARD_ATTRIBUTE_TYPES,
-					 G_FILE_QUERY_INFO_NONE,
-					 G_PRIORITY_DEFAULT,
-					 async->cancellable,
-					 (GAsyncReadyCallback)model_iterate_children_cb,
-					 async);
+static void
+model_load_directory (GeditFileBrowserStore *model,
+		      FileBrowserNode       *node)
+{
+	model_load_directory_real (model, node, FALSE);
+}
+
+/* Lists a loaded directory again in the background, the children that
+ * changed are replaced and the ones that are gone are removed */
+static void
+model_resync_directory (GeditFileBrowserStore *model,
+			FileBrowserNode       *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+	AsyncNode *async;
+
+	/* The current load picks the changes up */
+	if (!NODE_LOADED (node) || dir->cancellable != NULL)
+		return;
+
+	dir->prefetching = TRUE;
+	dir->cancellable = g_cancellable_new ();
+
+	async = async_node_new (dir, G_PRIORITY_LOW);
+	async->resync = TRUE;
+	async->cached = g_hash_table_new_full (g_file_hash,
+					       (GEqualFunc)g_file_equal,
+					       g_object_unref,
+					       g_object_unref);
+
+	for (guint i = 0; i < dir->children->len; ++i)
+	{
+		FileBrowserNode *child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
+
+		if (child->file != NULL)
+		{
+			g_hash_table_insert (async->cached,
+					     g_object_ref (child->file),
+					     file_browser_node_get_info (child));
+		}
+	}
+
+	g_file_query_info_async (node->file,
+				 DIRECTORY_MTIME_ATTRIBUTES,
+				 G_FILE_QUERY_INFO_NONE,
+				 async->io_priority,
+				 async->cancellable,
+				 (GAsyncReadyCallback)model_query_mtime_cb,
+				 async);
+}
+
+/* Loads a directory that is shown, or makes its background load a normal
+ * one */
+static void
+model_show_directory (GeditFileBrowserStore *model,
+		      FileBrowserNode       *node)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
+
+	if (!NODE_LOADED (node))
+	{
+		/* Load it now */
+		model_load_directory (model, node);
+	}
+	else if (dir->prefetching)
+	{
+		/* It is being loaded in the background, it's not anymore, the
+		 * rest of the load is done at the default priority */
+		dir->prefetching = FALSE;
+		model_begin_loading (model, node);
+	}
+	else if (dir->unwatched)
+	{
+		/* It was not monitored since it was loaded in the background,
+		 * the changes since then are picked up by listing it again */
+		dir->unwatched = FALSE;
+		model_monitor_directory (node);
+		model_resync_directory (model, node);
+	}
 }
 
 static GList *
@@ -2404,7 +3550,6 @@ model_fill (GeditFileBrowserStore  *model,
 {
 	gboolean free_path = FALSE;
 	GtkTreeIter iter = {0,};
-	GSList *item;
 	FileBrowserNode *child;
 
 	if (node == NULL)
@@ -2440,9 +3585,9 @@ model_fill (GeditFileBrowserStore  *model,
 		/* Go to the first child */
 		gtk_tree_path_down (*path);
 
-		for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
+		for (guint i = 0; i < FILE_BROWSER_NODE_DIR (node)->children->len; ++i)
 		{
-			child = (FileBrowserNode *) (item->data);
+			child = (FileBrowserNode *)g_ptr_array_index (FILE_BROWSER_NODE_DIR (node)->children, i);
 
 			if (model_node_visibility (model, child))
 			{
@@ -2471,18 +3616,26 @@ set_virtual_root_from_node (GeditFileBrowserStore *model,
 	FileBrowserNode *next = prev->parent;
 	FileBrowserNode *check;
 	FileBrowserNodeDir *dir;
-	GSList *copy;
+	GPtrArray *copy;
 	GtkTreePath *empty = NULL;
 
 	/* Free all the nodes below that we don't need in cache */
 	while (prev != model->priv->root)
 	{
 		dir = FILE_BROWSER_NODE_DIR (next);
-		copy = g_slist_copy (dir->children);
+		copy = g_ptr_array_copy (dir->children, NULL, NULL);
+
+		if (prev != node)
+		{
+			/* Only keep the node in the chain */
+			g_ptr_array_set_size (dir->children, 0);
+			g_ptr_array_add (dir->children, prev);
+			file_browser_node_dir_reindex (dir, 0);
+		}
 
-		for (GSList *item = copy; item; item = item->next)
+		for (guint i = 0; i < copy->len; ++i)
 		{
-			check = (FileBrowserNode *)(item->data);
+			check = (FileBrowserNode *)g_ptr_array_index (copy, i);
 
 			if (prev == node)
 			{
@@ -2496,7 +3649,6 @@ set_virtual_root_from_node (GeditFileBrowserStore *model,
 			else if (check != prev)
 			{
 				/* Only free when the node is not in the chain */
-				dir->children = g_slist_remove (dir->children, check);
 				file_browser_node_free (model, check);
 			}
 		}
@@ -2504,27 +3656,32 @@ set_virtual_root_from_node (GeditFileBrowserStore *model,
 		if (prev != node)
 			file_browser_node_unload (model, next, FALSE);
 
-		g_slist_free (copy);
+		g_ptr_array_unref (copy);
 		prev = next;
 		next = prev->parent;
 	}
 
 	/* Free all the nodes up that we don't need in cache */
-	for (GSList *item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
+	dir = FILE_BROWSER_NODE_DIR (node);
+
+	for (guint i = 0; i < dir->children->len; ++i)
 	{
-		check = (FileBrowserNode *)(item->data);
+		check = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
 
 		if (NODE_IS_DIR (check))
 		{
-			for (copy = FILE_BROWSER_NODE_DIR (check)->children; copy; copy = copy->next)
+			GPtrArray *children = FILE_BROWSER_NODE_DIR (check)->children;
+
+			for (guint j = 0; j < children->len; ++j)
 			{
-				file_browser_node_free_children (model, (FileBrowserNode*) (copy->data));
-				file_browser_node_unload (model, (FileBrowserNode*) (copy->data), FALSE);
+				file_browser_node_free_children (model, (FileBrowserNode *)g_ptr_array_index (children, j));
+				file_browser_node_unload (model, (FileBrowserNode *)g_ptr_array_index (children, j), FALSE);
 			}
 		}
 		else if (NODE_IS_DUMMY (check))
 		{
 			check->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
+			file_browser_node_update_row (check);
 		}
 	}
 
@@ -2536,9 +3693,7 @@ set_virtual_root_from_node (GeditFileBrowserStore *model,
 	g_object_notify (G_OBJECT (model), "virtual-root");
 
 	model_fill (model, NULL, &empty);
-
-	if (!NODE_LOADED (node))
-		model_load_directory (model, node);
+	model_show_directory (model, node);
 }
 
 static void
@@ -2582,9 +3737,9 @@ model_find_node_children (GeditFileBrowserStore *model,
 
 	dir = FILE_BROWSER_NODE_DIR (parent);
 
-	for (GSList *children = dir->children; children; children = children->next)
+	for (guint i = 0; i < dir->children->len; ++i)
 	{
-		child = (FileBrowserNode *)(children->data);
+		child = (FileBrowserNode *)g_ptr_array_index (dir->children, i);
 
 		result = model_find_node (model, child, file);
 
@@ -3100,11 +4255,13 @@ _gedit_file_browser_store_iter_expanded (GeditFileBrowserStore *model,
 
 	node = (FileBrowserNode *)(iter->user_data);
 
-	if (NODE_IS_DIR (node) && !NODE_LOADED (node))
-	{
-		/* Load it now */
-		model_load_directory (model, node);
-	}
+	if (!NODE_IS_DIR (node))
+		return;
+
+	model_show_directory (model, node);
+
+	/* Look one level further, once the current load is done */
+	model_prefetch_children (model, node);
 }
 
 void
@@ -3123,15 +4280,22 @@ _gedit_file_browser_store_iter_collapsed (GeditFileBrowserStore *model,
 	{
 		/* Unload children of the children, keeping 1 depth in cache */
 
-		for (GSList *item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
+		GPtrArray *children = FILE_BROWSER_NODE_DIR (node)->children;
+
+		FILE_BROWSER_NODE_DIR (node)->prefetch_children = FALSE;
+
+		for (guint i = 0; i < children->len; ++i)
 		{
-			node = (FileBrowserNode *)(item->data);
+			node = (FileBrowserNode *)g_ptr_array_index (children, i);
 
 			if (NODE_IS_DIR (node) && NODE_LOADED (node))
 			{
 				file_browser_node_unload (model, node, TRUE);
 				model_check_dummy (model, node);
 			}
+
+			if (NODE_IS_DIR (node))
+				FILE_BROWSER_NODE_DIR (node)->prefetched = FALSE;
 		}
 	}
 }
@@ -3258,8 +4422,8 @@ reparent_node (FileBrowserNode *node,
 	{
 		FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node);
 
-		for (GSList *child = dir->children; child; child = child->next)
-			reparent_node ((FileBrowserNode *)child->data, TRUE);
+		for (guint i = 0; i < dir->children->len; ++i)
+			reparent_node ((FileBrowserNode *)g_ptr_array_index (dir->children, i), TRUE);
 	}
 }
 
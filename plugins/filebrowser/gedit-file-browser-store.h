@@ -117,6 +117,10 @@ struct _GeditFileBrowserStoreClass {
 	                             GFile                 *location);
 	void (* before_row_deleted) (GeditFileBrowserStore *model,
 	                             GtkTreePath           *path);
+	void (* file_changed)       (GeditFileBrowserStore *model,
+	                             GFile                 *file,
+	                             GFile                 *other_file,
+	                             GFileMonitorEvent      event_type);
 };
 
 GType                            gedit_file_browser_store_get_type                       (void) G_GNUC_CONST;
@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <glib/gi18n-lib.h>
 #include <gedit/gedit-utils.h>
 
@@ -220,4 +221,62 @@ gedit_file_browser_utils_confirmation_dialog (GeditWindow    *window,
 	return (ret == GTK_RESPONSE_OK);
 }
 
+gboolean
+gedit_file_browser_utils_content_type_is_text (gchar const *content_type)
+{
+#ifdef G_OS_WIN32
+	gchar *mime;
+	gboolean ret;
+#endif
+
+	if (!content_type || g_content_type_is_unknown (content_type))
+		return TRUE;
+
+#ifndef G_OS_WIN32
+	return g_content_type_is_a (content_type, "text/plain");
+#else
+	if (g_content_type_is_a (content_type, "text"))
+		return TRUE;
+
+	/* This covers a rare case in which on Windows the PerceivedType is
+	   not set to "text" but the Content Type is set to text/plain */
+	mime = g_content_type_get_mime_type (content_type);
+	ret = g_strcmp0 (mime, "text/plain");
+
+	g_free (mime);
+
+	return ret;
+#endif
+}
+
+gboolean
+gedit_file_browser_utils_name_matches_patterns (GPtrArray   *pattern_specs,
+						gchar const *name)
+{
+	gssize name_length;
+	gchar *name_reversed;
+	gboolean matches = FALSE;
+
+	if (pattern_specs == NULL)
+		return FALSE;
+
+	name_length = strlen (name);
+	name_reversed = g_utf8_strreverse (name, name_length);
+
+	for (guint i = 0; i < pattern_specs->len; ++i)
+	{
+		GPatternSpec *spec = g_ptr_array_index (pattern_specs, i);
+
+		if (g_pattern_match (spec, name_length, name, name_reversed))
+		{
+			matches = TRUE;
+			break;
+		}
+	}
+
+	g_free (name_reversed);
+
+	return matches;
+}
+
 /* ex:set ts=8 noet: */
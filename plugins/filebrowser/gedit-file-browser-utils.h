@@ -42,5 +42,9 @@ gboolean	 gedit_file_browser_utils_confirmation_dialog	        (GeditWindow    *
 									 gchar const    *secondary,
 									 gchar const    *button_label);
 
+gboolean	 gedit_file_browser_utils_content_type_is_text	        (gchar const    *content_type);
+gboolean	 gedit_file_browser_utils_name_matches_patterns	        (GPtrArray      *pattern_specs,
+									 gchar const    *name);
+
 #endif /* GEDIT_FILE_BROWSER_UTILS_H */
 /* ex:set ts=8 noet: */
@@ -74,6 +74,7 @@ enum
 	CONFIRM_NO_TRASH,
 	OPEN_IN_TERMINAL,
 	SET_ACTIVE_ROOT,
+	FIND_IN_FILES,
 	NUM_SIGNALS
 };
 
@@ -263,6 +264,9 @@ static void open_in_terminal_activated         (GSimpleAction          *action,
 static void set_active_root_activated          (GSimpleAction          *action,
                                                 GVariant               *parameter,
                                                 gpointer                user_data);
+static void find_in_files_activated            (GSimpleAction          *action,
+                                                GVariant               *parameter,
+                                                gpointer                user_data);
 static void on_locations_treeview_selection_changed (GtkTreeSelection       *treeselection,
                                                      GeditFileBrowserWidget *obj);
 
@@ -523,6 +527,14 @@ gedit_file_browser_widget_class_init (GeditFileBrowserWidgetClass *klass)
 	                  NULL, NULL, NULL,
 	                  G_TYPE_NONE, 0);
 
+	signals[FIND_IN_FILES] =
+	    g_signal_new ("find-in-files",
+	                  G_OBJECT_CLASS_TYPE (object_class),
+	                  G_SIGNAL_RUN_LAST,
+	                  G_STRUCT_OFFSET (GeditFileBrowserWidgetClass, find_in_files),
+	                  NULL, NULL, NULL,
+	                  G_TYPE_NONE, 1, G_TYPE_FILE);
+
 	/* Bind class to template */
 	gtk_widget_class_set_template_from_resource (widget_class,
 	                                             "/org/gnome/gedit/plugins/file-browser/ui/gedit-file-browser-widget.ui");
@@ -911,6 +923,7 @@ static GActionEntry browser_entries[] = {
 	{ "refresh_view", refresh_view_activated },
 	{ "view_folder", view_folder_activated },
 	{ "open_in_terminal", open_in_terminal_activated },
+	{ "find_in_files", find_in_files_activated },
 	{ "show_hidden", NULL, NULL, "false", change_show_hidden_state },
 	{ "show_binary", NULL, NULL, "false", change_show_binary_state },
 	{ "show_match_filename", NULL, NULL, "false", change_show_match_filename },
@@ -3141,6 +3154,25 @@ set_active_root_activated (GSimpleAction *action,
 	g_signal_emit (widget, signals[SET_ACTIVE_ROOT], 0);
 }
 
+static void
+find_in_files_activated (GSimpleAction *action,
+                         GVariant      *parameter,
+                         gpointer       user_data)
+{
+	GeditFileBrowserWidget *widget = GEDIT_FILE_BROWSER_WIDGET (user_data);
+	GFile *virtual_root;
+
+	/* The search is scoped to what the file browser shows. */
+	virtual_root = gedit_file_browser_store_get_virtual_root (widget->priv->file_store);
+
+	if (virtual_root == NULL)
+		return;
+
+	g_signal_emit (widget, signals[FIND_IN_FILES], 0, virtual_root);
+
+	g_object_unref (virtual_root);
+}
+
 void
 _gedit_file_browser_widget_register_type (GTypeModule *type_module)
 {
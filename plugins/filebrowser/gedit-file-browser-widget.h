@@ -71,6 +71,8 @@ struct _GeditFileBrowserWidgetClass
 	void (* open_in_terminal)       (GeditFileBrowserWidget *widget,
 	                                 GFile                  *location);
 	void (* set_active_root)        (GeditFileBrowserWidget *widget);
+	void (* find_in_files)          (GeditFileBrowserWidget *widget,
+	                                 GFile                  *location);
 };
 
 GType		 gedit_file_browser_widget_get_type            (void) G_GNUC_CONST;
@@ -34,6 +34,9 @@ try:
 except:
     _ = lambda s: s
 
+# The file browser root is listed again when it is older than this, in us
+INDEX_MAX_AGE = 5 * 60 * 1000000
+
 class QuickOpenAppActivatable(GObject.Object, Gedit.AppActivatable):
     app = GObject.Property(type=Gedit.App)
 
@@ -63,6 +66,10 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
         self._popup_size = (450, 300)
         self._popup = None
 
+        self._index = None
+        self._index_time = 0
+        self._index_cancellable = None
+
         action = Gio.SimpleAction(name="quickopen")
         action.connect('activate', self.on_quick_open_activate)
         self.window.add_action(action)
@@ -70,14 +77,41 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
     def do_deactivate(self):
         self.window.remove_action("quickopen")
 
+        if self._index_cancellable:
+            self._index_cancellable.cancel()
+            self._index_cancellable = None
+
+        self._index = None
+
     def get_popup_size(self):
         return self._popup_size
 
     def set_popup_size(self, size):
         self._popup_size = size
 
+    def _get_index(self, gfile):
+        # Only the last file browser root is kept indexed
+        if not self._index or not self._index.get_root().equal(gfile):
+            if self._index_cancellable:
+                self._index_cancellable.cancel()
+
+            self._index = Gedit.FileIndex.new(gfile)
+            self._index_time = 0
+
+        now = GLib.get_monotonic_time()
+
+        if self._index_time == 0 or now - self._index_time > INDEX_MAX_AGE:
+            self._index_time = now
+            self._index_cancellable = Gio.Cancellable()
+            self._index.build_async(self._index_cancellable,
+                                    self.on_index_built,
+                                    None)
+
+        return self._index
+
     def _create_popup(self):
         paths = []
+        index = None
 
         # Open documents
         paths.append(CurrentDocumentsDirectory(self.window))
@@ -100,6 +134,7 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
 
                 if gfile and gfile.is_native():
                     paths.append(gfile)
+                    index = self._get_index(gfile)
 
         # Recent documents
         paths.append(RecentDocumentsDirectory())
@@ -117,7 +152,7 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
         # Home directory
         paths.append(Gio.file_new_for_path(os.path.expanduser('~')))
 
-        self._popup = Popup(self.window, paths, self.on_activated)
+        self._popup = Popup(self.window, paths, self.on_activated, index)
         self.window.get_group().add_window(self._popup)
 
         self._popup.set_default_size(*self.get_popup_size())
@@ -186,6 +221,17 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
 
         self._popup = None
 
+    def on_index_built(self, index, result, user_data=None):
+        try:
+            index.build_finish(result)
+        except GLib.Error as e:
+            if index == self._index:
+                self._index_time = 0
+            return
+
+        if self._popup:
+            self._popup.refresh()
+
     def on_activated(self, gfile, user_data=None):
         Gedit.commands_load_location(self.window, gfile, None, -1, -1)
         return True
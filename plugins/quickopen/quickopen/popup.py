@@ -32,10 +32,20 @@ try:
 except:
     _ = lambda s: s
 
+# The number of files asked to the file index, some may not be text files
+MAX_INDEX_RESULTS = 100
+
+# The time a search runs before letting the main loop handle the input and
+# redraw the results, in us
+SEARCH_STEP_TIME = 4000
+
+# The number of children asked at once when listing a directory
+LIST_BATCH_SIZE = 100
+
 class Popup(Gtk.Dialog):
     __gtype_name__ = "QuickOpenPopup"
 
-    def __init__(self, window, paths, handler):
+    def __init__(self, window, paths, handler, index=None):
         Gtk.Dialog.__init__(self,
                             title=_('Quick Open'),
                             transient_for=window,
@@ -56,6 +66,20 @@ class Popup(Gtk.Dialog):
         self._cursor = None
         self._shift_start = None
 
+        self._index = index
+        self._index_cancellable = None
+        self._index_pending = False
+
+        # The listings in progress, with the callbacks waiting for them
+        self._listing = {}
+        self._list_cancellable = Gio.Cancellable()
+
+        self._search = None
+        self._search_id = 0
+        self._results = []
+        self._result_uris = set()
+        self._synced = 0
+
         self._busy_cursor = Gdk.Cursor(Gdk.CursorType.WATCH)
 
         accel_group = Gtk.AccelGroup()
@@ -74,6 +98,7 @@ class Popup(Gtk.Dialog):
                 unique.append(path.get_uri())
 
         self.connect('show', self.on_show)
+        self.connect('destroy', self.on_destroy)
 
     def get_final_size(self):
         return self._size
@@ -155,8 +180,9 @@ class Popup(Gtk.Dialog):
             cell.set_property('style-set', False)
 
     def _is_text(self, entry):
-        content_type = entry.get_content_type()
+        return self._is_text_type(entry.get_content_type())
 
+    def _is_text_type(self, content_type):
         if content_type is None or Gio.content_type_is_unknown(content_type):
             return True
 
@@ -174,28 +200,7 @@ class Popup(Gtk.Dialog):
 
         return False
 
-    def _list_dir(self, gfile):
-        entries = []
-
-        try:
-            ret = gfile.enumerate_children("standard::*",
-                                           Gio.FileQueryInfoFlags.NONE,
-                                           None)
-        except GLib.Error as e:
-            pass
-
-        if isinstance(ret, Gio.FileEnumerator):
-            while True:
-                entry = ret.next_file(None)
-
-                if not entry:
-                    break
-
-                if not entry.get_is_backup():
-                    entries.append((gfile.get_child(entry.get_name()), entry))
-        else:
-            entries = ret
-
+    def _filter_entries(self, entries):
         children = []
 
         for entry in entries:
@@ -210,8 +215,72 @@ class Popup(Gtk.Dialog):
                              file_type,
                              entry[1].get_icon()))
 
+        children.sort(key=lambda x: x[1].lower())
+
         return children
 
+    def _list_dir_async(self, gfile, callback):
+        uri = gfile.get_uri()
+
+        # Several searches may wait for the same directory, a listing is
+        # never cancelled by a new search so that it ends up in the cache.
+        if uri in self._listing:
+            self._listing[uri].append(callback)
+            return
+
+        self._listing[uri] = [callback]
+        entries = []
+
+        def done():
+            self._cache[uri] = self._filter_entries(entries)
+
+            for cb in self._listing.pop(uri):
+                cb()
+
+        def on_next_files(enumerator, result, data=None):
+            try:
+                infos = enumerator.next_files_finish(result)
+            except GLib.Error as e:
+                infos = []
+
+            if self._list_cancellable.is_cancelled():
+                return
+
+            for info in infos:
+                if not info.get_is_backup():
+                    entries.append((enumerator.get_child(info), info))
+
+            if infos:
+                enumerator.next_files_async(LIST_BATCH_SIZE,
+                                            GLib.PRIORITY_DEFAULT,
+                                            self._list_cancellable,
+                                            on_next_files,
+                                            None)
+            else:
+                enumerator.close_async(GLib.PRIORITY_DEFAULT, None, None, None)
+                done()
+
+        def on_enumerated(source, result, data=None):
+            try:
+                enumerator = source.enumerate_children_finish(result)
+            except GLib.Error as e:
+                if not self._list_cancellable.is_cancelled():
+                    done()
+                return
+
+            enumerator.next_files_async(LIST_BATCH_SIZE,
+                                        GLib.PRIORITY_DEFAULT,
+                                        self._list_cancellable,
+                                        on_next_files,
+                                        None)
+
+        gfile.enumerate_children_async("standard::*",
+                                       Gio.FileQueryInfoFlags.NONE,
+                                       GLib.PRIORITY_DEFAULT,
+                                       self._list_cancellable,
+                                       on_enumerated,
+                                       None)
+
     def _compare_entries(self, a, b, lpart):
         if lpart in a:
             if lpart in b:
@@ -234,16 +303,20 @@ class Popup(Gtk.Dialog):
 
         return fnmatch.fnmatch(s, glob)
 
-    def do_search_dir(self, parts, d):
+    def _search_dir_iter(self, parts, d):
         if not parts or not d:
-            return []
+            return
 
-        if d in self._cache:
-            entries = self._cache[d]
-        else:
-            entries = self._list_dir(d)
-            entries.sort(key=lambda x: x[1].lower())
-            self._cache[d] = entries
+        uri = d.get_uri()
+
+        if uri not in self._cache:
+            if isinstance(d, VirtualDirectory):
+                self._cache[uri] = self._filter_entries(d.enumerate_children("standard::*", 0, None))
+            else:
+                # Wait for the directory to be listed
+                yield (None, d)
+
+        entries = self._cache[uri]
 
         found = []
         newdirs = []
@@ -271,10 +344,11 @@ class Popup(Gtk.Dialog):
         if lpart == '..':
             newdirs.append(d.get_parent())
 
-        for dd in newdirs:
-            found.extend(self.do_search_dir(parts[1:], dd))
+        for entry in found:
+            yield entry
 
-        return found
+        for dd in newdirs:
+            yield from self._search_dir_iter(parts[1:], dd)
 
     def _replace_insensitive(self, s, find, rep):
         out = ''
@@ -347,32 +421,86 @@ class Popup(Gtk.Dialog):
 
         return out
 
-    def _append_to_store(self, item):
+    def _add_result(self, item):
         uri = item[2].get_uri()
 
-        if uri not in self._stored_items:
-            self._store.append(item)
-            self._stored_items.add(uri)
+        if uri not in self._result_uris:
+            self._results.append(item)
+            self._result_uris.add(uri)
+
+    def _sync_store(self):
+        # The rows are replaced in place, so that the results which do not
+        # change between two searches do not move.
+        n_rows = self._store.iter_n_children(None)
+        piter = None
+
+        if self._synced < n_rows:
+            piter = self._store.iter_nth_child(None, self._synced)
+
+        for item in self._results[self._synced:]:
+            if piter:
+                row = self._store[piter]
+
+                if row[2].get_uri() != item[2].get_uri() or row[1] != item[1]:
+                    self._store.set_row(piter, item)
+
+                piter = self._store.iter_next(piter)
+            else:
+                self._store.append(item)
+
+        self._synced = len(self._results)
+
+        selection = self._treeview.get_selection()
+
+        if self._results and selection.count_selected_rows() == 0:
+            selection.select_path(Gtk.TreePath.new_first())
+
+    def _finish_search(self):
+        if self._search or self._index_pending:
+            return
 
-    def _clear_store(self):
-        self._store.clear()
-        self._stored_items = set()
+        # Remove what is left of the previous results
+        piter = self._store.iter_nth_child(None, len(self._results))
 
-    def _show_virtuals(self):
+        while piter and self._store.remove(piter):
+            pass
+
+        self._set_busy(False)
+        self.on_selection_changed(self._treeview.get_selection())
+
+    def _virtuals_iter(self):
         for d in self._dirs:
             if isinstance(d, VirtualDirectory):
                 for entry in d.enumerate_children("standard::*", 0, None):
-                    self._append_to_store((entry[1].get_icon(),
-                                          xml.sax.saxutils.escape(entry[1].get_name()),
-                                          entry[0],
-                                          entry[1].get_file_type()))
+                    yield (entry[1].get_icon(),
+                           xml.sax.saxutils.escape(entry[1].get_name()),
+                           entry[0],
+                           entry[1].get_file_type())
+
+    def _search_iter(self, parts, indexed):
+        for d in self._dirs:
+            if indexed and not isinstance(d, VirtualDirectory) and d.equal(indexed):
+                continue
+
+            for entry in self._search_dir_iter(parts, d):
+                if entry[0] is None:
+                    yield entry
+                    continue
+
+                pathparts = self._make_parts(d, entry[0], parts)
+                yield (entry[3],
+                       self.make_markup(parts, pathparts),
+                       entry[0],
+                       entry[2])
 
     def _set_busy(self, busy):
+        if not self.get_realized():
+            return
+
         if busy:
             self.get_window().set_cursor(self._busy_cursor)
         else:
             self.get_window().set_cursor(None)
-        Gdk.flush()
 
     def _remove_cursor(self):
         if self._cursor:
@@ -381,33 +509,133 @@ class Popup(Gtk.Dialog):
 
             self._store.row_changed(path, self._store.get_iter(path))
 
+    def _use_index(self, text):
+        if not self._index or os.path.isabs(text) or '..' in text.split(os.sep):
+            return False
+
+        return self._index.get_n_files() > 0
+
+    def _query_index(self, text):
+        self._index_cancellable = Gio.Cancellable()
+        self._index_pending = True
+        self._index.query_async(text,
+                                MAX_INDEX_RESULTS,
+                                self._index_cancellable,
+                                self.on_index_query_done,
+                                text)
+
+    def _cancel_search(self):
+        if self._search_id:
+            GLib.source_remove(self._search_id)
+            self._search_id = 0
+
+        self._search = None
+
+        if self._index_cancellable:
+            self._index_cancellable.cancel()
+            self._index_cancellable = None
+
+        self._index_pending = False
+
+    def _resume_search(self, search):
+        if search is self._search and not self._search_id:
+            self._search_id = GLib.idle_add(self.on_search_step)
+
     def do_search(self):
-        self._set_busy(True)
+        # The previous search is dropped, but its rows stay until they are
+        # replaced by the new results.
+        self._cancel_search()
         self._remove_cursor()
 
         text = self._entry.get_text().strip()
-        self._clear_store()
+
+        self._results = []
+        self._result_uris = set()
+        self._synced = 0
 
         if text == '':
-            self._show_virtuals()
+            self._search = self._virtuals_iter()
         else:
             parts = self.normalize_relative(text.split(os.sep))
-            files = []
+            indexed = None
 
-            for d in self._dirs:
-                for entry in self.do_search_dir(parts, d):
-                    pathparts = self._make_parts(d, entry[0], parts)
-                    self._append_to_store((entry[3],
-                                          self.make_markup(parts, pathparts),
-                                          entry[0],
-                                          entry[2]))
+            # The files below the indexed directory are fuzzy matched in
+            # a thread, and added at the top when they are found.
+            if self._use_index(text):
+                indexed = self._index.get_root()
+                self._query_index(text)
 
-        piter = self._store.get_iter_first()
-        if piter:
-            path = self._store.get_path(piter)
-            self._treeview.get_selection().select_path(path)
+            self._search = self._search_iter(parts, indexed)
 
-        self._set_busy(False)
+        self._set_busy(True)
+        self._search_id = GLib.idle_add(self.on_search_step)
+
+    def refresh(self):
+        if self.get_visible():
+            self.do_search()
+
+    def on_search_step(self):
+        search = self._search
+        end_time = GLib.get_monotonic_time() + SEARCH_STEP_TIME
+
+        for item in search:
+            if item[0] is None:
+                self._search_id = 0
+                self._sync_store()
+                self._list_dir_async(item[1], lambda: self._resume_search(search))
+                return False
+
+            self._add_result(item)
+
+            if GLib.get_monotonic_time() > end_time:
+                self._sync_store()
+                return True
+
+        self._search = None
+        self._search_id = 0
+
+        self._sync_store()
+        self._finish_search()
+
+        return False
+
+    def on_index_query_done(self, index, result, text):
+        try:
+            paths = index.query_finish(result)
+        except GLib.Error as e:
+            # A cancelled query belongs to a previous search
+            if e.matches(Gio.io_error_quark(), Gio.IOErrorEnum.CANCELLED):
+                return
+
+            # Otherwise the search ends without the fuzzy matches
+            paths = []
+
+        self._index_pending = False
+
+        root = index.get_root()
+        items = []
+
+        for path in paths:
+            gfile = root.resolve_relative_path(path)
+            name = os.path.basename(path)
+            content_type, uncertain = Gio.content_type_guess(name, None)
+
+            if not uncertain and not self._is_text_type(content_type):
+                continue
+
+            items.append((Gio.content_type_get_icon(content_type),
+                          Gedit.FileIndex.highlight_match(text, path),
+                          gfile,
+                          Gio.FileType.REGULAR))
+
+        # The fuzzy matches go first
+        uris = set(item[2].get_uri() for item in items)
+        self._results = items + [item for item in self._results if item[2].get_uri() not in uris]
+        self._result_uris |= uris
+        self._synced = 0
+
+        self._sync_store()
+        self._finish_search()
 
     # FIXME: override doesn't work anymore for some reason, if we override
     # the widget is not realized
@@ -419,6 +647,10 @@ class Popup(Gtk.Dialog):
 
         self.do_search()
 
+    def on_destroy(self, widget, data=None):
+        self._cancel_search()
+        self._list_cancellable.cancel()
+
     def on_changed(self, editable):
         self.do_search()
         self.on_selection_changed(self._treeview.get_selection())
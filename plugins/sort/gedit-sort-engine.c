@@ -0,0 +1,1085 @@
+/*
+ * gedit-sort-engine.c
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-sort-engine.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+
+#include <gedit/gedit-debug.h>
+
+/* The lines are sorted in a worker thread. For each line, the sort key (the
+ * collation key of the line from the starting column) is extracted into a
+ * compact array, which is sorted by several threads, each one sorting a slice
+ * of the array before the slices are merged.
+ *
+ * The keys take more memory than the text itself. When the keys of all the
+ * lines don't fit in what is left of MEMORY_BUDGET once the text and the
+ * output are counted, the lines are sorted in runs which are written to
+ * temporary files, and the runs are then merged.
+ *
+ * The result is not built in one piece: it is handed to the main thread in
+ * chunks of OUTPUT_CHUNK_SIZE, and the worker waits when more than
+ * MAX_PENDING_OUTPUT bytes have not been consumed yet.
+ *
+ * The result has the same order as gtk_source_buffer_sort_lines().
+ */
+
+#define MEMORY_BUDGET (128 * 1024 * 1024)
+
+/* The memory the keys of a run can use when the text alone is bigger than
+ * the budget.
+ */
+#define MIN_RUN_MEMORY (8 * 1024 * 1024)
+
+#define OUTPUT_CHUNK_SIZE (1024 * 1024)
+#define MAX_PENDING_OUTPUT (4 * OUTPUT_CHUNK_SIZE)
+
+/* Below this number of lines, the array is sorted by only one thread. */
+#define PARALLEL_SORT_MIN_LINES 65536
+#define MAX_SORT_THREADS 8
+
+/* Number of lines between two checks of the cancellable. */
+#define CHECK_INTERVAL 65536
+
+/* Part of the progress for the extraction and the sorting of the keys, the
+ * rest being for the merge and the output.
+ */
+#define SORT_PROGRESS_PART 0.8
+
+struct _GeditSortJob
+{
+	gint ref_count;
+
+	gchar *text;
+	gsize length;
+
+	GeditSortFlags flags;
+	gint starting_column;
+
+	/* Per mille, accessed atomically. */
+	gint progress;
+
+	GMainContext *context;
+	GeditSortOutputFunc output_func;
+	gpointer output_data;
+
+	/* Protects the fields below, the chunks of output are produced by
+	 * the worker thread and consumed in the main context.
+	 */
+	GMutex output_mutex;
+	GCond output_cond;
+	GQueue output_chunks;
+	gsize pending_output;
+	guint output_scheduled : 1;
+};
+
+typedef struct
+{
+	const gchar *line;
+	const gchar *key;
+	gdouble number;
+	guint32 line_length;
+	guint32 key_length;
+} SortLine;
+
+typedef struct
+{
+	GArray *lines;
+	GStringChunk *keys;
+	gsize memory;
+} Run;
+
+/* Header of a line written to a temporary file, followed by the key and the
+ * line.
+ */
+typedef struct
+{
+	gdouble number;
+	guint32 key_length;
+	guint32 line_length;
+} RecordHeader;
+
+typedef struct
+{
+	gchar *path;
+	FILE *file;
+
+	SortLine current;
+	gchar *key_buffer;
+	gchar *line_buffer;
+	gsize key_buffer_size;
+	gsize line_buffer_size;
+	guint done : 1;
+} Spill;
+
+typedef struct
+{
+	GeditSortJob *job;
+	GCancellable *cancellable;
+
+	/* The chunk being filled. */
+	GString *text;
+
+	/* The number of bytes output so far. */
+	gsize length;
+
+	GString *previous_key;
+	gdouble previous_number;
+	guint has_previous : 1;
+} Output;
+
+typedef struct
+{
+	SortLine *lines;
+	gsize n_lines;
+	GeditSortFlags flags;
+} SortSlice;
+
+static void
+set_progress (GeditSortJob *job,
+	      gdouble       fraction)
+{
+	g_atomic_int_set (&job->progress, (gint) (CLAMP (fraction, 0.0, 1.0) * 1000));
+}
+
+static gint
+compare_sort_lines (gconstpointer a,
+		    gconstpointer b,
+		    gpointer      user_data)
+{
+	const SortLine *line_a = a;
+	const SortLine *line_b = b;
+	GeditSortFlags flags = GPOINTER_TO_UINT (user_data);
+	gint ret = 0;
+
+	if ((flags & GEDIT_SORT_FLAGS_NUMERIC) != 0)
+	{
+		ret = (line_a->number > line_b->number) - (line_a->number < line_b->number);
+	}
+
+	if (ret == 0)
+	{
+		ret = strcmp (line_a->key, line_b->key);
+	}
+
+	return (flags & GEDIT_SORT_FLAGS_REVERSE_ORDER) != 0 ? -ret : ret;
+}
+
+/* The number at the start of the key, after blanks. The lines without a
+ * number come first.
+ */
+static gdouble
+parse_number (const gchar *key,
+	      const gchar *line_end)
+{
+	gchar *end = NULL;
+	gdouble number;
+
+	while (key < line_end && (*key == ' ' || *key == '\t'))
+	{
+		key++;
+	}
+
+	/* g_ascii_strtod() would skip the newline. */
+	if (key == line_end ||
+	    !(g_ascii_isdigit (*key) || *key == '-' || *key == '+' || *key == '.'))
+	{
+		return -G_MAXDOUBLE;
+	}
+
+	number = g_ascii_strtod (key, &end);
+
+	return end != key ? number : -G_MAXDOUBLE;
+}
+
+static void
+init_sort_line (GeditSortJob *job,
+		Run          *run,
+		SortLine     *sort_line,
+		const gchar  *line,
+		const gchar  *line_end)
+{
+	const gchar *key_start = line;
+	gchar *key;
+	gint column;
+
+	for (column = 0; column < job->starting_column && key_start < line_end; column++)
+	{
+		key_start = g_utf8_next_char (key_start);
+	}
+
+	key_start = MIN (key_start, line_end);
+
+	if ((job->flags & GEDIT_SORT_FLAGS_CASE_SENSITIVE) != 0)
+	{
+		key = g_utf8_collate_key (key_start, line_end - key_start);
+	}
+	else
+	{
+		gchar *folded;
+
+		folded = g_utf8_casefold (key_start, line_end - key_start);
+		key = g_utf8_collate_key (folded, -1);
+		g_free (folded);
+	}
+
+	sort_line->line = line;
+	sort_line->line_length = line_end - line;
+	sort_line->key_length = strlen (key);
+	sort_line->key = g_string_chunk_insert_len (run->keys, key, sort_line->key_length);
+	sort_line->number = (job->flags & GEDIT_SORT_FLAGS_NUMERIC) != 0 ?
+			    parse_number (key_start, line_end) : 0.0;
+
+	run->memory += sizeof (SortLine) + sort_line->key_length + 1;
+
+	g_free (key);
+}
+
+/* Extracts the keys of the lines starting at @start, until the end of the
+ * text or until the keys take more than @budget bytes.
+ *
+ * Returns: the start of the next line to process, or %NULL if all the lines
+ * have been processed.
+ */
+static const gchar *
+fill_run (GeditSortJob *job,
+	  Run          *run,
+	  gsize         budget,
+	  const gchar  *start,
+	  GCancellable *cancellable)
+{
+	const gchar *text_end = job->text + job->length;
+	const gchar *line = start;
+	guint n_lines = 0;
+
+	while (TRUE)
+	{
+		const gchar *newline;
+		const gchar *line_end;
+		SortLine sort_line;
+
+		newline = memchr (line, '\n', text_end - line);
+		line_end = newline != NULL ? newline : text_end;
+
+		init_sort_line (job, run, &sort_line, line, line_end);
+		g_array_append_val (run->lines, sort_line);
+
+		if (newline == NULL)
+		{
+			return NULL;
+		}
+
+		line = newline + 1;
+
+		if (run->memory >= budget)
+		{
+			return line;
+		}
+
+		if (++n_lines % CHECK_INTERVAL == 0)
+		{
+			set_progress (job, SORT_PROGRESS_PART * (line - job->text) / job->length);
+
+			if (g_cancellable_is_cancelled (cancellable))
+			{
+				return line;
+			}
+		}
+	}
+}
+
+static gpointer
+sort_slice_thread (gpointer data)
+{
+	SortSlice *slice = data;
+
+	g_qsort_with_data (slice->lines,
+			   slice->n_lines,
+			   sizeof (SortLine),
+			   compare_sort_lines,
+			   GUINT_TO_POINTER (slice->flags));
+
+	return NULL;
+}
+
+static void
+merge_slices (const SortLine *left,
+	      gsize           n_left,
+	      const SortLine *right,
+	      gsize           n_right,
+	      SortLine       *dest,
+	      GeditSortFlags  flags)
+{
+	gsize i = 0;
+	gsize j = 0;
+
+	/* Stable: the left slice wins on equal keys. */
+	while (i < n_left && j < n_right)
+	{
+		if (compare_sort_lines (&right[j], &left[i], GUINT_TO_POINTER (flags)) < 0)
+		{
+			*dest++ = right[j++];
+		}
+		else
+		{
+			*dest++ = left[i++];
+		}
+	}
+
+	memcpy (dest, left + i, (n_left - i) * sizeof (SortLine));
+	memcpy (dest + (n_left - i), right + j, (n_right - j) * sizeof (SortLine));
+}
+
+static void
+sort_lines (SortLine       *lines,
+	    gsize           n_lines,
+	    GeditSortFlags  flags)
+{
+	SortSlice slices[MAX_SORT_THREADS];
+	GThread *threads[MAX_SORT_THREADS];
+	gsize bounds[MAX_SORT_THREADS + 1];
+	SortLine *src;
+	SortLine *dest;
+	guint n_slices;
+	guint i;
+
+	n_slices = n_lines < PARALLEL_SORT_MIN_LINES ? 1 : CLAMP (g_get_num_processors (), 1, MAX_SORT_THREADS);
+
+	for (i = 0; i <= n_slices; i++)
+	{
+		bounds[i] = n_lines * i / n_slices;
+	}
+
+	for (i = 0; i < n_slices; i++)
+	{
+		slices[i].lines = lines + bounds[i];
+		slices[i].n_lines = bounds[i + 1] - bounds[i];
+		slices[i].flags = flags;
+
+		/* The current thread sorts the last slice. */
+		threads[i] = i + 1 < n_slices ? g_thread_new ("gedit-sort", sort_slice_thread, &slices[i]) : NULL;
+	}
+
+	sort_slice_thread (&slices[n_slices - 1]);
+
+	for (i = 0; i + 1 < n_slices; i++)
+	{
+		g_thread_join (threads[i]);
+	}
+
+	if (n_slices == 1)
+	{
+		return;
+	}
+
+	src = lines;
+	dest = g_new (SortLine, n_lines);
+
+	while (n_slices > 1)
+	{
+		SortLine *tmp;
+		guint n_merged = 0;
+
+		for (i = 0; i < n_slices; i += 2)
+		{
+			if (i + 1 < n_slices)
+			{
+				merge_slices (src + bounds[i], bounds[i + 1] - bounds[i],
+					      src + bounds[i + 1], bounds[i + 2] - bounds[i + 1],
+					      dest + bounds[i],
+					      flags);
+			}
+			else
+			{
+				memcpy (dest + bounds[i],
+					src + bounds[i],
+					(bounds[i + 1] - bounds[i]) * sizeof (SortLine));
+			}
+
+			bounds[n_merged++] = bounds[i];
+		}
+
+		bounds[n_merged] = n_lines;
+		n_slices = n_merged;
+
+		tmp = src;
+		src = dest;
+		dest = tmp;
+	}
+
+	if (src != lines)
+	{
+		memcpy (lines, src, n_lines * sizeof (SortLine));
+		g_free (src);
+	}
+	else
+	{
+		g_free (dest);
+	}
+}
+
+static gboolean
+dispatch_output_cb (gpointer data);
+
+/* Hands the current chunk to the main context. Blocks while the main
+ * context is behind.
+ */
+static gboolean
+flush_output (Output  *output,
+	      GError **error)
+{
+	GeditSortJob *job = output->job;
+
+	if (output->text->len == 0)
+	{
+		return TRUE;
+	}
+
+	g_mutex_lock (&job->output_mutex);
+
+	while (job->pending_output >= MAX_PENDING_OUTPUT &&
+	       !g_cancellable_is_cancelled (output->cancellable))
+	{
+		g_cond_wait_until (&job->output_cond,
+				   &job->output_mutex,
+				   g_get_monotonic_time () + 100 * G_TIME_SPAN_MILLISECOND);
+	}
+
+	g_queue_push_tail (&job->output_chunks, output->text);
+	job->pending_output += output->text->len;
+
+	if (!job->output_scheduled)
+	{
+		GSource *source;
+
+		source = g_idle_source_new ();
+		g_source_set_callback (source,
+				       dispatch_output_cb,
+				       gedit_sort_job_ref (job),
+				       (GDestroyNotify) gedit_sort_job_unref);
+		g_source_attach (source, job->context);
+		g_source_unref (source);
+
+		job->output_scheduled = TRUE;
+	}
+
+	g_mutex_unlock (&job->output_mutex);
+
+	output->text = g_string_sized_new (OUTPUT_CHUNK_SIZE);
+
+	return !g_cancellable_set_error_if_cancelled (output->cancellable, error);
+}
+
+static gboolean
+output_line (Output          *output,
+	     const SortLine  *line,
+	     GError         **error)
+{
+	if ((output->job->flags & GEDIT_SORT_FLAGS_REMOVE_DUPLICATES) != 0)
+	{
+		if (output->has_previous)
+		{
+			SortLine previous = { 0 };
+
+			previous.key = output->previous_key->str;
+			previous.number = output->previous_number;
+
+			if (compare_sort_lines (&previous, line, GUINT_TO_POINTER (output->job->flags)) == 0)
+			{
+				return TRUE;
+			}
+		}
+
+		g_string_assign (output->previous_key, line->key);
+		output->previous_number = line->number;
+	}
+
+	if (output->has_previous)
+	{
+		g_string_append_c (output->text, '\n');
+		output->length++;
+	}
+
+	g_string_append_len (output->text, line->line, line->line_length);
+	output->length += line->line_length;
+	output->has_previous = TRUE;
+
+	if (output->text->len >= OUTPUT_CHUNK_SIZE)
+	{
+		return flush_output (output, error);
+	}
+
+	return TRUE;
+}
+
+static void
+spill_free (Spill *spill)
+{
+	if (spill->file != NULL)
+	{
+		fclose (spill->file);
+	}
+
+	if (spill->path != NULL)
+	{
+		g_unlink (spill->path);
+		g_free (spill->path);
+	}
+
+	g_free (spill->key_buffer);
+	g_free (spill->line_buffer);
+	g_slice_free (Spill, spill);
+}
+
+static void
+set_io_error (GError      **error,
+	      const gchar  *message)
+{
+	gint saved_errno = errno;
+
+	g_set_error (error,
+		     G_IO_ERROR,
+		     g_io_error_from_errno (saved_errno),
+		     "%s: %s",
+		     message,
+		     g_strerror (saved_errno));
+}
+
+static Spill *
+spill_run (Run     *run,
+	   GError **error)
+{
+	Spill *spill;
+	gint fd;
+	guint i;
+
+	spill = g_slice_new0 (Spill);
+
+	fd = g_file_open_tmp ("gedit-sort-XXXXXX", &spill->path, error);
+
+	if (fd == -1)
+	{
+		spill_free (spill);
+		return NULL;
+	}
+
+	spill->file = fdopen (fd, "w+b");
+
+	if (spill->file == NULL)
+	{
+		set_io_error (error, "Failed to open the temporary file");
+		g_close (fd, NULL);
+		spill_free (spill);
+		return NULL;
+	}
+
+	for (i = 0; i < run->lines->len; i++)
+	{
+		const SortLine *line = &g_array_index (run->lines, SortLine, i);
+		RecordHeader header;
+
+		header.number = line->number;
+		header.key_length = line->key_length;
+		header.line_length = line->line_length;
+
+		if (fwrite (&header, sizeof (RecordHeader), 1, spill->file) != 1 ||
+		    fwrite (line->key, 1, line->key_length, spill->file) != line->key_length ||
+		    fwrite (line->line, 1, line->line_length, spill->file) != line->line_length)
+		{
+			set_io_error (error, "Failed to write the temporary file");
+			spill_free (spill);
+			return NULL;
+		}
+	}
+
+	if (fflush (spill->file) != 0 ||
+	    fseek (spill->file, 0, SEEK_SET) != 0)
+	{
+		set_io_error (error, "Failed to write the temporary file");
+		spill_free (spill);
+		return NULL;
+	}
+
+	gedit_debug_message (DEBUG_PLUGINS, "Run of %u lines written to %s", run->lines->len, spill->path);
+
+	return spill;
+}
+
+static gboolean
+read_field (FILE         *file,
+	    gchar       **buffer,
+	    gsize        *buffer_size,
+	    gsize         length)
+{
+	if (length + 1 > *buffer_size)
+	{
+		*buffer_size = MAX (length + 1, *buffer_size * 2);
+		*buffer = g_realloc (*buffer, *buffer_size);
+	}
+
+	if (fread (*buffer, 1, length, file) != length)
+	{
+		return FALSE;
+	}
+
+	(*buffer)[length] = '\0';
+	return TRUE;
+}
+
+/* Reads the next line of the run into spill->current. */
+static gboolean
+spill_next (Spill   *spill,
+	    GError **error)
+{
+	RecordHeader header;
+
+	if (fread (&header, sizeof (RecordHeader), 1, spill->file) != 1)
+	{
+		if (ferror (spill->file))
+		{
+			set_io_error (error, "Failed to read the temporary file");
+			return FALSE;
+		}
+
+		spill->done = TRUE;
+		return TRUE;
+	}
+
+	if (!read_field (spill->file, &spill->key_buffer, &spill->key_buffer_size, header.key_length) ||
+	    !read_field (spill->file, &spill->line_buffer, &spill->line_buffer_size, header.line_length))
+	{
+		set_io_error (error, "Failed to read the temporary file");
+		return FALSE;
+	}
+
+	spill->current.key = spill->key_buffer;
+	spill->current.key_length = header.key_length;
+	spill->current.line = spill->line_buffer;
+	spill->current.line_length = header.line_length;
+	spill->current.number = header.number;
+
+	return TRUE;
+}
+
+/* There are only a few runs, so the next line is simply searched among the
+ * current line of each run.
+ */
+static gboolean
+merge_spills (GeditSortJob  *job,
+	      GPtrArray     *spills,
+	      Output        *output,
+	      GCancellable  *cancellable,
+	      GError       **error)
+{
+	guint n_lines = 0;
+	guint i;
+
+	for (i = 0; i < spills->len; i++)
+	{
+		if (!spill_next (g_ptr_array_index (spills, i), error))
+		{
+			return FALSE;
+		}
+	}
+
+	while (TRUE)
+	{
+		Spill *next = NULL;
+
+		for (i = 0; i < spills->len; i++)
+		{
+			Spill *spill = g_ptr_array_index (spills, i);
+
+			/* On equal keys, the first run wins, as in a stable
+			 * sort.
+			 */
+			if (!spill->done &&
+			    (next == NULL ||
+			     compare_sort_lines (&spill->current, &next->current, GUINT_TO_POINTER (job->flags)) < 0))
+			{
+				next = spill;
+			}
+		}
+
+		if (next == NULL)
+		{
+			return TRUE;
+		}
+
+		if (!output_line (output, &next->current, error) ||
+		    !spill_next (next, error))
+		{
+			return FALSE;
+		}
+
+		if (++n_lines % CHECK_INTERVAL == 0)
+		{
+			set_progress (job,
+				      SORT_PROGRESS_PART +
+				      (1.0 - SORT_PROGRESS_PART) * output->length / job->length);
+
+			if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			{
+				return FALSE;
+			}
+		}
+	}
+}
+
+static void
+run_init (Run *run)
+{
+	run->lines = g_array_new (FALSE, FALSE, sizeof (SortLine));
+	run->keys = g_string_chunk_new (64 * 1024);
+	run->memory = 0;
+}
+
+static void
+run_clear (Run *run)
+{
+	g_array_unref (run->lines);
+	g_string_chunk_free (run->keys);
+}
+
+static void
+sort_thread (GTask        *task,
+	     gpointer      source_object,
+	     gpointer      task_data,
+	     GCancellable *cancellable)
+{
+	GeditSortJob *job = task_data;
+	GPtrArray *spills;
+	const gchar *next_line = job->text;
+	Output output = { 0 };
+	GError *error = NULL;
+	gsize output_memory;
+	gsize budget;
+	gint64 start_time;
+
+	start_time = g_get_monotonic_time ();
+
+	spills = g_ptr_array_new_with_free_func ((GDestroyNotify) spill_free);
+
+	output.job = job;
+	output.cancellable = cancellable;
+	output.text = g_string_sized_new (OUTPUT_CHUNK_SIZE);
+	output.previous_key = g_string_new (NULL);
+
+	/* The keys only get what the text and the output leave. */
+	output_memory = MAX_PENDING_OUTPUT + OUTPUT_CHUNK_SIZE;
+	budget = MEMORY_BUDGET > job->length + output_memory ?
+		 MEMORY_BUDGET - job->length - output_memory : 0;
+	budget = MAX (budget, MIN_RUN_MEMORY);
+
+	while (next_line != NULL)
+	{
+		Run run;
+		Spill *spill;
+
+		run_init (&run);
+		next_line = fill_run (job, &run, budget, next_line, cancellable);
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+		{
+			run_clear (&run);
+			goto out;
+		}
+
+		sort_lines ((SortLine *) run.lines->data, run.lines->len, job->flags);
+
+		/* Everything fits in memory. */
+		if (next_line == NULL && spills->len == 0)
+		{
+			guint i;
+
+			for (i = 0; i < run.lines->len; i++)
+			{
+				if (!output_line (&output, &g_array_index (run.lines, SortLine, i), &error))
+				{
+					run_clear (&run);
+					goto out;
+				}
+			}
+
+			run_clear (&run);
+			break;
+		}
+
+		spill = spill_run (&run, &error);
+		run_clear (&run);
+
+		if (spill == NULL)
+		{
+			goto out;
+		}
+
+		g_ptr_array_add (spills, spill);
+
+		/* All the lines are on disk, the merge doesn't need the
+		 * text.
+		 */
+		if (next_line == NULL)
+		{
+			g_clear_pointer (&job->text, g_free);
+		}
+	}
+
+	if (spills->len > 0 &&
+	    !merge_spills (job, spills, &output, cancellable, &error))
+	{
+		goto out;
+	}
+
+	if (!flush_output (&output, &error))
+	{
+		goto out;
+	}
+
+	set_progress (job, 1.0);
+
+	gedit_debug_message (DEBUG_PLUGINS,
+			     "Sorted %" G_GSIZE_FORMAT " bytes in %" G_GINT64_FORMAT " ms, %u runs on disk",
+			     job->length,
+			     (g_get_monotonic_time () - start_time) / 1000,
+			     spills->len);
+
+out:
+	g_ptr_array_unref (spills);
+	g_string_free (output.previous_key, TRUE);
+	g_string_free (output.text, TRUE);
+
+	if (error != NULL)
+	{
+		g_task_return_error (task, error);
+	}
+	else
+	{
+		g_task_return_boolean (task, TRUE);
+	}
+}
+
+static void
+dispatch_output (GeditSortJob *job)
+{
+	while (TRUE)
+	{
+		GString *chunk;
+
+		g_mutex_lock (&job->output_mutex);
+
+		chunk = g_queue_pop_head (&job->output_chunks);
+
+		if (chunk != NULL)
+		{
+			job->pending_output -= chunk->len;
+			g_cond_signal (&job->output_cond);
+		}
+
+		g_mutex_unlock (&job->output_mutex);
+
+		if (chunk == NULL)
+		{
+			break;
+		}
+
+		if (job->output_func != NULL)
+		{
+			job->output_func (chunk->str, chunk->len, job->output_data);
+		}
+
+		g_string_free (chunk, TRUE);
+	}
+}
+
+static gboolean
+dispatch_output_cb (gpointer data)
+{
+	GeditSortJob *job = data;
+
+	g_mutex_lock (&job->output_mutex);
+	job->output_scheduled = FALSE;
+	g_mutex_unlock (&job->output_mutex);
+
+	dispatch_output (job);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+free_chunk (gpointer data)
+{
+	g_string_free (data, TRUE);
+}
+
+/**
+ * gedit_sort_job_new:
+ * @text: (transfer full): the lines to sort, separated by newlines.
+ * @flags: the #GeditSortFlags.
+ * @starting_column: the column, in characters, where the sort keys start.
+ *
+ * Returns: (transfer full): a new #GeditSortJob.
+ */
+GeditSortJob *
+gedit_sort_job_new (gchar          *text,
+		    GeditSortFlags  flags,
+		    gint            starting_column)
+{
+	GeditSortJob *job;
+
+	g_return_val_if_fail (text != NULL, NULL);
+
+	job = g_slice_new0 (GeditSortJob);
+	job->ref_count = 1;
+	job->text = text;
+	job->length = strlen (text);
+	job->flags = flags;
+	job->starting_column = MAX (starting_column, 0);
+
+	g_mutex_init (&job->output_mutex);
+	g_cond_init (&job->output_cond);
+	g_queue_init (&job->output_chunks);
+
+	return job;
+}
+
+GeditSortJob *
+gedit_sort_job_ref (GeditSortJob *job)
+{
+	g_return_val_if_fail (job != NULL, NULL);
+
+	g_atomic_int_inc (&job->ref_count);
+	return job;
+}
+
+void
+gedit_sort_job_unref (GeditSortJob *job)
+{
+	g_return_if_fail (job != NULL);
+
+	if (g_atomic_int_dec_and_test (&job->ref_count))
+	{
+		g_free (job->text);
+		g_queue_clear_full (&job->output_chunks, free_chunk);
+		g_clear_pointer (&job->context, g_main_context_unref);
+		g_mutex_clear (&job->output_mutex);
+		g_cond_clear (&job->output_cond);
+		g_slice_free (GeditSortJob, job);
+	}
+}
+
+/**
+ * gedit_sort_job_get_progress:
+ * @job: a #GeditSortJob.
+ *
+ * Can be called from the main thread while the job runs.
+ *
+ * Returns: the fraction of the work done, between 0.0 and 1.0.
+ */
+gdouble
+gedit_sort_job_get_progress (GeditSortJob *job)
+{
+	g_return_val_if_fail (job != NULL, 0.0);
+
+	return g_atomic_int_get (&job->progress) / 1000.0;
+}
+
+/**
+ * gedit_sort_job_set_output_func:
+ * @job: a #GeditSortJob.
+ * @func: (nullable): the function receiving the sorted lines.
+ * @user_data: the data to pass to @func.
+ *
+ * The sorted lines are given to @func in chunks, in order, in the thread
+ * default main context of gedit_sort_job_run_async(). The last chunks are
+ * given at the latest by gedit_sort_job_run_finish(). If the job fails or
+ * is cancelled, the chunks already given are not a complete result.
+ */
+void
+gedit_sort_job_set_output_func (GeditSortJob        *job,
+				GeditSortOutputFunc  func,
+				gpointer             user_data)
+{
+	g_return_if_fail (job != NULL);
+
+	job->output_func = func;
+	job->output_data = user_data;
+}
+
+void
+gedit_sort_job_run_async (GeditSortJob        *job,
+			  GCancellable        *cancellable,
+			  GAsyncReadyCallback  callback,
+			  gpointer             user_data)
+{
+	GTask *task;
+
+	g_return_if_fail (job != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (job->context == NULL);
+
+	job->context = g_main_context_ref_thread_default ();
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	g_task_set_task_data (task,
+			      gedit_sort_job_ref (job),
+			      (GDestroyNotify) gedit_sort_job_unref);
+
+	g_task_run_in_thread (task, sort_thread);
+	g_object_unref (task);
+}
+
+/**
+ * gedit_sort_job_run_finish:
+ * @job: a #GeditSortJob.
+ * @result: a #GAsyncResult.
+ * @error: a location for a #GError, or %NULL.
+ *
+ * Gives the remaining chunks of the sorted lines to the output function on
+ * success. The output function is not called anymore afterwards.
+ *
+ * Returns: %TRUE if all the sorted lines have been output, %FALSE on error
+ * or if the job has been cancelled.
+ */
+gboolean
+gedit_sort_job_run_finish (GeditSortJob  *job,
+			   GAsyncResult  *result,
+			   GError       **error)
+{
+	gboolean ret;
+
+	g_return_val_if_fail (job != NULL, FALSE);
+	g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+	ret = g_task_propagate_boolean (G_TASK (result), error);
+
+	if (ret)
+	{
+		dispatch_output (job);
+	}
+
+	job->output_func = NULL;
+	job->output_data = NULL;
+
+	return ret;
+}
+
+/* ex:set ts=8 noet: */
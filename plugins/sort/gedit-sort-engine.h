@@ -0,0 +1,68 @@
+/*
+ * gedit-sort-engine.h
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_SORT_ENGINE_H
+#define GEDIT_SORT_ENGINE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+	GEDIT_SORT_FLAGS_NONE              = 0,
+	GEDIT_SORT_FLAGS_CASE_SENSITIVE    = 1 << 0,
+	GEDIT_SORT_FLAGS_REVERSE_ORDER     = 1 << 1,
+	GEDIT_SORT_FLAGS_REMOVE_DUPLICATES = 1 << 2,
+	GEDIT_SORT_FLAGS_NUMERIC           = 1 << 3
+} GeditSortFlags;
+
+typedef struct _GeditSortJob GeditSortJob;
+
+typedef void (*GeditSortOutputFunc) (const gchar *text,
+				     gsize        length,
+				     gpointer     user_data);
+
+GeditSortJob	*gedit_sort_job_new		(gchar               *text,
+						 GeditSortFlags       flags,
+						 gint                 starting_column);
+
+GeditSortJob	*gedit_sort_job_ref		(GeditSortJob        *job);
+
+void		 gedit_sort_job_unref		(GeditSortJob        *job);
+
+gdouble		 gedit_sort_job_get_progress	(GeditSortJob        *job);
+
+void		 gedit_sort_job_set_output_func	(GeditSortJob        *job,
+						 GeditSortOutputFunc  func,
+						 gpointer             user_data);
+
+void		 gedit_sort_job_run_async	(GeditSortJob        *job,
+						 GCancellable        *cancellable,
+						 GAsyncReadyCallback  callback,
+						 gpointer             user_data);
+
+gboolean	 gedit_sort_job_run_finish	(GeditSortJob        *job,
+						 GAsyncResult        *result,
+						 GError             **error);
+
+G_END_DECLS
+
+#endif /* GEDIT_SORT_ENGINE_H */
+/* ex:set ts=8 noet: */
@@ -32,6 +32,8 @@
 #include <gedit/gedit-app-activatable.h>
 #include <gedit/gedit-window-activatable.h>
 
+#include "gedit-sort-engine.h"
+
 static void gedit_app_activatable_iface_init (GeditAppActivatableInterface *iface);
 static void gedit_window_activatable_iface_init (GeditWindowActivatableInterface *iface);
 
@@ -45,11 +47,23 @@ struct _GeditSortPluginPrivate
 	GtkWidget *reverse_order_checkbutton;
 	GtkWidget *case_checkbutton;
 	GtkWidget *remove_dups_checkbutton;
+	GtkWidget *numeric_checkbutton;
+	GtkWidget *progressbar;
 
 	GeditApp *app;
 	GeditMenuExtension *menu_ext;
 
 	GtkTextIter start, end; /* selection */
+
+	/* The sort in progress. */
+	GeditSortJob *job;
+	GCancellable *cancellable;
+	GeditDocument *sort_doc;
+	GtkTextMark *sort_start_mark;
+	GtkTextMark *sort_end_mark;
+	GtkTextMark *sort_output_mark;
+	guint progress_timeout_id;
+	guint output_started : 1;
 };
 
 enum
@@ -69,13 +83,184 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditSortPlugin,
 							       gedit_window_activatable_iface_init)
 				G_ADD_PRIVATE_DYNAMIC (GeditSortPlugin))
 
+static void update_ui (GeditSortPlugin *plugin);
+
+static void
+set_sorting_ui (GeditSortPlugin *plugin,
+		gboolean         sorting)
+{
+	GeditSortPluginPrivate *priv = plugin->priv;
+
+	if (priv->dialog == NULL)
+	{
+		return;
+	}
+
+	gtk_widget_set_sensitive (priv->reverse_order_checkbutton, !sorting);
+	gtk_widget_set_sensitive (priv->case_checkbutton, !sorting);
+	gtk_widget_set_sensitive (priv->remove_dups_checkbutton, !sorting);
+	gtk_widget_set_sensitive (priv->numeric_checkbutton, !sorting);
+	gtk_widget_set_sensitive (priv->col_num_spinbutton, !sorting);
+
+	gtk_dialog_set_response_sensitive (GTK_DIALOG (priv->dialog),
+					   GTK_RESPONSE_OK,
+					   !sorting);
+
+	gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (priv->progressbar), 0.0);
+	gtk_widget_set_visible (priv->progressbar, sorting);
+}
+
+static gboolean
+update_progress_cb (GeditSortPlugin *plugin)
+{
+	GeditSortPluginPrivate *priv = plugin->priv;
+
+	if (priv->dialog != NULL)
+	{
+		gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (priv->progressbar),
+					       gedit_sort_job_get_progress (priv->job));
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/* The sorted lines are inserted after the lines to sort as they arrive, the
+ * lines to sort are deleted at the end. The whole replacement is one user
+ * action.
+ */
+static void
+insert_sorted_lines (const gchar *text,
+		     gsize        length,
+		     gpointer     user_data)
+{
+	GeditSortPlugin *plugin = GEDIT_SORT_PLUGIN (user_data);
+	GeditSortPluginPrivate *priv = plugin->priv;
+	GtkTextBuffer *buffer;
+	GtkTextIter iter;
+
+	if (priv->sort_doc == NULL)
+	{
+		return;
+	}
+
+	buffer = GTK_TEXT_BUFFER (priv->sort_doc);
+
+	if (!priv->output_started)
+	{
+		gtk_text_buffer_begin_user_action (buffer);
+		priv->output_started = TRUE;
+	}
+
+	gtk_text_buffer_get_iter_at_mark (buffer, &iter, priv->sort_output_mark);
+	gtk_text_buffer_insert (buffer, &iter, text, length);
+}
+
+static void
+finish_sorted_lines (GeditSortPlugin *plugin,
+		     gboolean         success)
+{
+	GeditSortPluginPrivate *priv = plugin->priv;
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (priv->sort_doc);
+	GtkTextIter start;
+	GtkTextIter end;
+
+	if (!priv->output_started)
+	{
+		gtk_text_buffer_begin_user_action (buffer);
+	}
+
+	if (success)
+	{
+		gtk_text_buffer_get_iter_at_mark (buffer, &start, priv->sort_start_mark);
+		gtk_text_buffer_get_iter_at_mark (buffer, &end, priv->sort_end_mark);
+	}
+	else
+	{
+		gtk_text_buffer_get_iter_at_mark (buffer, &start, priv->sort_end_mark);
+		gtk_text_buffer_get_iter_at_mark (buffer, &end, priv->sort_output_mark);
+	}
+
+	gtk_text_buffer_delete (buffer, &start, &end);
+	gtk_text_buffer_end_user_action (buffer);
+}
+
+static void
+sort_ready_cb (GObject      *source_object,
+	       GAsyncResult *result,
+	       gpointer      user_data)
+{
+	GeditSortPlugin *plugin = GEDIT_SORT_PLUGIN (user_data);
+	GeditSortPluginPrivate *priv = plugin->priv;
+	gboolean success;
+	GError *error = NULL;
+
+	success = gedit_sort_job_run_finish (priv->job, result, &error);
+
+	if (priv->sort_doc != NULL)
+	{
+		finish_sorted_lines (plugin, success);
+	}
+
+	if (success)
+	{
+		gedit_debug_message (DEBUG_PLUGINS, "Done.");
+	}
+	else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_warning ("Sort plugin: %s", error->message);
+	}
+
+	g_clear_error (&error);
+
+	g_source_remove (priv->progress_timeout_id);
+	priv->progress_timeout_id = 0;
+
+	if (priv->sort_doc != NULL)
+	{
+		gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (priv->sort_doc), priv->sort_start_mark);
+		gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (priv->sort_doc), priv->sort_end_mark);
+		gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (priv->sort_doc), priv->sort_output_mark);
+
+		g_object_remove_weak_pointer (G_OBJECT (priv->sort_doc),
+					      (gpointer *) &priv->sort_doc);
+		priv->sort_doc = NULL;
+	}
+
+	priv->sort_start_mark = NULL;
+	priv->sort_end_mark = NULL;
+	priv->sort_output_mark = NULL;
+	priv->output_started = FALSE;
+
+	g_clear_pointer (&priv->job, gedit_sort_job_unref);
+	g_clear_object (&priv->cancellable);
+
+	if (priv->dialog != NULL)
+	{
+		gtk_widget_destroy (priv->dialog);
+	}
+
+	if (priv->window != NULL)
+	{
+		update_ui (plugin);
+	}
+
+	g_object_unref (plugin);
+}
+
+/* The lines are sorted in a worker thread, the dialog shows the progress
+ * and can cancel the sort.
+ */
 static void
 do_sort (GeditSortPlugin *plugin)
 {
 	GeditSortPluginPrivate *priv;
 	GeditDocument *doc;
-	GtkSourceSortFlags sort_flags = 0;
+	GtkTextBuffer *buffer;
+	GeditSortFlags sort_flags = 0;
 	gint starting_column;
+	GtkTextIter start;
+	GtkTextIter end;
+	gchar *text;
 
 	gedit_debug (DEBUG_PLUGINS);
 
@@ -83,31 +268,74 @@ do_sort (GeditSortPlugin *plugin)
 
 	doc = gedit_window_get_active_document (priv->window);
 	g_return_if_fail (doc != NULL);
+	g_return_if_fail (priv->job == NULL);
+
+	buffer = GTK_TEXT_BUFFER (doc);
 
 	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->case_checkbutton)))
 	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_CASE_SENSITIVE;
+		sort_flags |= GEDIT_SORT_FLAGS_CASE_SENSITIVE;
 	}
 
 	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->reverse_order_checkbutton)))
 	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_REVERSE_ORDER;
+		sort_flags |= GEDIT_SORT_FLAGS_REVERSE_ORDER;
 	}
 
 	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->remove_dups_checkbutton)))
 	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_REMOVE_DUPLICATES;
+		sort_flags |= GEDIT_SORT_FLAGS_REMOVE_DUPLICATES;
+	}
+
+	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->numeric_checkbutton)))
+	{
+		sort_flags |= GEDIT_SORT_FLAGS_NUMERIC;
 	}
 
 	starting_column = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (priv->col_num_spinbutton)) - 1;
 
-	gtk_source_buffer_sort_lines (GTK_SOURCE_BUFFER (doc),
-	                              &priv->start,
-	                              &priv->end,
-	                              sort_flags,
-	                              starting_column);
+	/* Sort whole lines, without the last line terminator, like
+	 * gtk_source_buffer_sort_lines().
+	 */
+	start = priv->start;
+	end = priv->end;
+	gtk_text_iter_order (&start, &end);
+	gtk_text_iter_set_line_offset (&start, 0);
+
+	if (gtk_text_iter_starts_line (&end) &&
+	    gtk_text_iter_get_line (&end) > gtk_text_iter_get_line (&start))
+	{
+		gtk_text_iter_backward_line (&end);
+	}
+
+	if (!gtk_text_iter_ends_line (&end))
+	{
+		gtk_text_iter_forward_to_line_end (&end);
+	}
+
+	text = gtk_text_buffer_get_slice (buffer, &start, &end, TRUE);
+
+	/* The end mark stays before the sorted lines inserted after it. */
+	priv->sort_start_mark = gtk_text_buffer_create_mark (buffer, NULL, &start, TRUE);
+	priv->sort_end_mark = gtk_text_buffer_create_mark (buffer, NULL, &end, TRUE);
+	priv->sort_output_mark = gtk_text_buffer_create_mark (buffer, NULL, &end, FALSE);
 
-	gedit_debug_message (DEBUG_PLUGINS, "Done.");
+	priv->sort_doc = doc;
+	g_object_add_weak_pointer (G_OBJECT (doc), (gpointer *) &priv->sort_doc);
+
+	priv->job = gedit_sort_job_new (text, sort_flags, starting_column);
+	gedit_sort_job_set_output_func (priv->job, insert_sorted_lines, plugin);
+	priv->cancellable = g_cancellable_new ();
+
+	set_sorting_ui (plugin, TRUE);
+	update_ui (plugin);
+
+	priv->progress_timeout_id = g_timeout_add (100, (GSourceFunc) update_progress_cb, plugin);
+
+	gedit_sort_job_run_async (priv->job,
+				  priv->cancellable,
+				  sort_ready_cb,
+				  g_object_ref (plugin));
 }
 
 static void
@@ -117,9 +345,20 @@ sort_dialog_response_handler (GtkDialog       *dlg,
 {
 	gedit_debug (DEBUG_PLUGINS);
 
+	/* The dialog is destroyed when the sort is finished. */
 	if (response == GTK_RESPONSE_OK)
 	{
-		do_sort (plugin);
+		if (plugin->priv->job == NULL)
+		{
+			do_sort (plugin);
+		}
+
+		return;
+	}
+
+	if (plugin->priv->cancellable != NULL)
+	{
+		g_cancellable_cancel (plugin->priv->cancellable);
 	}
 
 	gtk_widget_destroy (GTK_WIDGET (dlg));
@@ -168,6 +407,8 @@ create_sort_dialog (GeditSortPlugin *plugin)
 	priv->col_num_spinbutton = GTK_WIDGET (gtk_builder_get_object (builder, "col_num_spinbutton"));
 	priv->case_checkbutton = GTK_WIDGET (gtk_builder_get_object (builder, "case_checkbutton"));
 	priv->remove_dups_checkbutton = GTK_WIDGET (gtk_builder_get_object (builder, "remove_dups_checkbutton"));
+	priv->numeric_checkbutton = GTK_WIDGET (gtk_builder_get_object (builder, "numeric_checkbutton"));
+	priv->progressbar = GTK_WIDGET (gtk_builder_get_object (builder, "progressbar"));
 	g_object_unref (builder);
 
 	gtk_dialog_set_default_response (GTK_DIALOG (priv->dialog),
@@ -224,7 +465,8 @@ update_ui (GeditSortPlugin *plugin)
 
 	g_simple_action_set_enabled (plugin->priv->action,
 	                             (view != NULL) &&
-	                             gtk_text_view_get_editable (GTK_TEXT_VIEW (view)));
+	                             gtk_text_view_get_editable (GTK_TEXT_VIEW (view)) &&
+	                             plugin->priv->job == NULL);
 }
 
 static void
@@ -281,6 +523,12 @@ gedit_sort_plugin_window_deactivate (GeditWindowActivatable *activatable)
 	gedit_debug (DEBUG_PLUGINS);
 
 	priv = GEDIT_SORT_PLUGIN (activatable)->priv;
+
+	if (priv->cancellable != NULL)
+	{
+		g_cancellable_cancel (priv->cancellable);
+	}
+
 	g_action_map_remove_action (G_ACTION_MAP (priv->window), "sort");
 }
 
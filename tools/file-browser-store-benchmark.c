@@ -0,0 +1,325 @@
+/*
+ * file-browser-store-benchmark.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the time the file browser store takes to show the first and the
+ * last row of a directory with N_FILES files, from the moment its root is
+ * set.
+ *
+ * Only the public API of the store is used, so that it can be built against
+ * an older store to compare the loading before and after:
+ *
+ *   git show <commit>:plugins/filebrowser/gedit-file-browser-store.c > /tmp/baseline/gedit-file-browser-store.c
+ *   meson configure -Dfile_browser_store_baseline=/tmp/baseline
+ *   ninja benchmark
+ *
+ * The listing cache is written in a temporary XDG_CACHE_HOME, the first run
+ * with the cache enabled fills it. A store without the listing cache is
+ * only measured once.
+ */
+
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+
+#include "gedit-file-browser-store.h"
+#include "gedit-file-browser-enum-types.h"
+
+#define N_FILES 20000
+#define N_RUNS 5
+
+typedef struct
+{
+	GMainLoop *loop;
+	gint64 start;
+	gint64 first_row;
+	gint64 last_row;
+} Run;
+
+/* The store is a dynamic type, registered by the plugin module */
+
+typedef GTypeModule BenchModule;
+typedef GTypeModuleClass BenchModuleClass;
+
+GType bench_module_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (BenchModule, bench_module, G_TYPE_TYPE_MODULE)
+
+static gboolean
+bench_module_load (GTypeModule *module)
+{
+	return TRUE;
+}
+
+static void
+bench_module_unload (GTypeModule *module)
+{
+}
+
+static void
+bench_module_class_init (BenchModuleClass *klass)
+{
+	klass->load = bench_module_load;
+	klass->unload = bench_module_unload;
+}
+
+static void
+bench_module_init (BenchModule *module)
+{
+}
+
+static void
+register_types (void)
+{
+	GTypeModule *module;
+
+	module = g_object_new (bench_module_get_type (), NULL);
+	g_type_module_set_name (module, "filebrowser");
+	g_type_module_use (module);
+
+	gedit_file_browser_enum_and_flag_register_type (module);
+	_gedit_file_browser_store_register_type (module);
+}
+
+static gchar *
+create_directory (void)
+{
+	gchar *path;
+	gint i;
+
+	path = g_dir_make_tmp ("gedit-file-browser-benchmark-XXXXXX", NULL);
+
+	if (path == NULL)
+	{
+		g_error ("Could not create the temporary directory");
+	}
+
+	for (i = 0; i < N_FILES; i++)
+	{
+		gchar *name;
+		gchar *filename;
+
+		name = g_strdup_printf ("file-%05d.txt", i);
+		filename = g_build_filename (path, name, NULL);
+
+		if (!g_file_set_contents (filename, "", 0, NULL))
+		{
+			g_error ("Could not create %s", filename);
+		}
+
+		g_free (filename);
+		g_free (name);
+	}
+
+	return path;
+}
+
+static void
+remove_directory (const gchar *path)
+{
+	GDir *dir;
+	const gchar *name;
+
+	dir = g_dir_open (path, 0, NULL);
+
+	if (dir != NULL)
+	{
+		while ((name = g_dir_read_name (dir)) != NULL)
+		{
+			gchar *filename = g_build_filename (path, name, NULL);
+
+			if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+			{
+				remove_directory (filename);
+			}
+			else
+			{
+				g_unlink (filename);
+			}
+
+			g_free (filename);
+		}
+
+		g_dir_close (dir);
+	}
+
+	g_rmdir (path);
+}
+
+static void
+row_inserted (GtkTreeModel *model,
+              GtkTreePath  *path,
+              GtkTreeIter  *iter,
+              Run          *run)
+{
+	guint flags;
+
+	/* The "(Empty)" row shown while the directory is loading */
+	gtk_tree_model_get (model, iter, GEDIT_FILE_BROWSER_STORE_COLUMN_FLAGS, &flags, -1);
+
+	if (FILE_IS_DUMMY (flags))
+	{
+		return;
+	}
+
+	run->last_row = g_get_monotonic_time ();
+
+	if (run->first_row == 0)
+	{
+		run->first_row = run->last_row;
+	}
+}
+
+static void
+end_loading (GeditFileBrowserStore *model,
+             GtkTreeIter           *iter,
+             Run                   *run)
+{
+	g_main_loop_quit (run->loop);
+}
+
+static gboolean
+has_listing_cache (void)
+{
+	GObjectClass *klass;
+	gboolean ret;
+
+	klass = g_type_class_ref (GEDIT_TYPE_FILE_BROWSER_STORE);
+	ret = g_object_class_find_property (klass, "listing-cache") != NULL;
+	g_type_class_unref (klass);
+
+	return ret;
+}
+
+static void
+load (GFile    *root,
+      gboolean  listing_cache,
+      gint64   *first_row,
+      gint64   *last_row)
+{
+	GeditFileBrowserStore *model;
+	Run run = { 0 };
+	gint n_rows;
+
+	model = g_object_new (GEDIT_TYPE_FILE_BROWSER_STORE, NULL);
+
+	if (has_listing_cache ())
+	{
+		g_object_set (model, "listing-cache", listing_cache, NULL);
+	}
+
+	g_signal_connect (model, "row-inserted", G_CALLBACK (row_inserted), &run);
+	g_signal_connect (model, "end-loading", G_CALLBACK (end_loading), &run);
+
+	run.loop = g_main_loop_new (NULL, FALSE);
+	run.start = g_get_monotonic_time ();
+
+	gedit_file_browser_store_set_root (model, root);
+	g_main_loop_run (run.loop);
+
+	n_rows = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (model), NULL);
+
+	if (n_rows != N_FILES)
+	{
+		g_error ("%d rows loaded instead of %d", n_rows, N_FILES);
+	}
+
+	*first_row = run.first_row - run.start;
+	*last_row = run.last_row - run.start;
+
+	g_main_loop_unref (run.loop);
+	g_object_unref (model);
+}
+
+static void
+run (const gchar *name,
+     GFile       *root,
+     gboolean     listing_cache)
+{
+	gint64 best_first_row = G_MAXINT64;
+	gint64 best_last_row = G_MAXINT64;
+	gint i;
+
+	for (i = 0; i < N_RUNS; i++)
+	{
+		gint64 first_row;
+		gint64 last_row;
+
+		load (root, listing_cache, &first_row, &last_row);
+
+		best_first_row = MIN (best_first_row, first_row);
+		best_last_row = MIN (best_last_row, last_row);
+	}
+
+	g_print ("%-32s %10.1f ms first row %10.1f ms last row\n",
+	         name,
+	         best_first_row / 1000.0,
+	         best_last_row / 1000.0);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+	gchar *cache_path;
+	gchar *path;
+	GFile *root;
+
+	/* Before anything reads the user cache directory */
+	cache_path = g_dir_make_tmp ("gedit-file-browser-benchmark-cache-XXXXXX", NULL);
+	g_setenv ("XDG_CACHE_HOME", cache_path, TRUE);
+
+	if (!gtk_init_check (&argc, &argv))
+	{
+		g_print ("No display, skipped\n");
+
+		remove_directory (cache_path);
+		g_free (cache_path);
+
+		return 77;
+	}
+
+	register_types ();
+
+	path = create_directory ();
+	root = g_file_new_for_path (path);
+
+	g_print ("%d files, best of %d runs\n", N_FILES, N_RUNS);
+
+	if (has_listing_cache ())
+	{
+		run ("listing cache disabled", root, FALSE);
+		run ("listing cache enabled", root, TRUE);
+	}
+	else
+	{
+		run ("no listing cache", root, FALSE);
+	}
+
+	g_object_unref (root);
+
+	remove_directory (path);
+	remove_directory (cache_path);
+
+	g_free (path);
+	g_free (cache_path);
+
+	return 0;
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,309 @@
+/*
+ * message-bus-benchmark.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the number of messages per second dispatched by a GeditMessageBus,
+ * with one listener, among other registered message types.
+ *
+ * The "by name" cases only use the API which predates the message ids, so that
+ * they can be built against an older libgedit (with -DLEGACY_ONLY) to compare
+ * the dispatch before and after.
+ */
+
+#include <gedit/gedit-message-bus.h>
+
+#define BENCH_OBJECT_PATH "/plugins/benchmark"
+#define N_OTHER_MESSAGES 200
+#define N_MESSAGES 200000
+#define N_RUNS 5
+
+/* A message like the ones generated by tools/generate-message.py */
+
+#define BENCH_TYPE_MESSAGE (bench_message_get_type ())
+#define BENCH_MESSAGE(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), BENCH_TYPE_MESSAGE, BenchMessage))
+
+typedef struct
+{
+	GeditMessage parent;
+
+	gchar *name;
+	gint value;
+} BenchMessage;
+
+typedef struct
+{
+	GeditMessageClass parent_class;
+} BenchMessageClass;
+
+GType bench_message_get_type (void) G_GNUC_CONST;
+
+enum
+{
+	PROP_0,
+	PROP_NAME,
+	PROP_VALUE
+};
+
+G_DEFINE_TYPE (BenchMessage, bench_message, GEDIT_TYPE_MESSAGE)
+
+static void
+bench_message_finalize (GObject *object)
+{
+	g_free (BENCH_MESSAGE (object)->name);
+
+	G_OBJECT_CLASS (bench_message_parent_class)->finalize (object);
+}
+
+static void
+bench_message_get_property (GObject    *object,
+                            guint       prop_id,
+                            GValue     *value,
+                            GParamSpec *pspec)
+{
+	BenchMessage *msg = BENCH_MESSAGE (object);
+
+	switch (prop_id)
+	{
+		case PROP_NAME:
+			g_value_set_string (value, msg->name);
+			break;
+		case PROP_VALUE:
+			g_value_set_int (value, msg->value);
+			break;
+	}
+}
+
+static void
+bench_message_set_property (GObject      *object,
+                            guint         prop_id,
+                            const GValue *value,
+                            GParamSpec   *pspec)
+{
+	BenchMessage *msg = BENCH_MESSAGE (object);
+
+	switch (prop_id)
+	{
+		case PROP_NAME:
+			g_free (msg->name);
+			msg->name = g_value_dup_string (value);
+			break;
+		case PROP_VALUE:
+			msg->value = g_value_get_int (value);
+			break;
+	}
+}
+
+static void
+bench_message_class_init (BenchMessageClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = bench_message_finalize;
+	object_class->get_property = bench_message_get_property;
+	object_class->set_property = bench_message_set_property;
+
+	g_object_class_install_property (object_class,
+	                                 PROP_NAME,
+	                                 g_param_spec_string ("name",
+	                                                      "Name",
+	                                                      "Name",
+	                                                      NULL,
+	                                                      G_PARAM_READWRITE |
+	                                                      G_PARAM_CONSTRUCT |
+	                                                      G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_VALUE,
+	                                 g_param_spec_int ("value",
+	                                                   "Value",
+	                                                   "Value",
+	                                                   G_MININT,
+	                                                   G_MAXINT,
+	                                                   0,
+	                                                   G_PARAM_READWRITE |
+	                                                   G_PARAM_CONSTRUCT |
+	                                                   G_PARAM_STATIC_STRINGS));
+}
+
+static void
+bench_message_init (BenchMessage *msg)
+{
+}
+
+static gint64 received;
+
+static void
+message_received (GeditMessageBus *bus,
+                  GeditMessage    *message,
+                  gpointer         user_data)
+{
+	received += BENCH_MESSAGE (message)->value;
+}
+
+static void
+send_sync_by_name (GeditMessageBus *bus)
+{
+	gint i;
+
+	for (i = 0; i < N_MESSAGES; i++)
+	{
+		GeditMessage *message;
+
+		message = gedit_message_bus_send_sync (bus,
+		                                       BENCH_OBJECT_PATH,
+		                                       "method",
+		                                       "value", 1,
+		                                       NULL);
+		g_object_unref (message);
+	}
+}
+
+static void
+send_reused_by_name (GeditMessageBus *bus)
+{
+	GeditMessage *message;
+	gint i;
+
+	message = g_object_new (BENCH_TYPE_MESSAGE,
+	                        "object-path", BENCH_OBJECT_PATH,
+	                        "method", "method",
+	                        NULL);
+
+	for (i = 0; i < N_MESSAGES; i++)
+	{
+		g_object_set (message, "value", 1, NULL);
+		gedit_message_bus_send_message_sync (bus, message);
+	}
+
+	g_object_unref (message);
+}
+
+static void
+send_async_by_name (GeditMessageBus *bus)
+{
+	gint i;
+
+	for (i = 0; i < N_MESSAGES; i++)
+	{
+		gedit_message_bus_send (bus,
+		                        BENCH_OBJECT_PATH,
+		                        "method",
+		                        "value", 1,
+		                        NULL);
+	}
+
+	while (g_main_context_iteration (NULL, FALSE))
+		;
+}
+
+#ifndef LEGACY_ONLY
+static void
+send_sync_by_id (GeditMessageBus *bus)
+{
+	guint message_id;
+	gint i;
+
+	message_id = gedit_message_bus_lookup_id (bus, BENCH_OBJECT_PATH, "method");
+
+	for (i = 0; i < N_MESSAGES; i++)
+	{
+		GeditMessage *message;
+
+		if (!gedit_message_bus_has_listeners (bus, message_id))
+		{
+			continue;
+		}
+
+		message = gedit_message_bus_acquire_message (bus, message_id);
+		BENCH_MESSAGE (message)->value = 1;
+
+		gedit_message_bus_send_message_sync (bus, message);
+		gedit_message_bus_release_message (bus, message);
+	}
+}
+#endif
+
+static void
+run (const gchar     *name,
+     GeditMessageBus *bus,
+     void           (*func) (GeditMessageBus *bus))
+{
+	gint64 best = G_MAXINT64;
+	gint i;
+
+	for (i = 0; i < N_RUNS; i++)
+	{
+		gint64 start;
+		gint64 elapsed;
+
+		received = 0;
+		start = g_get_monotonic_time ();
+
+		func (bus);
+
+		elapsed = g_get_monotonic_time () - start;
+		best = MIN (best, elapsed);
+
+		if (received != N_MESSAGES)
+		{
+			g_error ("%s: %" G_GINT64_FORMAT " messages received instead of %d",
+			         name, received, N_MESSAGES);
+		}
+	}
+
+	g_print ("%-32s %12.0f messages/s\n",
+	         name,
+	         N_MESSAGES / (MAX (best, 1) / (gdouble) G_USEC_PER_SEC));
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+	GeditMessageBus *bus;
+	gint i;
+
+	bus = gedit_message_bus_new ();
+
+	for (i = 0; i < N_OTHER_MESSAGES; i++)
+	{
+		gchar *method = g_strdup_printf ("other_%d", i);
+
+		gedit_message_bus_register (bus, BENCH_TYPE_MESSAGE, BENCH_OBJECT_PATH, method);
+		g_free (method);
+	}
+
+	gedit_message_bus_register (bus, BENCH_TYPE_MESSAGE, BENCH_OBJECT_PATH, "method");
+	gedit_message_bus_connect (bus, BENCH_OBJECT_PATH, "method", message_received, NULL, NULL);
+
+	g_print ("%d messages, best of %d runs\n", N_MESSAGES, N_RUNS);
+
+	run ("send_sync, by name", bus, send_sync_by_name);
+	run ("send_message_sync, reused", bus, send_reused_by_name);
+	run ("send, by name, async", bus, send_async_by_name);
+#ifndef LEGACY_ONLY
+	run ("send_message_sync, by id, pooled", bus, send_sync_by_id);
+#endif
+
+	g_object_unref (bus);
+
+	return 0;
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,382 @@
+/*
+ * message-bus-test.c
+ * This file is part of gedit
+ *
+ * Copyright (C) 2026 - The gedit Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the queue policies of the messages sent asynchronously, and that
+ * the queue is dispatched in time slices.
+ */
+
+#include <gedit/gedit-message-bus.h>
+
+#define TEST_OBJECT_PATH "/plugins/test"
+
+#define TEST_TYPE_MESSAGE (test_message_get_type ())
+#define TEST_MESSAGE(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), TEST_TYPE_MESSAGE, TestMessage))
+
+typedef struct
+{
+	GeditMessage parent;
+
+	gchar *name;
+	gint value;
+} TestMessage;
+
+typedef struct
+{
+	GeditMessageClass parent_class;
+} TestMessageClass;
+
+GType test_message_get_type (void) G_GNUC_CONST;
+
+enum
+{
+	PROP_0,
+	PROP_NAME,
+	PROP_VALUE
+};
+
+G_DEFINE_TYPE (TestMessage, test_message, GEDIT_TYPE_MESSAGE)
+
+static void
+test_message_finalize (GObject *object)
+{
+	g_free (TEST_MESSAGE (object)->name);
+
+	G_OBJECT_CLASS (test_message_parent_class)->finalize (object);
+}
+
+static void
+test_message_get_property (GObject    *object,
+                           guint       prop_id,
+                           GValue     *value,
+                           GParamSpec *pspec)
+{
+	TestMessage *msg = TEST_MESSAGE (object);
+
+	switch (prop_id)
+	{
+		case PROP_NAME:
+			g_value_set_string (value, msg->name);
+			break;
+		case PROP_VALUE:
+			g_value_set_int (value, msg->value);
+			break;
+	}
+}
+
+static void
+test_message_set_property (GObject      *object,
+                           guint         prop_id,
+                           const GValue *value,
+                           GParamSpec   *pspec)
+{
+	TestMessage *msg = TEST_MESSAGE (object);
+
+	switch (prop_id)
+	{
+		case PROP_NAME:
+			g_free (msg->name);
+			msg->name = g_value_dup_string (value);
+			break;
+		case PROP_VALUE:
+			msg->value = g_value_get_int (value);
+			break;
+	}
+}
+
+static void
+test_message_class_init (TestMessageClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = test_message_finalize;
+	object_class->get_property = test_message_get_property;
+	object_class->set_property = test_message_set_property;
+
+	g_object_class_install_property (object_class,
+	                                 PROP_NAME,
+	                                 g_param_spec_string ("name",
+	                                                      "Name",
+	                                                      "Name",
+	                                                      NULL,
+	                                                      G_PARAM_READWRITE |
+	                                                      G_PARAM_CONSTRUCT |
+	                                                      G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_VALUE,
+	                                 g_param_spec_int ("value",
+	                                                   "Value",
+	                                                   "Value",
+	                                                   G_MININT,
+	                                                   G_MAXINT,
+	                                                   0,
+	                                                   G_PARAM_READWRITE |
+	                                                   G_PARAM_CONSTRUCT |
+	                                                   G_PARAM_STATIC_STRINGS));
+}
+
+static void
+test_message_init (TestMessage *msg)
+{
+}
+
+/* The "name:value" of the received messages, in order */
+static GString *received;
+static gulong dispatch_delay;
+
+static void
+message_received (GeditMessageBus *bus,
+                  GeditMessage    *message,
+                  gpointer         user_data)
+{
+	TestMessage *msg = TEST_MESSAGE (message);
+
+	g_string_append_printf (received, "%s%s:%d",
+	                        received->len > 0 ? " " : "",
+	                        msg->name,
+	                        msg->value);
+
+	if (dispatch_delay > 0)
+	{
+		g_usleep (dispatch_delay);
+	}
+}
+
+static GeditMessageBus *
+create_bus (const gchar *method)
+{
+	GeditMessageBus *bus;
+
+	bus = gedit_message_bus_new ();
+
+	gedit_message_bus_register (bus, TEST_TYPE_MESSAGE, TEST_OBJECT_PATH, "other");
+	gedit_message_bus_register (bus, TEST_TYPE_MESSAGE, TEST_OBJECT_PATH, method);
+	gedit_message_bus_connect (bus, TEST_OBJECT_PATH, "other", message_received, NULL, NULL);
+	gedit_message_bus_connect (bus, TEST_OBJECT_PATH, method, message_received, NULL, NULL);
+
+	g_string_truncate (received, 0);
+	dispatch_delay = 0;
+
+	return bus;
+}
+
+static void
+send (GeditMessageBus *bus,
+      const gchar     *method,
+      const gchar     *name,
+      gint             value)
+{
+	gedit_message_bus_send (bus,
+	                        TEST_OBJECT_PATH,
+	                        method,
+	                        "name", name,
+	                        "value", value,
+	                        NULL);
+}
+
+static void
+dispatch_all (void)
+{
+	while (g_main_context_iteration (NULL, FALSE))
+		;
+}
+
+static void
+test_keep (void)
+{
+	GeditMessageBus *bus = create_bus ("method");
+
+	send (bus, "method", "a", 1);
+	send (bus, "method", "a", 1);
+	send (bus, "method", "b", 2);
+
+	g_assert_cmpstr (received->str, ==, "");
+
+	dispatch_all ();
+
+	g_assert_cmpstr (received->str, ==, "a:1 a:1 b:2");
+
+	g_object_unref (bus);
+}
+
+static void
+test_merge (void)
+{
+	GeditMessageBus *bus = create_bus ("method");
+
+	gedit_message_bus_set_queue_policy (bus,
+	                                    TEST_OBJECT_PATH,
+	                                    "method",
+	                                    GEDIT_MESSAGE_QUEUE_POLICY_MERGE);
+
+	/* Only the messages with the same arguments are merged */
+	send (bus, "method", "a", 1);
+	send (bus, "other", "x", 0);
+	send (bus, "method", "a", 2);
+	send (bus, "method", "a", 1);
+	send (bus, "method", "b", 2);
+
+	dispatch_all ();
+
+	g_assert_cmpstr (received->str, ==, "a:1 x:0 a:2 b:2");
+
+	/* A dispatched message is not pending anymore */
+	g_string_truncate (received, 0);
+
+	send (bus, "method", "a", 1);
+
+	dispatch_all ();
+
+	g_assert_cmpstr (received->str, ==, "a:1");
+
+	g_object_unref (bus);
+}
+
+static void
+test_merge_keys (void)
+{
+	GeditMessageBus *bus = create_bus ("method");
+	const gchar *keys[] = { "name", NULL };
+
+	gedit_message_bus_set_queue_policy (bus,
+	                                    TEST_OBJECT_PATH,
+	                                    "method",
+	                                    GEDIT_MESSAGE_QUEUE_POLICY_MERGE);
+	gedit_message_bus_set_merge_keys (bus, TEST_OBJECT_PATH, "method", keys);
+
+	/* The last message of each name, at the place of the first one */
+	send (bus, "method", "a", 1);
+	send (bus, "method", "b", 1);
+	send (bus, "method", "a", 2);
+	send (bus, "method", "b", 2);
+	send (bus, "method", "a", 3);
+
+	dispatch_all ();
+
+	g_assert_cmpstr (received->str, ==, "a:3 b:2");
+
+	/* Back to the keep policy */
+	g_string_truncate (received, 0);
+
+	gedit_message_bus_set_queue_policy (bus,
+	                                    TEST_OBJECT_PATH,
+	                                    "method",
+	                                    GEDIT_MESSAGE_QUEUE_POLICY_KEEP);
+
+	send (bus, "method", "a", 1);
+	send (bus, "method", "a", 2);
+
+	dispatch_all ();
+
+	g_assert_cmpstr (received->str, ==, "a:1 a:2");
+
+	g_object_unref (bus);
+}
+
+static void
+test_drop (void)
+{
+	GeditMessageBus *bus = create_bus ("method");
+
+	gedit_message_bus_set_queue_policy (bus,
+	                                    TEST_OBJECT_PATH,
+	                                    "method",
+	                                    GEDIT_MESSAGE_QUEUE_POLICY_DROP);
+	gedit_message_bus_set_max_queue_length (bus, 2);
+
+	/* The other messages are queued past the limit */
+	send (bus, "method", "a", 1);
+	send (bus, "method", "a", 2);
+	send (bus, "method", "a", 3);
+	send (bus, "other", "x", 0);
+	send (bus, "method", "a", 4);
+
+	dispatch_all ();
+
+	g_assert_cmpstr (received->str, ==, "a:1 a:2 x:0");
+
+	/* The queue is empty again */
+	g_string_truncate (received, 0);
+
+	send (bus, "method", "a", 5);
+
+	dispatch_all ();
+
+	g_assert_cmpstr (received->str, ==, "a:5");
+
+	g_object_unref (bus);
+}
+
+static void
+test_time_slice (void)
+{
+	GeditMessageBus *bus = create_bus ("method");
+	gchar **messages;
+	gint i;
+
+	/* Each message takes 1 ms, longer than the 4 ms slice with 20 */
+	for (i = 0; i < 20; i++)
+	{
+		send (bus, "method", "a", i);
+	}
+
+	dispatch_delay = 1000;
+
+	g_main_context_iteration (NULL, FALSE);
+
+	messages = g_strsplit (received->str, " ", -1);
+	g_assert_cmpuint (g_strv_length (messages), >, 0);
+	g_assert_cmpuint (g_strv_length (messages), <, 20);
+	g_strfreev (messages);
+
+	dispatch_all ();
+
+	messages = g_strsplit (received->str, " ", -1);
+	g_assert_cmpuint (g_strv_length (messages), ==, 20);
+	g_assert_cmpstr (messages[19], ==, "a:19");
+	g_strfreev (messages);
+
+	g_object_unref (bus);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+	gint ret;
+
+	g_test_init (&argc, &argv, NULL);
+
+	received = g_string_new (NULL);
+
+	g_test_add_func ("/message-bus/keep", test_keep);
+	g_test_add_func ("/message-bus/merge", test_merge);
+	g_test_add_func ("/message-bus/merge-keys", test_merge_keys);
+	g_test_add_func ("/message-bus/drop", test_drop);
+	g_test_add_func ("/message-bus/time-slice", test_time_slice);
+
+	ret = g_test_run ();
+
+	g_string_free (received, TRUE);
+
+	return ret;
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2026 - The gedit Team
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, see <http://www.gnu.org/licenses/>.
+
+"""
+Measures the startup time of gedit from its startup traces.
+
+gedit is started repeatedly in standalone mode with GEDIT_STARTUP_TRACE set,
+and quits as soon as its first window is shown with its documents loaded.
+The warm runs follow each other, the cold runs are preceded by a drop of the
+page cache, which needs root.
+
+The gedit given must be able to run: installed, or with the environment of
+the build directory (GSETTINGS_SCHEMA_DIR, GI_TYPELIB_PATH, etc).
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+# The event marking the end of the startup
+READY_EVENT = 'documents-loaded'
+
+
+def drop_caches():
+    os.sync()
+
+    try:
+        with open('/proc/sys/vm/drop_caches', 'w') as f:
+            f.write('3\n')
+    except OSError:
+        return False
+
+    return True
+
+
+def read_trace(filename):
+    with open(filename, encoding='utf-8') as f:
+        events = json.load(f)['traceEvents']
+
+    ready = None
+    phases = {}
+    begins = {}
+
+    for event in events:
+        if event['ph'] == 'i' and event['name'] == READY_EVENT:
+            ready = event['ts']
+        elif event['ph'] == 'B':
+            begins.setdefault(event['name'], []).append(event['ts'])
+        elif event['ph'] == 'E' and begins.get(event['name']):
+            start = begins[event['name']].pop()
+            phases[event['name']] = phases.get(event['name'], 0) + event['ts'] - start
+
+    if ready is None and events:
+        ready = max(event['ts'] for event in events)
+
+    return ready, phases
+
+
+def run_gedit(gedit, files, timeout):
+    fd, trace = tempfile.mkstemp(prefix='gedit-startup-', suffix='.json')
+    os.close(fd)
+
+    env = os.environ.copy()
+    env['GEDIT_STARTUP_TRACE'] = trace
+    env['GEDIT_STARTUP_TRACE_QUIT'] = '1'
+
+    start = time.monotonic()
+
+    try:
+        subprocess.run([gedit, '--standalone'] + files,
+                       env=env,
+                       timeout=timeout,
+                       check=True,
+                       stdout=subprocess.DEVNULL)
+        wall = (time.monotonic() - start) * 1000000
+        ready, phases = read_trace(trace)
+    finally:
+        os.unlink(trace)
+
+    return ready, wall, phases
+
+
+def percentile(values, p):
+    values = sorted(values)
+    rank = max(int(round(p / 100.0 * len(values))) - 1, 0)
+
+    return values[min(rank, len(values) - 1)]
+
+
+def report(name, runs):
+    ready = [run[0] / 1000.0 for run in runs]
+    wall = [run[1] / 1000.0 for run in runs]
+
+    print('%s startup, %d runs' % (name, len(runs)))
+    print('  %-22s %8s %8s %8s %8s %8s' % ('', 'min', 'p50', 'p90', 'p99', 'max'))
+
+    for label, values in (('ready (ms)', ready), ('process (ms)', wall)):
+        print('  %-22s %8.1f %8.1f %8.1f %8.1f %8.1f' % (label,
+                                                          min(values),
+                                                          percentile(values, 50),
+                                                          percentile(values, 90),
+                                                          percentile(values, 99),
+                                                          max(values)))
+
+    names = set()
+    for run in runs:
+        names.update(run[2].keys())
+
+    print('  median phase durations (ms)')
+
+    for phase in sorted(names, key=lambda n: -percentile([run[2].get(n, 0) for run in runs], 50)):
+        print('    %-30s %8.1f' % (phase, percentile([run[2].get(phase, 0) for run in runs], 50) / 1000.0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Measure the startup time of gedit.')
+    parser.add_argument('gedit', help='the gedit executable')
+    parser.add_argument('files', nargs='*', help='files to open at startup')
+    parser.add_argument('--runs', type=int, default=10, help='the number of runs of each kind')
+    parser.add_argument('--timeout', type=float, default=60, help='the maximum time of a run, in seconds')
+    parser.add_argument('--no-cold', action='store_true', help='only measure warm startups')
+    args = parser.parse_args()
+
+    cold = []
+    warm = []
+
+    if not args.no_cold:
+        for i in range(args.runs):
+            if not drop_caches():
+                print('The page cache cannot be dropped without root, no cold runs.',
+                      file=sys.stderr)
+                break
+
+            cold.append(run_gedit(args.gedit, args.files, args.timeout))
+
+    # The first warm run fills the caches
+    run_gedit(args.gedit, args.files, args.timeout)
+
+    for i in range(args.runs):
+        warm.append(run_gedit(args.gedit, args.files, args.timeout))
+
+    if cold:
+        report('Cold', cold)
+
+    report('Warm', warm)
+
+
+if __name__ == '__main__':
+    main()
+
+# ex:ts=4:et: